@@ -9,10 +9,12 @@
 // Arguments:
 // - cchRowWidth - the length of the default text attribute
 // - attr - the default text attribute
+// - table - the table to intern the attributes of this row in
 // Return Value:
 // - constructed object
-ATTR_ROW::ATTR_ROW(const uint16_t width, const TextAttribute attr) :
-    _data(width, attr) {}
+ATTR_ROW::ATTR_ROW(const uint16_t width, const TextAttribute attr, TextAttributeTable& table) :
+    _data(width, table.Intern(attr)),
+    _table{ &table } {}
 
 // Routine Description:
 // - Sets all properties of the ATTR_ROW to default values
@@ -20,7 +22,9 @@ ATTR_ROW::ATTR_ROW(const uint16_t width, const TextAttribute attr) :
 // - attr - The default text attributes to use on text in this row.
 void ATTR_ROW::Reset(const TextAttribute attr)
 {
-    _data.replace(0, _data.size(), attr);
+    const auto handle = _table->Intern(attr);
+    _revision = 0;
+    _data.replace(0, _data.size(), handle);
 }
 
 // Routine Description:
@@ -34,6 +38,7 @@ void ATTR_ROW::Reset(const TextAttribute attr)
 // - <none>, throws exceptions on failures.
 void ATTR_ROW::Resize(const uint16_t newWidth)
 {
+    _revision = 0;
     _data.resize_trailing_extent(newWidth);
 }
 
@@ -47,7 +52,7 @@ void ATTR_ROW::Resize(const uint16_t newWidth)
 // - will throw on error
 TextAttribute ATTR_ROW::GetAttrByColumn(const uint16_t column) const
 {
-    return _data.at(column);
+    return _table->Get(_data.at(column));
 }
 
 // Routine Description:
@@ -59,9 +64,10 @@ std::vector<uint16_t> ATTR_ROW::GetHyperlinks() const
     std::vector<uint16_t> ids;
     for (const auto& run : _data.runs())
     {
-        if (run.value.IsHyperlink())
+        const auto& attr = _table->Get(run.value);
+        if (attr.IsHyperlink())
         {
-            ids.emplace_back(run.value.GetHyperlinkId());
+            ids.emplace_back(attr.GetHyperlinkId());
         }
     }
     return ids;
@@ -76,7 +82,9 @@ std::vector<uint16_t> ATTR_ROW::GetHyperlinks() const
 // - <none>
 bool ATTR_ROW::SetAttrToEnd(const uint16_t beginIndex, const TextAttribute attr)
 {
-    _data.replace(gsl::narrow<uint16_t>(beginIndex), _data.size(), attr);
+    const auto handle = _table->Intern(attr);
+    _revision = 0;
+    _data.replace(gsl::narrow<uint16_t>(beginIndex), _data.size(), handle);
     return true;
 }
 
@@ -90,7 +98,16 @@ bool ATTR_ROW::SetAttrToEnd(const uint16_t beginIndex, const TextAttribute attr)
 // - <none>
 void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith)
 {
-    _data.replace_values(toBeReplacedAttr, replaceWith);
+    // Interning the new attribute first ensures that the handle of the old one stays valid.
+    const auto newHandle = _table->Intern(replaceWith);
+    const auto oldHandle = _table->Find(toBeReplacedAttr);
+    if (!oldHandle || *oldHandle == newHandle)
+    {
+        return;
+    }
+
+    _revision = 0;
+    _data.replace_values(*oldHandle, newHandle);
 }
 
 // Routine Description:
@@ -105,30 +122,182 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
 // - <none>
 void ATTR_ROW::Replace(const uint16_t beginIndex, const uint16_t endIndex, const TextAttribute& newAttr)
 {
-    _data.replace(beginIndex, endIndex, newAttr);
+    const auto handle = _table->Intern(newAttr);
+
+    // Rewriting text with the attributes it already has doesn't count as a modification.
+    if (_IsFilledWith(beginIndex, endIndex, handle))
+    {
+        return;
+    }
+
+    _revision = 0;
+    _data.replace(beginIndex, endIndex, handle);
+}
+
+// Routine Description:
+// - Merges several attributes into this row at once, like calling Replace() for
+//   each of them would, but in a single pass over the row's runs.
+// Arguments:
+// - replacements: The ranges to replace and their attributes, sorted by their
+//   beginIndex. The ranges must not overlap.
+// Return Value:
+// - <none>
+void ATTR_ROW::Replace(const gsl::span<const Replacement> replacements)
+{
+    if (replacements.size() <= 1)
+    {
+        for (const auto& replacement : replacements)
+        {
+            Replace(replacement.beginIndex, replacement.endIndex, replacement.attr);
+        }
+        return;
+    }
+
+    boost::container::small_vector<rle_vector::edit, 16> edits;
+    edits.reserve(replacements.size());
+    for (const auto& replacement : replacements)
+    {
+        edits.push_back({ replacement.beginIndex, replacement.endIndex, _table->Intern(replacement.attr) });
+    }
+
+    // Rewriting text with the attributes it already has doesn't count as a modification.
+    if (_data.apply({ edits.data(), edits.size() }))
+    {
+        _revision = 0;
+    }
+}
+
+// Routine Description:
+// - Gets a number identifying the current attributes of the row.
+// - Just like CharRow::GetRevision(), revisions are unique across all rows and
+//   are drawn lazily, once the row is queried after it was modified.
+// Arguments:
+// - <none>
+// Return Value:
+// - the revision of the row's attributes
+uint64_t ATTR_ROW::GetRevision() const noexcept
+{
+    static std::atomic<uint64_t> nextRevision{ 1 };
+    if (_revision == 0)
+    {
+        _revision = nextRevision.fetch_add(1, std::memory_order_relaxed);
+    }
+    return _revision;
+}
+
+// Routine Description:
+// - Checks whether all columns in [beginIndex, endIndex) have the given attribute.
+// Arguments:
+// - beginIndex, endIndex: The range of columns to check.
+// - handle: The handle of the attribute to compare with.
+// Return Value:
+// - true if every column in the range has the attribute.
+bool ATTR_ROW::_IsFilledWith(const uint16_t beginIndex, const uint16_t endIndex, const handle_type handle) const noexcept
+{
+    size_t runBegin = 0;
+    for (const auto& run : _data.runs())
+    {
+        const size_t runEnd = runBegin + run.length;
+        if (runBegin >= endIndex)
+        {
+            break;
+        }
+        if (runEnd > beginIndex && run.value != handle)
+        {
+            return false;
+        }
+        runBegin = runEnd;
+    }
+    return true;
+}
+
+// Routine Description:
+// - Replaces the attributes of the first columns with the ones of another row.
+// Arguments:
+// - source - the row to copy from. May belong to a different table.
+// - count - the number of columns to copy
+// Return Value:
+// - <none>
+void ATTR_ROW::_CopyFrom(const ATTR_ROW& source, const uint16_t count)
+{
+    auto slice = source._data.slice(0, count);
+
+    if (source._table != _table)
+    {
+        std::vector<til::rle_pair<handle_type, uint16_t>> runs;
+        runs.reserve(slice.runs().size());
+        for (const auto& run : slice.runs())
+        {
+            runs.emplace_back(_table->Intern(source._table->Get(run.value)), run.length);
+        }
+        _data.replace(0, count, gsl::span<const til::rle_pair<handle_type, uint16_t>>{ runs });
+    }
+    else
+    {
+        const auto& runs = slice.runs();
+        _data.replace(0, count, gsl::span<const til::rle_pair<handle_type, uint16_t>>{ runs.data(), runs.size() });
+    }
+
+    _revision = 0;
+}
+
+// Routine Description:
+// - Flags the handles used by this row in preparation of TextAttributeTable::Compact().
+// Arguments:
+// - used - the flags to set, one per handle of the table.
+// Return Value:
+// - <none>
+void ATTR_ROW::_MarkUsed(std::vector<bool>& used) const
+{
+    for (const auto& run : _data.runs())
+    {
+        used.at(run.value) = true;
+    }
+}
+
+// Routine Description:
+// - Translates the handles of this row after TextAttributeTable::Compact().
+// - The attributes themselves don't change and neither does the revision.
+// Arguments:
+// - remap - the new handle for each old one.
+// Return Value:
+// - <none>
+void ATTR_ROW::_Remap(const std::vector<handle_type>& remap)
+{
+    std::vector<til::rle_pair<handle_type, uint16_t>> runs;
+    runs.reserve(_data.runs().size());
+    for (const auto& run : _data.runs())
+    {
+        runs.emplace_back(remap.at(run.value), run.length);
+    }
+    _data.replace(0, _data.size(), gsl::span<const til::rle_pair<handle_type, uint16_t>>{ runs });
 }
 
 ATTR_ROW::const_iterator ATTR_ROW::begin() const noexcept
 {
-    return _data.begin();
+    return { _data.begin(), _table };
 }
 
 ATTR_ROW::const_iterator ATTR_ROW::end() const noexcept
 {
-    return _data.end();
+    return { _data.end(), _table };
 }
 
 ATTR_ROW::const_iterator ATTR_ROW::cbegin() const noexcept
 {
-    return _data.cbegin();
+    return { _data.cbegin(), _table };
 }
 
 ATTR_ROW::const_iterator ATTR_ROW::cend() const noexcept
 {
-    return _data.cend();
+    return { _data.cend(), _table };
 }
 
 bool operator==(const ATTR_ROW& a, const ATTR_ROW& b) noexcept
 {
-    return a._data == b._data;
+    if (a._table == b._table)
+    {
+        return a._data == b._data;
+    }
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
 }
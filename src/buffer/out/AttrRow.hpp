@@ -22,15 +22,98 @@ Revision History:
 
 #include "til/rle.h"
 #include "TextAttribute.hpp"
+#include "TextAttributeTable.hpp"
 
 class ATTR_ROW final
 {
-    using rle_vector = til::small_rle<TextAttribute, uint16_t, 1>;
+    using handle_type = TextAttributeTable::handle_type;
+    using rle_vector = til::small_rle<handle_type, uint16_t, 1>;
 
 public:
-    using const_iterator = rle_vector::const_iterator;
-
-    ATTR_ROW(uint16_t width, TextAttribute attr);
+    // Iterates over the attributes of the individual columns, just like the
+    // iterator of the underlying rle_vector does over the handles.
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = TextAttribute;
+        using pointer = const TextAttribute*;
+        using reference = const TextAttribute&;
+        using difference_type = rle_vector::const_iterator::difference_type;
+
+        const_iterator(rle_vector::const_iterator it, const TextAttributeTable* table) noexcept :
+            _it{ it },
+            _table{ table }
+        {
+        }
+
+        [[nodiscard]] reference operator*() const noexcept { return _table->Get(*_it); }
+        [[nodiscard]] pointer operator->() const noexcept { return &operator*(); }
+        [[nodiscard]] reference operator[](const difference_type offset) const noexcept { return *operator+(offset); }
+
+        const_iterator& operator++() noexcept
+        {
+            ++_it;
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept
+        {
+            auto tmp = *this;
+            ++_it;
+            return tmp;
+        }
+
+        const_iterator& operator--() noexcept
+        {
+            --_it;
+            return *this;
+        }
+
+        const_iterator operator--(int) noexcept
+        {
+            auto tmp = *this;
+            --_it;
+            return tmp;
+        }
+
+        const_iterator& operator+=(const difference_type offset) noexcept
+        {
+            _it += offset;
+            return *this;
+        }
+
+        const_iterator& operator-=(const difference_type offset) noexcept
+        {
+            _it -= offset;
+            return *this;
+        }
+
+        [[nodiscard]] const_iterator operator+(const difference_type offset) const noexcept { return { _it + offset, _table }; }
+        [[nodiscard]] const_iterator operator-(const difference_type offset) const noexcept { return { _it - offset, _table }; }
+        [[nodiscard]] difference_type operator-(const const_iterator& right) const noexcept { return _it - right._it; }
+
+        [[nodiscard]] bool operator==(const const_iterator& right) const noexcept { return _it == right._it; }
+        [[nodiscard]] bool operator!=(const const_iterator& right) const noexcept { return _it != right._it; }
+        [[nodiscard]] bool operator<(const const_iterator& right) const noexcept { return _it < right._it; }
+        [[nodiscard]] bool operator>(const const_iterator& right) const noexcept { return _it > right._it; }
+        [[nodiscard]] bool operator<=(const const_iterator& right) const noexcept { return _it <= right._it; }
+        [[nodiscard]] bool operator>=(const const_iterator& right) const noexcept { return _it >= right._it; }
+
+    private:
+        rle_vector::const_iterator _it;
+        const TextAttributeTable* _table;
+    };
+
+    // A range of columns [beginIndex, endIndex) and the attribute to fill it with.
+    struct Replacement
+    {
+        uint16_t beginIndex;
+        uint16_t endIndex;
+        TextAttribute attr;
+    };
+
+    ATTR_ROW(uint16_t width, TextAttribute attr, TextAttributeTable& table);
 
     ~ATTR_ROW() = default;
 
@@ -47,6 +130,9 @@ public:
     void ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith);
     void Resize(uint16_t newWidth);
     void Replace(uint16_t beginIndex, uint16_t endIndex, const TextAttribute& newAttr);
+    void Replace(const gsl::span<const Replacement> replacements);
+
+    uint64_t GetRevision() const noexcept;
 
     const_iterator begin() const noexcept;
     const_iterator end() const noexcept;
@@ -56,11 +142,20 @@ public:
 
     friend bool operator==(const ATTR_ROW& a, const ATTR_ROW& b) noexcept;
     friend class ROW;
+    friend class TextBuffer;
 
 private:
     void Reset(const TextAttribute attr);
+    bool _IsFilledWith(const uint16_t beginIndex, const uint16_t endIndex, const handle_type handle) const noexcept;
+    void _CopyFrom(const ATTR_ROW& source, const uint16_t count);
+    void _MarkUsed(std::vector<bool>& used) const;
+    void _Remap(const std::vector<handle_type>& remap);
 
     rle_vector _data;
+    // The table the handles in _data refer to. Owned by the TextBuffer.
+    TextAttributeTable* _table;
+    // identifies the current attributes of the row, 0 if they were modified since they were last queried
+    mutable uint64_t _revision{ 0 };
 
 #ifdef UNIT_TESTING
     friend class CommonState;
@@ -11,16 +11,17 @@
 // - constructor
 // Arguments:
 // - rowWidth - the size (in wchar_t) of the char and attribute rows
-// - pParent - the parent ROW
 // Return Value:
 // - instantiated object
 // Note: will through if unable to allocate char/attribute buffers
 #pragma warning(push)
 #pragma warning(disable : 26447) // small_vector's constructor says it can throw but it should not given how we use it.  This suppresses this error for the AuditMode build.
-CharRow::CharRow(size_t rowWidth, ROW* const pParent) noexcept :
-    _data(rowWidth, value_type()),
-    _pParent{ FAIL_FAST_IF_NULL(pParent) }
+CharRow::CharRow(size_t rowWidth) noexcept :
+    _chars(rowWidth, UNICODE_SPACE),
+    _charOffsets(rowWidth + 1),
+    _dbcsAttrs(rowWidth)
 {
+    std::iota(_charOffsets.begin(), _charOffsets.end(), gsl::narrow_cast<offset_type>(0));
 }
 #pragma warning(pop)
 
@@ -32,7 +33,7 @@ CharRow::CharRow(size_t rowWidth, ROW* const pParent) noexcept :
 // - the size of the row
 size_t CharRow::size() const noexcept
 {
-    return _data.size();
+    return _dbcsAttrs.size();
 }
 
 // Routine Description:
@@ -43,10 +44,12 @@ size_t CharRow::size() const noexcept
 // - <none>
 void CharRow::Reset() noexcept
 {
-    for (auto& cell : _data)
-    {
-        cell.Reset();
-    }
+    const auto width = size();
+    _revision = 0;
+    // Shrinking to a smaller size (or keeping the current one) never reallocates.
+    _chars.assign(width, UNICODE_SPACE);
+    std::iota(_charOffsets.begin(), _charOffsets.end(), gsl::narrow_cast<offset_type>(0));
+    std::fill(_dbcsAttrs.begin(), _dbcsAttrs.end(), DbcsAttribute{});
 }
 
 // Routine Description:
@@ -59,34 +62,32 @@ void CharRow::Reset() noexcept
 {
     try
     {
-        const value_type insertVals;
-        _data.resize(newSize, insertVals);
+        _revision = 0;
+        const auto oldSize = size();
+        if (newSize < oldSize)
+        {
+            // Cut off the text of all glyphs beyond the new width.
+            _chars.resize(til::at(_charOffsets, newSize));
+            _charOffsets.resize(newSize + 1);
+        }
+        else
+        {
+            // Append a space for each new column.
+            auto offset = gsl::narrow<offset_type>(_chars.size());
+            _chars.resize(_chars.size() + newSize - oldSize, UNICODE_SPACE);
+            _charOffsets.resize(newSize + 1);
+            for (auto column = oldSize + 1; column <= newSize; ++column)
+            {
+                til::at(_charOffsets, column) = ++offset;
+            }
+        }
+        _dbcsAttrs.resize(newSize);
     }
     CATCH_RETURN();
 
     return S_OK;
 }
 
-typename CharRow::iterator CharRow::begin() noexcept
-{
-    return _data.begin();
-}
-
-typename CharRow::const_iterator CharRow::cbegin() const noexcept
-{
-    return _data.cbegin();
-}
-
-typename CharRow::iterator CharRow::end() noexcept
-{
-    return _data.end();
-}
-
-typename CharRow::const_iterator CharRow::cend() const noexcept
-{
-    return _data.cend();
-}
-
 // Routine Description:
 // - Inspects the current internal string to find the left edge of it
 // Arguments:
@@ -95,12 +96,12 @@ typename CharRow::const_iterator CharRow::cend() const noexcept
 // - The calculated left boundary of the internal string.
 size_t CharRow::MeasureLeft() const noexcept
 {
-    const_iterator it = _data.cbegin();
-    while (it != _data.cend() && it->IsSpace())
+    size_t column = 0;
+    while (column < size() && _IsSpaceAt(column))
     {
-        ++it;
+        ++column;
     }
-    return it - _data.cbegin();
+    return column;
 }
 
 // Routine Description:
@@ -109,37 +110,126 @@ size_t CharRow::MeasureLeft() const noexcept
 // - <none>
 // Return Value:
 // - The calculated right boundary of the internal string.
-size_t CharRow::MeasureRight() const
+size_t CharRow::MeasureRight() const noexcept
 {
-    const_reverse_iterator it = _data.crbegin();
-    while (it != _data.crend() && it->IsSpace())
+    auto column = size();
+    while (column > 0 && _IsSpaceAt(column - 1))
     {
-        ++it;
+        --column;
     }
-    return _data.crend() - it;
+    return column;
 }
 
 void CharRow::ClearCell(const size_t column)
 {
-    _data.at(column).Reset();
+    _ReplaceGlyph(column, { &UNICODE_SPACE, 1 });
+    _dbcsAttrs.at(column).Reset();
 }
 
 // Routine Description:
-// - Tells you whether or not this row contains any valid text.
+// - replaces the first count columns of this row with those of another row,
+//   moving the glyphs as one block instead of assigning them one by one.
+// - The caller is responsible for not splitting a wide glyph at column count.
 // Arguments:
+// - source - the row to copy the glyphs and double byte attributes from
+// - count - the number of columns to copy
+// Return Value:
 // - <none>
+// Note: will throw exception if count exceeds the size of either row
+void CharRow::CopyCellsFrom(const CharRow& source, const size_t count)
+{
+    THROW_HR_IF(E_INVALIDARG, count > size() || count > source.size());
+
+    const size_t oldEnd = til::at(_charOffsets, count);
+    const size_t newEnd = til::at(source._charOffsets, count);
+    THROW_HR_IF(E_OUTOFMEMORY, _chars.size() - oldEnd + newEnd > std::numeric_limits<offset_type>::max());
+
+    _revision = 0;
+
+    _chars.erase(_chars.begin(), _chars.begin() + oldEnd);
+    _chars.insert(_chars.begin(), source._chars.begin(), source._chars.begin() + newEnd);
+
+    // See _ReplaceGlyph(): wrap-around arithmetic works for shrinking text, too.
+    const auto delta = gsl::narrow_cast<offset_type>(newEnd - oldEnd);
+    std::copy(source._charOffsets.begin(), source._charOffsets.begin() + count, _charOffsets.begin());
+    for (auto it = _charOffsets.begin() + count; it != _charOffsets.end(); ++it)
+    {
+        *it = gsl::narrow_cast<offset_type>(*it + delta);
+    }
+
+    std::copy(source._dbcsAttrs.begin(), source._dbcsAttrs.begin() + count, _dbcsAttrs.begin());
+}
+
+// Routine Description:
+// - replaces a range of columns with glyphs of a single code unit each, moving
+//   the text of the following columns at most once instead of once per column.
+// - Rewriting the columns with what they already contain doesn't count as a modification.
+// Arguments:
+// - column - the first column to replace
+// - chars - the new glyphs, one per column
+// - dbcsAttrs - the new double byte attributes, one per column
 // Return Value:
-// - True if there is valid text in this row. False otherwise.
-bool CharRow::ContainsText() const noexcept
+// - <none>
+// Note: will throw exception if the columns are out of bounds or the sizes don't match
+void CharRow::ReplaceCells(const size_t column, const std::wstring_view chars, const gsl::span<const DbcsAttribute> dbcsAttrs)
 {
-    for (const value_type& cell : _data)
+    const auto count = chars.size();
+    THROW_HR_IF(E_INVALIDARG, column > size() || count > size() - column || dbcsAttrs.size() != count);
+
+    const size_t begin = til::at(_charOffsets, column);
+    const size_t end = til::at(_charOffsets, column + count);
+    const auto attrsBegin = _dbcsAttrs.begin() + column;
+
+    if (end - begin == count &&
+        std::equal(chars.cbegin(), chars.cend(), _chars.begin() + begin) &&
+        std::equal(dbcsAttrs.begin(), dbcsAttrs.end(), attrsBegin))
+    {
+        return;
+    }
+
+    const auto oldLength = end - begin;
+    THROW_HR_IF(E_OUTOFMEMORY, _chars.size() - oldLength + count > std::numeric_limits<offset_type>::max());
+
+    _revision = 0;
+
+    if (count != oldLength)
     {
-        if (!cell.IsSpace())
+        if (count > oldLength)
         {
-            return true;
+            _chars.insert(_chars.begin() + end, count - oldLength, UNICODE_SPACE);
         }
+        else
+        {
+            _chars.erase(_chars.begin() + begin + count, _chars.begin() + end);
+        }
+
+        // See _ReplaceGlyph(): wrap-around arithmetic works for shrinking text, too.
+        const auto delta = gsl::narrow_cast<offset_type>(count - oldLength);
+        for (auto it = _charOffsets.begin() + column + count; it != _charOffsets.end(); ++it)
+        {
+            *it = gsl::narrow_cast<offset_type>(*it + delta);
+        }
+    }
+
+    std::copy(chars.cbegin(), chars.cend(), _chars.begin() + begin);
+    for (size_t i = 0; i < count; ++i)
+    {
+        til::at(_charOffsets, column + i) = gsl::narrow_cast<offset_type>(begin + i);
     }
-    return false;
+    std::copy(dbcsAttrs.begin(), dbcsAttrs.end(), attrsBegin);
+}
+
+// Routine Description:
+// - Tells you whether or not this row contains any valid text.
+// Arguments:
+// - <none>
+// Return Value:
+// - True if there is valid text in this row. False otherwise.
+bool CharRow::ContainsText() const noexcept
+{
+    // Any glyph longer than a single code unit can't be a space.
+    return _chars.size() != size() ||
+           std::any_of(_chars.cbegin(), _chars.cend(), [](const auto wch) { return wch != UNICODE_SPACE; });
 }
 
 // Routine Description:
@@ -151,7 +241,7 @@ bool CharRow::ContainsText() const noexcept
 // Note: will throw exception if column is out of bounds
 const DbcsAttribute& CharRow::DbcsAttrAt(const size_t column) const
 {
-    return _data.at(column).DbcsAttr();
+    return _dbcsAttrs.at(column);
 }
 
 // Routine Description:
@@ -161,9 +251,73 @@ const DbcsAttribute& CharRow::DbcsAttrAt(const size_t column) const
 // Return Value:
 // - the attribute
 // Note: will throw exception if column is out of bounds
+// Note: modifying the attribute through the reference doesn't change the
+//       revision of the row. Use SetDbcsAttrAt() for that.
 DbcsAttribute& CharRow::DbcsAttrAt(const size_t column)
 {
-    return _data.at(column).DbcsAttr();
+    return _dbcsAttrs.at(column);
+}
+
+// Routine Description:
+// - sets the attribute at the specified column
+// Arguments:
+// - column - the column to set the attribute for
+// - attr - the new attribute
+// Return Value:
+// - <none>
+// Note: will throw exception if column is out of bounds
+void CharRow::SetDbcsAttrAt(const size_t column, const DbcsAttribute attr)
+{
+    auto& current = _dbcsAttrs.at(column);
+    if (!(current == attr))
+    {
+        current = attr;
+        _revision = 0;
+    }
+}
+
+// Routine Description:
+// - Gets a number identifying the current contents of the row.
+// - Revisions are unique across all rows. If two calls return the same
+//   revision, the text of the row (or of the row it was copied from) hasn't
+//   changed in between. A new revision is only drawn once the row is queried,
+//   so that modifying the row doesn't cost more than a plain store.
+// Arguments:
+// - <none>
+// Return Value:
+// - the revision of the row's contents
+uint64_t CharRow::GetRevision() const noexcept
+{
+    static std::atomic<uint64_t> nextRevision{ 1 };
+    if (_revision == 0)
+    {
+        _revision = nextRevision.fetch_add(1, std::memory_order_relaxed);
+    }
+    return _revision;
+}
+
+// Routine Description:
+// - Gets the text of all columns back to back. The glyph of a wide character
+//   is contained twice, once for its leading and once for its trailing column.
+// Arguments:
+// - <none>
+// Return Value:
+// - a view into the row's text, valid until the row is modified
+std::wstring_view CharRow::GlyphData() const noexcept
+{
+    return { _chars.data(), _chars.size() };
+}
+
+// Routine Description:
+// - Gets the offset of each column's glyph into GlyphData(),
+//   followed by a final entry holding the length of GlyphData().
+// Arguments:
+// - <none>
+// Return Value:
+// - size() + 1 offsets, valid until the row is modified
+gsl::span<const CharRow::offset_type> CharRow::GlyphOffsets() const noexcept
+{
+    return { _charOffsets.data(), _charOffsets.size() };
 }
 
 // Routine Description:
@@ -175,7 +329,8 @@ DbcsAttribute& CharRow::DbcsAttrAt(const size_t column)
 // Note: will throw exception if column is out of bounds
 void CharRow::ClearGlyph(const size_t column)
 {
-    _data.at(column).EraseChars();
+    THROW_HR_IF(E_INVALIDARG, column >= size());
+    _ReplaceGlyph(column, { &UNICODE_SPACE, 1 });
 }
 
 // Routine Description:
@@ -187,7 +342,7 @@ void CharRow::ClearGlyph(const size_t column)
 // - Note: will throw exception if column is out of bounds
 const CharRow::reference CharRow::GlyphAt(const size_t column) const
 {
-    THROW_HR_IF(E_INVALIDARG, column >= _data.size());
+    THROW_HR_IF(E_INVALIDARG, column >= size());
     return { const_cast<CharRow&>(*this), column };
 }
 
@@ -200,24 +355,26 @@ const CharRow::reference CharRow::GlyphAt(const size_t column) const
 // - Note: will throw exception if column is out of bounds
 CharRow::reference CharRow::GlyphAt(const size_t column)
 {
-    THROW_HR_IF(E_INVALIDARG, column >= _data.size());
+    THROW_HR_IF(E_INVALIDARG, column >= size());
     return { *this, column };
 }
 
 std::wstring CharRow::GetText() const
 {
+    // Fast path: without any wide glyphs the row's text is already what we need.
+    if (std::none_of(_dbcsAttrs.cbegin(), _dbcsAttrs.cend(), [](const auto& attr) { return attr.IsTrailing(); }))
+    {
+        return { _chars.data(), _chars.size() };
+    }
+
     std::wstring wstr;
-    wstr.reserve(_data.size());
+    wstr.reserve(_chars.size());
 
-    for (size_t i = 0; i < _data.size(); ++i)
+    for (size_t i = 0; i < size(); ++i)
     {
-        const auto glyph = GlyphAt(i);
-        if (!DbcsAttrAt(i).IsTrailing())
+        if (!til::at(_dbcsAttrs, i).IsTrailing())
         {
-            for (const auto wch : glyph)
-            {
-                wstr.push_back(wch);
-            }
+            wstr.append(_GlyphAt(i));
         }
     }
     return wstr;
@@ -233,9 +390,9 @@ std::wstring CharRow::GetText() const
 // - the delimiter class for the given char
 const DelimiterClass CharRow::DelimiterClassAt(const size_t column, const std::wstring_view wordDelimiters) const
 {
-    THROW_HR_IF(E_INVALIDARG, column >= _data.size());
+    THROW_HR_IF(E_INVALIDARG, column >= size());
 
-    const auto glyph = *GlyphAt(column).begin();
+    const auto glyph = _GlyphAt(column).front();
     if (glyph <= UNICODE_SPACE)
     {
         return DelimiterClass::ControlChar;
@@ -250,32 +407,85 @@ const DelimiterClass CharRow::DelimiterClassAt(const size_t column, const std::w
     }
 }
 
-UnicodeStorage& CharRow::GetUnicodeStorage() noexcept
-{
-    return _pParent->GetUnicodeStorage();
-}
-
-const UnicodeStorage& CharRow::GetUnicodeStorage() const noexcept
+// Routine Description:
+// - returns the text of the glyph at the given column, without bounds checks
+// Arguments:
+// - column - the column to get the glyph of
+// Return Value:
+// - a view into the row's text, valid until the row is modified
+std::wstring_view CharRow::_GlyphAt(const size_t column) const noexcept
 {
-    return _pParent->GetUnicodeStorage();
+    const size_t begin = til::at(_charOffsets, column);
+    const size_t end = til::at(_charOffsets, column + 1);
+#pragma warning(suppress : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+    return { _chars.data() + begin, end - begin };
 }
 
 // Routine Description:
-// - calculates the key used by the given column of the char row to store glyph data in UnicodeStorage
+// - checks if the given column contains a single space, without bounds checks
 // Arguments:
-// - column - the column to generate the key for
+// - column - the column to check
 // Return Value:
-// - the COORD key for data access from UnicodeStorage for the column
-COORD CharRow::GetStorageKey(const size_t column) const noexcept
+// - true if the glyph at column is a space, false otherwise
+bool CharRow::_IsSpaceAt(const size_t column) const noexcept
 {
-    return { gsl::narrow<SHORT>(column), _pParent->GetId() };
+    const size_t begin = til::at(_charOffsets, column);
+    const size_t end = til::at(_charOffsets, column + 1);
+    return end - begin == 1 && til::at(_chars, begin) == UNICODE_SPACE;
 }
 
 // Routine Description:
-// - Updates the pointer to the parent row (which might change if we shuffle the rows around)
+// - replaces the glyph at the given column. If the new glyph's length differs from the old one,
+//   the text of all following columns is moved and their offsets are adjusted.
 // Arguments:
-// - pParent - Pointer to the parent row
-void CharRow::UpdateParent(ROW* const pParent)
+// - column - the column to replace the glyph of
+// - chars - the new glyph
+// Note: will throw exception if column is out of bounds or chars is empty
+void CharRow::_ReplaceGlyph(const size_t column, std::wstring_view chars)
 {
-    _pParent = FAIL_FAST_IF_NULL(pParent);
+    THROW_HR_IF(E_INVALIDARG, chars.empty());
+    THROW_HR_IF(E_INVALIDARG, column >= size());
+
+    // Rewriting a glyph with itself doesn't count as a modification, so that
+    // applications redrawing unchanged text don't cause the row to be repainted.
+    if (_GlyphAt(column) == chars)
+    {
+        return;
+    }
+
+    _revision = 0;
+
+    const size_t begin = til::at(_charOffsets, column);
+    const size_t end = til::at(_charOffsets, column + 1);
+    const auto oldLength = end - begin;
+
+    if (chars.size() != oldLength)
+    {
+        // The offsets are only 16 bits wide. This can only ever overflow if
+        // someone writes absurdly long combining sequences into every column.
+        if (_chars.size() - oldLength + chars.size() > std::numeric_limits<offset_type>::max())
+        {
+            chars = { &UNICODE_REPLACEMENT, 1 };
+        }
+
+        const auto newLength = chars.size();
+        if (newLength > oldLength)
+        {
+            _chars.insert(_chars.begin() + end, newLength - oldLength, UNICODE_SPACE);
+        }
+        else
+        {
+            _chars.erase(_chars.begin() + begin + newLength, _chars.begin() + end);
+        }
+
+        // Offsets are unsigned, but wrap-around arithmetic still
+        // ends up with the right result if the glyph shrunk.
+        const auto delta = gsl::narrow_cast<offset_type>(newLength - oldLength);
+        for (auto it = _charOffsets.begin() + column + 1; it != _charOffsets.end(); ++it)
+        {
+            *it = gsl::narrow_cast<offset_type>(*it + delta);
+        }
+    }
+
+    std::copy(chars.cbegin(), chars.cend(), _chars.begin() + begin);
 }
@@ -22,10 +22,7 @@ Revision History:
 
 #include "DbcsAttribute.hpp"
 #include "CharRowCellReference.hpp"
-#include "CharRowCell.hpp"
-#include "UnicodeStorage.hpp"
-
-class ROW;
+#include "unicode.hpp"
 
 enum class DelimiterClass
 {
@@ -44,72 +41,68 @@ enum class DelimiterClass
 //       ^    ^                  ^                     ^
 //       |    |                  |                     |
 //     Chars Left               Right                end of Chars buffer
+//
+// The text of the row is stored as a single contiguous UTF-16 string. The glyph
+// of column i spans _chars[_charOffsets[i], _charOffsets[i + 1]), which allows
+// surrogate pairs and combining sequences to be stored inline with all other
+// text instead of in a buffer-global map. A row with only single code unit glyphs
+// thus has _chars.size() == size() and _charOffsets[i] == i.
 class CharRow final
 {
 public:
     using glyph_type = typename wchar_t;
-    using value_type = typename CharRowCell;
-    using iterator = typename boost::container::small_vector_base<value_type>::iterator;
-    using const_iterator = typename boost::container::small_vector_base<value_type>::const_iterator;
-    using const_reverse_iterator = typename boost::container::small_vector_base<value_type>::const_reverse_iterator;
+    using offset_type = typename uint16_t;
     using reference = typename CharRowCellReference;
 
-    CharRow(size_t rowWidth, ROW* const pParent) noexcept;
+    CharRow(size_t rowWidth) noexcept;
 
     size_t size() const noexcept;
     [[nodiscard]] HRESULT Resize(const size_t newSize) noexcept;
     size_t MeasureLeft() const noexcept;
-    size_t MeasureRight() const;
+    size_t MeasureRight() const noexcept;
     bool ContainsText() const noexcept;
     const DbcsAttribute& DbcsAttrAt(const size_t column) const;
     DbcsAttribute& DbcsAttrAt(const size_t column);
+    void SetDbcsAttrAt(const size_t column, const DbcsAttribute attr);
     void ClearGlyph(const size_t column);
 
     const DelimiterClass DelimiterClassAt(const size_t column, const std::wstring_view wordDelimiters) const;
 
+    uint64_t GetRevision() const noexcept;
+
+    // bulk access to the packed text, for consumers that scan whole rows at once
+    std::wstring_view GlyphData() const noexcept;
+    gsl::span<const offset_type> GlyphOffsets() const noexcept;
+
     // working with glyphs
     const reference GlyphAt(const size_t column) const;
     reference GlyphAt(const size_t column);
 
-    // iterators
-    iterator begin() noexcept;
-    const_iterator cbegin() const noexcept;
-    const_iterator begin() const noexcept { return cbegin(); }
-
-    iterator end() noexcept;
-    const_iterator cend() const noexcept;
-    const_iterator end() const noexcept { return cend(); }
-
-    UnicodeStorage& GetUnicodeStorage() noexcept;
-    const UnicodeStorage& GetUnicodeStorage() const noexcept;
-    COORD GetStorageKey(const size_t column) const noexcept;
-
-    void UpdateParent(ROW* const pParent);
-
     friend CharRowCellReference;
     friend class ROW;
 
+#ifdef UNIT_TESTING
+    friend class CharRowTests;
+#endif
+
 private:
     void Reset() noexcept;
     void ClearCell(const size_t column);
+    void CopyCellsFrom(const CharRow& source, const size_t count);
+    void ReplaceCells(const size_t column, const std::wstring_view chars, const gsl::span<const DbcsAttribute> dbcsAttrs);
     std::wstring GetText() const;
 
-protected:
-    // storage for glyph data and dbcs attributes
-    boost::container::small_vector<value_type, 120> _data;
+    std::wstring_view _GlyphAt(const size_t column) const noexcept;
+    void _ReplaceGlyph(const size_t column, const std::wstring_view chars);
+    bool _IsSpaceAt(const size_t column) const noexcept;
 
-    // ROW that this CharRow belongs to
-    ROW* _pParent;
+protected:
+    // the text of all glyphs in the row, back to back
+    boost::container::small_vector<glyph_type, 120> _chars;
+    // the offset of each column's glyph into _chars, plus a final entry for _chars.size()
+    boost::container::small_vector<offset_type, 121> _charOffsets;
+    // the double byte attribute of each column
+    boost::container::small_vector<DbcsAttribute, 120> _dbcsAttrs;
+    // identifies the current contents of the row, 0 if it was modified since it was last queried
+    mutable uint64_t _revision{ 0 };
 };
-
-template<typename InputIt1, typename InputIt2>
-void OverwriteColumns(InputIt1 startChars, InputIt1 endChars, InputIt2 startAttrs, CharRow::iterator outIt)
-{
-    std::transform(startChars,
-                   endChars,
-                   startAttrs,
-                   outIt,
-                   [](const wchar_t wch, const DbcsAttribute attr) {
-                       return CharRow::value_type{ wch, attr };
-                   });
-}
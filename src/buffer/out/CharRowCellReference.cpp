@@ -2,28 +2,15 @@
 // Licensed under the MIT license.
 
 #include "precomp.h"
-#include "UnicodeStorage.hpp"
 #include "CharRow.hpp"
 
 // Routine Description:
-// - assignment operator. will store extended glyph data in a separate storage location
+// - assignment operator. will store the glyph data in the parent row's text
 // Arguments:
 // - chars - the glyph data to store
 void CharRowCellReference::operator=(const std::wstring_view chars)
 {
-    THROW_HR_IF(E_INVALIDARG, chars.empty());
-    if (chars.size() == 1)
-    {
-        _cellData().Char() = chars.front();
-        _cellData().DbcsAttr().SetGlyphStored(false);
-    }
-    else
-    {
-        auto& storage = _parent.GetUnicodeStorage();
-        const auto key = _parent.GetStorageKey(_index);
-        storage.StoreGlyph(key, { chars.cbegin(), chars.cend() });
-        _cellData().DbcsAttr().SetGlyphStored(true);
-    }
+    _parent._ReplaceGlyph(_index, chars);
 }
 
 // Routine Description:
@@ -35,40 +22,14 @@ CharRowCellReference::operator std::wstring_view() const
     return _glyphData();
 }
 
-// Routine Description:
-// - The CharRowCell this object "references"
-// Return Value:
-// - ref to the CharRowCell
-CharRowCell& CharRowCellReference::_cellData()
-{
-    return _parent._data.at(_index);
-}
-
-// Routine Description:
-// - The CharRowCell this object "references"
-// Return Value:
-// - ref to the CharRowCell
-const CharRowCell& CharRowCellReference::_cellData() const
-{
-    return _parent._data.at(_index);
-}
-
 // Routine Description:
 // - the glyph data of the referenced cell
 // Return Value:
 // - the glyph data
 std::wstring_view CharRowCellReference::_glyphData() const
 {
-    if (_cellData().DbcsAttr().IsGlyphStored())
-    {
-        const auto& text = _parent.GetUnicodeStorage().GetText(_parent.GetStorageKey(_index));
-
-        return { text.data(), text.size() };
-    }
-    else
-    {
-        return { &_cellData().Char(), 1 };
-    }
+    THROW_HR_IF(E_INVALIDARG, _index >= _parent.size());
+    return _parent._GlyphAt(_index);
 }
 
 // Routine Description:
@@ -77,14 +38,7 @@ std::wstring_view CharRowCellReference::_glyphData() const
 // - iterator of the glyph data
 CharRowCellReference::const_iterator CharRowCellReference::begin() const
 {
-    if (_cellData().DbcsAttr().IsGlyphStored())
-    {
-        return _parent.GetUnicodeStorage().GetText(_parent.GetStorageKey(_index)).data();
-    }
-    else
-    {
-        return &_cellData().Char();
-    }
+    return _glyphData().data();
 }
 
 // Routine Description:
@@ -96,38 +50,15 @@ CharRowCellReference::const_iterator CharRowCellReference::begin() const
 // TODO GH 2672: eliminate using pointers raw as begin/end markers in this class
 CharRowCellReference::const_iterator CharRowCellReference::end() const
 {
-    if (_cellData().DbcsAttr().IsGlyphStored())
-    {
-        const auto& chars = _parent.GetUnicodeStorage().GetText(_parent.GetStorageKey(_index));
-        return chars.data() + chars.size();
-    }
-    else
-    {
-        return &_cellData().Char() + 1;
-    }
+    const auto glyph = _glyphData();
+    return glyph.data() + glyph.size();
 }
 #pragma warning(pop)
 
 bool operator==(const CharRowCellReference& ref, const std::vector<wchar_t>& glyph)
 {
-    const DbcsAttribute& dbcsAttr = ref._cellData().DbcsAttr();
-    if (glyph.size() == 1 && dbcsAttr.IsGlyphStored())
-    {
-        return false;
-    }
-    else if (glyph.size() > 1 && !dbcsAttr.IsGlyphStored())
-    {
-        return false;
-    }
-    else if (glyph.size() == 1 && !dbcsAttr.IsGlyphStored())
-    {
-        return ref._cellData().Char() == glyph.front();
-    }
-    else
-    {
-        const auto& chars = ref._parent.GetUnicodeStorage().GetText(ref._parent.GetStorageKey(ref._index));
-        return chars == glyph;
-    }
+    const auto chars = ref._glyphData();
+    return std::equal(chars.cbegin(), chars.cend(), glyph.cbegin(), glyph.cend());
 }
 
 bool operator==(const std::vector<wchar_t>& glyph, const CharRowCellReference& ref)
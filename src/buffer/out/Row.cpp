@@ -14,13 +14,14 @@
 // - rowWidth - the width of the row, cell elements
 // - fillAttribute - the default text attribute
 // - pParent - the text buffer that this row belongs to
+// - attributes - the table the attributes of this row are interned in
 // Return Value:
 // - constructed object
-ROW::ROW(const SHORT rowId, const unsigned short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent) :
+ROW::ROW(const SHORT rowId, const unsigned short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent, TextAttributeTable& attributes) :
     _id{ rowId },
     _rowWidth{ rowWidth },
-    _charRow{ rowWidth, this },
-    _attrRow{ rowWidth, fillAttribute },
+    _charRow{ rowWidth },
+    _attrRow{ rowWidth, fillAttribute, attributes },
     _lineRendition{ LineRendition::SingleWidth },
     _wrapForced{ false },
     _doubleBytePadded{ false },
@@ -84,14 +85,24 @@ void ROW::ClearColumn(const size_t column)
     _charRow.ClearCell(column);
 }
 
-UnicodeStorage& ROW::GetUnicodeStorage() noexcept
+// Routine Description:
+// - copies the text and attributes of the first columns of another row,
+//   which is a lot cheaper than writing them cell by cell.
+// - Line rendition and wrap flags are left untouched.
+// Arguments:
+// - source - the row to copy from. May have a different width than this one.
+// - count - the number of columns to copy
+// Return Value:
+// - <none>
+void ROW::CopyCellsFrom(const ROW& source, const size_t count)
 {
-    return _pParent->GetUnicodeStorage();
-}
+    if (count == 0)
+    {
+        return;
+    }
 
-const UnicodeStorage& ROW::GetUnicodeStorage() const noexcept
-{
-    return _pParent->GetUnicodeStorage();
+    _charRow.CopyCellsFrom(source._charRow, count);
+    _attrRow._CopyFrom(source._attrRow, gsl::narrow<uint16_t>(count));
 }
 
 // Routine Description:
@@ -116,6 +127,9 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const size_t index, co
     uint16_t colorStarts = gsl::narrow_cast<uint16_t>(index);
     uint16_t currentIndex = colorStarts;
 
+    // The color runs are collected and committed into the attr row all at once.
+    boost::container::small_vector<ATTR_ROW::Replacement, 8> colorRuns;
+
     while (it && currentIndex <= finalColumnInRow)
     {
         // Fill the color if the behavior isn't set to keeping the current color.
@@ -130,8 +144,7 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const size_t index, co
             else
             {
                 // Otherwise, commit this color into the run and save off the new one.
-                // Now commit the new color runs into the attr row.
-                _attrRow.Replace(colorStarts, currentIndex, currentColor);
+                colorRuns.push_back({ colorStarts, currentIndex, currentColor });
                 currentColor = it->TextAttr();
                 colorUses = 1;
                 colorStarts = currentIndex;
@@ -163,7 +176,7 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const size_t index, co
             // Otherwise, copy the data given and increment the iterator.
             else
             {
-                _charRow.DbcsAttrAt(currentIndex) = it->DbcsAttr();
+                _charRow.SetDbcsAttrAt(currentIndex, it->DbcsAttr());
                 _charRow.GlyphAt(currentIndex) = it->Chars();
                 ++it;
             }
@@ -188,11 +201,128 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const size_t index, co
         ++currentIndex;
     }
 
-    // Now commit the final color into the attr row
+    // Now commit the final color and all the others into the attr row
     if (colorUses)
     {
-        _attrRow.Replace(colorStarts, currentIndex, currentColor);
+        colorRuns.push_back({ colorStarts, currentIndex, currentColor });
     }
+    _attrRow.Replace({ colorRuns.data(), colorRuns.size() });
 
     return it;
 }
+
+// Routine Description:
+// - writes a run of CHAR_INFOs to the row, like WriteCells() does with an iterator over
+//   them and wrap set to true, but replaces the text in one go and builds every
+//   attribute only once per run of cells that share it.
+// - The double byte padding WriteCells() applies to a trailing byte at the start or a
+//   leading byte at the end of the row isn't supported. Nothing is written in that case.
+// Arguments:
+// - charInfos - the cells to write
+// - index - column in row to start writing at
+// Return Value:
+// - true if the cells were written, false if the caller needs to use WriteCells() instead.
+bool ROW::WriteCharInfos(const gsl::span<const CHAR_INFO> charInfos, const size_t index)
+{
+    const auto count = gsl::narrow_cast<size_t>(charInfos.size());
+    THROW_HR_IF(E_INVALIDARG, index >= _charRow.size() || count > _charRow.size() - index);
+
+    if (count == 0)
+    {
+        return true;
+    }
+
+    const auto fillingLastColumn = index + count == _charRow.size();
+    const auto firstAttributes = til::at(charInfos, 0).Attributes;
+    const auto lastAttributes = til::at(charInfos, count - 1).Attributes;
+    if ((index == 0 && WI_IsFlagSet(firstAttributes, COMMON_LVB_TRAILING_BYTE) && WI_IsFlagClear(firstAttributes, COMMON_LVB_LEADING_BYTE)) ||
+        (fillingLastColumn && WI_IsFlagSet(lastAttributes, COMMON_LVB_LEADING_BYTE)))
+    {
+        return false;
+    }
+
+    boost::container::small_vector<wchar_t, 120> chars;
+    boost::container::small_vector<DbcsAttribute, 120> dbcsAttrs;
+    chars.reserve(count);
+    dbcsAttrs.reserve(count);
+
+    for (const auto& charInfo : charInfos)
+    {
+        // This matches OutputCellIterator::s_GenerateView(const CHAR_INFO&).
+        DbcsAttribute dbcsAttr;
+        if (WI_IsFlagSet(charInfo.Attributes, COMMON_LVB_LEADING_BYTE))
+        {
+            dbcsAttr.SetLeading();
+        }
+        else if (WI_IsFlagSet(charInfo.Attributes, COMMON_LVB_TRAILING_BYTE))
+        {
+            dbcsAttr.SetTrailing();
+        }
+
+        chars.push_back(charInfo.Char.UnicodeChar);
+        dbcsAttrs.push_back(dbcsAttr);
+    }
+
+    _charRow.ReplaceCells(index, { chars.data(), chars.size() }, { dbcsAttrs.data(), dbcsAttrs.size() });
+
+    // TextAttribute(WORD) ignores the double byte flags, so they don't break up a run.
+    const auto legacyAttributes = [](const CHAR_INFO& charInfo) noexcept {
+        return gsl::narrow_cast<WORD>(charInfo.Attributes & ~COMMON_LVB_SBCSDBCS);
+    };
+
+    boost::container::small_vector<ATTR_ROW::Replacement, 8> runs;
+    size_t runStart = 0;
+    while (runStart < count)
+    {
+        const auto attributes = legacyAttributes(til::at(charInfos, runStart));
+        auto runEnd = runStart + 1;
+        while (runEnd < count && legacyAttributes(til::at(charInfos, runEnd)) == attributes)
+        {
+            ++runEnd;
+        }
+
+        runs.push_back({ gsl::narrow_cast<uint16_t>(index + runStart), gsl::narrow_cast<uint16_t>(index + runEnd), TextAttribute{ attributes } });
+        runStart = runEnd;
+    }
+    _attrRow.Replace({ runs.data(), runs.size() });
+
+    if (fillingLastColumn)
+    {
+        SetWrapForced(true);
+    }
+
+    return true;
+}
+
+// Routine Description:
+// - reads a run of cells from the row as CHAR_INFOs, the way the legacy console APIs return them.
+// - The legacy attributes are only computed once per attribute the cells share.
+// Arguments:
+// - charInfos - receives the cells, one per column
+// - index - column in row to start reading at
+// Return Value:
+// - <none>
+void ROW::ReadCharInfos(const gsl::span<CHAR_INFO> charInfos, const size_t index) const
+{
+    const auto count = gsl::narrow_cast<size_t>(charInfos.size());
+    THROW_HR_IF(E_INVALIDARG, index > _charRow.size() || count > _charRow.size() - index);
+
+    auto attrIt = _attrRow.cbegin() + index;
+    const TextAttribute* lastAttr = nullptr;
+    WORD lastLegacyAttributes = 0;
+
+    for (size_t i = 0; i < count; ++i, ++attrIt)
+    {
+        const auto column = index + i;
+        const auto& attr = *attrIt;
+        if (&attr != lastAttr)
+        {
+            lastAttr = &attr;
+            lastLegacyAttributes = attr.GetLegacyAttributes();
+        }
+
+        auto& charInfo = til::at(charInfos, i);
+        charInfo.Char.UnicodeChar = Utf16ToUcs2(_charRow._GlyphAt(column));
+        charInfo.Attributes = lastLegacyAttributes | _charRow.DbcsAttrAt(column).GeneratePublicApiAttributeFormat();
+    }
+}
@@ -25,14 +25,33 @@ Revision History:
 #include "OutputCell.hpp"
 #include "OutputCellIterator.hpp"
 #include "CharRow.hpp"
-#include "UnicodeStorage.hpp"
 
 class TextBuffer;
 
+// Identifies everything about a row that affects how it's rendered.
+// Two equal revisions mean that the row's contents didn't change in between.
+struct RowRevision
+{
+    uint64_t text{ 0 };
+    uint64_t attributes{ 0 };
+    LineRendition lineRendition{ LineRendition::SingleWidth };
+    bool wrapForced{ false };
+};
+
+constexpr bool operator==(const RowRevision& a, const RowRevision& b) noexcept
+{
+    return a.text == b.text && a.attributes == b.attributes && a.lineRendition == b.lineRendition && a.wrapForced == b.wrapForced;
+}
+
+constexpr bool operator!=(const RowRevision& a, const RowRevision& b) noexcept
+{
+    return !(a == b);
+}
+
 class ROW final
 {
 public:
-    ROW(const SHORT rowId, const unsigned short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent);
+    ROW(const SHORT rowId, const unsigned short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent, TextAttributeTable& attributes);
 
     size_t size() const noexcept { return _rowWidth; }
 
@@ -51,6 +70,8 @@ public:
     LineRendition GetLineRendition() const noexcept { return _lineRendition; }
     void SetLineRendition(const LineRendition lineRendition) noexcept { _lineRendition = lineRendition; }
 
+    RowRevision GetRevision() const noexcept { return { _charRow.GetRevision(), _attrRow.GetRevision(), _lineRendition, _wrapForced }; }
+
     SHORT GetId() const noexcept { return _id; }
     void SetId(const SHORT id) noexcept { _id = id; }
 
@@ -58,12 +79,12 @@ public:
     [[nodiscard]] HRESULT Resize(const unsigned short width);
 
     void ClearColumn(const size_t column);
+    void CopyCellsFrom(const ROW& source, const size_t count);
     std::wstring GetText() const { return _charRow.GetText(); }
 
-    UnicodeStorage& GetUnicodeStorage() noexcept;
-    const UnicodeStorage& GetUnicodeStorage() const noexcept;
-
     OutputCellIterator WriteCells(OutputCellIterator it, const size_t index, const std::optional<bool> wrap = std::nullopt, std::optional<size_t> limitRight = std::nullopt);
+    bool WriteCharInfos(const gsl::span<const CHAR_INFO> charInfos, const size_t index);
+    void ReadCharInfos(const gsl::span<CHAR_INFO> charInfos, const size_t index) const;
 
 #ifdef UNIT_TESTING
     friend constexpr bool operator==(const ROW& a, const ROW& b) noexcept;
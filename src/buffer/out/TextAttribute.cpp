@@ -399,6 +399,23 @@ bool TextAttribute::BackgroundIsDefault() const noexcept
     return _background.IsDefault();
 }
 
+// Routine Description:
+// - Computes a hash over all members that operator== compares.
+// Return value:
+// - The hash, suitable for std::unordered_map.
+size_t TextAttribute::Hash() const noexcept
+{
+    // A TextColor consists of exactly 4 bytes without any padding.
+    uint32_t foreground;
+    uint32_t background;
+    memcpy(&foreground, &_foreground, sizeof(foreground));
+    memcpy(&background, &_background, sizeof(background));
+
+    const auto meta = uint64_t{ _wAttrLegacy } | uint64_t{ _hyperlinkId } << 16 | uint64_t{ static_cast<BYTE>(_extendedAttrs) } << 32;
+    const auto colors = uint64_t{ foreground } | uint64_t{ background } << 32;
+    return std::hash<uint64_t>{}(meta ^ colors * 0x9E3779B97F4A7C15);
+}
+
 // Routine Description:
 // - Resets the meta and extended attributes, which is what the VT standard
 //      requires for most erasing and filling operations.
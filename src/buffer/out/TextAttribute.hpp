@@ -137,6 +137,8 @@ public:
 
     bool BackgroundIsDefault() const noexcept;
 
+    size_t Hash() const noexcept;
+
     void SetStandardErase() noexcept;
 
     // This returns whether this attribute, if printed directly next to another attribute, for the space
@@ -0,0 +1,163 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "TextAttributeTable.hpp"
+
+// Compacting a table that is mostly in use would only ever free a few handles.
+// Start with 7/8 of all handles and back off from there.
+static constexpr size_t InitialCompactionThreshold = TextAttributeTable::MaxSize / 8 * 7;
+
+TextAttributeTable::TextAttributeTable() :
+    _attributes(1),
+    _compactionThreshold{ InitialCompactionThreshold }
+{
+    _handles.emplace(TextAttribute{}, gsl::narrow_cast<handle_type>(0));
+}
+
+// Routine Description:
+// - Gets the handle of the given attribute, adding it to the table if necessary.
+// Arguments:
+// - attr - the attribute to look up
+// Return Value:
+// - The handle of the attribute.
+// - Throws if the table is full and the attribute isn't part of it yet.
+TextAttributeTable::handle_type TextAttributeTable::Intern(const TextAttribute& attr)
+{
+    // The vast majority of cells use the default attributes.
+    if (attr == til::at(_attributes, 0))
+    {
+        return 0;
+    }
+
+    const auto it = _handles.find(attr);
+    if (it != _handles.end())
+    {
+        return it->second;
+    }
+
+    // Mapping the attribute to any other handle would silently change the colors of the text.
+    THROW_HR_IF_MSG(E_OUTOFMEMORY, _attributes.size() >= MaxSize, "All %zu attribute handles are in use", MaxSize);
+
+    const auto handle = gsl::narrow_cast<handle_type>(_attributes.size());
+    _attributes.emplace_back(attr);
+    try
+    {
+        _handles.emplace(attr, handle);
+    }
+    catch (...)
+    {
+        _attributes.pop_back();
+        throw;
+    }
+    return handle;
+}
+
+// Routine Description:
+// - Gets the handle of the given attribute without adding it to the table.
+// Arguments:
+// - attr - the attribute to look up
+// Return Value:
+// - The handle of the attribute, or nullopt if it's not part of the table.
+std::optional<TextAttributeTable::handle_type> TextAttributeTable::Find(const TextAttribute& attr) const
+{
+    const auto it = _handles.find(attr);
+    if (it == _handles.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+// Routine Description:
+// - Gets the attribute a handle refers to.
+// Arguments:
+// - handle - a handle returned by Intern() or Find()
+// Return Value:
+// - The attribute. The reference is valid until the next call to Intern().
+const TextAttribute& TextAttributeTable::Get(const handle_type handle) const noexcept
+{
+    return til::at(_attributes, handle);
+}
+
+size_t TextAttributeTable::size() const noexcept
+{
+    return _attributes.size();
+}
+
+// Routine Description:
+// - Approximates the number of bytes allocated by the table.
+size_t TextAttributeTable::MemoryUsage() const noexcept
+{
+    // Every node of the map holds the key, the value and two pointers. The bucket array holds one more.
+    constexpr auto nodeSize = sizeof(TextAttribute) + sizeof(handle_type) + 2 * sizeof(void*);
+    return _attributes.capacity() * sizeof(TextAttribute) +
+           _handles.size() * nodeSize +
+           _handles.bucket_count() * sizeof(void*);
+}
+
+// Routine Description:
+// - Tells the owner of the table that it's time to call Compact().
+// Arguments:
+// - headroom - the number of attributes the owner might add before it checks again
+// Return Value:
+// - true if the table passed the compaction threshold or the headroom isn't free anymore.
+bool TextAttributeTable::NeedsCompaction(const size_t headroom) const noexcept
+{
+    return _attributes.size() >= _compactionThreshold || headroom > MaxSize - _attributes.size();
+}
+
+// Routine Description:
+// - Removes all attributes that aren't in use anymore and renumbers the rest.
+// Arguments:
+// - used - for each handle, whether it's still referenced by the owner.
+//   Handles beyond the end of the vector are considered unused.
+// Return Value:
+// - For each old handle the new one. The owner must replace all its handles accordingly.
+std::vector<TextAttributeTable::handle_type> TextAttributeTable::Compact(const std::vector<bool>& used)
+{
+    std::vector<handle_type> remap(_attributes.size());
+    std::vector<TextAttribute> attributes;
+    attributes.reserve(_attributes.size());
+
+    // Handle 0 stays the default attribute, whether it's used or not.
+    attributes.emplace_back(til::at(_attributes, 0));
+
+    for (size_t handle = 1; handle < _attributes.size(); ++handle)
+    {
+        if (handle < used.size() && used[handle])
+        {
+            til::at(remap, handle) = gsl::narrow_cast<handle_type>(attributes.size());
+            attributes.emplace_back(til::at(_attributes, handle));
+        }
+    }
+
+    std::unordered_map<TextAttribute, handle_type, Hasher> handles;
+    handles.reserve(attributes.size());
+    for (size_t handle = 0; handle < attributes.size(); ++handle)
+    {
+        handles.emplace(til::at(attributes, handle), gsl::narrow_cast<handle_type>(handle));
+    }
+
+    _attributes = std::move(attributes);
+    _handles = std::move(handles);
+
+    // If most handles are still in use, don't bother again until half of the rest is taken.
+    _compactionThreshold = std::max(InitialCompactionThreshold, _attributes.size() + (MaxSize - _attributes.size()) / 2);
+
+    return remap;
+}
+
+// Routine Description:
+// - Removes all attributes except for the default one. All existing handles
+//   except for 0 become invalid.
+void TextAttributeTable::Clear() noexcept
+{
+    _attributes.erase(_attributes.begin() + 1, _attributes.end());
+    for (auto it = _handles.begin(); it != _handles.end();)
+    {
+        it = it->second == 0 ? std::next(it) : _handles.erase(it);
+    }
+    _compactionThreshold = InitialCompactionThreshold;
+}
@@ -0,0 +1,60 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextAttributeTable.hpp
+
+Abstract:
+- Interns the TextAttributes used by the rows of a buffer. Rows store 16 bit
+  handles into this table instead of full attributes, which makes their runs
+  a quarter of the size and turns comparing two runs into an integer compare.
+
+Notes:
+- Handles are only meaningful within the table that handed them out.
+- Handle 0 always refers to the default TextAttribute{}.
+- The table never forgets an attribute by itself. Its owner is expected to
+  call Compact() with the handles its rows still use once NeedsCompaction()
+  returns true. Owners pass the number of attributes their next write might
+  add, so that the table is compacted before it runs full, not after.
+- If the table is full anyways, Intern() throws instead of handing out a
+  handle to a different attribute.
+--*/
+
+#pragma once
+
+#include "TextAttribute.hpp"
+
+class TextAttributeTable final
+{
+public:
+    using handle_type = uint16_t;
+
+    static constexpr size_t MaxSize = size_t{ std::numeric_limits<handle_type>::max() } + 1;
+
+    TextAttributeTable();
+
+    handle_type Intern(const TextAttribute& attr);
+    std::optional<handle_type> Find(const TextAttribute& attr) const;
+    const TextAttribute& Get(const handle_type handle) const noexcept;
+
+    size_t size() const noexcept;
+    size_t MemoryUsage() const noexcept;
+
+    bool NeedsCompaction(const size_t headroom = 0) const noexcept;
+    std::vector<handle_type> Compact(const std::vector<bool>& used);
+    void Clear() noexcept;
+
+private:
+    struct Hasher
+    {
+        size_t operator()(const TextAttribute& attr) const noexcept
+        {
+            return attr.Hash();
+        }
+    };
+
+    std::vector<TextAttribute> _attributes;
+    std::unordered_map<TextAttribute, handle_type, Hasher> _handles;
+    size_t _compactionThreshold;
+};
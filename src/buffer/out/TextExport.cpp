@@ -0,0 +1,278 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "TextExport.hpp"
+#include "../types/inc/convert.hpp"
+
+// The CF_HTML header consists of the following lines, with each offset
+// formatted as exactly 10 digits. Once filled in, it's exactly 157 bytes long.
+static constexpr size_t HtmlClipboardHeaderSize = 157;
+static constexpr std::string_view HtmlHeader = "<!DOCTYPE><HTML><HEAD></HEAD><BODY>";
+static constexpr std::string_view HtmlFooter = "</BODY></HTML>";
+
+static void _AppendHexColor(std::string& out, const COLORREF color)
+{
+    fmt::format_to(std::back_inserter(out), FMT_COMPILE("#{:02X}{:02X}{:02X}"), GetRValue(color), GetGValue(color), GetBValue(color));
+}
+
+void PlainTextExportSink::BeginRow(const size_t /*index*/)
+{
+}
+
+void PlainTextExportSink::WriteRun(const std::wstring_view text, const COLORREF /*foreground*/, const COLORREF /*background*/)
+{
+    _text.append(text);
+}
+
+void PlainTextExportSink::WriteLineBreak()
+{
+    _text.push_back(UNICODE_CARRIAGERETURN);
+    _text.push_back(UNICODE_LINEFEED);
+}
+
+// Routine Description:
+// - Gets the text written so far. The caller may move it out of the sink.
+std::wstring& PlainTextExportSink::Text() noexcept
+{
+    return _text;
+}
+
+// Routine Description:
+// - Starts a CF_HTML compliant document.
+// Arguments:
+// - fontHeightPoints - the unscaled font height
+// - fontFaceName - the name of the font used
+// - backgroundColor - default background color for characters, also used in padding
+HtmlExportSink::HtmlExportSink(const int fontHeightPoints, const std::wstring_view fontFaceName, const COLORREF backgroundColor)
+{
+    // The clipboard header is filled in by Finish(), once the offsets are known.
+    _html.append(HtmlClipboardHeaderSize, ' ');
+    _html.append(HtmlHeader);
+    _html.append("<!--StartFragment -->");
+
+    // apply global style in div element
+    // note: MS Word doesn't support padding (in this way at least)
+    _html.append("<DIV STYLE=\"display:inline-block;white-space:pre;background-color:");
+    _AppendHexColor(_html, backgroundColor);
+    fmt::format_to(std::back_inserter(_html),
+                   FMT_COMPILE(";font-family:'{}',monospace;font-size:{}pt;padding:4px;\">"),
+                   ConvertToA(CP_UTF8, fontFaceName),
+                   fontHeightPoints);
+}
+
+void HtmlExportSink::BeginRow(const size_t index)
+{
+    if (index != 0)
+    {
+        _html.append("<BR>");
+    }
+}
+
+void HtmlExportSink::WriteRun(const std::wstring_view text, const COLORREF foreground, const COLORREF background)
+{
+    if (text.empty())
+    {
+        return;
+    }
+
+    const std::pair colors{ foreground, background };
+    if (_colors != colors)
+    {
+        if (_colors)
+        {
+            _html.append("</SPAN>");
+        }
+
+        _html.append("<SPAN STYLE=\"color:");
+        _AppendHexColor(_html, foreground);
+        _html.append(";background-color:");
+        _AppendHexColor(_html, background);
+        _html.append(";\">");
+        _colors = colors;
+    }
+
+    THROW_IF_FAILED(til::u16u8(text, _utf8));
+    for (const auto c : _utf8)
+    {
+        switch (c)
+        {
+        case '<':
+            _html.append("&lt;");
+            break;
+        case '>':
+            _html.append("&gt;");
+            break;
+        case '&':
+            _html.append("&amp;");
+            break;
+        default:
+            _html.push_back(c);
+        }
+    }
+}
+
+// Routine Description:
+// - HTML uses <BR> for line breaks, which BeginRow() takes care of.
+void HtmlExportSink::WriteLineBreak()
+{
+}
+
+// Routine Description:
+// - Completes the document and fills in the clipboard header.
+// Return Value:
+// - The generated HTML. The sink must not be used anymore afterwards.
+std::string HtmlExportSink::Finish()
+{
+    if (_colors)
+    {
+        // last opened span wasn't closed yet, so close it now
+        _html.append("</SPAN>");
+    }
+
+    _html.append("</DIV>");
+    _html.append("<!--EndFragment -->");
+    _html.append(HtmlFooter);
+
+    // these values are byte offsets from start of clipboard
+    const auto htmlStartPos = HtmlClipboardHeaderSize;
+    const auto htmlEndPos = _html.size();
+    const auto fragStartPos = HtmlClipboardHeaderSize + HtmlHeader.size();
+    const auto fragEndPos = htmlEndPos - HtmlFooter.size();
+
+    // header required by HTML 0.9 format
+    const auto header = fmt::format(FMT_COMPILE("Version:0.9\r\n"
+                                                "StartHTML:{:010}\r\n"
+                                                "EndHTML:{:010}\r\n"
+                                                "StartFragment:{:010}\r\n"
+                                                "EndFragment:{:010}\r\n"
+                                                "StartSelection:{:010}\r\n"
+                                                "EndSelection:{:010}\r\n"),
+                                    htmlStartPos,
+                                    htmlEndPos,
+                                    fragStartPos,
+                                    fragEndPos,
+                                    fragStartPos,
+                                    fragEndPos);
+    THROW_HR_IF(E_UNEXPECTED, header.size() != HtmlClipboardHeaderSize);
+    _html.replace(0, HtmlClipboardHeaderSize, header);
+
+    return std::move(_html);
+}
+
+// Routine Description:
+// - Starts an RTF document.
+//   RTF 1.5 Spec: https://www.biblioscape.com/rtf15_spec.htm
+// Arguments:
+// - fontHeightPoints - the unscaled font height
+// - fontFaceName - the name of the font used
+// - backgroundColor - default background color for characters, also used in padding
+RtfExportSink::RtfExportSink(const int fontHeightPoints, const std::wstring_view fontFaceName, const COLORREF backgroundColor)
+{
+    // Standard RTF header.
+    // This is similar to the header generated by WordPad.
+    // \ansi - specifies that the ANSI char set is used in the current doc
+    // \ansicpg1252 - represents the ANSI code page which is used to perform the Unicode to ANSI conversion when writing RTF text
+    // \deff0 - specifies that the default font for the document is the one at index 0 in the font table
+    // \nouicompat - ?
+    _header.append("{\\rtf1\\ansi\\ansicpg1252\\deff0\\nouicompat");
+
+    // font table
+    fmt::format_to(std::back_inserter(_header), FMT_COMPILE("{{\\fonttbl{{\\f0\\fmodern\\fcharset0 {};}}}}"), ConvertToA(CP_UTF8, fontFaceName));
+
+    // RTF color table, with the background color at index 1.
+    _colorTable.append("{\\colortbl ;");
+    _GetColorIndex(backgroundColor);
+
+    // paragraph styles
+    // \fs specifies font size in half-points i.e. \fs20 results in a font size
+    // of 10 pts. That's why, font size is multiplied by 2 here.
+    fmt::format_to(std::back_inserter(_content), FMT_COMPILE("\\viewkind4\\uc4\\pard\\slmult1\\f0\\fs{}\\highlight1 "), 2 * fontHeightPoints);
+}
+
+void RtfExportSink::BeginRow(const size_t index)
+{
+    if (index != 0)
+    {
+        _content.append("\\line "); // new line
+    }
+}
+
+void RtfExportSink::WriteRun(const std::wstring_view text, const COLORREF foreground, const COLORREF background)
+{
+    if (text.empty())
+    {
+        return;
+    }
+
+    const std::pair colors{ foreground, background };
+    if (_colors != colors)
+    {
+        const auto backgroundIndex = _GetColorIndex(background);
+        const auto foregroundIndex = _GetColorIndex(foreground);
+        fmt::format_to(std::back_inserter(_content), FMT_COMPILE("\\highlight{}\\cf{} "), backgroundIndex, foregroundIndex);
+        _colors = colors;
+    }
+
+    THROW_IF_FAILED(til::u16u8(text, _utf8));
+    for (const auto c : _utf8)
+    {
+        switch (c)
+        {
+        case '\\':
+        case '{':
+        case '}':
+            _content.push_back('\\');
+            _content.push_back(c);
+            break;
+        default:
+            _content.push_back(c);
+        }
+    }
+}
+
+// Routine Description:
+// - RTF uses \line for line breaks, which BeginRow() takes care of.
+void RtfExportSink::WriteLineBreak()
+{
+}
+
+// Routine Description:
+// - Completes the document.
+// Return Value:
+// - The generated RTF. The sink must not be used anymore afterwards.
+std::string RtfExportSink::Finish()
+{
+    // end colortbl
+    _colorTable.append("}");
+
+    std::string rtf;
+    rtf.reserve(_header.size() + _colorTable.size() + _content.size() + 1);
+    rtf.append(_header);
+    rtf.append(_colorTable);
+    rtf.append(_content);
+    rtf.append("}");
+    return rtf;
+}
+
+// Routine Description:
+// - Gets the index of a color in the color table, adding it if necessary.
+size_t RtfExportSink::_GetColorIndex(const COLORREF color)
+{
+    const auto it = _colorIndices.find(color);
+    if (it != _colorIndices.end())
+    {
+        return it->second;
+    }
+
+    // leave 0 for the default color and start from 1.
+    const auto index = _colorIndices.size() + 1;
+    fmt::format_to(std::back_inserter(_colorTable),
+                   FMT_COMPILE("\\red{}\\green{}\\blue{};"),
+                   GetRValue(color),
+                   GetGValue(color),
+                   GetBValue(color));
+    _colorIndices.emplace(color, index);
+    return index;
+}
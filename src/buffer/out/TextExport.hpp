@@ -0,0 +1,81 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextExport.hpp
+
+Abstract:
+- Sinks for TextBuffer::ExportText(), which hands them the selected text row by
+  row, in runs of equal colors. This allows for generating the plain text, HTML
+  and RTF clipboard formats in a single pass over the buffer, without first
+  gathering the colors of every single cell.
+--*/
+
+#pragma once
+
+class ITextExportSink
+{
+public:
+    virtual ~ITextExportSink() = default;
+
+    // Called before the runs of each row, with index 0 being the first row.
+    virtual void BeginRow(const size_t index) = 0;
+    // Appends text of the current row which has the same colors throughout.
+    virtual void WriteRun(const std::wstring_view text, const COLORREF foreground, const COLORREF background) = 0;
+    // Called after the runs of a row that's supposed to end with a CR/LF.
+    virtual void WriteLineBreak() = 0;
+};
+
+class PlainTextExportSink final : public ITextExportSink
+{
+public:
+    void BeginRow(const size_t index) override;
+    void WriteRun(const std::wstring_view text, const COLORREF foreground, const COLORREF background) override;
+    void WriteLineBreak() override;
+
+    std::wstring& Text() noexcept;
+
+private:
+    std::wstring _text;
+};
+
+class HtmlExportSink final : public ITextExportSink
+{
+public:
+    HtmlExportSink(const int fontHeightPoints, const std::wstring_view fontFaceName, const COLORREF backgroundColor);
+
+    void BeginRow(const size_t index) override;
+    void WriteRun(const std::wstring_view text, const COLORREF foreground, const COLORREF background) override;
+    void WriteLineBreak() override;
+
+    std::string Finish();
+
+private:
+    std::string _html;
+    std::string _utf8;
+    std::optional<std::pair<COLORREF, COLORREF>> _colors;
+};
+
+class RtfExportSink final : public ITextExportSink
+{
+public:
+    RtfExportSink(const int fontHeightPoints, const std::wstring_view fontFaceName, const COLORREF backgroundColor);
+
+    void BeginRow(const size_t index) override;
+    void WriteRun(const std::wstring_view text, const COLORREF foreground, const COLORREF background) override;
+    void WriteLineBreak() override;
+
+    std::string Finish();
+
+private:
+    size_t _GetColorIndex(const COLORREF color);
+
+    std::string _header;
+    std::string _colorTable;
+    std::string _content;
+    std::string _utf8;
+    // The index of each color in the color table. 0 is the default color.
+    std::unordered_map<COLORREF, size_t> _colorIndices;
+    std::optional<std::pair<COLORREF, COLORREF>> _colors;
+};
@@ -28,10 +28,10 @@ Search::Search(IUiaData& uiaData,
                const Sensitivity sensitivity) :
     _direction(direction),
     _sensitivity(sensitivity),
-    _needle(s_CreateNeedleFromString(str)),
     _uiaData(uiaData),
     _coordAnchor(s_GetInitialAnchor(uiaData, direction))
 {
+    _CreateNeedle(str);
     _coordNext = _coordAnchor;
 }
 
@@ -53,10 +53,10 @@ Search::Search(IUiaData& uiaData,
                const COORD anchor) :
     _direction(direction),
     _sensitivity(sensitivity),
-    _needle(s_CreateNeedleFromString(str)),
     _coordAnchor(anchor),
     _uiaData(uiaData)
 {
+    _CreateNeedle(str);
     _coordNext = _coordAnchor;
 }
 
@@ -75,22 +75,61 @@ bool Search::FindNext()
         return false;
     }
 
-    do
+    const auto next = _ToLinear(_coordNext);
+    const auto anchor = _ToLinear(_coordAnchor);
+    const auto end = _ToLinear(_uiaData.GetTextBufferEndPosition());
+
+    std::optional<std::pair<COORD, COORD>> match;
+    if (_direction == Direction::Forward)
     {
-        if (_FindNeedleInHaystackAt(_coordNext, _coordSelStart, _coordSelEnd))
+        // First search from next up to the anchor or the end of the text, whichever comes first.
+        match = _FindInRange(next, next < anchor ? anchor - 1 : end);
+
+        // Then wrap around to the start of the buffer.
+        if (!match && (next >= anchor || anchor > end))
         {
-            _UpdateNextPosition();
-            _reachedEnd = _coordNext == _coordAnchor;
-            return true;
+            match = _FindInRange(0, std::min(anchor, next) - 1);
         }
-        else
+    }
+    else
+    {
+        // First search from next down to the anchor or the start of the buffer, whichever comes first.
+        match = _FindInRange(next > anchor ? anchor + 1 : 0, std::min(next, end));
+
+        // Then wrap around to the end of the text.
+        if (!match && next <= anchor)
         {
-            _UpdateNextPosition();
+            match = _FindInRange(anchor + 1, end);
         }
+    }
 
-    } while (_coordNext != _coordAnchor);
+    if (!match)
+    {
+        _coordNext = _coordAnchor;
+        return false;
+    }
 
-    return false;
+    _coordSelStart = match->first;
+    _coordSelEnd = match->second;
+    _coordNext = _coordSelStart;
+    _UpdateNextPosition();
+    _reachedEnd = _coordNext == _coordAnchor;
+    return true;
+}
+
+// Routine Description
+// - Locates all instances of the search term within the screen buffer,
+//   for instance to highlight all of them at once.
+// - Only rows that changed since they were last searched are scanned again.
+// Arguments:
+// - <none> - Uses internal state from constructor
+// Return Value:
+// - The [start, end] positions of all matches in buffer order.
+//   Valid until the next call to FindAll().
+const std::vector<std::pair<COORD, COORD>>& Search::FindAll()
+{
+    _UpdateMatches();
+    return _matches;
 }
 
 // Routine Description:
@@ -178,72 +217,316 @@ COORD Search::s_GetInitialAnchor(IUiaData& uiaData, const Direction direction)
 }
 
 // Routine Description:
-// - Attempts to compare the search term (the needle) to the screen buffer (the haystack)
-//   at the given coordinate position of the screen buffer.
-// - Performs one comparison. Call again with new positions to check other spots.
+// - Gets the search cache of the buffer, after making sure that it holds the matches of our needle.
 // Arguments:
-// - pos - The position in the haystack (screen buffer) to compare
-// - start - If we found it, this is filled with the coordinate of the first character of the needle.
-// - end - If we found it, this is filled with the coordinate of the last character of the needle.
+// - <none>
 // Return Value:
-// - True if we found it. False if not.
-bool Search::_FindNeedleInHaystackAt(const COORD pos, COORD& start, COORD& end) const
+// - The cache
+TextBuffer::SearchCache& Search::_GetCache()
 {
-    start = { 0 };
-    end = { 0 };
+    auto& cache = _uiaData.GetTextBuffer().GetSearchCache();
+    const auto caseSensitive = _sensitivity == Sensitivity::CaseSensitive;
+    if (cache.needle != _needle || cache.caseSensitive != caseSensitive)
+    {
+        cache.lines.clear();
+        cache.needle = _needle;
+        cache.caseSensitive = caseSensitive;
+    }
+    return cache;
+}
 
-    COORD bufferPos = pos;
+// Routine Description:
+// - Searches the buffer for all matches of the needle. A row is only scanned
+//   again if its text or the text of any of the following rows that a match
+//   starting in it could span changed since it was last searched.
+// Arguments:
+// - <none>
+void Search::_UpdateMatches()
+{
+    _matches.clear();
+
+    auto& cache = _GetCache();
+    const auto& textBuffer = _uiaData.GetTextBuffer();
+    const auto bufferSize = textBuffer.GetSize();
+    const auto width = gsl::narrow_cast<size_t>(bufferSize.Width());
+    const auto height = gsl::narrow_cast<size_t>(bufferSize.Height());
+    const auto needleCells = _needleOffsets.size() - 1;
+    if (needleCells == 0 || width == 0 || height == 0)
+    {
+        cache.lines.clear();
+        return;
+    }
+
+    // Matches may only start up to the end of the written text, but they
+    // may extend beyond it. A match starting in the last column can span
+    // this many rows after the one it started in.
+    const auto endPosition = _uiaData.GetTextBufferEndPosition();
+    const auto lastStartRow = std::min(gsl::narrow_cast<size_t>(std::max<SHORT>(endPosition.Y, 0)), height - 1);
+    const auto extraRows = (needleCells + width - 2) / width;
+    const auto endLinear = _ToLinear(endPosition);
+
+    decltype(cache.lines) lines;
+    std::vector<size_t> cells;
+    // The cache entries of the rows that are being searched again. Rows that were copied from
+    // another one share its revision and only the first of them gets an entry.
+    std::vector<TextBuffer::SearchCache::Line*> dirtyRows;
+
+    const auto appendMatch = [&](const size_t row, const size_t column) {
+        const auto start = row * width + column;
+        if (gsl::narrow_cast<ptrdiff_t>(start) > endLinear)
+        {
+            return;
+        }
+        const auto last = start + needleCells - 1;
+        _matches.emplace_back(COORD{ gsl::narrow_cast<SHORT>(column), gsl::narrow_cast<SHORT>(row) },
+                              COORD{ gsl::narrow_cast<SHORT>(last % width), gsl::narrow_cast<SHORT>(last / width) });
+    };
 
-    for (const auto& needleCell : _needle)
+    for (size_t row = 0; row <= lastStartRow;)
     {
-        // Haystack is the buffer. Needle is the string we were given.
-        const auto hayIter = _uiaData.GetTextBuffer().GetTextDataAt(bufferPos);
-        const auto hayChars = *hayIter;
-        const auto needleChars = std::wstring_view(needleCell.data(), needleCell.size());
+        // Rows whose cached matches are still valid are taken as is.
+        // Runs of rows that need to be searched again are scanned together.
+        auto dirtyEnd = row;
+        dirtyRows.clear();
+        while (dirtyEnd <= lastStartRow)
+        {
+            _revisions.clear();
+            for (auto i = dirtyEnd; i <= std::min(dirtyEnd + extraRows, height - 1); ++i)
+            {
+                _revisions.push_back(textBuffer.GetRowByOffset(i).GetCharRow().GetRevision());
+            }
+
+            const auto it = cache.lines.find(_revisions.front());
+            if (it != cache.lines.end() && it->second.revisions == _revisions)
+            {
+                break;
+            }
+
+            const auto [entry, inserted] = lines.try_emplace(_revisions.front(), TextBuffer::SearchCache::Line{ _revisions, {} });
+            dirtyRows.push_back(inserted ? &entry->second : nullptr);
+            ++dirtyEnd;
+        }
+
+        if (dirtyEnd != row)
+        {
+            cells.clear();
+            _FindInRows(row, dirtyEnd - 1, std::min(dirtyEnd - 1 + extraRows, height - 1), cells);
+
+            for (const auto cell : cells)
+            {
+                const auto column = cell % width;
+                if (const auto entry = til::at(dirtyRows, cell / width))
+                {
+                    entry->columns.push_back(column);
+                }
+                appendMatch(row + cell / width, column);
+            }
+
+            row = dirtyEnd;
+            continue;
+        }
 
-        // If we didn't match at any point of the needle, return false.
-        if (!_CompareChars(hayChars, needleChars))
+        auto& line = cache.lines.at(_revisions.front());
+        for (const auto column : line.columns)
         {
-            return false;
+            appendMatch(row, column);
         }
+        lines.try_emplace(_revisions.front(), std::move(line));
+        ++row;
+    }
+
+    // Only keep the rows we've just seen. Everything else has
+    // either scrolled out of the buffer or was overwritten.
+    cache.lines = std::move(lines);
+}
 
-        _IncrementCoord(bufferPos);
+// Routine Description:
+// - Finds the match closest to the start of the given range in search order.
+//   The rows are scanned one at a time, beginning at that end of the range.
+// Arguments:
+// - first - The linear position of the first cell a match may start at
+// - last - The linear position of the last cell a match may start at
+// Return Value:
+// - The [start, end] positions of the match, or nullopt if there's none.
+std::optional<std::pair<COORD, COORD>> Search::_FindInRange(const ptrdiff_t first, const ptrdiff_t last)
+{
+    const auto bufferSize = _uiaData.GetTextBuffer().GetSize();
+    const auto width = gsl::narrow_cast<ptrdiff_t>(bufferSize.Width());
+    const auto height = gsl::narrow_cast<ptrdiff_t>(bufferSize.Height());
+    const auto needleCells = gsl::narrow_cast<ptrdiff_t>(_needleOffsets.size() - 1);
+
+    // Matches may only start up to the end of the written text, but they may extend beyond it.
+    const auto lastStart = std::min({ last, _ToLinear(_uiaData.GetTextBufferEndPosition()), width * height - 1 });
+    if (needleCells == 0 || first < 0 || first > lastStart)
+    {
+        return std::nullopt;
     }
 
-    _DecrementCoord(bufferPos);
+    // A match starting in the last column can span this many rows after the one it started in.
+    const auto extraRows = (needleCells + width - 2) / width;
+    const auto firstRow = first / width;
+    const auto lastRow = lastStart / width;
+    const auto forward = _direction == Direction::Forward;
 
-    // If we made it the whole way through the needle, then it was in the haystack.
-    // Fill out the span that we found the result at and return true.
-    start = pos;
-    end = bufferPos;
+    for (auto row = forward ? firstRow : lastRow; row >= firstRow && row <= lastRow; row += forward ? 1 : -1)
+    {
+        const auto& columns = _GetRowMatches(gsl::narrow_cast<size_t>(row), gsl::narrow_cast<size_t>(std::min(row + extraRows, height - 1)));
 
-    return true;
+        const auto inRange = [&](const size_t column) noexcept {
+            const auto pos = row * width + gsl::narrow_cast<ptrdiff_t>(column);
+            return pos >= first && pos <= lastStart;
+        };
+
+        std::optional<size_t> column;
+        if (forward)
+        {
+            const auto it = std::find_if(columns.begin(), columns.end(), inRange);
+            if (it != columns.end())
+            {
+                column = *it;
+            }
+        }
+        else
+        {
+            const auto it = std::find_if(columns.rbegin(), columns.rend(), inRange);
+            if (it != columns.rend())
+            {
+                column = *it;
+            }
+        }
+
+        if (column)
+        {
+            const auto end = row * width + gsl::narrow_cast<ptrdiff_t>(*column) + needleCells - 1;
+            return std::pair{ COORD{ gsl::narrow_cast<SHORT>(*column), gsl::narrow_cast<SHORT>(row) },
+                              COORD{ gsl::narrow_cast<SHORT>(end % width), gsl::narrow_cast<SHORT>(end / width) } };
+        }
+    }
+
+    return std::nullopt;
 }
 
 // Routine Description:
-// - Provides an abstraction for comparing two spans of text.
-// - Internally handles case sensitivity based on object construction.
+// - Gets the columns at which matches start in the given row. They're taken from the
+//   cache, unless the row or any of the following rows the matches could span changed.
 // Arguments:
-// - one - String view representing the first string of text
-// - two - String view representing the second string of text
+// - row - The row in which the matches start
+// - lastRow - The last row the matches could extend into
 // Return Value:
-// - True if they are the same. False otherwise.
-bool Search::_CompareChars(const std::wstring_view one, const std::wstring_view two) const noexcept
+// - The columns in ascending order. Valid until the cache is modified again.
+const std::vector<size_t>& Search::_GetRowMatches(const size_t row, const size_t lastRow)
 {
-    if (one.size() != two.size())
+    auto& cache = _GetCache();
+    const auto& textBuffer = _uiaData.GetTextBuffer();
+
+    _revisions.clear();
+    for (auto i = row; i <= lastRow; ++i)
     {
-        return false;
+        _revisions.push_back(textBuffer.GetRowByOffset(i).GetCharRow().GetRevision());
     }
 
-    for (size_t i = 0; i < one.size(); i++)
+    if (const auto it = cache.lines.find(_revisions.front()); it != cache.lines.end() && it->second.revisions == _revisions)
     {
-        if (_ApplySensitivity(one.at(i)) != _ApplySensitivity(two.at(i)))
+        return it->second.columns;
+    }
+
+    // Only FindAll() drops the entries of rows that were overwritten. Start over instead
+    // of letting the cache grow without bounds if FindNext() is all that's ever called.
+    if (cache.lines.size() >= 2 * gsl::narrow_cast<size_t>(textBuffer.GetSize().Height()))
+    {
+        cache.lines.clear();
+    }
+
+    auto& line = cache.lines[_revisions.front()];
+    line.revisions = _revisions;
+    line.columns.clear();
+    _FindInRows(row, row, lastRow, line.columns);
+    return line.columns;
+}
+
+// Routine Description:
+// - Scans the given rows for the needle in one pass.
+// Arguments:
+// - firstRow - The first row to extract text from
+// - lastStartRow - The last row in which matches may start
+// - lastRow - The last row to extract text from. Matches may extend into it.
+// - cells - Receives the starting cell of each match, counted from the start of firstRow
+void Search::_FindInRows(const size_t firstRow, const size_t lastStartRow, const size_t lastRow, std::vector<size_t>& cells)
+{
+    const auto& textBuffer = _uiaData.GetTextBuffer();
+    const auto width = gsl::narrow_cast<size_t>(textBuffer.GetSize().Width());
+
+    _haystack.clear();
+    _haystackOffsets.clear();
+    for (auto row = firstRow; row <= lastRow; ++row)
+    {
+        const auto& charRow = textBuffer.GetRowByOffset(row).GetCharRow();
+        const auto offsets = charRow.GlyphOffsets();
+        const auto base = _haystack.size();
+        _haystack.append(charRow.GlyphData());
+        for (size_t column = 0; column < width; ++column)
         {
-            return false;
+            _haystackOffsets.push_back(base + til::at(offsets, column));
         }
     }
+    _haystackOffsets.push_back(_haystack.size());
 
-    return true;
+    if (_sensitivity == Sensitivity::CaseInsensitive)
+    {
+        std::transform(_haystack.begin(), _haystack.end(), _haystack.begin(), [this](const wchar_t wch) noexcept { return _ApplySensitivity(wch); });
+    }
+
+    const auto needleLength = _needle.size();
+    const auto needleCells = _needleOffsets.size() - 1;
+    const auto maxStartCell = (lastStartRow - firstRow + 1) * width;
+    // If every cell holds a single code unit, text offsets are equal to cell indices.
+    const auto singleUnitCells = _haystack.size() == _haystackOffsets.size() - 1;
+    const std::wstring_view haystack{ _haystack };
+    const std::wstring_view needle{ _needle };
+    const auto needleLast = needle.back();
+
+    for (size_t pos = 0; pos + needleLength <= haystack.size();)
+    {
+        const auto last = til::at(haystack, pos + needleLength - 1);
+        if (last == needleLast && haystack.compare(pos, needleLength - 1, needle, 0, needleLength - 1) == 0)
+        {
+            // The match has to line up with cell boundaries: it can neither begin nor end
+            // in the middle of a glyph, and each cell of the needle has to match a whole cell.
+            size_t cell = pos;
+            if (!singleUnitCells)
+            {
+                const auto it = std::lower_bound(_haystackOffsets.begin(), _haystackOffsets.end(), pos);
+                cell = gsl::narrow_cast<size_t>(it - _haystackOffsets.begin());
+            }
+
+            if (cell < maxStartCell && cell + needleCells < _haystackOffsets.size() && til::at(_haystackOffsets, cell) == pos)
+            {
+                auto aligned = true;
+                for (size_t i = 1; i <= needleCells && aligned; ++i)
+                {
+                    aligned = til::at(_haystackOffsets, cell + i) == pos + til::at(_needleOffsets, i);
+                }
+                if (aligned)
+                {
+                    cells.push_back(cell);
+                }
+            }
+        }
+
+        pos += til::at(_skip, last & 0xff);
+    }
+}
+
+// Routine Description:
+// - Converts a buffer position into its index when counting cells row by row.
+// Arguments:
+// - coord - The buffer position
+// Return Value:
+// - The linear position
+ptrdiff_t Search::_ToLinear(const COORD coord) const noexcept
+{
+    const auto width = _uiaData.GetTextBuffer().GetSize().Width();
+    return gsl::narrow_cast<ptrdiff_t>(coord.Y) * width + coord.X;
 }
 
 // Routine Description:
@@ -257,6 +540,11 @@ wchar_t Search::_ApplySensitivity(const wchar_t wch) const noexcept
 {
     if (_sensitivity == Sensitivity::CaseInsensitive)
     {
+        // Most text is ASCII, which doesn't need a trip through the CRT.
+        if (wch < 0x80)
+        {
+            return wch >= L'A' && wch <= L'Z' ? gsl::narrow_cast<wchar_t>(wch + (L'a' - L'A')) : wch;
+        }
         return ::towlower(wch);
     }
     else
@@ -325,22 +613,32 @@ void Search::_UpdateNextPosition()
 
 // Routine Description:
 // - Creates a "needle" of the correct format for comparison to the screen buffer text data
-//   that we can use for our search
+//   that we can use for our search. A wide glyph occupies two cells in the buffer and
+//   is thus contained twice, just like in the buffer's row text.
+// - Also prepares the Boyer-Moore-Horspool shift table for it.
 // Arguments:
 // - wstr - String that will be our search term
-// Return Value:
-// - Structured text data for comparison to screen buffer text data.
-std::vector<std::vector<wchar_t>> Search::s_CreateNeedleFromString(const std::wstring& wstr)
+void Search::_CreateNeedle(const std::wstring& wstr)
 {
     const auto charData = Utf16Parser::Parse(wstr);
-    std::vector<std::vector<wchar_t>> cells;
+    _needleOffsets.push_back(0);
     for (const auto chars : charData)
     {
-        if (IsGlyphFullWidth(std::wstring_view{ chars.data(), chars.size() }))
+        const std::wstring_view glyph{ chars.data(), chars.size() };
+        const auto count = IsGlyphFullWidth(glyph) ? 2 : 1;
+        for (auto i = 0; i < count; ++i)
         {
-            cells.emplace_back(chars);
+            std::transform(glyph.begin(), glyph.end(), std::back_inserter(_needle), [this](const wchar_t wch) noexcept { return _ApplySensitivity(wch); });
+            _needleOffsets.push_back(_needle.size());
         }
-        cells.emplace_back(chars);
     }
-    return cells;
+
+    // The shift table is indexed by the low byte of a code unit only. Code units
+    // sharing a low byte share the smallest shift of any of them, which is safe.
+    const auto length = _needle.size();
+    _skip.fill(std::max<size_t>(length, 1));
+    for (size_t i = 0; i + 1 < length; ++i)
+    {
+        til::at(_skip, til::at(_needle, i) & 0xff) = length - 1 - i;
+    }
 }
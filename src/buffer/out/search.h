@@ -7,6 +7,13 @@ Module Name:
 
 Abstract:
 - This module is used for searching through the screen for a substring
+- The text of the buffer is extracted a row at a time and scanned in bulk
+  using Boyer-Moore-Horspool. FindNext() only scans as many rows as it takes
+  to find the next match. FindAll() finds all of them in one pass, for
+  instance to highlight them.
+- The matches of each row are cached by the TextBuffer, along with the
+  revisions of the rows they span. Consecutive queries for the same term,
+  even from different Search objects, only scan rows that changed.
 
 Author(s):
 - Michael Niksa (MiNiksa) 20-Apr-2018
@@ -52,6 +59,7 @@ public:
            const COORD anchor);
 
     bool FindNext();
+    const std::vector<std::pair<COORD, COORD>>& FindAll();
     void Select() const;
     void Color(const TextAttribute attr) const;
 
@@ -59,8 +67,13 @@ public:
 
 private:
     wchar_t _ApplySensitivity(const wchar_t wch) const noexcept;
-    bool _FindNeedleInHaystackAt(const COORD pos, COORD& start, COORD& end) const;
-    bool _CompareChars(const std::wstring_view one, const std::wstring_view two) const noexcept;
+    void _CreateNeedle(const std::wstring& wstr);
+    TextBuffer::SearchCache& _GetCache();
+    void _UpdateMatches();
+    std::optional<std::pair<COORD, COORD>> _FindInRange(const ptrdiff_t first, const ptrdiff_t last);
+    const std::vector<size_t>& _GetRowMatches(const size_t row, const size_t lastRow);
+    void _FindInRows(const size_t firstRow, const size_t lastStartRow, const size_t lastRow, std::vector<size_t>& cells);
+    ptrdiff_t _ToLinear(const COORD coord) const noexcept;
     void _UpdateNextPosition();
 
     void _IncrementCoord(COORD& coord) const noexcept;
@@ -68,19 +81,31 @@ private:
 
     static COORD s_GetInitialAnchor(Microsoft::Console::Types::IUiaData& uiaData, const Direction dir);
 
-    static std::vector<std::vector<wchar_t>> s_CreateNeedleFromString(const std::wstring& wstr);
-
     bool _reachedEnd = false;
     COORD _coordNext = { 0 };
     COORD _coordSelStart = { 0 };
     COORD _coordSelEnd = { 0 };
 
     const COORD _coordAnchor;
-    const std::vector<std::vector<wchar_t>> _needle;
     const Direction _direction;
     const Sensitivity _sensitivity;
     Microsoft::Console::Types::IUiaData& _uiaData;
 
+    // The text of all needle cells back to back, case folded if necessary.
+    std::wstring _needle;
+    // The offset of each needle cell into _needle, plus a final entry for _needle.size().
+    std::vector<size_t> _needleOffsets;
+    // Boyer-Moore-Horspool shift for each value of the low byte of a code unit.
+    std::array<size_t, 256> _skip{};
+
+    // All matches in buffer order, as [start, end] positions, as of the last call to FindAll().
+    std::vector<std::pair<COORD, COORD>> _matches;
+    // Scratch buffers for the text of the rows being searched,
+    // the offset of each cell's glyph into that text and the revisions of the rows.
+    std::wstring _haystack;
+    std::vector<size_t> _haystackOffsets;
+    std::vector<uint64_t> _revisions;
+
 #ifdef UNIT_TESTING
     friend class SearchTests;
 #endif
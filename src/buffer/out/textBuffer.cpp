@@ -8,7 +8,6 @@
 
 #include "../types/inc/utils.hpp"
 #include "../types/inc/convert.hpp"
-#include "../../types/inc/GlyphWidth.hpp"
 
 #pragma hdrstop
 
@@ -35,7 +34,6 @@ TextBuffer::TextBuffer(const COORD screenBufferSize,
     _currentAttributes{ defaultAttributes },
     _cursor{ cursorSize, *this },
     _storage{},
-    _unicodeStorage{},
     _renderTarget{ renderTarget },
     _size{},
     _currentHyperlinkId{ 1 },
@@ -45,7 +43,7 @@ TextBuffer::TextBuffer(const COORD screenBufferSize,
     _storage.reserve(static_cast<size_t>(screenBufferSize.Y));
     for (size_t i = 0; i < static_cast<size_t>(screenBufferSize.Y); ++i)
     {
-        _storage.emplace_back(static_cast<SHORT>(i), screenBufferSize.X, _currentAttributes, this);
+        _storage.emplace_back(static_cast<SHORT>(i), screenBufferSize.X, _currentAttributes, this, _attributeTable);
     }
 
     _UpdateSize();
@@ -379,6 +377,8 @@ OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
         return givenIt;
     }
 
+    _CompactAttributesIfNeeded();
+
     //  Get the row and write the cells
     ROW& row = GetRowByOffset(target.Y);
     const auto newIt = row.WriteCells(givenIt, target.X, wrap, limitRight);
@@ -391,6 +391,101 @@ OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
     return newIt;
 }
 
+// Routine Description:
+// - Writes a run of printable text with a single attribute into one row, like
+//   a terminal printing a stream of characters does. As much text is written
+//   as fits into the row. Writing the last column marks the row as wrapped.
+// - A wide glyph which doesn't fit into the last column is not written. The
+//   last column is padded instead, and the glyph is left for the next row.
+// Arguments:
+// - text - The text to write. On return, the consumed part is removed from it.
+// - attributes - The attributes to write the text with
+// - target - The position to start writing at
+// Return Value:
+// - The position following the last written cell. If no text was consumed,
+//   the text doesn't fit into this row anymore and the caller should wrap.
+COORD TextBuffer::WriteRun(std::wstring_view& text, const TextAttribute& attributes, const COORD target)
+{
+    const OutputCellIterator it{ text, attributes };
+    const auto end = WriteLine(it, target, true);
+
+    text.remove_prefix(gsl::narrow_cast<size_t>(end.GetInputDistance(it)));
+
+    auto position = target;
+    position.X += gsl::narrow<SHORT>(end.GetCellDistance(it));
+    return position;
+}
+
+// Routine Description:
+// - Copies a rectangle of CHAR_INFOs into the buffer, the way the legacy WriteConsoleOutput
+//   API does, one row span at a time instead of one cell at a time.
+// - Each row of the rectangle is written like Write() writes an OutputCellIterator over its
+//   CHAR_INFOs. The rare rows that rely on the double byte padding of WriteCells()
+//   are still written that way.
+// Arguments:
+// - source - The cells to write. The first row of the rectangle starts at its beginning.
+// - stride - The distance between the rows of the rectangle in source, in cells
+// - rect - The area of the buffer to write to
+// Return Value:
+// - <none>
+// Note:
+// - will throw exception if the rectangle isn't inside the buffer or source is too small.
+void TextBuffer::WriteCharInfoRect(const gsl::span<const CHAR_INFO> source, const size_t stride, const Viewport& rect)
+{
+    if (rect.Width() <= 0 || rect.Height() <= 0)
+    {
+        return;
+    }
+
+    const auto width = gsl::narrow_cast<size_t>(rect.Width());
+    const auto height = gsl::narrow_cast<size_t>(rect.Height());
+    THROW_HR_IF(E_INVALIDARG, !GetSize().IsInBounds(rect));
+    THROW_HR_IF(E_INVALIDARG, stride < width || gsl::narrow_cast<size_t>(source.size()) < (height - 1) * stride + width);
+
+    for (size_t y = 0; y < height; ++y)
+    {
+        _CompactAttributesIfNeeded();
+
+        const auto cells = source.subspan(y * stride, width);
+        const COORD target{ rect.Left(), gsl::narrow_cast<SHORT>(rect.Top() + y) };
+        if (!GetRowByOffset(target.Y).WriteCharInfos(cells, target.X))
+        {
+            Write(OutputCellIterator{ cells }, target);
+        }
+    }
+
+    _NotifyPaint(rect);
+}
+
+// Routine Description:
+// - Copies a rectangle of the buffer into CHAR_INFOs, the way the legacy
+//   ReadConsoleOutput API returns them, one row span at a time.
+// Arguments:
+// - target - Receives the cells. The first row of the rectangle starts at its beginning.
+// - stride - The distance between the rows of the rectangle in target, in cells
+// - rect - The area of the buffer to read from
+// Return Value:
+// - <none>
+// Note:
+// - will throw exception if the rectangle isn't inside the buffer or target is too small.
+void TextBuffer::ReadCharInfoRect(const gsl::span<CHAR_INFO> target, const size_t stride, const Viewport& rect) const
+{
+    if (rect.Width() <= 0 || rect.Height() <= 0)
+    {
+        return;
+    }
+
+    const auto width = gsl::narrow_cast<size_t>(rect.Width());
+    const auto height = gsl::narrow_cast<size_t>(rect.Height());
+    THROW_HR_IF(E_INVALIDARG, !GetSize().IsInBounds(rect));
+    THROW_HR_IF(E_INVALIDARG, stride < width || gsl::narrow_cast<size_t>(target.size()) < (height - 1) * stride + width);
+
+    for (size_t y = 0; y < height; ++y)
+    {
+        GetRowByOffset(rect.Top() + y).ReadCharInfos(target.subspan(y * stride, width), rect.Left());
+    }
+}
+
 //Routine Description:
 // - Inserts one codepoint into the buffer at the current cursor position and advances the cursor as appropriate.
 //Arguments:
@@ -422,7 +517,7 @@ bool TextBuffer::InsertCharacter(const std::wstring_view chars,
         try
         {
             charRow.GlyphAt(iCol) = chars;
-            charRow.DbcsAttrAt(iCol) = dbcsAttribute;
+            charRow.SetDbcsAttrAt(iCol, dbcsAttribute);
         }
         catch (...)
         {
@@ -559,6 +654,7 @@ bool TextBuffer::IncrementCircularBuffer(const bool inVtMode)
 
     // Prune hyperlinks to delete obsolete references
     _PruneHyperlinks();
+    _CompactAttributesIfNeeded();
 
     // Second, clean out the old "first row" as it will become the "last row" of the buffer after the circle is performed.
     auto fillAttributes = _currentAttributes;
@@ -580,6 +676,14 @@ bool TextBuffer::IncrementCircularBuffer(const bool inVtMode)
         {
             _firstRow = 0;
         }
+
+        // Every row moved up by one. The render target was told about that through
+        // TriggerCircling() already. The new last row was cleared, which does count as a change.
+        _RotateNotifiedRevisions(0, 1, _notifiedRevisions.size());
+        if (!_notifiedRevisions.empty())
+        {
+            _notifiedRevisions.back() = RowRevision{};
+        }
     }
     return fSuccess;
 }
@@ -690,16 +794,34 @@ void TextBuffer::ScrollRows(const SHORT firstRow, const SHORT size, const SHORT
 
     // OK. We're about to play games by moving rows around within the deque to
     // scroll a massive region in a faster way than copying things.
-    // To make this easier, first correct the circular buffer to have the first row be 0 again.
-    if (_firstRow != 0)
+    // The rows affected by the rotation are [firstRow + delta, firstRow + size) when scrolling up
+    // and [firstRow, firstRow + size + delta) when scrolling down.
+    const auto affectedTop = gsl::narrow_cast<size_t>(firstRow + std::min<SHORT>(delta, 0));
+    const auto affectedBottom = gsl::narrow_cast<size_t>(firstRow + size + std::max<SHORT>(delta, 0));
+
+    // To make this easier, the affected rows have to be stored contiguously. This is the case unless
+    // they wrap around the end of the circular buffer. Only then do we correct the circular buffer
+    // to have the first row be 0 again, which moves every single row of the buffer. Scrolling within
+    // the margins happens for every line of output and would otherwise touch the whole buffer each time.
+    auto storageTop = (gsl::narrow_cast<size_t>(_firstRow) + affectedTop) % _storage.size();
+    if (storageTop + (affectedBottom - affectedTop) > _storage.size())
     {
         // Rotate the buffer to put the first row at the front.
         std::rotate(_storage.begin(), _storage.begin() + _firstRow, _storage.end());
 
         // The first row is now at the top.
         _firstRow = 0;
+        storageTop = affectedTop;
+
+        // Every row has moved. Renumber them all now, the affected ones are renumbered again below.
+        _RefreshRowIDs(std::nullopt);
     }
 
+    // Translates a row index into an iterator into the storage. Only valid for the affected rows.
+    const auto storageAt = [&](const auto row) {
+        return _storage.begin() + (storageTop + (gsl::narrow_cast<size_t>(row) - affectedTop));
+    };
+
     // Rotate just the subsection specified
     if (delta < 0)
     {
@@ -736,7 +858,8 @@ void TextBuffer::ScrollRows(const SHORT firstRow, const SHORT size, const SHORT
         // | 10
         // | 11
         // - end
-        std::rotate(_storage.begin() + firstRow + delta, _storage.begin() + firstRow, _storage.begin() + firstRow + size);
+        std::rotate(storageAt(firstRow + delta), storageAt(firstRow), storageAt(firstRow + size));
+        _RotateNotifiedRevisions(gsl::narrow_cast<size_t>(firstRow + delta), gsl::narrow_cast<size_t>(firstRow), gsl::narrow_cast<size_t>(firstRow + size));
     }
     else
     {
@@ -773,12 +896,15 @@ void TextBuffer::ScrollRows(const SHORT firstRow, const SHORT size, const SHORT
         // | 10
         // | 11
         // - end
-        std::rotate(_storage.begin() + firstRow, _storage.begin() + firstRow + size, _storage.begin() + firstRow + size + delta);
+        std::rotate(storageAt(firstRow), storageAt(firstRow + size), storageAt(firstRow + size + delta));
+        _RotateNotifiedRevisions(gsl::narrow_cast<size_t>(firstRow), gsl::narrow_cast<size_t>(firstRow + size), gsl::narrow_cast<size_t>(firstRow + size + delta));
     }
 
     // Renumber the IDs now that we've rearranged where the rows sit within the buffer.
-    // Refreshing should also delegate to the UnicodeStorage to re-key all the stored unicode sequences (where applicable).
-    _RefreshRowIDs(std::nullopt);
+    for (auto i = storageTop; i < storageTop + (affectedBottom - affectedTop); ++i)
+    {
+        til::at(_storage, i).SetId(gsl::narrow_cast<SHORT>(i));
+    }
 }
 
 Cursor& TextBuffer::GetCursor() noexcept
@@ -836,6 +962,31 @@ void TextBuffer::ResetLineRenditionRange(const size_t startRow, const size_t end
     }
 }
 
+// Routine Description:
+// - Erases entire rows by resetting them, which is a lot cheaper than filling
+//   them with spaces cell by cell. The rows end up single width and unwrapped.
+// Arguments:
+// - startRow - The first row to erase
+// - endRow - The row after the last one to erase
+// - fillAttributes - The attributes to fill the rows with
+// Return Value:
+// - <none>, throws if the rows can't be reset.
+void TextBuffer::ResetRows(const size_t startRow, const size_t endRow, const TextAttribute& fillAttributes)
+{
+    const auto clampedEnd = std::min(endRow, _storage.size());
+    if (startRow >= clampedEnd)
+    {
+        return;
+    }
+
+    for (auto row = startRow; row < clampedEnd; row++)
+    {
+        THROW_HR_IF(E_OUTOFMEMORY, !GetRowByOffset(row).Reset(fillAttributes));
+    }
+
+    _NotifyPaint(Viewport::FromExclusive({ 0, gsl::narrow_cast<SHORT>(startRow), GetSize().Width(), gsl::narrow_cast<SHORT>(clampedEnd) }));
+}
+
 LineRendition TextBuffer::GetLineRendition(const size_t row) const
 {
     return GetRowByOffset(row).GetLineRendition();
@@ -926,12 +1077,11 @@ void TextBuffer::Reset()
         // add rows if we're growing
         while (_storage.size() < static_cast<size_t>(newSize.Y))
         {
-            _storage.emplace_back(static_cast<short>(_storage.size()), newSize.X, attributes, this);
+            _storage.emplace_back(static_cast<short>(_storage.size()), newSize.X, attributes, this, _attributeTable);
         }
 
         // Now that we've tampered with the row placement, refresh all the row IDs.
-        // Also take advantage of the row ID refresh loop to resize the rows in the X dimension
-        // and cleanup the UnicodeStorage characters that might fall outside the resized buffer.
+        // Also take advantage of the row ID refresh loop to resize the rows in the X dimension.
         _RefreshRowIDs(newSize.X);
 
         // Update the cached size value
@@ -942,40 +1092,21 @@ void TextBuffer::Reset()
     return S_OK;
 }
 
-const UnicodeStorage& TextBuffer::GetUnicodeStorage() const noexcept
-{
-    return _unicodeStorage;
-}
-
-UnicodeStorage& TextBuffer::GetUnicodeStorage() noexcept
-{
-    return _unicodeStorage;
-}
-
 // Routine Description:
 // - Method to help refresh all the Row IDs after manipulating the row
 //   by shuffling pointers around.
-// - This will also update parent pointers that are stored in depth within the buffer
-//   (e.g. it will update CharRow parents pointing at Rows that might have been moved around)
-// - Optionally takes a new row width if we're resizing to perform a resize operation and cleanup
-//   any high unicode (UnicodeStorage) runs while we're already looping through the rows.
+// - Optionally takes a new row width if we're resizing to perform a resize operation
+//   while we're already looping through the rows.
 // Arguments:
 // - newRowWidth - Optional new value for the row width.
 void TextBuffer::_RefreshRowIDs(std::optional<SHORT> newRowWidth)
 {
-    std::unordered_map<SHORT, SHORT> rowMap;
     SHORT i = 0;
     for (auto& it : _storage)
     {
-        // Build a map so we can update Unicode Storage
-        rowMap.emplace(it.GetId(), i);
-
         // Update the IDs
         it.SetId(i++);
 
-        // Also update the char row parent pointers as they can get shuffled up in the rotates.
-        it.GetCharRow().UpdateParent(&it);
-
         // Resize the rows in the X dimension if we have a new width
         if (newRowWidth.has_value())
         {
@@ -983,14 +1114,67 @@ void TextBuffer::_RefreshRowIDs(std::optional<SHORT> newRowWidth)
             THROW_IF_FAILED(it.Resize(newRowWidth.value()));
         }
     }
-
-    // Give the new mapping to Unicode Storage
-    _unicodeStorage.Remap(rowMap, newRowWidth);
 }
 
+// Routine Description:
+// - Notifies the render target that the given region of the buffer was written to.
+// - Only rows whose contents actually changed since they were last reported are
+//   passed on, so that applications which keep redrawing the same text (like
+//   status bars or full screen TUIs) don't cause anything to be repainted.
+//   Consecutive changed rows are reported as a single region.
+// Arguments:
+// - viewport - The region that was written to
 void TextBuffer::_NotifyPaint(const Viewport& viewport) const
 {
-    _renderTarget.TriggerRedraw(viewport);
+    const auto height = _storage.size();
+    if (_notifiedRevisions.size() != height)
+    {
+        // The buffer was resized. Forget everything we knew about it.
+        _notifiedRevisions.assign(height, RowRevision{});
+    }
+
+    const auto top = gsl::narrow_cast<size_t>(std::max<SHORT>(viewport.Top(), 0));
+    const auto bottom = std::min(gsl::narrow_cast<size_t>(std::max<SHORT>(viewport.BottomExclusive(), 0)), height);
+    const auto notify = [&](const size_t begin, const size_t end) {
+        _renderTarget.TriggerRedraw(Viewport::FromExclusive({ viewport.Left(), gsl::narrow_cast<SHORT>(begin), viewport.RightExclusive(), gsl::narrow_cast<SHORT>(end) }));
+    };
+
+    auto damageBegin = bottom;
+    for (auto row = top; row < bottom; ++row)
+    {
+        const auto revision = GetRowByOffset(row).GetRevision();
+        auto& notified = til::at(_notifiedRevisions, row);
+        if (revision != notified)
+        {
+            notified = revision;
+            damageBegin = std::min(damageBegin, row);
+        }
+        else if (damageBegin < row)
+        {
+            notify(damageBegin, row);
+            damageBegin = bottom;
+        }
+    }
+
+    if (damageBegin < bottom)
+    {
+        notify(damageBegin, bottom);
+    }
+}
+
+// Routine Description:
+// - Moves the notified revisions along with the rows they belong to, when rows
+//   are moved around within the buffer. The render target is told about moves
+//   separately, so rows that merely moved don't have to be reported again.
+// - Works just like std::rotate over the logical row indices.
+// Arguments:
+// - first, middle, last - The range of rows to rotate and the row that becomes the first one
+void TextBuffer::_RotateNotifiedRevisions(const size_t first, const size_t middle, const size_t last) noexcept
+{
+    if (_notifiedRevisions.size() == _storage.size() && first <= middle && middle <= last && last <= _notifiedRevisions.size())
+    {
+        std::rotate(_notifiedRevisions.begin() + first, _notifiedRevisions.begin() + middle, _notifiedRevisions.begin() + last);
+    }
 }
 
 // Routine Description:
@@ -1304,6 +1488,38 @@ const COORD TextBuffer::_GetWordEndForSelection(const COORD target, const std::w
     return result;
 }
 
+// Routine Description:
+// - Removes the attributes from the table that aren't used by any row anymore,
+//   once the table is about to run out of handles.
+// - Called before writing to a row, which adds at most one attribute per cell.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void TextBuffer::_CompactAttributesIfNeeded() noexcept
+{
+    if (!_attributeTable.NeedsCompaction(gsl::narrow_cast<size_t>(GetSize().Width())))
+    {
+        return;
+    }
+
+    try
+    {
+        std::vector<bool> used(_attributeTable.size());
+        for (const auto& row : _storage)
+        {
+            row.GetAttrRow()._MarkUsed(used);
+        }
+
+        const auto remap = _attributeTable.Compact(used);
+        for (auto& row : _storage)
+        {
+            row.GetAttrRow()._Remap(remap);
+        }
+    }
+    CATCH_LOG();
+}
+
 void TextBuffer::_PruneHyperlinks()
 {
     // Check the old first row for hyperlink references
@@ -1772,186 +1988,190 @@ const TextBuffer::TextAndColor TextBuffer::GetText(const bool includeCRLF,
 }
 
 // Routine Description:
-// - Generates a CF_HTML compliant structure based on the passed in text and color data
+// - Streams the text data from the selected region into the given sinks, row by
+//   row and in runs of equal colors. Unlike GetText(), this walks the text and
+//   attribute runs of each row directly and never holds more than a single row
+//   in memory, which allows for producing all clipboard formats in one pass.
 // Arguments:
-// - rows - the text and color data we will format & encapsulate
-// - backgroundColor - default background color for characters, also used in padding
-// - fontHeightPoints - the unscaled font height
-// - fontFaceName - the name of the font used
+// - includeCRLF - inject CRLF pairs to the end of each line
+// - trimTrailingWhitespace - remove the trailing whitespace at the end of each line
+// - selectionRects - the rectangular regions from which the data will be extracted from the buffer (i.e.: selection rects)
+// - GetAttributeColors - function used to map TextAttribute to RGB COLORREFs. If null, all runs are reported as black on black.
+// - formatWrappedRows - if set we will apply formatting (CRLF inclusion and whitespace trimming) on wrapped rows
+// - sinks - the sinks receiving the text
 // Return Value:
-// - string containing the generated HTML
-std::string TextBuffer::GenHTML(const TextAndColor& rows,
-                                const int fontHeightPoints,
-                                const std::wstring_view fontFaceName,
-                                const COLORREF backgroundColor)
+// - <none>
+void TextBuffer::ExportText(const bool includeCRLF,
+                            const bool trimTrailingWhitespace,
+                            const std::vector<SMALL_RECT>& selectionRects,
+                            const std::function<std::pair<COLORREF, COLORREF>(const TextAttribute&)>& GetAttributeColors,
+                            const bool formatWrappedRows,
+                            const gsl::span<ITextExportSink* const> sinks) const
 {
-    try
+    struct ColorRun
     {
-        std::ostringstream htmlBuilder;
+        size_t length;
+        std::pair<COLORREF, COLORREF> colors;
+    };
 
-        // First we have to add some standard
-        // HTML boiler plate required for CF_HTML
-        // as part of the HTML Clipboard format
-        const std::string htmlHeader =
-            "<!DOCTYPE><HTML><HEAD></HEAD><BODY>";
-        htmlBuilder << htmlHeader;
+    const bool copyTextColor = GetAttributeColors != nullptr;
 
-        htmlBuilder << "<!--StartFragment -->";
+    // Both are reused for every row to avoid reallocs.
+    std::wstring text;
+    std::vector<ColorRun> runs;
 
-        // apply global style in div element
-        {
-            htmlBuilder << "<DIV STYLE=\"";
-            htmlBuilder << "display:inline-block;";
-            htmlBuilder << "white-space:pre;";
-
-            htmlBuilder << "background-color:";
-            htmlBuilder << Utils::ColorToHexString(backgroundColor);
-            htmlBuilder << ";";
-
-            htmlBuilder << "font-family:";
-            htmlBuilder << "'";
-            htmlBuilder << ConvertToA(CP_UTF8, fontFaceName);
-            htmlBuilder << "',";
-            // even with different font, add monospace as fallback
-            htmlBuilder << "monospace;";
-
-            htmlBuilder << "font-size:";
-            htmlBuilder << fontHeightPoints;
-            htmlBuilder << "pt;";
-
-            // note: MS Word doesn't support padding (in this way at least)
-            htmlBuilder << "padding:";
-            htmlBuilder << 4; // todo: customizable padding
-            htmlBuilder << "px;";
-
-            htmlBuilder << "\">";
-        }
+    for (size_t i = 0; i < selectionRects.size(); ++i)
+    {
+        const auto& rect = til::at(selectionRects, i);
+        const auto& row = GetRowByOffset(gsl::narrow<size_t>(rect.Top));
+        const auto& charRow = row.GetCharRow();
+        const auto& attrRow = row.GetAttrRow();
+        const auto glyphs = charRow.GlyphData();
+        const auto offsets = charRow.GlyphOffsets();
 
-        // copy text and info color from buffer
-        bool hasWrittenAnyText = false;
-        std::optional<COLORREF> fgColor = std::nullopt;
-        std::optional<COLORREF> bkColor = std::nullopt;
-        for (size_t row = 0; row < rows.text.size(); row++)
-        {
-            size_t startOffset = 0;
+        const auto left = gsl::narrow<size_t>(std::max<SHORT>(rect.Left, 0));
+        const auto right = std::min(gsl::narrow<size_t>(rect.Right) + 1, charRow.size());
+
+        text.clear();
+        runs.clear();
+
+        // The attribute runs are walked alongside the columns, so that the
+        // colors only need to be resolved once per run and not once per cell.
+        const auto attrRuns = attrRow._data.runs();
+        auto attrRun = attrRuns.begin();
+        size_t attrRunEnd = attrRun->length;
+        std::pair<COLORREF, COLORREF> colors{};
+        bool hasColors = false;
 
-            if (row != 0)
+        for (auto col = left; col < right; ++col)
+        {
+            while (col >= attrRunEnd)
             {
-                htmlBuilder << "<BR>";
+                ++attrRun;
+                attrRunEnd += attrRun->length;
+                hasColors = false;
             }
 
-            for (size_t col = 0; col < rows.text.at(row).length(); col++)
+            // skip trailing bytes, as their glyph is already part of the leading one
+            if (charRow.DbcsAttrAt(col).IsTrailing())
             {
-                const auto writeAccumulatedChars = [&](bool includeCurrent) {
-                    if (col >= startOffset)
-                    {
-                        const auto unescapedText = ConvertToA(CP_UTF8, std::wstring_view(rows.text.at(row)).substr(startOffset, col - startOffset + includeCurrent));
-                        for (const auto c : unescapedText)
-                        {
-                            switch (c)
-                            {
-                            case '<':
-                                htmlBuilder << "&lt;";
-                                break;
-                            case '>':
-                                htmlBuilder << "&gt;";
-                                break;
-                            case '&':
-                                htmlBuilder << "&amp;";
-                                break;
-                            default:
-                                htmlBuilder << c;
-                            }
-                        }
-
-                        startOffset = col;
-                    }
-                };
-
-                if (rows.text.at(row).at(col) == '\r' || rows.text.at(row).at(col) == '\n')
-                {
-                    // do not include \r nor \n as they don't have color attributes
-                    // and are not HTML friendly. For line break use '<BR>' instead.
-                    writeAccumulatedChars(false);
-                    break;
-                }
-
-                bool colorChanged = false;
-                if (!fgColor.has_value() || rows.FgAttr.at(row).at(col) != fgColor.value())
-                {
-                    fgColor = rows.FgAttr.at(row).at(col);
-                    colorChanged = true;
-                }
-
-                if (!bkColor.has_value() || rows.BkAttr.at(row).at(col) != bkColor.value())
-                {
-                    bkColor = rows.BkAttr.at(row).at(col);
-                    colorChanged = true;
-                }
+                continue;
+            }
 
-                if (colorChanged)
-                {
-                    writeAccumulatedChars(false);
+            const auto begin = til::at(offsets, col);
+            const size_t length = til::at(offsets, col + 1) - begin;
+            text.append(glyphs.substr(begin, length));
 
-                    if (hasWrittenAnyText)
-                    {
-                        htmlBuilder << "</SPAN>";
-                    }
+            if (copyTextColor && !hasColors)
+            {
+                colors = GetAttributeColors(attrRow._table->Get(attrRun->value));
+                hasColors = true;
+            }
 
-                    htmlBuilder << "<SPAN STYLE=\"";
-                    htmlBuilder << "color:";
-                    htmlBuilder << Utils::ColorToHexString(fgColor.value());
-                    htmlBuilder << ";";
-                    htmlBuilder << "background-color:";
-                    htmlBuilder << Utils::ColorToHexString(bkColor.value());
-                    htmlBuilder << ";";
-                    htmlBuilder << "\">";
-                }
+            if (!runs.empty() && runs.back().colors == colors)
+            {
+                runs.back().length += length;
+            }
+            else
+            {
+                runs.push_back({ length, colors });
+            }
+        }
 
-                hasWrittenAnyText = true;
+        // We apply formatting to rows if the row was NOT wrapped or formatting of wrapped rows is allowed
+        const bool shouldFormatRow = formatWrappedRows || !row.WasWrapForced();
 
-                // if this is the last character in the row, flush the whole row
-                if (col == rows.text.at(row).length() - 1)
+        if (trimTrailingWhitespace && shouldFormatRow)
+        {
+            // remove the spaces at the end (aka trim the trailing whitespace)
+            while (!text.empty() && text.back() == UNICODE_SPACE)
+            {
+                text.pop_back();
+                if (--runs.back().length == 0)
                 {
-                    writeAccumulatedChars(true);
+                    runs.pop_back();
                 }
             }
         }
 
-        if (hasWrittenAnyText)
+        // apply CR/LF to the end of the final string, unless we're the last line.
+        const bool lineBreak = includeCRLF && i < selectionRects.size() - 1 && shouldFormatRow;
+
+        for (const auto sink : sinks)
         {
-            // last opened span wasn't closed in loop above, so close it now
-            htmlBuilder << "</SPAN>";
-        }
+            sink->BeginRow(i);
 
-        htmlBuilder << "</DIV>";
+            std::wstring_view remaining{ text };
+            for (const auto& run : runs)
+            {
+                sink->WriteRun(remaining.substr(0, run.length), run.colors.first, run.colors.second);
+                remaining = remaining.substr(run.length);
+            }
 
-        htmlBuilder << "<!--EndFragment -->";
+            if (lineBreak)
+            {
+                sink->WriteLineBreak();
+            }
+        }
+    }
+}
 
-        constexpr std::string_view HtmlFooter = "</BODY></HTML>";
-        htmlBuilder << HtmlFooter;
+// Routine Description:
+// - Feeds data previously retrieved by GetText() into a sink, grouping
+//   consecutive characters of equal colors into runs.
+// - Rows end at the first CR or LF, as these don't have color attributes.
+// Arguments:
+// - rows - the text and color data
+// - sink - the sink receiving the text
+// Return Value:
+// - <none>
+static void _ExportTextAndColor(const TextBuffer::TextAndColor& rows, ITextExportSink& sink)
+{
+    for (size_t row = 0; row < rows.text.size(); ++row)
+    {
+        const std::wstring_view text{ rows.text.at(row) };
+        const auto& fgAttr = rows.FgAttr.at(row);
+        const auto& bkAttr = rows.BkAttr.at(row);
 
-        // once filled with values, there will be exactly 157 bytes in the clipboard header
-        constexpr size_t ClipboardHeaderSize = 157;
+        sink.BeginRow(row);
 
-        // these values are byte offsets from start of clipboard
-        const size_t htmlStartPos = ClipboardHeaderSize;
-        const size_t htmlEndPos = ClipboardHeaderSize + gsl::narrow<size_t>(htmlBuilder.tellp());
-        const size_t fragStartPos = ClipboardHeaderSize + gsl::narrow<size_t>(htmlHeader.length());
-        const size_t fragEndPos = htmlEndPos - HtmlFooter.length();
+        size_t startOffset = 0;
+        size_t col = 0;
+        for (; col < text.size() && text.at(col) != UNICODE_CARRIAGERETURN && text.at(col) != UNICODE_LINEFEED; ++col)
+        {
+            if (fgAttr.at(col) != fgAttr.at(startOffset) || bkAttr.at(col) != bkAttr.at(startOffset))
+            {
+                sink.WriteRun(text.substr(startOffset, col - startOffset), fgAttr.at(startOffset), bkAttr.at(startOffset));
+                startOffset = col;
+            }
+        }
 
-        // header required by HTML 0.9 format
-        std::ostringstream clipHeaderBuilder;
-        clipHeaderBuilder << "Version:0.9\r\n";
-        clipHeaderBuilder << std::setfill('0');
-        clipHeaderBuilder << "StartHTML:" << std::setw(10) << htmlStartPos << "\r\n";
-        clipHeaderBuilder << "EndHTML:" << std::setw(10) << htmlEndPos << "\r\n";
-        clipHeaderBuilder << "StartFragment:" << std::setw(10) << fragStartPos << "\r\n";
-        clipHeaderBuilder << "EndFragment:" << std::setw(10) << fragEndPos << "\r\n";
-        clipHeaderBuilder << "StartSelection:" << std::setw(10) << fragStartPos << "\r\n";
-        clipHeaderBuilder << "EndSelection:" << std::setw(10) << fragEndPos << "\r\n";
+        if (col > startOffset)
+        {
+            sink.WriteRun(text.substr(startOffset, col - startOffset), fgAttr.at(startOffset), bkAttr.at(startOffset));
+        }
+    }
+}
 
-        return clipHeaderBuilder.str() + htmlBuilder.str();
+// Routine Description:
+// - Generates a CF_HTML compliant structure based on the passed in text and color data
+// Arguments:
+// - rows - the text and color data we will format & encapsulate
+// - backgroundColor - default background color for characters, also used in padding
+// - fontHeightPoints - the unscaled font height
+// - fontFaceName - the name of the font used
+// Return Value:
+// - string containing the generated HTML
+std::string TextBuffer::GenHTML(const TextAndColor& rows,
+                                const int fontHeightPoints,
+                                const std::wstring_view fontFaceName,
+                                const COLORREF backgroundColor)
+{
+    try
+    {
+        HtmlExportSink sink{ fontHeightPoints, fontFaceName, backgroundColor };
+        _ExportTextAndColor(rows, sink);
+        return sink.Finish();
     }
     catch (...)
     {
@@ -1968,175 +2188,15 @@ std::string TextBuffer::GenHTML(const TextAndColor& rows,
 // - backgroundColor - default background color for characters, also used in padding
 // - fontHeightPoints - the unscaled font height
 // - fontFaceName - the name of the font used
-// - htmlTitle - value used in title tag of html header. Used to name the application
 // Return Value:
 // - string containing the generated RTF
 std::string TextBuffer::GenRTF(const TextAndColor& rows, const int fontHeightPoints, const std::wstring_view fontFaceName, const COLORREF backgroundColor)
 {
     try
     {
-        std::ostringstream rtfBuilder;
-
-        // start rtf
-        rtfBuilder << "{";
-
-        // Standard RTF header.
-        // This is similar to the header generated by WordPad.
-        // \ansi - specifies that the ANSI char set is used in the current doc
-        // \ansicpg1252 - represents the ANSI code page which is used to perform the Unicode to ANSI conversion when writing RTF text
-        // \deff0 - specifies that the default font for the document is the one at index 0 in the font table
-        // \nouicompat - ?
-        rtfBuilder << "\\rtf1\\ansi\\ansicpg1252\\deff0\\nouicompat";
-
-        // font table
-        rtfBuilder << "{\\fonttbl{\\f0\\fmodern\\fcharset0 " << ConvertToA(CP_UTF8, fontFaceName) << ";}}";
-
-        // map to keep track of colors:
-        // keys are colors represented by COLORREF
-        // values are indices of the corresponding colors in the color table
-        std::unordered_map<COLORREF, int> colorMap;
-        int nextColorIndex = 1; // leave 0 for the default color and start from 1.
-
-        // RTF color table
-        std::ostringstream colorTableBuilder;
-        colorTableBuilder << "{\\colortbl ;";
-        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(backgroundColor))
-                          << "\\green" << static_cast<int>(GetGValue(backgroundColor))
-                          << "\\blue" << static_cast<int>(GetBValue(backgroundColor))
-                          << ";";
-        colorMap[backgroundColor] = nextColorIndex++;
-
-        // content
-        std::ostringstream contentBuilder;
-        contentBuilder << "\\viewkind4\\uc4";
-
-        // paragraph styles
-        // \fs specifies font size in half-points i.e. \fs20 results in a font size
-        // of 10 pts. That's why, font size is multiplied by 2 here.
-        contentBuilder << "\\pard\\slmult1\\f0\\fs" << std::to_string(2 * fontHeightPoints)
-                       << "\\highlight1"
-                       << " ";
-
-        std::optional<COLORREF> fgColor = std::nullopt;
-        std::optional<COLORREF> bkColor = std::nullopt;
-        for (size_t row = 0; row < rows.text.size(); ++row)
-        {
-            size_t startOffset = 0;
-
-            if (row != 0)
-            {
-                contentBuilder << "\\line "; // new line
-            }
-
-            for (size_t col = 0; col < rows.text.at(row).length(); ++col)
-            {
-                const auto writeAccumulatedChars = [&](bool includeCurrent) {
-                    if (col >= startOffset)
-                    {
-                        const auto unescapedText = ConvertToA(CP_UTF8, std::wstring_view(rows.text.at(row)).substr(startOffset, col - startOffset + includeCurrent));
-                        for (const auto c : unescapedText)
-                        {
-                            switch (c)
-                            {
-                            case '\\':
-                            case '{':
-                            case '}':
-                                contentBuilder << "\\" << c;
-                                break;
-                            default:
-                                contentBuilder << c;
-                            }
-                        }
-
-                        startOffset = col;
-                    }
-                };
-
-                if (rows.text.at(row).at(col) == '\r' || rows.text.at(row).at(col) == '\n')
-                {
-                    // do not include \r nor \n as they don't have color attributes.
-                    // For line break use \line instead.
-                    writeAccumulatedChars(false);
-                    break;
-                }
-
-                bool colorChanged = false;
-                if (!fgColor.has_value() || rows.FgAttr.at(row).at(col) != fgColor.value())
-                {
-                    fgColor = rows.FgAttr.at(row).at(col);
-                    colorChanged = true;
-                }
-
-                if (!bkColor.has_value() || rows.BkAttr.at(row).at(col) != bkColor.value())
-                {
-                    bkColor = rows.BkAttr.at(row).at(col);
-                    colorChanged = true;
-                }
-
-                if (colorChanged)
-                {
-                    writeAccumulatedChars(false);
-
-                    int bkColorIndex = 0;
-                    if (colorMap.find(bkColor.value()) != colorMap.end())
-                    {
-                        // color already exists in the map, just retrieve the index
-                        bkColorIndex = colorMap[bkColor.value()];
-                    }
-                    else
-                    {
-                        // color not present in the map, so add it
-                        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(bkColor.value()))
-                                          << "\\green" << static_cast<int>(GetGValue(bkColor.value()))
-                                          << "\\blue" << static_cast<int>(GetBValue(bkColor.value()))
-                                          << ";";
-                        colorMap[bkColor.value()] = nextColorIndex;
-                        bkColorIndex = nextColorIndex++;
-                    }
-
-                    int fgColorIndex = 0;
-                    if (colorMap.find(fgColor.value()) != colorMap.end())
-                    {
-                        // color already exists in the map, just retrieve the index
-                        fgColorIndex = colorMap[fgColor.value()];
-                    }
-                    else
-                    {
-                        // color not present in the map, so add it
-                        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(fgColor.value()))
-                                          << "\\green" << static_cast<int>(GetGValue(fgColor.value()))
-                                          << "\\blue" << static_cast<int>(GetBValue(fgColor.value()))
-                                          << ";";
-                        colorMap[fgColor.value()] = nextColorIndex;
-                        fgColorIndex = nextColorIndex++;
-                    }
-
-                    contentBuilder << "\\highlight" << bkColorIndex
-                                   << "\\cf" << fgColorIndex
-                                   << " ";
-                }
-
-                // if this is the last character in the row, flush the whole row
-                if (col == rows.text.at(row).length() - 1)
-                {
-                    writeAccumulatedChars(true);
-                }
-            }
-        }
-
-        // end colortbl
-        colorTableBuilder << "}";
-
-        // add color table to the final RTF
-        rtfBuilder << colorTableBuilder.str();
-
-        // add the text content to the final RTF
-        rtfBuilder << contentBuilder.str();
-
-        // end rtf
-        rtfBuilder << "}";
-
-        return rtfBuilder.str();
+        RtfExportSink sink{ fontHeightPoints, fontFaceName, backgroundColor };
+        _ExportTextAndColor(rows, sink);
+        return sink.Finish();
     }
     catch (...)
     {
@@ -2224,31 +2284,60 @@ HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
             }
         }
 
-        // Loop through every character in the current row (up to
-        // the "right" boundary, which is one past the final valid
-        // character)
-        for (short iOldCol = 0; iOldCol < iRight; iOldCol++)
+        // Most rows start a logical line in the new buffer and fit into it
+        // without being wrapped. Copy those as a whole. This produces the
+        // same row as the cell by cell loop below, including the attribute
+        // of the last character being extended to the end of the row.
+        if (newBufferPos.X == 0 && iRight > 0 && iRight < newBuffer.GetLineWidth(newBufferPos.Y))
         {
-            if (iOldCol == cOldCursorPos.X && iOldRow == cOldCursorPos.Y)
+            if (iOldRow == cOldCursorPos.Y && cOldCursorPos.X < iRight)
             {
-                cNewCursorPos = newCursor.GetPosition();
+                cNewCursorPos = { cOldCursorPos.X, newBufferPos.Y };
                 fFoundCursorPos = true;
             }
 
             try
             {
-                // TODO: MSFT: 19446208 - this should just use an iterator and the inserter...
-                const auto glyph = row.GetCharRow().GlyphAt(iOldCol);
-                const auto dbcsAttr = row.GetCharRow().DbcsAttrAt(iOldCol);
-                const auto textAttr = row.GetAttrRow().GetAttrByColumn(iOldCol);
-
-                if (!newBuffer.InsertCharacter(glyph, dbcsAttr, textAttr))
+                auto& newRow = newBuffer.GetRowByOffset(newBufferPos.Y);
+                newRow.CopyCellsFrom(row, gsl::narrow_cast<size_t>(iRight));
+                const auto lastAttr = row.GetAttrRow().GetAttrByColumn(gsl::narrow_cast<uint16_t>(iRight - 1));
+                if (!newRow.GetAttrRow().SetAttrToEnd(gsl::narrow_cast<uint16_t>(iRight), lastAttr))
                 {
                     hr = E_OUTOFMEMORY;
-                    break;
                 }
             }
             CATCH_RETURN();
+
+            newCursor.SetXPosition(iRight);
+        }
+        else
+        {
+            // Loop through every character in the current row (up to
+            // the "right" boundary, which is one past the final valid
+            // character)
+            for (short iOldCol = 0; iOldCol < iRight; iOldCol++)
+            {
+                if (iOldCol == cOldCursorPos.X && iOldRow == cOldCursorPos.Y)
+                {
+                    cNewCursorPos = newCursor.GetPosition();
+                    fFoundCursorPos = true;
+                }
+
+                try
+                {
+                    // TODO: MSFT: 19446208 - this should just use an iterator and the inserter...
+                    const auto glyph = row.GetCharRow().GlyphAt(iOldCol);
+                    const auto dbcsAttr = row.GetCharRow().DbcsAttrAt(iOldCol);
+                    const auto textAttr = row.GetAttrRow().GetAttrByColumn(iOldCol);
+
+                    if (!newBuffer.InsertCharacter(glyph, dbcsAttr, textAttr))
+                    {
+                        hr = E_OUTOFMEMORY;
+                        break;
+                    }
+                }
+                CATCH_RETURN();
+            }
         }
 
         // If we found the old row that the caller was interested in, set the
@@ -2522,8 +2611,13 @@ void TextBuffer::CopyHyperlinkMaps(const TextBuffer& other)
 // - An ID that the caller should associate with the given pattern
 const size_t TextBuffer::AddPatternRecognizer(const std::wstring_view regexString)
 {
+    // Compiling a regex is far more expensive than running it,
+    // so we only ever do it once for each pattern.
+    std::wregex regexObj{ regexString.cbegin(), regexString.cend() };
+
     ++_currentPatternId;
-    _idsAndPatterns.emplace(std::make_pair(_currentPatternId, regexString));
+    _idsAndPatterns.emplace(_currentPatternId, std::move(regexObj));
+    _patternCache.clear();
     return _currentPatternId;
 }
 
@@ -2533,6 +2627,7 @@ void TextBuffer::ClearPatternRecognizers() noexcept
 {
     _idsAndPatterns.clear();
     _currentPatternId = 0;
+    _patternCache.clear();
 }
 
 // Method Description:
@@ -2543,10 +2638,25 @@ void TextBuffer::CopyPatterns(const TextBuffer& OtherBuffer)
 {
     _idsAndPatterns = OtherBuffer._idsAndPatterns;
     _currentPatternId = OtherBuffer._currentPatternId;
+    _patternCache.clear();
+}
+
+// Method Description:
+// - Gets the search matches cached for this buffer. They're maintained by Search.
+// - Like the rest of the buffer, the cache must only be used while holding the console lock.
+// Return value:
+// - The cache, which may hold the matches of a different search term.
+TextBuffer::SearchCache& TextBuffer::GetSearchCache() const noexcept
+{
+    return _searchCache;
 }
 
 // Method Description:
 // - Finds patterns within the requested region of the text buffer
+// - Text that wraps across rows is matched as a single line. Matches are
+//   cached for each line and a line is only searched again if the text of
+//   any of its rows changed since the previous call. Scrolling or printing
+//   a few new lines thus only costs as much as searching the new lines.
 // Arguments:
 // - The firstRow to start searching from
 // - The lastRow to search
@@ -2555,49 +2665,41 @@ void TextBuffer::CopyPatterns(const TextBuffer& OtherBuffer)
 PointTree TextBuffer::GetPatterns(const size_t firstRow, const size_t lastRow) const
 {
     PointTree::interval_vector intervals;
+    decltype(_patternCache) cache;
+    std::vector<uint64_t> revisions;
 
-    std::wstring concatAll;
     const auto rowSize = GetRowByOffset(0).size();
-    concatAll.reserve(rowSize * (lastRow - firstRow + 1));
-
-    // to deal with text that spans multiple lines, we will first concatenate
-    // all the text into one string and find the patterns in that string
-    for (auto i = firstRow; i <= lastRow; ++i)
-    {
-        auto& row = GetRowByOffset(i);
-        concatAll += row.GetText();
-    }
 
-    // for each pattern we know of, iterate through the string
-    for (const auto& idAndPattern : _idsAndPatterns)
+    for (auto lineStart = firstRow; lineStart <= lastRow;)
     {
-        std::wregex regexObj{ idAndPattern.second };
+        auto lineEnd = lineStart;
+        while (lineEnd < lastRow && GetRowByOffset(lineEnd).WasWrapForced())
+        {
+            ++lineEnd;
+        }
 
-        // search through the run with our regex object
-        auto words_begin = std::wsregex_iterator(concatAll.begin(), concatAll.end(), regexObj);
-        auto words_end = std::wsregex_iterator();
+        revisions.clear();
+        for (auto i = lineStart; i <= lineEnd; ++i)
+        {
+            revisions.push_back(GetRowByOffset(i).GetCharRow().GetRevision());
+        }
 
-        size_t lenUpToThis = 0;
-        for (auto i = words_begin; i != words_end; ++i)
+        PatternLine line;
+        if (const auto it = _patternCache.find(revisions.front()); it != _patternCache.end() && it->second.revisions == revisions)
         {
-            // record the locations -
-            // when we find a match, the prefix is text that is between this
-            // match and the previous match, so we use the size of the prefix
-            // along with the size of the match to determine the locations
-            size_t prefixSize = 0;
+            line = std::move(it->second);
+        }
+        else
+        {
+            line.revisions = revisions;
+            line.matches = _FindPatterns(lineStart, lineEnd);
+        }
 
-            for (const auto ch : i->prefix().str())
-            {
-                prefixSize += IsGlyphFullWidth(ch) ? 2 : 1;
-            }
-            const auto start = lenUpToThis + prefixSize;
-            size_t matchSize = 0;
-            for (const auto ch : i->str())
-            {
-                matchSize += IsGlyphFullWidth(ch) ? 2 : 1;
-            }
-            const auto end = start + matchSize;
-            lenUpToThis = end;
+        const auto lineOffset = (lineStart - firstRow) * rowSize;
+        for (const auto& match : line.matches)
+        {
+            const auto start = lineOffset + match.start;
+            const auto end = lineOffset + match.end;
 
             const til::point startCoord{ gsl::narrow<SHORT>(start % rowSize), gsl::narrow<SHORT>(start / rowSize) };
             const til::point endCoord{ gsl::narrow<SHORT>(end % rowSize), gsl::narrow<SHORT>(end / rowSize) };
@@ -2607,9 +2709,76 @@ PointTree TextBuffer::GetPatterns(const size_t firstRow, const size_t lastRow) c
             // Keeping these relative to the viewport for now because its the renderer
             // that actually uses these locations and the renderer works relative to
             // the viewport
-            intervals.push_back(PointTree::interval(startCoord, endCoord, idAndPattern.first));
+            intervals.push_back(PointTree::interval(startCoord, endCoord, match.id));
         }
+
+        cache.insert_or_assign(revisions.front(), std::move(line));
+        lineStart = lineEnd + 1;
     }
+
+    // Only keep the lines we've just seen. Everything else has
+    // either scrolled out of view or was overwritten.
+    _patternCache = std::move(cache);
+
     PointTree result(std::move(intervals));
     return result;
 }
+
+// Method Description:
+// - Searches the given rows for all patterns we know of, treating them as one line.
+// Arguments:
+// - The firstRow of the line
+// - The lastRow of the line
+// Return value:
+// - The matches found, with columns relative to the start of firstRow
+std::vector<TextBuffer::PatternMatch> TextBuffer::_FindPatterns(const size_t firstRow, const size_t lastRow) const
+{
+    std::vector<PatternMatch> matches;
+    if (_idsAndPatterns.empty())
+    {
+        return matches;
+    }
+
+    const auto rowSize = GetRowByOffset(0).size();
+
+    // The text of the line, along with the column each of its code units is
+    // in. The final entry in columns is for the end of the line.
+    std::wstring text;
+    std::vector<size_t> columns;
+    text.reserve(rowSize * (lastRow - firstRow + 1));
+    columns.reserve(text.capacity() + 1);
+
+    for (auto i = firstRow; i <= lastRow; ++i)
+    {
+        const auto& charRow = GetRowByOffset(i).GetCharRow();
+        const auto rowOffset = (i - firstRow) * rowSize;
+        for (size_t column = 0; column < charRow.size(); ++column)
+        {
+            if (charRow.DbcsAttrAt(column).IsTrailing())
+            {
+                continue;
+            }
+            const std::wstring_view glyph{ charRow.GlyphAt(column) };
+            text.append(glyph);
+            columns.insert(columns.end(), glyph.size(), rowOffset + column);
+        }
+    }
+    columns.push_back((lastRow - firstRow + 1) * rowSize);
+
+    for (const auto& [id, regexObj] : _idsAndPatterns)
+    {
+        const auto wordsBegin = std::wcregex_iterator(text.data(), text.data() + text.size(), regexObj);
+        const auto wordsEnd = std::wcregex_iterator();
+        for (auto it = wordsBegin; it != wordsEnd; ++it)
+        {
+            const auto position = gsl::narrow_cast<size_t>(it->position());
+            const auto length = gsl::narrow_cast<size_t>(it->length());
+            if (length != 0)
+            {
+                matches.push_back({ id, til::at(columns, position), til::at(columns, position + length) });
+            }
+        }
+    }
+
+    return matches;
+}
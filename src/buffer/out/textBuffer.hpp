@@ -54,7 +54,7 @@ filling in the last row, and updating the screen.
 #include "cursor.h"
 #include "Row.hpp"
 #include "TextAttribute.hpp"
-#include "UnicodeStorage.hpp"
+#include "TextExport.hpp"
 #include "../types/inc/Viewport.hpp"
 
 #include "../buffer/out/textBufferCellIterator.hpp"
@@ -97,6 +97,11 @@ public:
                                  const std::optional<bool> setWrap = std::nullopt,
                                  const std::optional<size_t> limitRight = std::nullopt);
 
+    COORD WriteRun(std::wstring_view& text, const TextAttribute& attributes, const COORD target);
+
+    void WriteCharInfoRect(const gsl::span<const CHAR_INFO> source, const size_t stride, const Microsoft::Console::Types::Viewport& rect);
+    void ReadCharInfoRect(const gsl::span<CHAR_INFO> target, const size_t stride, const Microsoft::Console::Types::Viewport& rect) const;
+
     bool InsertCharacter(const wchar_t wch, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
     bool InsertCharacter(const std::wstring_view chars, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
     bool IncrementCursor();
@@ -124,6 +129,7 @@ public:
 
     void SetCurrentLineRendition(const LineRendition lineRendition);
     void ResetLineRenditionRange(const size_t startRow, const size_t endRow);
+    void ResetRows(const size_t startRow, const size_t endRow, const TextAttribute& fillAttributes);
     LineRendition GetLineRendition(const size_t row) const;
     bool IsDoubleWidthLine(const size_t row) const;
 
@@ -136,9 +142,6 @@ public:
 
     [[nodiscard]] HRESULT ResizeTraditional(const COORD newSize) noexcept;
 
-    const UnicodeStorage& GetUnicodeStorage() const noexcept;
-    UnicodeStorage& GetUnicodeStorage() noexcept;
-
     Microsoft::Console::Render::IRenderTarget& GetRenderTarget() noexcept;
 
     const COORD GetWordStart(const COORD target, const std::wstring_view wordDelimiters, bool accessibilityMode = false, std::optional<til::point> limitOptional = std::nullopt) const;
@@ -174,6 +177,13 @@ public:
                                std::function<std::pair<COLORREF, COLORREF>(const TextAttribute&)> GetAttributeColors = nullptr,
                                const bool formatWrappedRows = false) const;
 
+    void ExportText(const bool includeCRLF,
+                    const bool trimTrailingWhitespace,
+                    const std::vector<SMALL_RECT>& selectionRects,
+                    const std::function<std::pair<COLORREF, COLORREF>(const TextAttribute&)>& GetAttributeColors,
+                    const bool formatWrappedRows,
+                    const gsl::span<ITextExportSink* const> sinks) const;
+
     static std::string GenHTML(const TextAndColor& rows,
                                const int fontHeightPoints,
                                const std::wstring_view fontFaceName,
@@ -200,9 +210,32 @@ public:
     void CopyPatterns(const TextBuffer& OtherBuffer);
     interval_tree::IntervalTree<til::point, size_t> GetPatterns(const size_t firstRow, const size_t lastRow) const;
 
+    // The matches of a search term in each row. It's kept by the buffer, so that
+    // the Search objects of consecutive queries only scan rows that changed.
+    struct SearchCache
+    {
+        struct Line
+        {
+            // The revisions of the row and of all rows that its matches could span.
+            std::vector<uint64_t> revisions;
+            // The columns at which the needle starts within the row.
+            std::vector<size_t> columns;
+        };
+
+        // The needle the lines were searched for, case folded if necessary.
+        std::wstring needle;
+        bool caseSensitive = false;
+        // Keyed by the revision of the text of the row.
+        std::unordered_map<uint64_t, Line> lines;
+    };
+
+    SearchCache& GetSearchCache() const noexcept;
+
 private:
     void _UpdateSize();
     Microsoft::Console::Types::Viewport _size;
+    // The attributes of all rows in _storage, which only hold handles into this table.
+    TextAttributeTable _attributeTable;
     std::vector<ROW> _storage;
     Cursor _cursor;
 
@@ -210,9 +243,6 @@ private:
 
     TextAttribute _currentAttributes;
 
-    // storage location for glyphs that can't fit into the buffer normally
-    UnicodeStorage _unicodeStorage;
-
     std::unordered_map<uint16_t, std::wstring> _hyperlinkMap;
     std::unordered_map<std::wstring, uint16_t> _hyperlinkCustomIdMap;
     uint16_t _currentHyperlinkId;
@@ -229,6 +259,11 @@ private:
     void _AdjustWrapOnCurrentRow(const bool fSet);
 
     void _NotifyPaint(const Microsoft::Console::Types::Viewport& viewport) const;
+    void _RotateNotifiedRevisions(const size_t first, const size_t middle, const size_t last) noexcept;
+
+    // The revision of each row, by logical row index, as of the last time it was
+    // reported to the render target. Rows that didn't change since aren't reported again.
+    mutable std::vector<RowRevision> _notifiedRevisions;
 
     // Assist with maintaining proper buffer state for Double Byte character sequences
     bool _PrepareForDoubleByteSequence(const DbcsAttribute dbcsAttribute);
@@ -246,10 +281,33 @@ private:
     const COORD _GetWordEndForSelection(const COORD target, const std::wstring_view wordDelimiters) const;
 
     void _PruneHyperlinks();
+    void _CompactAttributesIfNeeded() noexcept;
 
-    std::unordered_map<size_t, std::wstring> _idsAndPatterns;
+    std::unordered_map<size_t, std::wregex> _idsAndPatterns;
     size_t _currentPatternId;
 
+    struct PatternMatch
+    {
+        size_t id;
+        // in cells, relative to the beginning of the line the match was found in
+        size_t start;
+        size_t end;
+    };
+
+    struct PatternLine
+    {
+        std::vector<uint64_t> revisions;
+        std::vector<PatternMatch> matches;
+    };
+
+    // The matches found by the last call to GetPatterns(),
+    // keyed by the revision of the first row of each line.
+    mutable std::unordered_map<uint64_t, PatternLine> _patternCache;
+
+    mutable SearchCache _searchCache;
+
+    std::vector<PatternMatch> _FindPatterns(const size_t firstRow, const size_t lastRow) const;
+
 #ifdef UNIT_TESTING
     friend class TextBufferTests;
     friend class UiaTextRangeTests;
@@ -0,0 +1,116 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../CharRow.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class CharRowTests
+{
+    TEST_CLASS(CharRowTests);
+
+    TEST_METHOD(CanOverwriteEmoji)
+    {
+        CharRow charRow{ 10 };
+        const std::vector<wchar_t> newMoon{ 0xD83C, 0xDF11 };
+        const std::vector<wchar_t> fullMoon{ 0xD83C, 0xDF15 };
+
+        // store initial glyph
+        charRow.GlyphAt(1) = { newMoon.data(), newMoon.size() };
+
+        // verify it was stored
+        VERIFY_IS_TRUE(charRow.GlyphAt(1) == newMoon);
+
+        // overwrite it
+        charRow.GlyphAt(1) = { fullMoon.data(), fullMoon.size() };
+
+        // verify the glyph was overwritten and nothing else changed
+        VERIFY_IS_TRUE(charRow.GlyphAt(1) == fullMoon);
+        VERIFY_IS_TRUE(charRow.GlyphAt(0) == std::vector<wchar_t>{ L' ' });
+        VERIFY_IS_TRUE(charRow.GlyphAt(2) == std::vector<wchar_t>{ L' ' });
+        VERIFY_ARE_EQUAL(11u, charRow._chars.size());
+    }
+
+    TEST_METHOD(GlyphsOfDifferentLengthsKeepOffsetsConsistent)
+    {
+        CharRow charRow{ 6 };
+
+        charRow.GlyphAt(0) = L"a";
+        charRow.GlyphAt(1) = L"\xD83C\xDF46"; // 🍆
+        charRow.GlyphAt(2) = L"e\x0301\x0323"; // e + 2 combining marks
+        charRow.GlyphAt(4) = L"b";
+
+        VERIFY_ARE_EQUAL(String(L"a\xD83C\xDF46"
+                                L"e\x0301\x0323 b "),
+                         String(charRow.GetText().c_str()));
+        VERIFY_ARE_EQUAL(5u, charRow.MeasureRight());
+
+        // Shrinking a glyph in the middle of the row must move all following ones.
+        charRow.GlyphAt(1) = L"c";
+        VERIFY_ARE_EQUAL(String(L"ace\x0301\x0323 b "), String(charRow.GetText().c_str()));
+
+        // ...and so must growing one.
+        charRow.GlyphAt(3) = L"\xD83C\xDF51"; // 🍑
+        VERIFY_ARE_EQUAL(String(L"ace\x0301\x0323\xD83C\xDF51"
+                                L"b "),
+                         String(charRow.GetText().c_str()));
+
+        const std::wstring_view expected[]{ L"a", L"c", L"e\x0301\x0323", L"\xD83C\xDF51", L"b", L" " };
+        for (size_t i = 0; i < std::size(expected); ++i)
+        {
+            const std::wstring_view glyph{ charRow.GlyphAt(i) };
+            VERIFY_ARE_EQUAL(String(expected[i].data(), gsl::narrow<int>(expected[i].size())), String(glyph.data(), gsl::narrow<int>(glyph.size())));
+        }
+
+        VERIFY_ARE_EQUAL(charRow._chars.size(), static_cast<size_t>(charRow._charOffsets.back()));
+
+        charRow.Reset();
+        VERIFY_IS_FALSE(charRow.ContainsText());
+        VERIFY_ARE_EQUAL(6u, charRow._chars.size());
+    }
+
+    TEST_METHOD(ResizeKeepsGlyphs)
+    {
+        CharRow charRow{ 4 };
+
+        charRow.GlyphAt(0) = L"\xD83C\xDF46";
+        charRow.GlyphAt(3) = L"\xD83C\xDF51";
+
+        VERIFY_SUCCEEDED(charRow.Resize(6));
+        VERIFY_ARE_EQUAL(6u, charRow.size());
+        VERIFY_ARE_EQUAL(String(L"\xD83C\xDF46  \xD83C\xDF51  "), String(charRow.GetText().c_str()));
+        VERIFY_ARE_EQUAL(4u, charRow.MeasureRight());
+
+        // Cutting off the last emoji must remove its text as well.
+        VERIFY_SUCCEEDED(charRow.Resize(3));
+        VERIFY_ARE_EQUAL(3u, charRow.size());
+        VERIFY_ARE_EQUAL(String(L"\xD83C\xDF46  "), String(charRow.GetText().c_str()));
+        VERIFY_ARE_EQUAL(charRow._chars.size(), static_cast<size_t>(charRow._charOffsets.back()));
+    }
+
+    TEST_METHOD(OnlyChangingDbcsAttributesChangesRevision)
+    {
+        CharRow charRow{ 4 };
+        const auto revision = charRow.GetRevision();
+
+        Log::Comment(L"Reading through a non-const row must keep the revision.");
+        VERIFY_IS_TRUE(charRow.DbcsAttrAt(1).IsSingle());
+        VERIFY_ARE_EQUAL(revision, charRow.GetRevision());
+
+        Log::Comment(L"Setting the attribute a cell already has must keep the revision.");
+        charRow.SetDbcsAttrAt(1, DbcsAttribute{});
+        VERIFY_ARE_EQUAL(revision, charRow.GetRevision());
+
+        DbcsAttribute leading;
+        leading.SetLeading();
+        charRow.SetDbcsAttrAt(1, leading);
+        VERIFY_IS_TRUE(charRow.DbcsAttrAt(1).IsLeading());
+        VERIFY_ARE_NOT_EQUAL(revision, charRow.GetRevision());
+    }
+};
@@ -746,21 +746,21 @@ class ReflowTests
             row.SetWrapForced(testRow.wrap);
 
             size_t j{};
-            for (auto it{ charRow.begin() }; it != charRow.end(); ++it)
+            for (size_t col{}; col < charRow.size(); ++col)
             {
                 // Yes, we're about to manually create a buffer. It is unpleasant.
                 const auto ch{ til::at(testRow.text, j) };
-                it->Char() = ch;
+                charRow.GlyphAt(col) = { &ch, 1 };
                 if (IsGlyphFullWidth(ch))
                 {
-                    it->DbcsAttr().SetLeading();
-                    it++;
-                    it->Char() = ch;
-                    it->DbcsAttr().SetTrailing();
+                    charRow.DbcsAttrAt(col).SetLeading();
+                    col++;
+                    charRow.GlyphAt(col) = { &ch, 1 };
+                    charRow.DbcsAttrAt(col).SetTrailing();
                 }
                 else
                 {
-                    it->DbcsAttr().SetSingle();
+                    charRow.DbcsAttrAt(col).SetSingle();
                 }
                 j++;
             }
@@ -795,27 +795,27 @@ class ReflowTests
             VERIFY_ARE_EQUAL(testRow.wrap, row.WasWrapForced(), indexString);
 
             size_t j{};
-            for (auto it{ charRow.begin() }; it != charRow.end(); ++it)
+            for (size_t col{}; col < charRow.size(); ++col)
             {
-                indexString.Format(L"[Cell %d, %d; Text line index %d]", it - charRow.begin(), i, j);
+                indexString.Format(L"[Cell %d, %d; Text line index %d]", col, i, j);
                 // Yes, we're about to manually create a buffer. It is unpleasant.
                 const auto ch{ til::at(testRow.text, j) };
                 if (IsGlyphFullWidth(ch))
                 {
                     // Char is full width in test buffer, so
                     // ensure that real buffer is LEAD, TRAIL (ch)
-                    VERIFY_IS_TRUE(it->DbcsAttr().IsLeading(), indexString);
-                    VERIFY_ARE_EQUAL(ch, it->Char(), indexString);
+                    VERIFY_IS_TRUE(charRow.DbcsAttrAt(col).IsLeading(), indexString);
+                    VERIFY_ARE_EQUAL(ch, *charRow.GlyphAt(col).begin(), indexString);
 
-                    it++;
-                    VERIFY_IS_TRUE(it->DbcsAttr().IsTrailing(), indexString);
+                    col++;
+                    VERIFY_IS_TRUE(charRow.DbcsAttrAt(col).IsTrailing(), indexString);
                 }
                 else
                 {
-                    VERIFY_IS_TRUE(it->DbcsAttr().IsSingle(), indexString);
+                    VERIFY_IS_TRUE(charRow.DbcsAttrAt(col).IsSingle(), indexString);
                 }
 
-                VERIFY_ARE_EQUAL(ch, it->Char(), indexString);
+                VERIFY_ARE_EQUAL(ch, *charRow.GlyphAt(col).begin(), indexString);
                 j++;
             }
             i++;
@@ -851,6 +851,57 @@ class ReflowTests
             _compareTextBufferAgainstTestBuffer(*textBuffer, testBuffer);
         }
     }
+
+    TEST_METHOD(ResizeLatencyBenchmark)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        // Typical shell history: mostly short lines, some colored, now and then one that wraps.
+        const std::wstring_view lines[]{
+            L"PS C:\\src\\terminal> git status",
+            L"On branch main",
+            L"        modified:   src/buffer/out/textBuffer.cpp",
+            L"  0 Warning(s), 0 Error(s) -- the quick brown fox jumps over the lazy dog, the quick brown fox jumps over the lazy dog",
+            L"",
+        };
+        TextAttribute colored{ 0x7 };
+        colored.SetIndexedForeground(FOREGROUND_GREEN);
+
+        constexpr SHORT width = 120;
+        constexpr SHORT viewportHeight = 30;
+
+        for (const int scrollback : { 0, 1000, 3000, 9001 - viewportHeight })
+        {
+            const auto height = gsl::narrow<SHORT>(scrollback + viewportHeight);
+            auto textBuffer = std::make_unique<TextBuffer>(COORD{ width, height }, TextAttribute{ 0x7 }, 0, target);
+            for (SHORT row = 0; row < height - 1; ++row)
+            {
+                const auto text = til::at(lines, row % std::size(lines));
+                const auto attr = row % 3 ? textBuffer->GetCurrentAttributes() : colored;
+                for (const auto ch : text)
+                {
+                    VERIFY_IS_TRUE(textBuffer->InsertCharacter(ch, DbcsAttribute{}, attr));
+                }
+                VERIFY_IS_TRUE(textBuffer->NewlineCursor());
+            }
+
+            // Drag the window edge back and forth, one column per step.
+            constexpr SHORT steps = 20;
+            const auto now = std::chrono::steady_clock::now();
+            for (SHORT step = 1; step <= steps; ++step)
+            {
+                const auto newWidth = gsl::narrow_cast<SHORT>(step % 2 ? width - 1 : width);
+                auto newBuffer = std::make_unique<TextBuffer>(COORD{ newWidth, height }, TextAttribute{ 0x7 }, 0, target);
+                VERIFY_SUCCEEDED(TextBuffer::Reflow(*textBuffer, *newBuffer, std::nullopt, std::nullopt));
+                std::swap(textBuffer, newBuffer);
+            }
+            const auto delta = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - now).count();
+
+            Log::Comment(String().Format(L"%d rows of scrollback: %.2f ms per resize", scrollback, delta / steps));
+        }
+    }
 };
 
 DummyRenderTarget ReflowTests::target{};
@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../TextAttributeTable.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class TextAttributeTableTests
+{
+    TEST_CLASS(TextAttributeTableTests);
+
+    static TextAttribute _MakeAttribute(const size_t index)
+    {
+        TextAttribute attr;
+        attr.SetForeground(RGB(index & 0xff, (index >> 8) & 0xff, 0x80));
+        return attr;
+    }
+
+    TEST_METHOD(InternReturnsStableHandles)
+    {
+        TextAttributeTable table;
+        VERIFY_ARE_EQUAL(1u, table.size());
+        VERIFY_ARE_EQUAL(0u, table.Intern(TextAttribute{}));
+
+        const auto red = _MakeAttribute(1);
+        const auto blue = _MakeAttribute(2);
+        const auto redHandle = table.Intern(red);
+        const auto blueHandle = table.Intern(blue);
+
+        VERIFY_ARE_NOT_EQUAL(redHandle, blueHandle);
+        VERIFY_ARE_EQUAL(redHandle, table.Intern(red));
+        VERIFY_ARE_EQUAL(3u, table.size());
+        VERIFY_ARE_EQUAL(red, table.Get(redHandle));
+        VERIFY_ARE_EQUAL(blue, table.Get(blueHandle));
+
+        VERIFY_ARE_EQUAL(blueHandle, table.Find(blue).value());
+        VERIFY_IS_FALSE(table.Find(_MakeAttribute(3)).has_value());
+    }
+
+    TEST_METHOD(CompactKeepsUsedAttributes)
+    {
+        TextAttributeTable table;
+        std::vector<TextAttributeTable::handle_type> handles;
+        for (size_t i = 1; i <= 10; ++i)
+        {
+            handles.emplace_back(table.Intern(_MakeAttribute(i)));
+        }
+
+        // Only keep every third attribute.
+        std::vector<bool> used(table.size());
+        for (size_t i = 0; i < handles.size(); i += 3)
+        {
+            used.at(handles.at(i)) = true;
+        }
+
+        const auto remap = table.Compact(used);
+        VERIFY_ARE_EQUAL(5u, table.size());
+        VERIFY_ARE_EQUAL(TextAttribute{}, table.Get(0));
+        for (size_t i = 0; i < handles.size(); ++i)
+        {
+            const auto attr = _MakeAttribute(i + 1);
+            if (i % 3 == 0)
+            {
+                VERIFY_ARE_EQUAL(attr, table.Get(remap.at(handles.at(i))));
+                VERIFY_ARE_EQUAL(remap.at(handles.at(i)), table.Find(attr).value());
+            }
+            else
+            {
+                VERIFY_IS_FALSE(table.Find(attr).has_value());
+            }
+        }
+    }
+
+    TEST_METHOD(NeedsCompactionKeepsHeadroomFree)
+    {
+        TextAttributeTable table;
+        VERIFY_IS_FALSE(table.NeedsCompaction());
+        VERIFY_IS_FALSE(table.NeedsCompaction(TextAttributeTable::MaxSize - 1));
+        VERIFY_IS_TRUE(table.NeedsCompaction(TextAttributeTable::MaxSize));
+    }
+
+    TEST_METHOD(FullTableThrowsInsteadOfFallingBackToDefault)
+    {
+        TextAttributeTable table;
+        for (size_t i = 1; i < TextAttributeTable::MaxSize; ++i)
+        {
+            table.Intern(_MakeAttribute(i));
+        }
+
+        VERIFY_ARE_EQUAL(TextAttributeTable::MaxSize, table.size());
+        VERIFY_IS_TRUE(table.NeedsCompaction());
+        VERIFY_THROWS(table.Intern(_MakeAttribute(TextAttributeTable::MaxSize)), wil::ResultException);
+
+        // Attributes that are part of the table can still be looked up.
+        VERIFY_ARE_EQUAL(0u, table.Intern(TextAttribute{}));
+        VERIFY_ARE_EQUAL(1u, table.Intern(_MakeAttribute(1)));
+        VERIFY_ARE_EQUAL(TextAttributeTable::MaxSize, table.size());
+
+        table.Clear();
+        VERIFY_ARE_EQUAL(1u, table.size());
+        VERIFY_IS_FALSE(table.NeedsCompaction());
+        VERIFY_ARE_EQUAL(1u, table.Intern(_MakeAttribute(1)));
+    }
+};
@@ -592,11 +592,70 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
     }
 
     DWORD ConptyConnection::_OutputThread()
+    try
     {
         // Keep us alive until the output thread terminates; the destructor
         // won't wait for us, and the known exit points _do_.
         auto strongThis{ get_strong() };
 
+        auto channel = til::spsc::channel<std::wstring>(_outputQueueCapacity);
+        auto producer = std::move(channel.first);
+
+        // The event handlers usually need to acquire the terminal's lock, which the UI and
+        // render threads hold while they paint, select or scroll. Calling them on a separate
+        // thread allows us to keep draining the pipe (and the pseudoconsole to keep running) meanwhile.
+        std::thread dispatchThread{ [this, consumer = std::move(channel.second)]() {
+            _DispatchOutput(consumer);
+        } };
+
+        // Dropping the producer tells the dispatch thread to exit once it handed off all queued output.
+        // This has to happen even if reading throws, since destroying a joinable thread terminates us.
+        auto joinDispatchThread = wil::scope_exit([&]() noexcept {
+            {
+                const auto dropped = std::move(producer);
+            }
+            dispatchThread.join();
+        });
+
+        const auto hr = _ReadOutput(producer);
+        joinDispatchThread.reset();
+
+#pragma warning(suppress : 26477 26485 26494 26482 26446) // We don't control TraceLoggingWrite
+        TraceLoggingWrite(g_hTerminalConnectionProvider,
+                          "OutputQueueStatistics",
+                          TraceLoggingDescription("An event emitted when the connection stops reading output"),
+                          TraceLoggingGuid(_guid, "SessionGuid", "The WT_SESSION's GUID"),
+                          TraceLoggingUInt32(_outputQueuePeakDepth, "PeakQueueDepth", "The largest number of chunks waiting to be handed off"),
+                          TraceLoggingUInt64(_outputBatches, "Batches", "The number of times the event handlers were called"),
+                          TraceLoggingFloat64(std::chrono::duration<double>(_outputDispatchWait).count(), "DispatchDuration", "The time spent waiting for the event handlers, mostly on the terminal's lock"),
+                          TraceLoggingKeyword(MICROSOFT_KEYWORD_MEASURES),
+                          TelemetryPrivacyDataTag(PDT_ProductAndServicePerformance));
+
+        if (FAILED(hr))
+        {
+            // EXIT POINT
+            // This happens only now, so that the message is printed after all of the output.
+            _indicateExitWithStatus(hr); // print a message
+            _transitionToState(ConnectionState::Failed);
+        }
+
+        return gsl::narrow_cast<DWORD>(hr);
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        return gsl::narrow_cast<DWORD>(wil::ResultFromCaughtException());
+    }
+
+    // Method Description:
+    // - Reads the output pipe in a loop and queues the decoded output for the dispatch thread.
+    //   Blocks whenever the queue is full, which applies backpressure onto the pseudoconsole.
+    // Arguments:
+    // - producer: the sending end of the queue
+    // Return Value:
+    // - S_OK if the pipe was closed, or the failure that should be reported to the user
+    HRESULT ConptyConnection::_ReadOutput(const til::spsc::producer<std::wstring>& producer)
+    {
         // process the data of the output pipe in a loop
         while (true)
         {
@@ -608,10 +667,7 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 const auto lastError = GetLastError();
                 if (lastError != ERROR_BROKEN_PIPE && !_isStateAtOrBeyond(ConnectionState::Closing))
                 {
-                    // EXIT POINT
-                    _indicateExitWithStatus(HRESULT_FROM_WIN32(lastError)); // print a message
-                    _transitionToState(ConnectionState::Failed);
-                    return gsl::narrow_cast<DWORD>(HRESULT_FROM_WIN32(lastError));
+                    return HRESULT_FROM_WIN32(lastError);
                 }
                 // else we call convertUTF8ChunkToUTF16 with an empty string_view to convert possible remaining partials to U+FFFD
             }
@@ -622,18 +678,15 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 if (_isStateAtOrBeyond(ConnectionState::Closing))
                 {
                     // This termination was expected.
-                    return 0;
+                    return S_OK;
                 }
 
-                // EXIT POINT
-                _indicateExitWithStatus(result); // print a message
-                _transitionToState(ConnectionState::Failed);
-                return gsl::narrow_cast<DWORD>(result);
+                return result;
             }
 
             if (_u16Str.empty())
             {
-                return 0;
+                return S_OK;
             }
 
             if (!_receivedFirstByte)
@@ -652,11 +705,55 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 _receivedFirstByte = true;
             }
 
-            // Pass the output to our registered event handlers
-            _TerminalOutputHandlers(_u16Str);
+            // Pass the output on to the dispatch thread. The depth is incremented
+            // first, since the dispatch thread might pop the chunk immediately.
+            const auto depth = _outputQueueDepth.fetch_add(1, std::memory_order_relaxed) + 1;
+            _outputQueuePeakDepth = std::max(_outputQueuePeakDepth, depth);
+            if (!producer.emplace(std::move(_u16Str)))
+            {
+                return S_OK;
+            }
+            _u16Str.clear();
         }
+    }
+
+    // Method Description:
+    // - Hands the queued output to our registered event handlers until the output thread is done.
+    //   All chunks which queued up while the handlers were busy are joined and passed on at once,
+    //   so that the terminal only needs to acquire its lock and parse once for all of them.
+    // Arguments:
+    // - consumer: the receiving end of the queue
+    void ConptyConnection::_DispatchOutput(const til::spsc::consumer<std::wstring>& consumer)
+    {
+        std::array<std::wstring, _outputBatchSize> chunks;
+        std::wstring batch;
+
+        while (true)
+        {
+            const auto count = consumer.pop_n(til::spsc::block_initially, chunks.begin(), chunks.size()).first;
+            if (count == 0)
+            {
+                // The producer is gone and there's nothing left in the queue.
+                return;
+            }
+
+            _outputQueueDepth.fetch_sub(gsl::narrow_cast<uint32_t>(count), std::memory_order_relaxed);
+
+            batch.clear();
+            for (size_t i = 0; i < count; ++i)
+            {
+                batch.append(til::at(chunks, i));
+            }
 
-        return 0;
+            const auto start = std::chrono::steady_clock::now();
+            try
+            {
+                _TerminalOutputHandlers(batch);
+            }
+            CATCH_LOG();
+            _outputDispatchWait += std::chrono::steady_clock::now() - start;
+            ++_outputBatches;
+        }
     }
 
     static winrt::event<NewConnectionHandler> _newConnectionHandlers;
@@ -87,7 +87,19 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         std::wstring _u16Str{};
         std::array<char, 4096> _buffer{};
 
+        // The output thread drains the pipe and queues the decoded chunks, while a
+        // dispatch thread hands them to our event handlers in batches. Once the queue
+        // is full, the output thread stops reading from the pipe until there's room.
+        static constexpr uint32_t _outputQueueCapacity{ 64 };
+        static constexpr size_t _outputBatchSize{ 16 };
+        std::atomic<uint32_t> _outputQueueDepth{ 0 };
+        uint32_t _outputQueuePeakDepth{ 0 }; // only accessed by the output thread
+        uint64_t _outputBatches{ 0 }; // only accessed by the dispatch thread
+        std::chrono::steady_clock::duration _outputDispatchWait{}; // only accessed by the dispatch thread
+
         DWORD _OutputThread();
+        HRESULT _ReadOutput(const til::spsc::producer<std::wstring>& producer);
+        void _DispatchOutput(const til::spsc::consumer<std::wstring>& consumer);
     };
 }
 
@@ -959,35 +959,36 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             return false;
         }
 
-        // extract text from buffer
-        // RetrieveSelectedTextFromBuffer will lock while it's reading
-        const auto bufferData = _terminal->RetrieveSelectedTextFromBuffer(singleLine);
+        const auto fontHeightPoints = _actualFont.GetUnscaledSize().Y;
+        const auto fontFaceName = _actualFont.GetFaceName();
+        const til::color backgroundColor{ _settings.DefaultBackground() };
 
-        // convert text: vector<string> --> string
-        std::wstring textData;
-        for (const auto& text : bufferData.text)
-        {
-            textData += text;
-        }
-
-        // convert text to HTML format
+        // The plain text, HTML and RTF are all generated in a single pass over
+        // the buffer, instead of first gathering the colors of every cell.
         // GH#5347 - Don't provide a title for the generated HTML, as many
         // web applications will paste the title first, followed by the HTML
         // content, which is unexpected.
-        const auto htmlData = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::HTML) ?
-                                  TextBuffer::GenHTML(bufferData,
-                                                      _actualFont.GetUnscaledSize().Y,
-                                                      _actualFont.GetFaceName(),
-                                                      til::color{ _settings.DefaultBackground() }) :
-                                  "";
-
-        // convert to RTF format
-        const auto rtfData = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::RTF) ?
-                                 TextBuffer::GenRTF(bufferData,
-                                                    _actualFont.GetUnscaledSize().Y,
-                                                    _actualFont.GetFaceName(),
-                                                    til::color{ _settings.DefaultBackground() }) :
-                                 "";
+        PlainTextExportSink textSink;
+        std::optional<HtmlExportSink> htmlSink;
+        std::optional<RtfExportSink> rtfSink;
+        std::vector<ITextExportSink*> sinks{ &textSink };
+
+        if (formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::HTML))
+        {
+            sinks.emplace_back(&htmlSink.emplace(fontHeightPoints, fontFaceName, backgroundColor));
+        }
+        if (formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::RTF))
+        {
+            sinks.emplace_back(&rtfSink.emplace(fontHeightPoints, fontFaceName, backgroundColor));
+        }
+
+        // extract text from buffer
+        // ExportSelectedText will lock while it's reading
+        _terminal->ExportSelectedText(singleLine, sinks);
+
+        const auto& textData = textSink.Text();
+        const auto htmlData = htmlSink ? htmlSink->Finish() : "";
+        const auto rtfData = rtfSink ? rtfSink->Finish() : "";
 
         if (!_settings.CopyOnSelect())
         {
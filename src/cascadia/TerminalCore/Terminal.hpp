@@ -254,6 +254,7 @@ public:
     static UpdateSelectionParams ConvertKeyEventToUpdateSelectionParams(const ControlKeyStates mods, const WORD vkey);
 
     const TextBuffer::TextAndColor RetrieveSelectedTextFromBuffer(bool trimTrailingWhitespace);
+    void ExportSelectedText(bool singleLine, const gsl::span<ITextExportSink* const> sinks);
 #pragma endregion
 
 private:
@@ -490,6 +490,30 @@ const TextBuffer::TextAndColor Terminal::RetrieveSelectedTextFromBuffer(bool sin
     return _buffer->GetText(includeCRLF, trimTrailingWhitespace, selectionRects, GetAttributeColors, formatWrappedRows);
 }
 
+// Method Description:
+// - Streams the highlighted portion of the text buffer into the given sinks,
+//   formatted the same way as RetrieveSelectedTextFromBuffer() does. This
+//   produces all requested clipboard formats in a single pass.
+// Arguments:
+// - singleLine: collapse all of the text to one line
+// - sinks: the sinks receiving the text and its colors
+// Return Value:
+// - <none>
+void Terminal::ExportSelectedText(bool singleLine, const gsl::span<ITextExportSink* const> sinks)
+{
+    auto lock = LockForReading();
+
+    const auto selectionRects = _GetSelectionRects();
+
+    const auto GetAttributeColors = std::bind(&Terminal::GetAttributeColors, this, std::placeholders::_1);
+
+    // See RetrieveSelectedTextFromBuffer() for the reasoning behind these.
+    const auto includeCRLF = !singleLine || _blockSelection;
+    const auto trimTrailingWhitespace = !singleLine && (!_blockSelection || _trimBlockSelection);
+    const auto formatWrappedRows = _blockSelection;
+    _buffer->ExportText(includeCRLF, trimTrailingWhitespace, selectionRects, GetAttributeColors, formatWrappedRows, sinks);
+}
+
 // Method Description:
 // - convert viewport position to the corresponding location on the buffer
 // Arguments:
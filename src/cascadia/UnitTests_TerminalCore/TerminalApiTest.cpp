@@ -34,6 +34,8 @@ namespace TerminalCoreUnitTests
         // PrintString() is called with more code units than the buffer width.
         TEST_METHOD(PrintStringOfSurrogatePairs);
         TEST_METHOD(CheckDoubleWidthCursor);
+        TEST_METHOD(PrintStringWrapsWideGlyphs);
+        TEST_METHOD(PrintStringThroughputBenchmark);
 
         TEST_METHOD(AddHyperlink);
         TEST_METHOD(AddHyperlinkCustomId);
@@ -259,6 +261,98 @@ void TerminalApiTest::CheckDoubleWidthCursor()
     VERIFY_IS_TRUE(term.IsCursorDoubleWidth());
 }
 
+void TerminalApiTest::PrintStringWrapsWideGlyphs()
+{
+    DummyRenderTarget renderTarget;
+    Terminal term;
+    term.Create({ 100, 100 }, 0, renderTarget);
+
+    auto& tbi = *(term._buffer);
+    auto& cursor = tbi.GetCursor();
+
+    Log::Comment(L"Fill all but the last column and print a wide glyph, which doesn't fit anymore.");
+    term.PrintString(std::wstring(99, L'A') + L"我B");
+
+    const auto& firstRow = tbi.GetRowByOffset(0);
+    VERIFY_IS_TRUE(firstRow.WasWrapForced());
+    VERIFY_IS_TRUE(firstRow.WasDoubleBytePadded());
+    VERIFY_ARE_EQUAL(L" ", tbi.GetCellDataAt({ 99, 0 })->Chars());
+
+    Log::Comment(L"The glyph should've been written to the start of the next row, followed by the rest.");
+    VERIFY_ARE_EQUAL(L"我", tbi.GetCellDataAt({ 0, 1 })->Chars());
+    VERIFY_IS_TRUE(tbi.GetCellDataAt({ 0, 1 })->DbcsAttr().IsLeading());
+    VERIFY_IS_TRUE(tbi.GetCellDataAt({ 1, 1 })->DbcsAttr().IsTrailing());
+    VERIFY_ARE_EQUAL(L"B", tbi.GetCellDataAt({ 2, 1 })->Chars());
+    VERIFY_ARE_EQUAL(COORD({ 3, 1 }), cursor.GetPosition());
+}
+
+void TerminalApiTest::PrintStringThroughputBenchmark()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    // The way Terminal::_WriteBuffer used to print: one code point at a time.
+    const auto printPerCodePoint = [](Terminal& term, const std::wstring_view stringView) {
+        auto& cursor = term._buffer->GetCursor();
+        for (size_t i = 0; i < stringView.size(); i++)
+        {
+            const auto wch = stringView.at(i);
+            COORD proposedCursorPosition = cursor.GetPosition();
+            const auto isSurrogate = wch >= 0xD800 && wch <= 0xDFFF;
+            const OutputCellIterator it{ stringView.substr(i, isSurrogate ? 2 : 1), term._buffer->GetCurrentAttributes() };
+            const auto end = term._buffer->Write(it);
+            const auto inputDistance = end.GetInputDistance(it);
+            if (inputDistance > 0)
+            {
+                proposedCursorPosition.X += gsl::narrow<SHORT>(end.GetCellDistance(it));
+                i += inputDistance - 1;
+            }
+            else
+            {
+                proposedCursorPosition.X = 0;
+                proposedCursorPosition.Y++;
+                i--;
+            }
+            term._AdjustCursorPosition(proposedCursorPosition);
+        }
+    };
+    const auto printPerRow = [](Terminal& term, const std::wstring_view stringView) {
+        term.PrintString(stringView);
+    };
+
+    // Mixed ASCII and CJK, printed in chunks of roughly the size ConPTY writes.
+    std::wstring chunk;
+    while (chunk.size() < 2048)
+    {
+        chunk.append(L"The quick brown fox 跳过了懒狗 jumps over the lazy dog 敏捷的棕色狐狸 ");
+    }
+
+    constexpr size_t targetSize = 100 * 1024 * 1024;
+    const auto chunks = targetSize / (chunk.size() * sizeof(wchar_t));
+
+    for (const auto& [name, print] : { std::pair{ L"per code point", std::function<void(Terminal&, std::wstring_view)>{ printPerCodePoint } },
+                                       std::pair{ L"per row", std::function<void(Terminal&, std::wstring_view)>{ printPerRow } } })
+    {
+        DummyRenderTarget renderTarget;
+        Terminal term;
+        term.Create({ 120, 30 }, 9001, renderTarget);
+        auto& cursor = term._buffer->GetCursor();
+
+        cursor.StartDeferDrawing();
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < chunks; ++i)
+        {
+            print(term, chunk);
+        }
+        const auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+        cursor.EndDeferDrawing();
+
+        const auto megabytes = static_cast<double>(chunks * chunk.size() * sizeof(wchar_t)) / (1024.0 * 1024.0);
+        Log::Comment(WEX::Common::String().Format(L"%s: %.1f MB in %.1f ms -> %.1f MB/s", name, megabytes, delta * 1000.0, megabytes / delta));
+    }
+}
+
 void TerminalCoreUnitTests::TerminalApiTest::AddHyperlink()
 {
     // This is a nearly literal copy-paste of ScreenBufferTests::TestAddHyperlink, adapted for the Terminal
@@ -527,9 +527,34 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 
     try
     {
-        auto events = IInputEvent::Create(buffer);
+        // The records are stored as they are, but we still need to reject
+        // the same invalid event types that IInputEvent::Create() rejects.
+        const auto invalid = std::find_if(buffer.begin(), buffer.end(), [](const INPUT_RECORD& record) {
+            switch (record.EventType)
+            {
+            case KEY_EVENT:
+            case MOUSE_EVENT:
+            case WINDOW_BUFFER_SIZE_EVENT:
+            case MENU_EVENT:
+            case FOCUS_EVENT:
+                return false;
+            default:
+                return true;
+            }
+        });
+        RETURN_HR_IF(E_INVALIDARG, invalid != buffer.end());
 
-        return _WriteConsoleInputWImplHelper(context, events, written, append);
+        // add to InputBuffer
+        if (append)
+        {
+            written = context.Write(buffer);
+        }
+        else
+        {
+            written = context.Prepend(buffer);
+        }
+
+        return S_OK;
     }
     CATCH_RETURN();
 }
@@ -786,7 +811,6 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 {
     try
     {
-        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
         const auto& storageBuffer = context.GetActiveBuffer();
         const auto storageSize = storageBuffer.GetBufferSize().Dimensions();
 
@@ -822,44 +846,13 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
         // The final "request rectangle" or the area inside the buffer we want to read, is the clipped dimensions.
         const auto clippedRequestRectangle = Viewport::FromExclusive(clip);
 
-        // We will start reading the buffer at the point of the top left corner (origin) of the (potentially adjusted) request
-        const auto sourcePoint = clippedRequestRectangle.Origin();
-
-        // Get an iterator to the beginning of the return buffer
-        // We might have to seek this forward or skip around if we clipped the request.
-        auto targetIter = targetBuffer.begin();
-        COORD targetPos = { 0 };
-        const auto targetLimit = Viewport::FromDimensions(targetPoint, clippedRequestRectangle.Dimensions());
-
-        // Get an iterator to the beginning of the request inside the screen buffer
-        // This should walk exactly along every cell of the clipped request.
-        auto sourceIter = storageBuffer.GetCellDataAt(sourcePoint, clippedRequestRectangle);
-
-        // Walk through every cell of the target, advancing the buffer.
-        // Validate that we always still have a valid iterator to the backing store,
-        // that we always are writing inside the user's buffer (before the end)
-        // and we're always targeting the user's buffer inside its original bounds.
-        while (sourceIter && targetIter < targetBuffer.end())
+        // Copy the clipped request row by row into the user's buffer, skipping
+        // the cells of the target that fall outside of the storage buffer.
+        if (clippedRequestRectangle.Width() > 0 && clippedRequestRectangle.Height() > 0)
         {
-            // If the point we're trying to write is inside the limited buffer write zone...
-            if (targetLimit.IsInBounds(targetPos))
-            {
-                // Copy the data into position...
-                *targetIter = gci.AsCharInfo(*sourceIter);
-                // ... and advance the read iterator.
-                sourceIter++;
-            }
-
-            // Always advance the write iterator, we might have skipped it due to clipping.
-            targetIter++;
-
-            // Increment the target
-            targetPos.X++;
-            if (targetPos.X >= targetSize.X)
-            {
-                targetPos.X = 0;
-                targetPos.Y++;
-            }
+            const auto targetOffset = gsl::narrow_cast<size_t>(targetPoint.Y) * targetSize.X + targetPoint.X;
+            RETURN_HR_IF(E_INVALIDARG, targetOffset > targetBuffer.size());
+            storageBuffer.GetTextBuffer().ReadCharInfoRect(targetBuffer.subspan(targetOffset), gsl::narrow_cast<size_t>(targetSize.X), clippedRequestRectangle);
         }
 
         // Reply with the region we read out of the backing buffer (potentially clipped)
@@ -985,34 +978,22 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 
         const auto writeRectangle = Viewport::FromInclusive(writeRegion);
 
-        auto target = writeRectangle.Origin();
-
-        // For every row in the request, create a view into the clamped portion of just the one line to write.
-        // This allows us to restrict the width of the call without allocating/copying any memory by just making
-        // a smaller view over the existing big blob of data from the original call.
-        for (; target.Y < writeRectangle.BottomExclusive(); target.Y++)
-        {
-            // We find the offset into the original buffer by the dimensions of the original request rectangle.
-            ptrdiff_t rowOffset = 0;
-            RETURN_IF_FAILED(PtrdiffTSub(target.Y, requestRectangle.Top(), &rowOffset));
-            RETURN_IF_FAILED(PtrdiffTMult(rowOffset, requestRectangle.Width(), &rowOffset));
+        // We find the offset of the clamped portion into the original buffer by the dimensions of the original request rectangle.
+        // The rows of the clamped portion are then blitted as views into the existing big blob of data
+        // from the original call, without allocating/copying any memory.
+        ptrdiff_t rowOffset = 0;
+        RETURN_IF_FAILED(PtrdiffTSub(writeRectangle.Top(), requestRectangle.Top(), &rowOffset));
+        RETURN_IF_FAILED(PtrdiffTMult(rowOffset, requestRectangle.Width(), &rowOffset));
 
-            ptrdiff_t colOffset = 0;
-            RETURN_IF_FAILED(PtrdiffTSub(target.X, requestRectangle.Left(), &colOffset));
+        ptrdiff_t colOffset = 0;
+        RETURN_IF_FAILED(PtrdiffTSub(writeRectangle.Left(), requestRectangle.Left(), &colOffset));
 
-            ptrdiff_t totalOffset = 0;
-            RETURN_IF_FAILED(PtrdiffTAdd(rowOffset, colOffset, &totalOffset));
+        ptrdiff_t totalOffset = 0;
+        RETURN_IF_FAILED(PtrdiffTAdd(rowOffset, colOffset, &totalOffset));
+        RETURN_HR_IF(E_INVALIDARG, gsl::narrow_cast<size_t>(totalOffset) > buffer.size());
 
-            // Now we make a subspan starting from that offset for as much of the original request as would fit
-            const auto subspan = buffer.subspan(totalOffset, writeRectangle.Width());
-
-            // Convert to a CHAR_INFO view to fit into the iterator
-            const auto charInfos = gsl::span<const CHAR_INFO>(subspan.data(), subspan.size());
-
-            // Make the iterator and write to the target position.
-            OutputCellIterator it(charInfos);
-            storageBuffer.Write(it, target);
-        }
+        const auto source = buffer.subspan(totalOffset);
+        storageBuffer.GetTextBuffer().WriteCharInfoRect({ source.data(), source.size() }, gsl::narrow_cast<size_t>(requestRectangle.Width()), writeRectangle);
 
         // Since we've managed to write part of the request, return the clamped part that we actually used.
         writtenRectangle = writeRectangle;
@@ -2232,14 +2232,42 @@ void DoSrvPrivateMoveToBottom(SCREEN_INFORMATION& screenInfo)
             fillAttrs.SetStandardErase();
         }
 
-        const auto fillData = OutputCellIterator{ fillChar, fillAttrs, fillLength };
-        screenInfo.Write(fillData, startPosition, false);
+        // Erasing entire rows is common (ED erases the whole display, for
+        // instance) and those rows can simply be reset instead of being
+        // filled cell by cell. That would reset their line rendition as
+        // well, though, so this only applies to single width rows.
+        auto& textBuffer = screenInfo.GetTextBuffer();
+        const auto bufferSize = screenInfo.GetBufferSize();
+        const auto bufferWidth = gsl::narrow_cast<size_t>(bufferSize.Width());
+        auto fillStart = startPosition;
+        auto fillRemaining = fillLength;
+        if (fillChar == UNICODE_SPACE && startPosition.X == 0 && bufferSize.IsInBounds(startPosition))
+        {
+            const auto startRow = gsl::narrow_cast<size_t>(startPosition.Y);
+            const auto endRow = std::min(startRow + fillLength / bufferWidth, gsl::narrow_cast<size_t>(bufferSize.Height()));
+            auto row = startRow;
+            while (row < endRow && !textBuffer.IsDoubleWidthLine(row))
+            {
+                ++row;
+            }
+            if (row == endRow)
+            {
+                textBuffer.ResetRows(startRow, endRow, fillAttrs);
+                fillStart.Y = gsl::narrow_cast<SHORT>(endRow);
+                fillRemaining -= (endRow - startRow) * bufferWidth;
+            }
+        }
+
+        if (fillRemaining > 0 && bufferSize.IsInBounds(fillStart))
+        {
+            const auto fillData = OutputCellIterator{ fillChar, fillAttrs, fillRemaining };
+            screenInfo.Write(fillData, fillStart, false);
+        }
 
         // Notify accessibility
         if (screenInfo.HasAccessibilityEventing())
         {
             auto endPosition = startPosition;
-            const auto bufferSize = screenInfo.GetBufferSize();
             bufferSize.MoveInBounds(fillLength - 1, endPosition);
             screenInfo.NotifyAccessibilityEventing(startPosition.X, startPosition.Y, endPosition.X, endPosition.Y);
         }
@@ -6,6 +6,7 @@
 #include "dbcs.h"
 #include "stream.h"
 #include "../types/inc/GlyphWidth.hpp"
+#include "../interactivity/inc/EventSynthesis.hpp"
 
 #include <functional>
 
@@ -13,6 +14,8 @@
 
 #define INPUT_BUFFER_DEFAULT_INPUT_MODE (ENABLE_LINE_INPUT | ENABLE_PROCESSED_INPUT | ENABLE_ECHO_INPUT | ENABLE_MOUSE_INPUT)
 
+using Microsoft::Console::Interactivity::CharToKeyEvents;
+using Microsoft::Console::Interactivity::CharToKeyEventCount;
 using Microsoft::Console::Interactivity::ServiceLocator;
 using Microsoft::Console::VirtualTerminal::TerminalInput;
 using namespace Microsoft::Console;
@@ -153,6 +156,10 @@ void InputBuffer::ReinitializeInputBuffer()
     ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
     InputMode = INPUT_BUFFER_DEFAULT_INPUT_MODE;
     _storage.clear();
+    _pendingText.clear();
+    _pendingTextHead = 0;
+    _pendingTextCounted = 0;
+    _pendingTextEvents = 0;
 }
 
 // Routine Description:
@@ -179,6 +186,8 @@ void InputBuffer::TerminateRead(_In_ WaitTerminationReason Flag)
 
 // Routine Description:
 // - Returns the number of events in the input buffer.
+// - This includes the key events that pending text will turn into. They're
+//   counted without being synthesized, and each character is only counted once.
 // Arguments:
 // - None
 // Return Value:
@@ -187,7 +196,17 @@ void InputBuffer::TerminateRead(_In_ WaitTerminationReason Flag)
 // - The console lock must be held when calling this routine.
 size_t InputBuffer::GetNumberOfReadyEvents() const noexcept
 {
-    return _storage.size();
+    try
+    {
+        const auto pendingChars = _pendingText.size() - _pendingTextHead;
+        for (; _pendingTextCounted < pendingChars; ++_pendingTextCounted)
+        {
+            const auto ch = til::at(_pendingText, _pendingTextHead + _pendingTextCounted);
+            _pendingTextEvents += CharToKeyEventCount(ch, _pendingTextCodepage);
+        }
+    }
+    CATCH_LOG();
+    return _storage.size() + _pendingTextEvents;
 }
 
 // Routine Description:
@@ -201,6 +220,10 @@ size_t InputBuffer::GetNumberOfReadyEvents() const noexcept
 void InputBuffer::Flush()
 {
     _storage.clear();
+    _pendingText.clear();
+    _pendingTextHead = 0;
+    _pendingTextCounted = 0;
+    _pendingTextEvents = 0;
     ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
 }
 
@@ -214,10 +237,10 @@ void InputBuffer::Flush()
 // - The console lock must be held when calling this routine.
 void InputBuffer::FlushAllButKeys()
 {
-    auto newEnd = std::remove_if(_storage.begin(), _storage.end(), [](const std::unique_ptr<IInputEvent>& event) {
-        return event->EventType() != InputEventType::KeyEvent;
+    auto newEnd = std::remove_if(_storage.begin(), _storage.end(), [](const INPUT_RECORD& record) {
+        return record.EventType != KEY_EVENT;
     });
-    _storage.erase(newEnd, _storage.end());
+    _storage.erase_to_end(newEnd);
 }
 
 void InputBuffer::SetTerminalConnection(_In_ ITerminalOutputConnection* const pTtyConnection)
@@ -247,7 +270,7 @@ void InputBuffer::PassThroughWin32MouseRequest(bool enable)
 // Note:
 // - The console lock must be held when calling this routine.
 // Arguments:
-// - OutEvents - deque to store the read events
+// - OutRecords - vector the read records are appended to
 // - AmountToRead - the amount of events to try to read
 // - Peek - If true, copy events to pInputRecord but don't remove them from the input buffer.
 // - WaitForData - if true, wait until an event is input (if there aren't enough to fill client buffer). if false, return immediately
@@ -257,7 +280,7 @@ void InputBuffer::PassThroughWin32MouseRequest(bool enable)
 // - STATUS_SUCCESS if records were read into the client buffer and everything is OK.
 // - CONSOLE_STATUS_WAIT if there weren't enough records to satisfy the request (and waits are allowed)
 // - otherwise a suitable memory/math/string error in NTSTATUS form.
-[[nodiscard]] NTSTATUS InputBuffer::Read(_Out_ std::deque<std::unique_ptr<IInputEvent>>& OutEvents,
+[[nodiscard]] NTSTATUS InputBuffer::Read(_Out_ std::vector<INPUT_RECORD>& OutRecords,
                                          const size_t AmountToRead,
                                          const bool Peek,
                                          const bool WaitForData,
@@ -266,6 +289,9 @@ void InputBuffer::PassThroughWin32MouseRequest(bool enable)
 {
     try
     {
+        // Key events for pending text are only synthesized once they're about to be read.
+        _ExpandPendingText(AmountToRead);
+
         if (_storage.empty())
         {
             if (!WaitForData)
@@ -276,10 +302,9 @@ void InputBuffer::PassThroughWin32MouseRequest(bool enable)
         }
 
         // read from buffer
-        std::deque<std::unique_ptr<IInputEvent>> events;
         size_t eventsRead;
         bool resetWaitEvent;
-        _ReadBuffer(events,
+        _ReadBuffer(OutRecords,
                     AmountToRead,
                     eventsRead,
                     Peek,
@@ -287,13 +312,6 @@ void InputBuffer::PassThroughWin32MouseRequest(bool enable)
                     Unicode,
                     Stream);
 
-        // copy events to outEvents
-        while (!events.empty())
-        {
-            OutEvents.push_back(std::move(events.front()));
-            events.pop_front();
-        }
-
         if (resetWaitEvent)
         {
             ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
@@ -306,6 +324,51 @@ void InputBuffer::PassThroughWin32MouseRequest(bool enable)
     }
 }
 
+// Routine Description:
+// - This routine reads from the input buffer.
+// - Same as the INPUT_RECORD overload, but wraps each read record into an IInputEvent.
+// Note:
+// - The console lock must be held when calling this routine.
+// Arguments:
+// - OutEvents - deque to store the read events
+// - AmountToRead - the amount of events to try to read
+// - Peek - If true, copy events to pInputRecord but don't remove them from the input buffer.
+// - WaitForData - if true, wait until an event is input (if there aren't enough to fill client buffer). if false, return immediately
+// - Unicode - true if the data in key events should be treated as unicode. false if they should be converted by the current input CP.
+// - Stream - true if read should unpack KeyEvents that have a >1 repeat count. AmountToRead must be 1 if Stream is true.
+// Return Value:
+// - STATUS_SUCCESS if records were read into the client buffer and everything is OK.
+// - CONSOLE_STATUS_WAIT if there weren't enough records to satisfy the request (and waits are allowed)
+// - otherwise a suitable memory/math/string error in NTSTATUS form.
+[[nodiscard]] NTSTATUS InputBuffer::Read(_Out_ std::deque<std::unique_ptr<IInputEvent>>& OutEvents,
+                                         const size_t AmountToRead,
+                                         const bool Peek,
+                                         const bool WaitForData,
+                                         const bool Unicode,
+                                         const bool Stream)
+{
+    try
+    {
+        std::vector<INPUT_RECORD> records;
+        const auto Status = Read(records,
+                                 AmountToRead,
+                                 Peek,
+                                 WaitForData,
+                                 Unicode,
+                                 Stream);
+
+        for (const auto& record : records)
+        {
+            OutEvents.push_back(IInputEvent::Create(record));
+        }
+        return Status;
+    }
+    catch (...)
+    {
+        return NTSTATUS_FROM_HRESULT(wil::ResultFromCaughtException());
+    }
+}
+
 // Routine Description:
 // - This routine reads a single event from the input buffer.
 // - It can convert returned data to through the currently set Input CP, it can optionally return a wait condition
@@ -331,16 +394,16 @@ void InputBuffer::PassThroughWin32MouseRequest(bool enable)
     NTSTATUS Status;
     try
     {
-        std::deque<std::unique_ptr<IInputEvent>> outEvents;
-        Status = Read(outEvents,
+        std::vector<INPUT_RECORD> outRecords;
+        Status = Read(outRecords,
                       1,
                       Peek,
                       WaitForData,
                       Unicode,
                       Stream);
-        if (!outEvents.empty())
+        if (!outRecords.empty())
         {
-            outEvent.swap(outEvents.front());
+            outEvent = IInputEvent::Create(outRecords.front());
         }
     }
     catch (...)
@@ -354,7 +417,7 @@ void InputBuffer::PassThroughWin32MouseRequest(bool enable)
 // Routine Description:
 // - This routine reads from a buffer. It does the buffer manipulation.
 // Arguments:
-// - outEvents - where read events are placed
+// - outRecords - where read records are appended
 // - readCount - amount of events to read
 // - eventsRead - where to store number of events read
 // - peek - if true , don't remove data from buffer, just copy it.
@@ -365,7 +428,7 @@ void InputBuffer::PassThroughWin32MouseRequest(bool enable)
 // - <none>
 // Note:
 // - The console lock must be held when calling this routine.
-void InputBuffer::_ReadBuffer(_Out_ std::deque<std::unique_ptr<IInputEvent>>& outEvents,
+void InputBuffer::_ReadBuffer(_Out_ std::vector<INPUT_RECORD>& outRecords,
                               const size_t readCount,
                               _Out_ size_t& eventsRead,
                               const bool peek,
@@ -379,119 +442,79 @@ void InputBuffer::_ReadBuffer(_Out_ std::deque<std::unique_ptr<IInputEvent>>& ou
 
     resetWaitEvent = false;
 
-    std::deque<std::unique_ptr<IInputEvent>> readEvents;
+    const auto initialSize = outRecords.size();
+    // the number of records at the front of _storage that are fully consumed by this read
+    size_t consumed = 0;
     // we need another var to keep track of how many we've read
     // because dbcs records count for two when we aren't doing a
     // unicode read but the eventsRead count should return the number
     // of events actually put into outRecords.
     size_t virtualReadCount = 0;
 
-    while (!_storage.empty() && virtualReadCount < readCount)
+    while (consumed < _storage.size() && virtualReadCount < readCount)
     {
-        bool performNormalRead = true;
-        // for stream reads we need to split any key events that have been coalesced
-        if (streamRead)
+        auto& stored = _storage[consumed];
+        auto& record = outRecords.emplace_back(stored);
+
+        // for stream reads we need to split any key events that have been coalesced.
+        // A peek leaves the stored event untouched, which is equivalent to splitting
+        // it and coalescing the split off event back into it again.
+        if (streamRead && record.EventType == KEY_EVENT && record.Event.KeyEvent.wRepeatCount > 1)
         {
-            if (_storage.front()->EventType() == InputEventType::KeyEvent)
+            record.Event.KeyEvent.wRepeatCount = 1;
+            if (!peek)
             {
-                KeyEvent* const pKeyEvent = static_cast<KeyEvent* const>(_storage.front().get());
-                if (pKeyEvent->GetRepeatCount() > 1)
-                {
-                    // split the key event
-                    std::unique_ptr<KeyEvent> streamKeyEvent = std::make_unique<KeyEvent>(*pKeyEvent);
-                    streamKeyEvent->SetRepeatCount(1);
-                    readEvents.push_back(std::move(streamKeyEvent));
-                    pKeyEvent->SetRepeatCount(pKeyEvent->GetRepeatCount() - 1);
-                    performNormalRead = false;
-                }
+                --stored.Event.KeyEvent.wRepeatCount;
             }
         }
-
-        if (performNormalRead)
+        else
         {
-            readEvents.push_back(std::move(_storage.front()));
-            _storage.pop_front();
+            ++consumed;
         }
 
         ++virtualReadCount;
         if (!unicode)
         {
-            if (readEvents.back()->EventType() == InputEventType::KeyEvent)
+            if (record.EventType == KEY_EVENT && IsGlyphFullWidth(record.Event.KeyEvent.uChar.UnicodeChar))
             {
-                const KeyEvent* const pKeyEvent = static_cast<const KeyEvent* const>(readEvents.back().get());
-                if (IsGlyphFullWidth(pKeyEvent->GetCharData()))
-                {
-                    ++virtualReadCount;
-                }
+                ++virtualReadCount;
             }
         }
     }
 
     // the amount of events that were actually read
-    eventsRead = readEvents.size();
-
-    // copy the events back if we were supposed to peek
-    if (peek)
-    {
-        if (streamRead)
-        {
-            // we need to check and see if the event was split from a coalesced key event
-            // or if it was unrelated to the current front event in storage
-            if (!readEvents.empty() &&
-                !_storage.empty() &&
-                readEvents.back()->EventType() == InputEventType::KeyEvent &&
-                _storage.front()->EventType() == InputEventType::KeyEvent &&
-                _CanCoalesce(static_cast<const KeyEvent&>(*readEvents.back()),
-                             static_cast<const KeyEvent&>(*_storage.front())))
-            {
-                KeyEvent& keyEvent = static_cast<KeyEvent&>(*_storage.front());
-                keyEvent.SetRepeatCount(keyEvent.GetRepeatCount() + 1);
-            }
-            else
-            {
-                _storage.push_front(IInputEvent::Create(readEvents.back()->ToInputRecord()));
-            }
-        }
-        else
-        {
-            for (auto it = readEvents.crbegin(); it != readEvents.crend(); ++it)
-            {
-                _storage.push_front(IInputEvent::Create((*it)->ToInputRecord()));
-            }
-        }
-    }
+    eventsRead = outRecords.size() - initialSize;
 
-    // move events read to proper deque
-    while (!readEvents.empty())
+    // records are only removed from the buffer if we weren't supposed to peek
+    if (!peek)
     {
-        outEvents.push_back(std::move(readEvents.front()));
-        readEvents.pop_front();
+        _storage.pop_front(consumed);
     }
 
     // signal if we emptied the buffer
-    if (_storage.empty())
+    if (_storage.empty() && !_HasPendingText())
     {
         resetWaitEvent = true;
     }
 }
 
 // Routine Description:
-// -  Writes events to the beginning of the input buffer.
+// -  Writes records to the beginning of the input buffer.
 // Arguments:
-// - inEvents - events to write to buffer.
-// - eventsWritten - The number of events written to the buffer on exit.
+// - inRecords - records to write to buffer.
 // Return Value:
-// S_OK if successful.
+// - The number of events written to the buffer.
 // Note:
 // - The console lock must be held when calling this routine.
-size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+size_t InputBuffer::Prepend(const gsl::span<const INPUT_RECORD> inRecords)
 {
     try
     {
         _vtInputShouldSuppress = true;
         auto resetVtInputSuppress = wil::scope_exit([&]() { _vtInputShouldSuppress = false; });
-        _HandleConsoleSuspensionEvents(inEvents);
-        if (inEvents.empty())
+        std::vector<INPUT_RECORD> filteredRecords;
+        const auto records = _HandleConsoleSuspensionEvents(inRecords, filteredRecords);
+        if (records.empty())
         {
             return STATUS_SUCCESS;
         }
@@ -500,23 +523,23 @@ size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& in
         // this way to handle any coalescing that might occur.
 
         // get all of the existing records, "emptying" the buffer
-        std::deque<std::unique_ptr<IInputEvent>> existingStorage;
+        InputRecordQueue existingStorage;
         existingStorage.swap(_storage);
 
         // We will need this variable to pass to _WriteBuffer so it can attempt to determine wait status.
-        // However, because we swapped the storage out from under it with an empty deque, it will always
-        // return true after the first one (as it is filling the newly emptied backing deque.)
+        // However, because we swapped the storage out from under it with an empty queue, it will always
+        // return true after the first one (as it is filling the newly emptied backing queue.)
         // Then after the second one, because we've inserted some input, it will always say false.
         bool unusedWaitStatus = false;
 
         // write the prepend records
         size_t prependEventsWritten;
-        _WriteBuffer(inEvents, prependEventsWritten, unusedWaitStatus);
+        _WriteBuffer(records, prependEventsWritten, unusedWaitStatus);
         FAIL_FAST_IF(!(unusedWaitStatus));
 
         // write all previously existing records
         size_t existingEventsWritten;
-        _WriteBuffer(existingStorage, existingEventsWritten, unusedWaitStatus);
+        _WriteBuffer(existingStorage.span(), existingEventsWritten, unusedWaitStatus);
         FAIL_FAST_IF(!(!unusedWaitStatus));
 
         // We need to set the wait event if there were 0 events in the
@@ -542,23 +565,20 @@ size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& in
 }
 
 // Routine Description:
-// - Writes event to the input buffer. Wakes up any readers that are
-// waiting for additional input events.
+// -  Writes events to the beginning of the input buffer.
 // Arguments:
-// - inEvent - input event to store in the buffer.
+// - inEvents - events to write to buffer. Empty on exit.
 // Return Value:
-// - The number of events that were written to input buffer.
+// - The number of events written to the buffer.
 // Note:
 // - The console lock must be held when calling this routine.
-// - any outside references to inEvent will ben invalidated after
-// calling this method.
-size_t InputBuffer::Write(_Inout_ std::unique_ptr<IInputEvent> inEvent)
+size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
 {
     try
     {
-        std::deque<std::unique_ptr<IInputEvent>> inEvents;
-        inEvents.push_back(std::move(inEvent));
-        return Write(inEvents);
+        const auto records = IInputEvent::ToInputRecords(inEvents);
+        inEvents.clear();
+        return Prepend(records);
     }
     catch (...)
     {
@@ -568,22 +588,40 @@ size_t InputBuffer::Write(_Inout_ std::unique_ptr<IInputEvent> inEvent)
 }
 
 // Routine Description:
-// - Writes events to the input buffer. Wakes up any readers that are
+// - Writes a record to the input buffer. Wakes up any readers that are
 // waiting for additional input events.
 // Arguments:
-// - inEvents - input events to store in the buffer.
+// - inRecord - input record to store in the buffer.
 // Return Value:
 // - The number of events that were written to input buffer.
 // Note:
 // - The console lock must be held when calling this routine.
-size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+size_t InputBuffer::Write(const INPUT_RECORD& inRecord)
+{
+    return Write(gsl::span<const INPUT_RECORD>{ &inRecord, 1 });
+}
+
+// Routine Description:
+// - Writes records to the input buffer. Wakes up any readers that are
+// waiting for additional input events.
+// Arguments:
+// - inRecords - input records to store in the buffer.
+// Return Value:
+// - The number of events that were written to input buffer.
+// Note:
+// - The console lock must be held when calling this routine.
+size_t InputBuffer::Write(const gsl::span<const INPUT_RECORD> inRecords)
 {
     try
     {
+        // The records need to end up after any text that was written before them.
+        _ExpandPendingText();
+
         _vtInputShouldSuppress = true;
         auto resetVtInputSuppress = wil::scope_exit([&]() { _vtInputShouldSuppress = false; });
-        _HandleConsoleSuspensionEvents(inEvents);
-        if (inEvents.empty())
+        std::vector<INPUT_RECORD> filteredRecords;
+        const auto records = _HandleConsoleSuspensionEvents(inRecords, filteredRecords);
+        if (records.empty())
         {
             return 0;
         }
@@ -591,7 +629,7 @@ size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEv
         // Write to buffer.
         size_t EventsWritten;
         bool SetWaitEvent;
-        _WriteBuffer(inEvents, EventsWritten, SetWaitEvent);
+        _WriteBuffer(records, EventsWritten, SetWaitEvent);
 
         if (SetWaitEvent)
         {
@@ -610,9 +648,236 @@ size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEv
 }
 
 // Routine Description:
-// - Coalesces input events and transfers them to storage queue.
+// - Writes event to the input buffer. Wakes up any readers that are
+// waiting for additional input events.
+// Arguments:
+// - inEvent - input event to store in the buffer.
+// Return Value:
+// - The number of events that were written to input buffer.
+// Note:
+// - The console lock must be held when calling this routine.
+// - any outside references to inEvent will ben invalidated after
+// calling this method.
+size_t InputBuffer::Write(_Inout_ std::unique_ptr<IInputEvent> inEvent)
+{
+    if (!inEvent)
+    {
+        return 0;
+    }
+    return Write(inEvent->ToInputRecord());
+}
+
+// Routine Description:
+// - Writes events to the input buffer. Wakes up any readers that are
+// waiting for additional input events.
+// Arguments:
+// - inEvents - input events to store in the buffer. Empty on exit.
+// Return Value:
+// - The number of events that were written to input buffer.
+// Note:
+// - The console lock must be held when calling this routine.
+size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+{
+    try
+    {
+        const auto records = IInputEvent::ToInputRecords(inEvents);
+        inEvents.clear();
+        return Write(records);
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return 0;
+    }
+}
+
+// Routine Description:
+// - Writes text to the input buffer, as if it had been typed on the keyboard.
+// - Instead of synthesizing the key events for every character right away,
+//   the text is stored as is. Stream reads (ReadConsole and ReadFile) consume
+//   it directly and key events are only synthesized for clients that read
+//   input records. This keeps large pastes cheap.
 // Arguments:
-// - inRecords - The events to store.
+// - text - The text to write.
+// - codepage - The codepage used for synthesizing key events for characters
+//   that aren't part of the keyboard layout.
+// Return Value:
+// - The number of characters written to the input buffer.
+// Note:
+// - The console lock must be held when calling this routine.
+size_t InputBuffer::WriteString(const std::wstring_view text, const unsigned int codepage)
+{
+    if (text.empty())
+    {
+        return 0;
+    }
+
+    try
+    {
+        const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+
+        // Key events are translated by the VT input module and resume
+        // suspended output. Both need to see the actual key events.
+        if (IsInVirtualTerminalInputMode() || WI_IsFlagSet(gci.Flags, CONSOLE_SUSPENDED))
+        {
+            std::vector<INPUT_RECORD> records;
+            for (const auto wch : text)
+            {
+                for (const auto& keyEvent : CharToKeyEvents(wch, codepage))
+                {
+                    records.push_back(keyEvent->ToInputRecord());
+                }
+            }
+            Write(records);
+            return text.size();
+        }
+
+        if (_HasPendingText() && _pendingTextCodepage != codepage)
+        {
+            _ExpandPendingText();
+        }
+
+        const bool initiallyEmpty = _storage.empty() && !_HasPendingText();
+        _pendingText.append(text);
+        _pendingTextCodepage = codepage;
+
+        if (initiallyEmpty)
+        {
+            ServiceLocator::LocateGlobals().hInputEvent.SetEvent();
+        }
+        WakeUpReadersWaitingForData();
+        return text.size();
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return 0;
+    }
+}
+
+// Routine Description:
+// - Reads a single character of text written by WriteString(), without
+//   synthesizing key events for it.
+// - This only succeeds if the text is at the front of the buffer and the
+//   character is printable. Control characters have special meaning to
+//   stream readers, which need to see the actual key events for them.
+// Arguments:
+// - wch - on success, the character that was read
+// Return Value:
+// - true if a character was read.
+// Note:
+// - The console lock must be held when calling this routine.
+bool InputBuffer::ReadPendingTextChar(_Out_ wchar_t& wch) noexcept
+{
+    wch = UNICODE_NULL;
+
+    if (!_storage.empty() || !_HasPendingText())
+    {
+        return false;
+    }
+
+    try
+    {
+        const auto ch = til::at(_pendingText, _pendingTextHead);
+        if (ch < UNICODE_SPACE || ch == UNICODE_DEL)
+        {
+            _ExpandPendingText(1);
+            return false;
+        }
+
+        if (_pendingTextCounted)
+        {
+            _UncountPendingChar(CharToKeyEventCount(ch, _pendingTextCodepage));
+        }
+        _ConsumePendingText(1);
+        wch = ch;
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return false;
+    }
+
+    if (!_HasPendingText())
+    {
+        ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
+    }
+    return true;
+}
+
+bool InputBuffer::_HasPendingText() const noexcept
+{
+    return _pendingTextHead < _pendingText.size();
+}
+
+// Routine Description:
+// - Synthesizes the key events for pending text and appends them to the
+//   storage, until it holds at least the given number of records.
+// Arguments:
+// - minimumRecords - The number of records the storage should hold on exit,
+//   unless the text runs out first. Expands all of the text by default.
+// Return Value:
+// - <none>
+// Note:
+// - The console lock must be held when calling this routine.
+// - will throw on failure
+void InputBuffer::_ExpandPendingText(const size_t minimumRecords) const
+{
+    while (_HasPendingText() && _storage.size() < minimumRecords)
+    {
+        const auto keyEvents = CharToKeyEvents(til::at(_pendingText, _pendingTextHead), _pendingTextCodepage);
+        for (const auto& keyEvent : keyEvents)
+        {
+            _storage.push_back(keyEvent->ToInputRecord());
+        }
+        _UncountPendingChar(keyEvents.size());
+        _ConsumePendingText(1);
+    }
+}
+
+// Routine Description:
+// - Removes the given number of characters from the front of the pending text.
+// - Like InputRecordQueue, the consumed characters are only reclaimed once
+//   they make up more than half of the text.
+// Arguments:
+// - count - The number of characters to remove.
+// Return Value:
+// - <none>
+void InputBuffer::_ConsumePendingText(const size_t count) const noexcept
+{
+    _pendingTextHead += count;
+    if (!_HasPendingText())
+    {
+        _pendingText.clear();
+        _pendingTextHead = 0;
+    }
+    else if (_pendingTextHead > _pendingText.size() - _pendingTextHead)
+    {
+        _pendingText.erase(0, _pendingTextHead);
+        _pendingTextHead = 0;
+    }
+}
+
+// Routine Description:
+// - Removes the first pending character from the events counted by
+//   GetNumberOfReadyEvents(), if it was counted.
+// Arguments:
+// - events - The number of key events the character turned into.
+// Return Value:
+// - <none>
+void InputBuffer::_UncountPendingChar(const size_t events) const noexcept
+{
+    if (_pendingTextCounted)
+    {
+        _pendingTextCounted--;
+        _pendingTextEvents -= std::min(events, _pendingTextEvents);
+    }
+}
+
+// Routine Description:
+// - Coalesces input records and transfers them to storage queue.
+// Arguments:
+// - inRecords - The records to store.
 // - eventsWritten - The number of events written since this function
 // was called.
 // - setWaitEvent - on exit, true if buffer became non-empty.
@@ -621,77 +886,59 @@ size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEv
 // Note:
 // - The console lock must be held when calling this routine.
 // - will throw on failure
-void InputBuffer::_WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
+void InputBuffer::_WriteBuffer(const gsl::span<const INPUT_RECORD> inRecords,
                                _Out_ size_t& eventsWritten,
                                _Out_ bool& setWaitEvent)
 {
     eventsWritten = 0;
     setWaitEvent = false;
     const bool initiallyEmptyQueue = _storage.empty();
-    const size_t initialInEventsSize = inEvents.size();
     const bool vtInputMode = IsInVirtualTerminalInputMode();
 
-    while (!inEvents.empty())
+    // we only check for possible coalescing when storing one
+    // record at a time because this is the original behavior of
+    // the input buffer. Changing this behavior may break stuff
+    // that was depending on it.
+    const bool mayCoalesce = inRecords.size() == 1;
+
+    if (!vtInputMode && !mayCoalesce)
     {
-        // Pop the next event.
-        // If we're in vt mode, try and handle it with the vt input module.
-        // If it was handled, do nothing else for it.
-        // If there was one event passed in, try coalescing it with the previous event currently in the buffer.
-        // If it's not coalesced, append it to the buffer.
-        std::unique_ptr<IInputEvent> inEvent = std::move(inEvents.front());
-        inEvents.pop_front();
-        if (vtInputMode)
+        // Nothing can happen to the records on their way into the buffer.
+        _storage.append(inRecords);
+        eventsWritten = inRecords.size();
+    }
+    else
+    {
+        for (const auto& inRecord : inRecords)
         {
-            const bool handled = _termInput.HandleKey(inEvent.get());
-            if (handled)
+            // If we're in vt mode, try and handle it with the vt input module.
+            // If it was handled, do nothing else for it.
+            if (vtInputMode && inRecord.EventType == KEY_EVENT)
             {
-                eventsWritten++;
-                continue;
+                const KeyEvent keyEvent{ inRecord.Event.KeyEvent };
+                if (_termInput.HandleKey(&keyEvent))
+                {
+                    eventsWritten++;
+                    continue;
+                }
             }
-        }
-
-        // we only check for possible coalescing when storing one
-        // record at a time because this is the original behavior of
-        // the input buffer. Changing this behavior may break stuff
-        // that was depending on it.
-        if (initialInEventsSize == 1 && !_storage.empty())
-        {
-            // coalescing requires a deque of events, so push it back onto the front.
-            inEvents.push_front(std::move(inEvent));
 
-            bool coalesced = false;
+            // If there was one event passed in, try coalescing it with the previous event currently in the buffer.
             // this looks kinda weird but we don't want to coalesce a
             // mouse event and then try to coalesce a key event right after.
-            //
-            // we also pass the whole deque to the coalescing methods
-            // even though they only want one event because it should
-            // be their responsibility to maintain the correct state
-            // of the deque if they process any records in it.
-            if (_CoalesceMouseMovedEvents(inEvents))
-            {
-                coalesced = true;
-            }
-            else if (_CoalesceRepeatedKeyPressEvents(inEvents))
-            {
-                coalesced = true;
-            }
-            if (coalesced)
+            if (mayCoalesce && !_storage.empty() &&
+                (_CoalesceMouseMovedEvents(inRecord) || _CoalesceRepeatedKeyPressEvents(inRecord)))
             {
                 eventsWritten = 1;
                 return;
             }
-            else
-            {
-                // We didn't coalesce the event. pull it from the queue again,
-                //  to keep the state consistent with the start of this block.
-                inEvent = std::move(inEvents.front());
-                inEvents.pop_front();
-            }
+
+            // At this point, the event was neither coalesced, nor processed by VT.
+            _storage.push_back(inRecord);
+            ++eventsWritten;
         }
-        // At this point, the event was neither coalesced, nor processed by VT.
-        _storage.push_back(std::move(inEvent));
-        ++eventsWritten;
     }
+
     if (initiallyEmptyQueue && !_storage.empty())
     {
         setWaitEvent = true;
@@ -699,67 +946,54 @@ void InputBuffer::_WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>&
 }
 
 // Routine Description:
-// - Checks if the last saved event and the first event of inRecords are
-// both MOUSE_MOVED events. If they are, the last saved event is
-// updated with the new mouse position and the first event of inRecords is
-// dropped.
+// - Checks if the last saved record and inRecord are both MOUSE_MOVED
+// events. If they are, the last saved record is updated with the new
+// mouse position.
 // Arguments:
-// - inRecords - The incoming records to process.
+// - inRecord - The incoming record to process.
 // Return Value:
-// true if events were coalesced, false if they were not.
+// true if the record was coalesced, false if it was not.
 // Note:
-// - The size of inRecords must be 1.
+// - The storage must not be empty.
 // - Coalescing here means updating a record that already exists in
 // the buffer with updated values from an incoming event, instead of
 // storing the incoming event (which would make the original one
 // redundant/out of date with the most current state).
-bool InputBuffer::_CoalesceMouseMovedEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+bool InputBuffer::_CoalesceMouseMovedEvents(const INPUT_RECORD& inRecord)
 {
-    FAIL_FAST_IF(!(inEvents.size() == 1));
     FAIL_FAST_IF(_storage.empty());
-    const IInputEvent* const pFirstInEvent = inEvents.front().get();
-    const IInputEvent* const pLastStoredEvent = _storage.back().get();
-    if (pFirstInEvent->EventType() == InputEventType::MouseEvent &&
-        pLastStoredEvent->EventType() == InputEventType::MouseEvent)
+    auto& lastStoredRecord = _storage.back();
+    if (inRecord.EventType == MOUSE_EVENT &&
+        lastStoredRecord.EventType == MOUSE_EVENT &&
+        inRecord.Event.MouseEvent.dwEventFlags == MOUSE_MOVED &&
+        lastStoredRecord.Event.MouseEvent.dwEventFlags == MOUSE_MOVED)
     {
-        const MouseEvent* const pInMouseEvent = static_cast<const MouseEvent* const>(pFirstInEvent);
-        const MouseEvent* const pLastMouseEvent = static_cast<const MouseEvent* const>(pLastStoredEvent);
-
-        if (pInMouseEvent->IsMouseMoveEvent() &&
-            pLastMouseEvent->IsMouseMoveEvent())
-        {
-            // update mouse moved position
-            MouseEvent* const pMouseEvent = static_cast<MouseEvent* const>(_storage.back().release());
-            pMouseEvent->SetPosition(pInMouseEvent->GetPosition());
-            std::unique_ptr<IInputEvent> tempPtr(pMouseEvent);
-            tempPtr.swap(_storage.back());
-
-            inEvents.pop_front();
-            return true;
-        }
+        // update mouse moved position
+        lastStoredRecord.Event.MouseEvent.dwMousePosition = inRecord.Event.MouseEvent.dwMousePosition;
+        return true;
     }
     return false;
 }
 
 // Routine Description:
-// - checks two KeyEvents to see if they're similar enough to be coalesced
+// - checks two key event records to see if they're similar enough to be coalesced
 // Arguments:
-// - a - the first KeyEvent
-// - b - the other KeyEvent
+// - a - the first key event record
+// - b - the other key event record
 // Return Value:
 // - true if the events could be coalesced, false otherwise
-bool InputBuffer::_CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexcept
+bool InputBuffer::_CanCoalesce(const KEY_EVENT_RECORD& a, const KEY_EVENT_RECORD& b) const noexcept
 {
-    if (WI_IsFlagSet(a.GetActiveModifierKeys(), NLS_IME_CONVERSION) &&
-        a.GetCharData() == b.GetCharData() &&
-        a.GetActiveModifierKeys() == b.GetActiveModifierKeys())
+    if (WI_IsFlagSet(a.dwControlKeyState, NLS_IME_CONVERSION) &&
+        a.uChar.UnicodeChar == b.uChar.UnicodeChar &&
+        a.dwControlKeyState == b.dwControlKeyState)
     {
         return true;
     }
     // other key events check
-    else if (a.GetVirtualScanCode() == b.GetVirtualScanCode() &&
-             a.GetCharData() == b.GetCharData() &&
-             a.GetActiveModifierKeys() == b.GetActiveModifierKeys())
+    else if (a.wVirtualScanCode == b.wVirtualScanCode &&
+             a.uChar.UnicodeChar == b.uChar.UnicodeChar &&
+             a.dwControlKeyState == b.dwControlKeyState)
     {
         return true;
     }
@@ -767,44 +1001,35 @@ bool InputBuffer::_CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexc
 }
 
 // Routine Description::
-// - If the last input event saved and the first input event in inRecords
-// are both a keypress down event for the same key, update the repeat
-// count of the saved event and drop the first from inRecords.
+// - If the last input record saved and inRecord are both a keypress down
+// event for the same key, update the repeat count of the saved record.
 // Arguments:
-// - inRecords - The incoming records to process.
+// - inRecord - The incoming record to process.
 // Return Value:
-// true if events were coalesced, false if they were not.
+// true if the record was coalesced, false if it was not.
 // Note:
-// - The size of inRecords must be 1.
+// - The storage must not be empty.
 // - Coalescing here means updating a record that already exists in
 // the buffer with updated values from an incoming event, instead of
 // storing the incoming event (which would make the original one
 // redundant/out of date with the most current state).
-bool InputBuffer::_CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+bool InputBuffer::_CoalesceRepeatedKeyPressEvents(const INPUT_RECORD& inRecord)
 {
-    FAIL_FAST_IF(!(inEvents.size() == 1));
     FAIL_FAST_IF(_storage.empty());
-    const IInputEvent* const pFirstInEvent = inEvents.front().get();
-    const IInputEvent* const pLastStoredEvent = _storage.back().get();
-    if (pFirstInEvent->EventType() == InputEventType::KeyEvent &&
-        pLastStoredEvent->EventType() == InputEventType::KeyEvent)
-    {
-        const KeyEvent* const pInKeyEvent = static_cast<const KeyEvent* const>(pFirstInEvent);
-        const KeyEvent* const pLastKeyEvent = static_cast<const KeyEvent* const>(pLastStoredEvent);
-
-        if (pInKeyEvent->IsKeyDown() &&
-            pLastKeyEvent->IsKeyDown() &&
-            !IsGlyphFullWidth(pInKeyEvent->GetCharData()) &&
-            _CanCoalesce(*pInKeyEvent, *pLastKeyEvent))
+    auto& lastStoredRecord = _storage.back();
+    if (inRecord.EventType == KEY_EVENT &&
+        lastStoredRecord.EventType == KEY_EVENT)
+    {
+        const auto& inKeyEvent = inRecord.Event.KeyEvent;
+        auto& lastKeyEvent = lastStoredRecord.Event.KeyEvent;
+
+        if (inKeyEvent.bKeyDown &&
+            lastKeyEvent.bKeyDown &&
+            !IsGlyphFullWidth(inKeyEvent.uChar.UnicodeChar) &&
+            _CanCoalesce(inKeyEvent, lastKeyEvent))
         {
             // increment repeat count
-            KeyEvent* const pKeyEvent = static_cast<KeyEvent* const>(_storage.back().release());
-            WORD repeatCount = pKeyEvent->GetRepeatCount() + pInKeyEvent->GetRepeatCount();
-            pKeyEvent->SetRepeatCount(repeatCount);
-            std::unique_ptr<IInputEvent> tempPtr(pKeyEvent);
-            tempPtr.swap(_storage.back());
-
-            inEvents.pop_front();
+            lastKeyEvent.wRepeatCount += inKeyEvent.wRepeatCount;
             return true;
         }
     }
@@ -814,42 +1039,59 @@ bool InputBuffer::_CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique
 // Routine Description:
 // - Handles records that suspend/resume the console.
 // Arguments:
-// - records - records to check for pause/unpause events
+// - inRecords - records to check for pause/unpause events
+// - filteredRecords - storage for the remaining records, if any had to be removed
 // Return Value:
-// - None
+// - The records that should be written to the buffer. This is inRecords
+//   itself unless any of them were consumed here.
 // Note:
 // - The console lock must be held when calling this routine.
 // - will throw exception on error
-void InputBuffer::_HandleConsoleSuspensionEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+gsl::span<const INPUT_RECORD> InputBuffer::_HandleConsoleSuspensionEvents(const gsl::span<const INPUT_RECORD> inRecords,
+                                                                          _Out_ std::vector<INPUT_RECORD>& filteredRecords)
 {
     CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
 
-    std::deque<std::unique_ptr<IInputEvent>> outEvents;
-    while (!inEvents.empty())
+    // true once the first record was removed. From then on all
+    // remaining records are copied into filteredRecords.
+    bool filtered = false;
+    filteredRecords.clear();
+
+    for (auto it = inRecords.begin(); it != inRecords.end(); ++it)
     {
-        std::unique_ptr<IInputEvent> currEvent = std::move(inEvents.front());
-        inEvents.pop_front();
-        if (currEvent->EventType() == InputEventType::KeyEvent)
+        bool remove = false;
+        if (it->EventType == KEY_EVENT && it->Event.KeyEvent.bKeyDown)
         {
-            const KeyEvent* const pKeyEvent = static_cast<const KeyEvent* const>(currEvent.get());
-            if (pKeyEvent->IsKeyDown())
+            const auto virtualKeyCode = it->Event.KeyEvent.wVirtualKeyCode;
+            if (WI_IsFlagSet(gci.Flags, CONSOLE_SUSPENDED) &&
+                !IsSystemKey(virtualKeyCode))
             {
-                if (WI_IsFlagSet(gci.Flags, CONSOLE_SUSPENDED) &&
-                    !IsSystemKey(pKeyEvent->GetVirtualKeyCode()))
-                {
-                    UnblockWriteConsole(CONSOLE_OUTPUT_SUSPENDED);
-                    continue;
-                }
-                else if (WI_IsFlagSet(InputMode, ENABLE_LINE_INPUT) && pKeyEvent->IsPauseKey())
-                {
-                    WI_SetFlag(gci.Flags, CONSOLE_SUSPENDED);
-                    continue;
-                }
+                UnblockWriteConsole(CONSOLE_OUTPUT_SUSPENDED);
+                remove = true;
+            }
+            else if (WI_IsFlagSet(InputMode, ENABLE_LINE_INPUT) && virtualKeyCode == VK_PAUSE)
+            {
+                WI_SetFlag(gci.Flags, CONSOLE_SUSPENDED);
+                remove = true;
             }
         }
-        outEvents.push_back(std::move(currEvent));
+
+        if (remove && !filtered)
+        {
+            filteredRecords.assign(inRecords.begin(), it);
+            filtered = true;
+        }
+        else if (!remove && filtered)
+        {
+            filteredRecords.push_back(*it);
+        }
+    }
+
+    if (filtered)
+    {
+        return filteredRecords;
     }
-    inEvents.swap(outEvents);
+    return inRecords;
 }
 
 // Routine Description:
@@ -875,12 +1117,11 @@ void InputBuffer::_HandleTerminalInputCallback(std::deque<std::unique_ptr<IInput
     try
     {
         // add all input events to the storage queue
-        while (!inEvents.empty())
+        for (const auto& inEvent : inEvents)
         {
-            std::unique_ptr<IInputEvent> inEvent = std::move(inEvents.front());
-            inEvents.pop_front();
-            _storage.push_back(std::move(inEvent));
+            _storage.push_back(inEvent->ToInputRecord());
         }
+        inEvents.clear();
 
         if (!_vtInputShouldSuppress)
         {
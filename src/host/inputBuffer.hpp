@@ -20,6 +20,7 @@ Revision History:
 
 #include "inputReadHandleData.h"
 #include "readData.hpp"
+#include "inputRecordQueue.hpp"
 #include "../types/inc/IInputEvent.hpp"
 
 #include "../server/ObjectHandle.h"
@@ -57,6 +58,13 @@ public:
     void Flush();
     void FlushAllButKeys();
 
+    [[nodiscard]] NTSTATUS Read(_Out_ std::vector<INPUT_RECORD>& OutRecords,
+                                const size_t AmountToRead,
+                                const bool Peek,
+                                const bool WaitForData,
+                                const bool Unicode,
+                                const bool Stream);
+
     [[nodiscard]] NTSTATUS Read(_Out_ std::deque<std::unique_ptr<IInputEvent>>& OutEvents,
                                 const size_t AmountToRead,
                                 const bool Peek,
@@ -70,18 +78,36 @@ public:
                                 const bool Unicode,
                                 const bool Stream);
 
+    size_t Prepend(const gsl::span<const INPUT_RECORD> inRecords);
     size_t Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
 
+    size_t Write(const INPUT_RECORD& inRecord);
+    size_t Write(const gsl::span<const INPUT_RECORD> inRecords);
     size_t Write(_Inout_ std::unique_ptr<IInputEvent> inEvent);
     size_t Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
 
+    size_t WriteString(const std::wstring_view text, const unsigned int codepage);
+    bool ReadPendingTextChar(_Out_ wchar_t& wch) noexcept;
+
     bool IsInVirtualTerminalInputMode() const;
     Microsoft::Console::VirtualTerminal::TerminalInput& GetTerminalInput();
     void SetTerminalConnection(_In_ Microsoft::Console::ITerminalOutputConnection* const pTtyConnection);
     void PassThroughWin32MouseRequest(bool enable);
 
 private:
-    std::deque<std::unique_ptr<IInputEvent>> _storage;
+    // Turning pending text into records doesn't change the logical contents of
+    // the buffer, which is why even const methods may do so.
+    mutable InputRecordQueue _storage;
+    // Text written by WriteString() that hasn't been turned into key events yet.
+    // It logically follows all records in _storage.
+    mutable std::wstring _pendingText;
+    mutable size_t _pendingTextHead{ 0 };
+    unsigned int _pendingTextCodepage{ 0 };
+    // GetNumberOfReadyEvents() counts the key events of the pending text
+    // without synthesizing them: the first _pendingTextCounted characters
+    // turn into _pendingTextEvents key events.
+    mutable size_t _pendingTextCounted{ 0 };
+    mutable size_t _pendingTextEvents{ 0 };
     std::unique_ptr<IInputEvent> _readPartialByteSequence;
     std::unique_ptr<IInputEvent> _writePartialByteSequence;
     Microsoft::Console::VirtualTerminal::TerminalInput _termInput;
@@ -93,7 +119,7 @@ private:
     // Otherwise, we should be calling them.
     bool _vtInputShouldSuppress{ false };
 
-    void _ReadBuffer(_Out_ std::deque<std::unique_ptr<IInputEvent>>& outEvents,
+    void _ReadBuffer(_Out_ std::vector<INPUT_RECORD>& outRecords,
                      const size_t readCount,
                      _Out_ size_t& eventsRead,
                      const bool peek,
@@ -101,14 +127,20 @@ private:
                      const bool unicode,
                      const bool streamRead);
 
-    void _WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inRecords,
+    void _WriteBuffer(const gsl::span<const INPUT_RECORD> inRecords,
                       _Out_ size_t& eventsWritten,
                       _Out_ bool& setWaitEvent);
 
-    bool _CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexcept;
-    bool _CoalesceMouseMovedEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
-    bool _CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
-    void _HandleConsoleSuspensionEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
+    bool _HasPendingText() const noexcept;
+    void _ExpandPendingText(const size_t minimumRecords = SIZE_MAX) const;
+    void _ConsumePendingText(const size_t count) const noexcept;
+    void _UncountPendingChar(const size_t events) const noexcept;
+
+    bool _CanCoalesce(const KEY_EVENT_RECORD& a, const KEY_EVENT_RECORD& b) const noexcept;
+    bool _CoalesceMouseMovedEvents(const INPUT_RECORD& inRecord);
+    bool _CoalesceRepeatedKeyPressEvents(const INPUT_RECORD& inRecord);
+    gsl::span<const INPUT_RECORD> _HandleConsoleSuspensionEvents(const gsl::span<const INPUT_RECORD> inRecords,
+                                                                 _Out_ std::vector<INPUT_RECORD>& filteredRecords);
 
     void _HandleTerminalInputCallback(_In_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
 
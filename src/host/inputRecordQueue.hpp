@@ -0,0 +1,149 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- inputRecordQueue.hpp
+
+Abstract:
+- A FIFO of INPUT_RECORDs stored by value in a single contiguous allocation.
+- std::deque allocates a separate block for every INPUT_RECORD with MSVC's
+  STL, since its block size is only 16 bytes. Together with the unique_ptr
+  around each event the input buffer used to perform two allocations for
+  every single key press or mouse move it stored.
+
+Notes:
+- Consumed records at the front are only reclaimed once they make up more than
+  half of the storage, which keeps both pop_front() and push_back() amortized O(1).
+- Once the queue drains completely the storage is reused from the beginning
+  and its capacity is retained.
+--*/
+
+#pragma once
+
+class InputRecordQueue final
+{
+public:
+    using iterator = std::vector<INPUT_RECORD>::iterator;
+    using const_iterator = std::vector<INPUT_RECORD>::const_iterator;
+
+    size_t size() const noexcept
+    {
+        return _records.size() - _head;
+    }
+
+    bool empty() const noexcept
+    {
+        return _head == _records.size();
+    }
+
+    void clear() noexcept
+    {
+        _records.clear();
+        _head = 0;
+    }
+
+    INPUT_RECORD& front() noexcept
+    {
+        return til::at(_records, _head);
+    }
+
+    const INPUT_RECORD& front() const noexcept
+    {
+        return til::at(_records, _head);
+    }
+
+    INPUT_RECORD& back() noexcept
+    {
+        return _records.back();
+    }
+
+    const INPUT_RECORD& back() const noexcept
+    {
+        return _records.back();
+    }
+
+    INPUT_RECORD& operator[](const size_t index) noexcept
+    {
+        return til::at(_records, _head + index);
+    }
+
+    const INPUT_RECORD& operator[](const size_t index) const noexcept
+    {
+        return til::at(_records, _head + index);
+    }
+
+    iterator begin() noexcept
+    {
+        return _records.begin() + _head;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return _records.cbegin() + _head;
+    }
+
+    iterator end() noexcept
+    {
+        return _records.end();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return _records.cend();
+    }
+
+    // The records of the queue as one contiguous range. Invalidated by any modification.
+    gsl::span<const INPUT_RECORD> span() const noexcept
+    {
+        return gsl::span<const INPUT_RECORD>{ _records }.subspan(_head);
+    }
+
+    void push_back(const INPUT_RECORD& record)
+    {
+        _records.push_back(record);
+    }
+
+    void append(const gsl::span<const INPUT_RECORD> records)
+    {
+        _records.insert(_records.end(), records.begin(), records.end());
+    }
+
+    // Removes all records from the given position up to the end of the queue.
+    void erase_to_end(const const_iterator first)
+    {
+        _records.erase(first, _records.cend());
+        if (empty())
+        {
+            clear();
+        }
+    }
+
+    // Removes the given number of records from the front of the queue.
+    void pop_front(const size_t count = 1)
+    {
+        FAIL_FAST_IF(count > size());
+
+        _head += count;
+        if (empty())
+        {
+            clear();
+        }
+        else if (_head > size())
+        {
+            _records.erase(_records.begin(), _records.begin() + _head);
+            _head = 0;
+        }
+    }
+
+    void swap(InputRecordQueue& other) noexcept
+    {
+        _records.swap(other._records);
+        std::swap(_head, other._head);
+    }
+
+private:
+    std::vector<INPUT_RECORD> _records;
+    // The index of the first record in _records that hasn't been consumed yet.
+    size_t _head{ 0 };
+};
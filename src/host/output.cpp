@@ -253,7 +253,7 @@ void ScreenBufferSizeChange(const COORD coordNewSize)
 
     try
     {
-        gci.pInputBuffer->Write(std::make_unique<WindowBufferSizeEvent>(coordNewSize));
+        gci.pInputBuffer->Write(WindowBufferSizeEvent{ coordNewSize }.ToInputRecord());
     }
     catch (...)
     {
@@ -382,15 +382,19 @@ void ScrollRegion(SCREEN_INFORMATION& screenInfo,
 
     // Determine the cell we will use to fill in any revealed/uncovered space.
     // We generally use exactly what was given to us.
-    OutputCellIterator fillData(fillCharGiven, fillAttrsGiven);
+    auto fillChar = fillCharGiven;
+    auto fillAttrs = fillAttrsGiven;
 
     // However, if the character is null and we were given a null attribute (represented as legacy 0),
     // then we'll just fill with spaces and whatever the buffer's default colors are.
     if (fillCharGiven == UNICODE_NULL && fillAttrsGiven == TextAttribute{ 0 })
     {
-        fillData = OutputCellIterator(UNICODE_SPACE, screenInfo.GetAttributes());
+        fillChar = UNICODE_SPACE;
+        fillAttrs = screenInfo.GetAttributes();
     }
 
+    const OutputCellIterator fillData(fillChar, fillAttrs);
+
     // ------ 4. PREP TARGET ------
     // Now it's time to think about the target. We're only given the origin of the target
     // because it is assumed that it will have the same relative dimensions as the original source.
@@ -450,11 +454,22 @@ void ScrollRegion(SCREEN_INFORMATION& screenInfo,
     for (size_t i = 0; i < remaining.size(); i++)
     {
         const auto& view = remaining.at(i);
+        const auto fullRows = view.Width() == buffer.Width() && destinationOriginGiven.X == 0;
+
+        // Rows that are blanked entirely can simply be reset, which is a lot
+        // cheaper than filling them cell by cell. This is the common case of
+        // scrolling within the margins, which happens for every new line.
+        if (fullRows && fillChar == UNICODE_SPACE)
+        {
+            screenInfo.GetTextBuffer().ResetRows(view.Top(), view.BottomExclusive(), fillAttrs);
+            continue;
+        }
+
         screenInfo.WriteRect(fillData, view);
 
         // If we're scrolling an area that encompasses the full buffer width,
         // then the filled rows should also have their line rendition reset.
-        if (view.Width() == buffer.Width() && destinationOriginGiven.X == 0)
+        if (fullRows)
         {
             screenInfo.GetTextBuffer().ResetLineRenditionRange(view.Top(), view.BottomExclusive());
         }
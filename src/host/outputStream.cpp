@@ -125,6 +125,23 @@ bool ConhostInternalGetSet::SetConsoleScreenBufferInfoEx(const CONSOLE_SCREEN_BU
     return SUCCEEDED(ServiceLocator::LocateGlobals().api.SetConsoleScreenBufferInfoExImpl(_io.GetActiveOutputBuffer(), screenBufferInfo));
 }
 
+// Routine Description:
+// - Retrieves the size, cursor position and viewport of the active screen buffer.
+// - Unlike GetConsoleScreenBufferInfoEx, this doesn't gather the color table
+//   and window metrics, which none of the cursor movement operations need.
+// Arguments:
+// - state - Receives the buffer size, cursor position and exclusive viewport.
+// Return Value:
+// - true if successful. false otherwise.
+bool ConhostInternalGetSet::PrivateGetScreenBufferState(VirtualTerminal::ScreenBufferState& state) const
+{
+    const auto& buffer = _io.GetActiveOutputBuffer().GetActiveBuffer();
+    state.bufferSize = buffer.GetBufferSize().Dimensions();
+    state.cursorPosition = buffer.GetTextBuffer().GetCursor().GetPosition();
+    state.viewport = buffer.GetViewport().ToExclusive();
+    return true;
+}
+
 // Routine Description:
 // - Connects the SetConsoleCursorPosition API call directly into our Driver Message servicing call inside Conhost.exe
 // Arguments:
@@ -224,6 +241,22 @@ bool ConhostInternalGetSet::PrivateWriteConsoleInputW(std::deque<std::unique_ptr
                                                     true)); // append
 }
 
+// Routine Description:
+// - Writes text to the end of the input buffer, as if it had been typed.
+//   Key events for it are synthesized with the current output codepage,
+//   but only once a client reads input records.
+// Arguments:
+// - text - the text to write
+// Return Value:
+// - true if successful. false otherwise.
+bool ConhostInternalGetSet::PrivateWriteConsoleTextInput(const std::wstring_view text)
+{
+    unsigned int codepage = 0;
+    DoSrvGetConsoleOutputCodePage(codepage);
+
+    return _io.GetActiveInputBuffer()->WriteString(text, codepage) == text.size();
+}
+
 // Routine Description:
 // - Connects the SetConsoleWindowInfo API call directly into our Driver Message servicing call inside Conhost.exe
 // Arguments:
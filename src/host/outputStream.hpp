@@ -56,6 +56,7 @@ public:
 
     bool GetConsoleScreenBufferInfoEx(CONSOLE_SCREEN_BUFFER_INFOEX& screenBufferInfo) const override;
     bool SetConsoleScreenBufferInfoEx(const CONSOLE_SCREEN_BUFFER_INFOEX& screenBufferInfo) override;
+    bool PrivateGetScreenBufferState(Microsoft::Console::VirtualTerminal::ScreenBufferState& state) const override;
 
     bool SetConsoleCursorPosition(const COORD position) override;
 
@@ -68,6 +69,7 @@ public:
 
     bool PrivateWriteConsoleInputW(std::deque<std::unique_ptr<IInputEvent>>& events,
                                    size_t& eventsWritten) override;
+    bool PrivateWriteConsoleTextInput(const std::wstring_view text) override;
 
     bool SetConsoleWindowInfo(bool const absolute,
                               const SMALL_RECT& window) override;
@@ -60,6 +60,13 @@ using Microsoft::Console::Interactivity::ServiceLocator;
     NTSTATUS Status;
     for (;;)
     {
+        // Text that was written in bulk, for instance by a paste through
+        // conpty, is read directly without synthesizing key events for it.
+        if (pInputBuffer->ReadPendingTextChar(*pwchOut))
+        {
+            return STATUS_SUCCESS;
+        }
+
         std::unique_ptr<IInputEvent> inputEvent;
         Status = pInputBuffer->Read(inputEvent,
                                     false, // peek
@@ -877,4 +877,77 @@ class ApiRoutinesTests
 
         ValidateComplexScreen(si, background, fill, scrollRect, Viewport::FromInclusive(scroll), destination, clipViewport);
     }
+
+    TEST_METHOD(ApiWriteConsoleOutputWBenchmark)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        Log::Comment(L"Redraws a 120x50 screen with WriteConsoleOutputW and reads it back with ReadConsoleOutputW, like full-screen console apps do.");
+
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+
+        const COORD screenSize{ 120, 50 };
+        VERIFY_SUCCEEDED(si.GetTextBuffer().ResizeTraditional(screenSize));
+
+        // Two frames of a file manager: two panels, a highlighted entry that moves
+        // between the frames, and a status line. Every frame changes every row.
+        std::array<std::vector<CHAR_INFO>, 2> frames;
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            auto& frame = frames[i];
+            for (SHORT y = 0; y < screenSize.Y; ++y)
+            {
+                for (SHORT x = 0; x < screenSize.X; ++x)
+                {
+                    CHAR_INFO charInfo;
+                    charInfo.Char.UnicodeChar = gsl::narrow_cast<wchar_t>(L'a' + (x + y + i) % 26);
+                    charInfo.Attributes = x < screenSize.X / 2 ? 0x1b : 0x1e;
+                    if (y == screenSize.Y - 1)
+                    {
+                        charInfo.Attributes = 0x30;
+                    }
+                    else if (y == gsl::narrow_cast<SHORT>(5 + i * 10) && x > 1 && x < 40)
+                    {
+                        charInfo.Attributes = 0x70;
+                    }
+                    frame.push_back(charInfo);
+                }
+            }
+        }
+
+        constexpr size_t iterations = 2000;
+        const auto rect = Viewport::FromDimensions({ 0, 0 }, screenSize);
+        Viewport affected;
+        HRESULT hr = S_OK;
+
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations && SUCCEEDED(hr); ++i)
+        {
+            hr = _pApiRoutines->WriteConsoleOutputWImpl(si, til::at(frames, i % frames.size()), rect, affected);
+        }
+        auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+        VERIFY_SUCCEEDED(hr);
+        Log::Comment(NoThrowString().Format(L"WriteConsoleOutputW: %zu frames in %.2f ms, %.0f frames/s", iterations, delta * 1000.0, iterations / delta));
+
+        std::vector<CHAR_INFO> readBack(frames[0].size());
+
+        now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations && SUCCEEDED(hr); ++i)
+        {
+            hr = _pApiRoutines->ReadConsoleOutputWImpl(si, readBack, rect, affected);
+        }
+        delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+        VERIFY_SUCCEEDED(hr);
+        Log::Comment(NoThrowString().Format(L"ReadConsoleOutputW: %zu frames in %.2f ms, %.0f frames/s", iterations, delta * 1000.0, iterations / delta));
+
+        const auto& lastFrame = til::at(frames, (iterations - 1) % frames.size());
+        VERIFY_IS_TRUE(std::equal(lastFrame.begin(), lastFrame.end(), readBack.begin(), [](const CHAR_INFO& a, const CHAR_INFO& b) {
+            return a.Char.UnicodeChar == b.Char.UnicodeChar && a.Attributes == b.Attributes;
+        }));
+    }
 };
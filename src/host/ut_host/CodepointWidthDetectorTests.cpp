@@ -7,7 +7,9 @@
 #include "CommonState.hpp"
 
 #include "../types/inc/CodepointWidthDetector.hpp"
+#include "../types/inc/Utf16Parser.hpp"
 
+using namespace WEX::Common;
 using namespace WEX::Logging;
 
 static constexpr std::wstring_view emoji = L"\xD83E\xDD22"; // U+1F922 nauseated face
@@ -98,4 +100,92 @@ class CodepointWidthDetectorTests
         widthDetector.NotifyFontChanged();
         VERIFY_ARE_EQUAL(0u, widthDetector._fallbackCache.size());
     }
+
+    TEST_METHOD(MeasureWidthsMatchesGetWidth)
+    {
+        CodepointWidthDetector widthDetector;
+
+        std::wstring text;
+        for (const auto& data : testData)
+        {
+            text += std::get<1>(data);
+        }
+
+        std::vector<uint8_t> widths(text.size());
+        const auto columns = widthDetector.MeasureWidths(text, widths);
+
+        size_t expectedColumns = 0;
+        size_t offset = 0;
+        for (const auto& data : testData)
+        {
+            const auto& wstr = std::get<1>(data);
+            const auto expected = widthDetector.IsWide(wstr) ? 2u : 1u;
+            VERIFY_ARE_EQUAL(expected, widths.at(offset));
+            for (size_t i = 1; i < wstr.size(); ++i)
+            {
+                VERIFY_ARE_EQUAL(0u, widths.at(offset + i));
+            }
+            expectedColumns += expected;
+            offset += wstr.size();
+        }
+        VERIFY_ARE_EQUAL(expectedColumns, columns);
+
+        // An unpaired surrogate is measured on its own.
+        const std::wstring_view unpaired{ L"Ø3Dz" };
+        VERIFY_ARE_EQUAL(2u, widthDetector.MeasureWidths(unpaired, widths));
+        VERIFY_ARE_EQUAL(1u, widths.at(0));
+        VERIFY_ARE_EQUAL(1u, widths.at(1));
+
+        // The output must be able to hold a width for every code unit.
+        VERIFY_THROWS_SPECIFIC(widthDetector.MeasureWidths(text, gsl::span<uint8_t>(widths.data(), text.size() - 1)),
+                               wil::ResultException,
+                               [](wil::ResultException& e) { return e.GetErrorCode() == E_INVALIDARG; });
+    }
+
+    TEST_METHOD(MeasureWidthsBenchmark)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        constexpr size_t textSize = 1024 * 1024;
+        constexpr std::array<std::pair<std::wstring_view, std::wstring_view>, 3> samples{ {
+            { L"ASCII", L"The quick brown fox jumps over the lazy dog. " },
+            { L"CJK", L"\x65E5\x672C\x8A9E\x306E\x6587\x7AE0\x3002\xD55C\xAD6D\xC5B4\x4E2D\x6587" },
+            { L"emoji", L"\xD83D\xDE00\xD83D\xDC7E\xD83E\xDD22\xD83D\xDD1C " },
+        } };
+
+        CodepointWidthDetector widthDetector;
+        std::vector<uint8_t> widths(textSize);
+
+        for (const auto& [name, sample] : samples)
+        {
+            std::wstring text;
+            while (text.size() + sample.size() <= textSize)
+            {
+                text += sample;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            size_t glyphColumns = 0;
+            for (size_t i = 0; i < text.size();)
+            {
+                const auto glyph = Utf16Parser::ParseNext(std::wstring_view{ text }.substr(i));
+                glyphColumns += widthDetector.IsWide(glyph) ? 2 : 1;
+                i += glyph.size();
+            }
+            const auto glyphDelta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+            now = std::chrono::steady_clock::now();
+            const auto columns = widthDetector.MeasureWidths(text, widths);
+            const auto bulkDelta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+            VERIFY_ARE_EQUAL(glyphColumns, columns);
+            Log::Comment(String().Format(L"%s: %zu code units, %.2f ms one glyph at a time, %.2f ms with MeasureWidths",
+                                         std::wstring{ name }.c_str(),
+                                         text.size(),
+                                         glyphDelta * 1000.0,
+                                         bulkDelta * 1000.0));
+        }
+    }
 };
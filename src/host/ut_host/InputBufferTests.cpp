@@ -6,10 +6,13 @@
 #include "../../inc/consoletaeftemplates.hpp"
 #include "CommonState.hpp"
 
+#include "../interactivity/inc/EventSynthesis.hpp"
 #include "../interactivity/inc/ServiceLocator.hpp"
 #include "../types/inc/IInputEvent.hpp"
 
+using namespace WEX::Common;
 using namespace WEX::Logging;
+using Microsoft::Console::Interactivity::CharToKeyEvents;
 using Microsoft::Console::Interactivity::ServiceLocator;
 
 class InputBufferTests
@@ -78,7 +81,7 @@ class InputBufferTests
             INPUT_RECORD record;
             record.EventType = MENU_EVENT;
             VERIFY_IS_GREATER_THAN(inputBuffer.Write(IInputEvent::Create(record)), 0u);
-            VERIFY_ARE_EQUAL(record, inputBuffer._storage.back()->ToInputRecord());
+            VERIFY_ARE_EQUAL(record, inputBuffer._storage.back());
         }
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT);
     }
@@ -98,7 +101,7 @@ class InputBufferTests
         // verify that the events are the same in storage
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i]->ToInputRecord(), record);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i], record);
         }
     }
 
@@ -121,10 +124,9 @@ class InputBufferTests
         // check that they coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 1u);
         // check that the mouse position is being updated correctly
-        const IInputEvent* const pOutEvent = inputBuffer._storage.front().get();
-        const MouseEvent* const pMouseEvent = static_cast<const MouseEvent* const>(pOutEvent);
-        VERIFY_ARE_EQUAL(pMouseEvent->GetPosition().X, static_cast<SHORT>(RECORD_INSERT_COUNT));
-        VERIFY_ARE_EQUAL(pMouseEvent->GetPosition().Y, static_cast<SHORT>(RECORD_INSERT_COUNT * 2));
+        const auto& storedMouseEvent = inputBuffer._storage.front().Event.MouseEvent;
+        VERIFY_ARE_EQUAL(storedMouseEvent.dwMousePosition.X, static_cast<SHORT>(RECORD_INSERT_COUNT));
+        VERIFY_ARE_EQUAL(storedMouseEvent.dwMousePosition.Y, static_cast<SHORT>(RECORD_INSERT_COUNT * 2));
 
         // add a key event and another mouse event to make sure that
         // an event between two mouse events stopped the coalescing.
@@ -162,10 +164,10 @@ class InputBufferTests
         // no events should have been coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT + 1);
         // check that the events stored match those inserted
-        VERIFY_ARE_EQUAL(inputBuffer._storage.front()->ToInputRecord(), mouseRecords[0]);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front(), mouseRecords[0]);
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1]->ToInputRecord(), mouseRecords[i]);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1], mouseRecords[i]);
         }
     }
 
@@ -221,10 +223,10 @@ class InputBufferTests
         // no events should have been coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT + 1);
         // check that the events stored match those inserted
-        VERIFY_ARE_EQUAL(inputBuffer._storage.front()->ToInputRecord(), keyRecords[0]);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front(), keyRecords[0]);
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1]->ToInputRecord(), keyRecords[i]);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1], keyRecords[i]);
         }
     }
 
@@ -239,7 +241,7 @@ class InputBufferTests
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
             VERIFY_IS_GREATER_THAN(inputBuffer.Write(IInputEvent::Create(record)), 0u);
-            VERIFY_ARE_EQUAL(inputBuffer._storage.back()->ToInputRecord(), record);
+            VERIFY_ARE_EQUAL(inputBuffer._storage.back(), record);
         }
 
         // The events shouldn't be coalesced
@@ -382,10 +384,10 @@ class InputBufferTests
         VERIFY_IS_GREATER_THAN(inputBuffer.Write(inEvents), 0u);
 
         // read one record, make sure ResetWaitEvent isn't set
-        std::deque<std::unique_ptr<IInputEvent>> outEvents;
+        std::vector<INPUT_RECORD> outRecords;
         size_t eventsRead = 0;
         bool resetWaitEvent = false;
-        inputBuffer._ReadBuffer(outEvents,
+        inputBuffer._ReadBuffer(outRecords,
                                 1,
                                 eventsRead,
                                 false,
@@ -396,8 +398,8 @@ class InputBufferTests
         VERIFY_IS_FALSE(!!resetWaitEvent);
 
         // read the rest, resetWaitEvent should be set to true
-        outEvents.clear();
-        inputBuffer._ReadBuffer(outEvents,
+        outRecords.clear();
+        inputBuffer._ReadBuffer(outRecords,
                                 RECORD_INSERT_COUNT - 1,
                                 eventsRead,
                                 false,
@@ -431,10 +433,10 @@ class InputBufferTests
         VERIFY_IS_GREATER_THAN(inputBuffer.Write(inEvents), 0u);
 
         // read them out non-unicode style and compare
-        std::deque<std::unique_ptr<IInputEvent>> outEvents;
+        std::vector<INPUT_RECORD> outRecords;
         size_t eventsRead = 0;
         bool resetWaitEvent = false;
-        inputBuffer._ReadBuffer(outEvents,
+        inputBuffer._ReadBuffer(outRecords,
                                 recordInsertCount,
                                 eventsRead,
                                 false,
@@ -444,10 +446,10 @@ class InputBufferTests
         // the dbcs record should have counted for two elements in
         // the array, making it so that we get less events read
         VERIFY_ARE_EQUAL(eventsRead, recordInsertCount - 1);
-        VERIFY_ARE_EQUAL(eventsRead, outEvents.size());
+        VERIFY_ARE_EQUAL(eventsRead, outRecords.size());
         for (size_t i = 0; i < eventsRead; ++i)
         {
-            VERIFY_ARE_EQUAL(outEvents[i]->ToInputRecord(), inRecords[i]);
+            VERIFY_ARE_EQUAL(outRecords[i], inRecords[i]);
         }
     }
 
@@ -589,22 +591,17 @@ class InputBufferTests
     {
         InputBuffer inputBuffer;
         INPUT_RECORD record = MakeKeyEvent(true, 1, L'a', 0, L'a', 0);
-        std::unique_ptr<IInputEvent> inputEvent = IInputEvent::Create(record);
         size_t eventsWritten;
         bool waitEvent = false;
         inputBuffer.Flush();
         // write one event to an empty buffer
-        std::deque<std::unique_ptr<IInputEvent>> storage;
-        storage.push_back(std::move(inputEvent));
-        inputBuffer._WriteBuffer(storage, eventsWritten, waitEvent);
+        inputBuffer._WriteBuffer({ &record, 1 }, eventsWritten, waitEvent);
         VERIFY_IS_TRUE(waitEvent);
         // write another, it shouldn't signal this time
         INPUT_RECORD record2 = MakeKeyEvent(true, 1, L'b', 0, L'b', 0);
-        std::unique_ptr<IInputEvent> inputEvent2 = IInputEvent::Create(record2);
         // write another event to a non-empty buffer
         waitEvent = false;
-        storage.push_back(std::move(inputEvent2));
-        inputBuffer._WriteBuffer(storage, eventsWritten, waitEvent);
+        inputBuffer._WriteBuffer({ &record2, 1 }, eventsWritten, waitEvent);
 
         VERIFY_IS_FALSE(waitEvent);
     }
@@ -625,7 +622,7 @@ class InputBufferTests
                                                  true));
         VERIFY_ARE_EQUAL(outEvents.size(), 1u);
         VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 1u);
-        VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*inputBuffer._storage.front()).GetRepeatCount(), repeatCount - 1);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front().Event.KeyEvent.wRepeatCount, repeatCount - 1);
         VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*outEvents.front()).GetRepeatCount(), 1u);
     }
 
@@ -645,7 +642,290 @@ class InputBufferTests
                                                  true));
         VERIFY_ARE_EQUAL(outEvents.size(), 1u);
         VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 1u);
-        VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*inputBuffer._storage.front()).GetRepeatCount(), repeatCount);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front().Event.KeyEvent.wRepeatCount, repeatCount);
         VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*outEvents.front()).GetRepeatCount(), 1u);
     }
+
+    TEST_METHOD(BulkPasteBenchmark)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        Log::Comment(L"Writes 1 MB of pasted text as key down/up pairs and reads it back like a console client would");
+
+        constexpr size_t pasteSize = 1024 * 1024;
+        constexpr size_t readSize = 4096;
+
+        // A paste produces a key down and a key up event for every character.
+        std::vector<INPUT_RECORD> records;
+        records.reserve(pasteSize / sizeof(wchar_t) * 2);
+        for (size_t i = 0; i < pasteSize / sizeof(wchar_t); ++i)
+        {
+            const auto ch = static_cast<WCHAR>(L'a' + i % 26);
+            records.push_back(MakeKeyEvent(TRUE, 1, ch, 0, ch, 0));
+            records.push_back(MakeKeyEvent(FALSE, 1, ch, 0, ch, 0));
+        }
+
+        InputBuffer inputBuffer;
+        std::vector<INPUT_RECORD> outRecords;
+        outRecords.reserve(readSize);
+
+        const auto now = std::chrono::steady_clock::now();
+
+        VERIFY_ARE_EQUAL(records.size(), inputBuffer.Write(records));
+        size_t totalRead = 0;
+        auto status = STATUS_SUCCESS;
+        while (NT_SUCCESS(status) && inputBuffer.GetNumberOfReadyEvents() != 0)
+        {
+            outRecords.clear();
+            status = inputBuffer.Read(outRecords, readSize, false, false, true, false);
+            totalRead += outRecords.size();
+        }
+
+        const auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+        VERIFY_SUCCESS_NTSTATUS(status);
+        VERIFY_ARE_EQUAL(records.size(), totalRead);
+        VERIFY_ARE_EQUAL(records.back(), outRecords.back());
+        Log::Comment(String().Format(L"%zu records in %.2f ms", records.size(), delta * 1000.0));
+    }
+
+    TEST_METHOD(MouseMoveBenchmark)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        Log::Comment(L"Writes 10K mouse move events one at a time, the way the window procedure does");
+
+        constexpr size_t eventCount = 10000;
+
+        InputBuffer inputBuffer;
+        INPUT_RECORD record{};
+        record.EventType = MOUSE_EVENT;
+        record.Event.MouseEvent.dwEventFlags = MOUSE_MOVED;
+        std::vector<INPUT_RECORD> outRecords;
+        outRecords.reserve(1);
+
+        // With a client that reads every event as soon as it arrives, nothing gets coalesced.
+        size_t written = 0;
+        size_t read = 0;
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < eventCount; ++i)
+        {
+            record.Event.MouseEvent.dwMousePosition = { static_cast<SHORT>(i % 120), static_cast<SHORT>(i % 30) };
+            written += inputBuffer.Write(record);
+            outRecords.clear();
+            (void)inputBuffer.Read(outRecords, 1, false, false, true, false);
+            read += outRecords.size();
+        }
+        auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+        VERIFY_ARE_EQUAL(eventCount, written);
+        VERIFY_ARE_EQUAL(eventCount, read);
+        Log::Comment(String().Format(L"%zu write/read pairs in %.2f ms", eventCount, delta * 1000.0));
+
+        // Without a reader they all coalesce into the last stored event.
+        written = 0;
+        now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < eventCount; ++i)
+        {
+            record.Event.MouseEvent.dwMousePosition = { static_cast<SHORT>(i % 120), static_cast<SHORT>(i % 30) };
+            written += inputBuffer.Write(record);
+        }
+        delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+        VERIFY_ARE_EQUAL(eventCount, written);
+        Log::Comment(String().Format(L"%zu coalesced writes in %.2f ms", eventCount, delta * 1000.0));
+
+        VERIFY_ARE_EQUAL(1u, inputBuffer.GetNumberOfReadyEvents());
+        VERIFY_ARE_EQUAL(record, inputBuffer._storage.front());
+    }
+
+    TEST_METHOD(WriteStringIsReadAsText)
+    {
+        Log::Comment(L"Printable text is read without synthesizing any key events for it");
+
+        InputBuffer inputBuffer;
+        VERIFY_ARE_EQUAL(5u, inputBuffer.WriteString(L"abc\rd", CP_USA));
+
+        std::wstring text;
+        wchar_t wch;
+        while (inputBuffer.ReadPendingTextChar(wch))
+        {
+            text.push_back(wch);
+        }
+        VERIFY_ARE_EQUAL(L"abc", text);
+
+        // The carriage return is turned into key events, since stream readers need to see the key.
+        VERIFY_ARE_EQUAL(L'\r', inputBuffer._storage.front().Event.KeyEvent.uChar.UnicodeChar);
+
+        std::vector<INPUT_RECORD> outRecords;
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(outRecords, inputBuffer._storage.size(), false, false, true, false));
+        VERIFY_IS_TRUE(inputBuffer.ReadPendingTextChar(wch));
+        VERIFY_ARE_EQUAL(L'd', wch);
+        VERIFY_IS_FALSE(inputBuffer.ReadPendingTextChar(wch));
+        VERIFY_ARE_EQUAL(0u, inputBuffer.GetNumberOfReadyEvents());
+    }
+
+    TEST_METHOD(WriteStringIsReadAsRecords)
+    {
+        Log::Comment(L"Text is turned into the same key events as before, in order with the surrounding records");
+
+        InputBuffer inputBuffer;
+        const auto first = MakeKeyEvent(true, 1, L'x', 0, L'x', 0);
+        const auto last = MakeKeyEvent(true, 1, L'y', 0, L'y', 0);
+        const std::wstring_view text{ L"Hello, World!" };
+
+        std::vector<INPUT_RECORD> expected;
+        expected.push_back(first);
+        for (const auto wch : text)
+        {
+            for (const auto& keyEvent : CharToKeyEvents(wch, CP_USA))
+            {
+                expected.push_back(keyEvent->ToInputRecord());
+            }
+        }
+        expected.push_back(last);
+
+        VERIFY_ARE_EQUAL(1u, inputBuffer.Write(first));
+        VERIFY_ARE_EQUAL(text.size(), inputBuffer.WriteString(text, CP_USA));
+
+        // A record in front of the text means it can't be read directly.
+        wchar_t wch;
+        VERIFY_IS_FALSE(inputBuffer.ReadPendingTextChar(wch));
+
+        VERIFY_ARE_EQUAL(1u, inputBuffer.Write(last));
+        VERIFY_ARE_EQUAL(expected.size(), inputBuffer.GetNumberOfReadyEvents());
+
+        std::vector<INPUT_RECORD> outRecords;
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(outRecords, expected.size(), false, false, true, false));
+        VERIFY_ARE_EQUAL(expected.size(), outRecords.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(expected[i], outRecords[i]);
+        }
+    }
+
+    TEST_METHOD(WriteStringIsExpandedOnDemand)
+    {
+        Log::Comment(L"Reading a single record only synthesizes the key events for the first character");
+
+        InputBuffer inputBuffer;
+        VERIFY_ARE_EQUAL(4u, inputBuffer.WriteString(L"abcd", CP_USA));
+        VERIFY_ARE_EQUAL(0u, inputBuffer._storage.size());
+
+        std::vector<INPUT_RECORD> outRecords;
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(outRecords, 1, false, false, true, false));
+        VERIFY_ARE_EQUAL(1u, outRecords.size());
+        VERIFY_ARE_EQUAL(L'a', outRecords[0].Event.KeyEvent.uChar.UnicodeChar);
+        VERIFY_IS_TRUE(!!outRecords[0].Event.KeyEvent.bKeyDown);
+
+        // The key up event for 'a' is still stored and the rest is still text.
+        VERIFY_ARE_EQUAL(1u, inputBuffer._storage.size());
+        VERIFY_ARE_EQUAL(3u, inputBuffer._pendingText.size() - inputBuffer._pendingTextHead);
+
+        inputBuffer.Flush();
+        VERIFY_ARE_EQUAL(0u, inputBuffer.GetNumberOfReadyEvents());
+    }
+
+    TEST_METHOD(WriteStringIsCountedWithoutExpanding)
+    {
+        Log::Comment(L"Pending text is counted as the key events it turns into, without synthesizing them");
+
+        InputBuffer inputBuffer;
+        const std::wstring_view text{ L"aB\r" };
+        size_t expected = 0;
+        for (const auto wch : text)
+        {
+            expected += CharToKeyEvents(wch, CP_USA).size();
+        }
+
+        VERIFY_ARE_EQUAL(text.size(), inputBuffer.WriteString(text, CP_USA));
+        VERIFY_ARE_EQUAL(expected, inputBuffer.GetNumberOfReadyEvents());
+        VERIFY_ARE_EQUAL(0u, inputBuffer._storage.size());
+
+        std::vector<INPUT_RECORD> outRecords;
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(outRecords, 1, false, false, true, false));
+        VERIFY_ARE_EQUAL(expected - 1, inputBuffer.GetNumberOfReadyEvents());
+
+        // Text written after counting is counted as well.
+        VERIFY_ARE_EQUAL(1u, inputBuffer.WriteString(L"c", CP_USA));
+        expected += CharToKeyEvents(L'c', CP_USA).size();
+        VERIFY_ARE_EQUAL(expected - 1, inputBuffer.GetNumberOfReadyEvents());
+
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(outRecords, expected - 1, false, false, true, false));
+        VERIFY_ARE_EQUAL(0u, inputBuffer.GetNumberOfReadyEvents());
+
+        // Text read directly is no longer counted.
+        VERIFY_ARE_EQUAL(2u, inputBuffer.WriteString(L"de", CP_USA));
+        VERIFY_ARE_EQUAL(4u, inputBuffer.GetNumberOfReadyEvents());
+        wchar_t wch;
+        VERIFY_IS_TRUE(inputBuffer.ReadPendingTextChar(wch));
+        VERIFY_ARE_EQUAL(2u, inputBuffer.GetNumberOfReadyEvents());
+        VERIFY_ARE_EQUAL(0u, inputBuffer._storage.size());
+    }
+
+    TEST_METHOD(WriteStringPasteBenchmark)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        Log::Comment(L"Pastes 5 MB of text and reads it back one character at a time, like ReadConsole does");
+
+        constexpr size_t pasteSize = 5 * 1024 * 1024;
+
+        std::wstring text;
+        text.reserve(pasteSize / sizeof(wchar_t) + 64);
+        while (text.size() < pasteSize / sizeof(wchar_t))
+        {
+            text.append(L"The quick brown fox jumps over the lazy dog. ");
+        }
+        text.resize(pasteSize / sizeof(wchar_t));
+
+        {
+            InputBuffer inputBuffer;
+            std::wstring output;
+            output.reserve(text.size());
+
+            const auto now = std::chrono::steady_clock::now();
+            VERIFY_ARE_EQUAL(text.size(), inputBuffer.WriteString(text, CP_USA));
+            wchar_t wch;
+            while (inputBuffer.ReadPendingTextChar(wch))
+            {
+                output.push_back(wch);
+            }
+            const auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+            VERIFY_ARE_EQUAL(text, output);
+            Log::Comment(String().Format(L"as text: %zu characters in %.2f ms", text.size(), delta * 1000.0));
+        }
+
+        {
+            InputBuffer inputBuffer;
+            std::vector<INPUT_RECORD> records;
+            records.reserve(text.size() * 2);
+            std::unique_ptr<IInputEvent> event;
+            size_t keyDowns = 0;
+
+            const auto now = std::chrono::steady_clock::now();
+            for (const auto wch : text)
+            {
+                for (const auto& keyEvent : CharToKeyEvents(wch, CP_USA))
+                {
+                    records.push_back(keyEvent->ToInputRecord());
+                }
+            }
+            VERIFY_ARE_EQUAL(records.size(), inputBuffer.Write(records));
+            while (NT_SUCCESS(inputBuffer.Read(event, false, false, true, true)) && event)
+            {
+                keyDowns += static_cast<const KeyEvent&>(*event).IsKeyDown();
+                event.reset();
+            }
+            const auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+            VERIFY_ARE_EQUAL(text.size(), keyDowns);
+            Log::Comment(String().Format(L"as key events: %zu characters in %.2f ms", text.size(), delta * 1000.0));
+        }
+    }
 };
@@ -8,9 +8,182 @@
 
 #include "../../host/renderData.hpp"
 #include "../../renderer/base/renderer.hpp"
+#include "../../renderer/inc/RenderEngineBase.hpp"
 
+using namespace WEX::Common;
 using namespace WEX::Logging;
 using namespace WEX::TestExecution;
+using namespace Microsoft::Console::Render;
+using namespace Microsoft::Console::Types;
+using Microsoft::Console::Interactivity::ServiceLocator;
+
+// A headless engine which paints nothing, but keeps count of the
+// rows and cells the renderer asked it to paint during each frame.
+class CountingEngine final : public RenderEngineBase
+{
+public:
+    size_t frames = 0;
+    size_t paintedRows = 0;
+    size_t paintedCells = 0;
+
+    // If set, every run of text and change of the brushes is logged to calls.
+    bool logCalls = false;
+    std::vector<std::wstring> calls;
+
+    void ResetCounters() noexcept
+    {
+        frames = 0;
+        paintedRows = 0;
+        paintedCells = 0;
+    }
+
+    [[nodiscard]] HRESULT StartPaint() noexcept override
+    {
+        if (!_invalidMap.any())
+        {
+            return S_FALSE;
+        }
+        ++frames;
+        return S_OK;
+    }
+
+    [[nodiscard]] HRESULT EndPaint() noexcept override
+    {
+        _invalidMap.reset_all();
+        return S_OK;
+    }
+
+    [[nodiscard]] HRESULT Present() noexcept override { return S_OK; }
+
+    [[nodiscard]] HRESULT PrepareForTeardown(_Out_ bool* const pForcePaint) noexcept override
+    {
+        *pForcePaint = false;
+        return S_OK;
+    }
+
+    [[nodiscard]] HRESULT ScrollFrame() noexcept override { return S_OK; }
+
+    [[nodiscard]] HRESULT Invalidate(const SMALL_RECT* const psrRegion) noexcept override
+    try
+    {
+        _invalidMap.set(til::rectangle{ Viewport::FromExclusive(*psrRegion).ToInclusive() });
+        return S_OK;
+    }
+    CATCH_RETURN();
+
+    [[nodiscard]] HRESULT InvalidateCursor(const SMALL_RECT* const /*psrRegion*/) noexcept override { return S_OK; }
+    [[nodiscard]] HRESULT InvalidateSystem(const RECT* const /*prcDirtyClient*/) noexcept override { return InvalidateAll(); }
+    [[nodiscard]] HRESULT InvalidateSelection(const std::vector<SMALL_RECT>& /*rectangles*/) noexcept override { return S_OK; }
+
+    [[nodiscard]] HRESULT InvalidateScroll(const COORD* const pcoordDelta) noexcept override
+    try
+    {
+        // Rows that were scrolled are already on screen and only the uncovered ones need to be painted.
+        _invalidMap.translate(til::point{ *pcoordDelta }, true);
+        return S_OK;
+    }
+    CATCH_RETURN();
+
+    [[nodiscard]] HRESULT InvalidateAll() noexcept override
+    {
+        _invalidMap.set_all();
+        return S_OK;
+    }
+
+    [[nodiscard]] HRESULT InvalidateCircling(_Out_ bool* const pForcePaint) noexcept override
+    {
+        *pForcePaint = false;
+        return S_OK;
+    }
+
+    [[nodiscard]] HRESULT PaintBackground() noexcept override { return S_OK; }
+
+    [[nodiscard]] HRESULT PaintBufferLine(gsl::span<const Cluster> const clusters,
+                                          const COORD coord,
+                                          const bool fTrimLeft,
+                                          const bool lineWrapped) noexcept override
+    try
+    {
+        if (logCalls)
+        {
+            auto call = fmt::format(L"text {},{} trim {} wrapped {}:", coord.X, coord.Y, fTrimLeft, lineWrapped);
+            for (const auto& cluster : clusters)
+            {
+                call += fmt::format(L" {}/{}", cluster.GetText(), cluster.GetColumns());
+            }
+            calls.emplace_back(std::move(call));
+        }
+        ++paintedRows;
+        for (const auto& cluster : clusters)
+        {
+            paintedCells += cluster.GetColumns();
+        }
+        return S_OK;
+    }
+    CATCH_RETURN();
+
+    [[nodiscard]] HRESULT PaintBufferGridLines(const GridLineSet /*lines*/,
+                                               const COLORREF /*color*/,
+                                               const size_t /*cchLine*/,
+                                               const COORD /*coordTarget*/) noexcept override { return S_OK; }
+    [[nodiscard]] HRESULT PaintSelection(const SMALL_RECT /*rect*/) noexcept override { return S_OK; }
+    [[nodiscard]] HRESULT PaintCursor(const CursorOptions& /*options*/) noexcept override { return S_OK; }
+
+    [[nodiscard]] HRESULT UpdateDrawingBrushes(const TextAttribute& textAttributes,
+                                               const gsl::not_null<IRenderData*> /*pData*/,
+                                               const bool usingSoftFont,
+                                               const bool isSettingDefaultBrushes) noexcept override
+    try
+    {
+        if (logCalls && !isSettingDefaultBrushes)
+        {
+            calls.emplace_back(fmt::format(L"brushes {:#x} soft font {}", textAttributes.GetLegacyAttributes(), usingSoftFont));
+        }
+        return S_OK;
+    }
+    CATCH_RETURN();
+    [[nodiscard]] HRESULT UpdateFont(const FontInfoDesired& /*FontInfoDesired*/, _Out_ FontInfo& /*FontInfo*/) noexcept override { return S_OK; }
+    [[nodiscard]] HRESULT UpdateDpi(const int /*iDpi*/) noexcept override { return S_OK; }
+
+    [[nodiscard]] HRESULT UpdateViewport(const SMALL_RECT srNewViewport) noexcept override
+    try
+    {
+        const auto size = Viewport::FromInclusive(srNewViewport).Dimensions();
+        _invalidMap.resize(til::size{ size }, true);
+        return S_OK;
+    }
+    CATCH_RETURN();
+
+    [[nodiscard]] HRESULT GetProposedFont(const FontInfoDesired& /*FontInfoDesired*/,
+                                          _Out_ FontInfo& /*FontInfo*/,
+                                          const int /*iDpi*/) noexcept override { return S_OK; }
+
+    [[nodiscard]] HRESULT GetDirtyArea(gsl::span<const til::rectangle>& area) noexcept override
+    try
+    {
+        area = _invalidMap.runs();
+        return S_OK;
+    }
+    CATCH_RETURN();
+
+    [[nodiscard]] HRESULT GetFontSize(_Out_ COORD* const pFontSize) noexcept override
+    {
+        *pFontSize = { 1, 1 };
+        return S_OK;
+    }
+
+    [[nodiscard]] HRESULT IsGlyphWideByFont(const std::wstring_view /*glyph*/, _Out_ bool* const pResult) noexcept override
+    {
+        *pResult = false;
+        return S_OK;
+    }
+
+protected:
+    [[nodiscard]] HRESULT _DoUpdateTitle(const std::wstring_view /*newTitle*/) noexcept override { return S_OK; }
+
+private:
+    til::bitmap _invalidMap;
+};
 
 class RendererTests
 {
@@ -50,11 +223,8 @@ class RendererTests
 
     TEST_METHOD_SETUP(MethodSetup)
     {
-        Renderer* pRenderer = nullptr;
-        Globals& g = ServiceLocator::LocateGlobals();
-        CONSOLE_INFORMATION& gci = g.getConsoleInformation();
-        VERIFY_SUCCEEDED(Renderer::s_CreateInstance(gci.renderData, &pRenderer));
-        m_renderer.reset(pRenderer);
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        m_renderer = std::make_unique<Renderer>(&gci.renderData, nullptr, 0, nullptr);
         return true;
     }
 
@@ -68,4 +238,216 @@ class RendererTests
     {
         m_renderer->TriggerTitleChange();
     }
+
+    // Routine Description:
+    // - Attaches a CountingEngine to the renderer and makes the active buffer
+    //   report its changes to it. Everything is painted once up front, so that
+    //   the following frames only contain what changed afterwards.
+    [[nodiscard]] auto _AttachCountingEngine(CountingEngine& engine)
+    {
+        Globals& g = ServiceLocator::LocateGlobals();
+        const auto previous = std::exchange(g.pRender, m_renderer.get());
+        m_renderer->AddRenderEngine(&engine);
+
+        m_renderer->TriggerRedrawAll();
+        VERIFY_SUCCEEDED(m_renderer->PaintFrame());
+        engine.ResetCounters();
+
+        return wil::scope_exit([&g, previous]() noexcept {
+            g.pRender = previous;
+        });
+    }
+
+    TEST_METHOD(UnchangedRowsAreNotRepainted)
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+        TextBuffer& textBuffer = si.GetTextBuffer();
+        const auto origin = si.GetViewport().Origin();
+
+        CountingEngine engine;
+        auto restore = _AttachCountingEngine(engine);
+
+        Log::Comment(L"Writing new text should paint the row it was written to.");
+        textBuffer.Write(OutputCellIterator{ L"Hello" }, origin);
+        VERIFY_SUCCEEDED(m_renderer->PaintFrame());
+        VERIFY_ARE_EQUAL(1u, engine.frames);
+        VERIFY_ARE_EQUAL(1u, engine.paintedRows);
+        VERIFY_IS_GREATER_THAN_OR_EQUAL(engine.paintedCells, 5u);
+        engine.ResetCounters();
+
+        Log::Comment(L"Writing the same text again shouldn't paint anything.");
+        textBuffer.Write(OutputCellIterator{ L"Hello" }, origin);
+        VERIFY_SUCCEEDED(m_renderer->PaintFrame());
+        VERIFY_ARE_EQUAL(0u, engine.frames);
+        VERIFY_ARE_EQUAL(0u, engine.paintedRows);
+        VERIFY_ARE_EQUAL(0u, engine.paintedCells);
+        engine.ResetCounters();
+
+        Log::Comment(L"Changing the color of the text should paint it again.");
+        const TextAttribute red{ FOREGROUND_RED };
+        textBuffer.Write(OutputCellIterator{ L"Hello", red }, origin);
+        VERIFY_SUCCEEDED(m_renderer->PaintFrame());
+        VERIFY_ARE_EQUAL(1u, engine.frames);
+        VERIFY_ARE_EQUAL(1u, engine.paintedRows);
+        engine.ResetCounters();
+
+        textBuffer.Write(OutputCellIterator{ L"Hello", red }, origin);
+        VERIFY_SUCCEEDED(m_renderer->PaintFrame());
+        VERIFY_ARE_EQUAL(0u, engine.frames);
+    }
+
+    TEST_METHOD(OnlyChangedRowsOfARegionAreRepainted)
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+        TextBuffer& textBuffer = si.GetTextBuffer();
+        const auto origin = COORD{ 0, si.GetViewport().Top() };
+        const auto bufferWidth = gsl::narrow_cast<size_t>(textBuffer.GetSize().Width());
+        const auto width = gsl::narrow_cast<size_t>(si.GetViewport().Width());
+
+        CountingEngine engine;
+        auto restore = _AttachCountingEngine(engine);
+
+        // Fill the first 3 rows of the viewport, just like a full screen
+        // application redrawing its whole screen on every update would.
+        const auto redraw = [&](const wchar_t middle) {
+            std::wstring text(bufferWidth * 3, L'A');
+            text[bufferWidth + 1] = middle;
+            textBuffer.Write(OutputCellIterator{ text }, origin);
+        };
+
+        redraw(L'A');
+        VERIFY_SUCCEEDED(m_renderer->PaintFrame());
+        VERIFY_ARE_EQUAL(3u, engine.paintedRows);
+        VERIFY_ARE_EQUAL(width * 3, engine.paintedCells);
+        engine.ResetCounters();
+
+        Log::Comment(L"Only the row in the middle changed and only it should be painted.");
+        redraw(L'B');
+        VERIFY_SUCCEEDED(m_renderer->PaintFrame());
+        VERIFY_ARE_EQUAL(1u, engine.frames);
+        VERIFY_ARE_EQUAL(1u, engine.paintedRows);
+        VERIFY_ARE_EQUAL(width, engine.paintedCells);
+        engine.ResetCounters();
+
+        Log::Comment(L"Nothing changed and nothing should be painted.");
+        redraw(L'B');
+        VERIFY_SUCCEEDED(m_renderer->PaintFrame());
+        VERIFY_ARE_EQUAL(0u, engine.frames);
+        VERIFY_ARE_EQUAL(0u, engine.paintedCells);
+    }
+
+    // Routine Description:
+    // - Fills the viewport with text that changes its color every few cells,
+    //   with some wide characters and runs of spaces in between.
+    void _FillViewportWithRuns()
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+        TextBuffer& textBuffer = si.GetTextBuffer();
+        const auto viewport = si.GetViewport();
+
+        for (auto y = viewport.Top(); y < viewport.BottomExclusive(); ++y)
+        {
+            // Each piece of text is 8 columns wide.
+            WORD color = 1;
+            for (SHORT x = 0; x + 8 <= viewport.Width(); x += 8, ++color)
+            {
+                const auto text = color % 3 == 0 ? L"\x4e2d\x6587    " : color % 3 == 1 ? L"word    " : L"run     ";
+                textBuffer.Write(OutputCellIterator{ text, TextAttribute{ gsl::narrow_cast<WORD>(color & 0xff) } }, { x, y });
+            }
+        }
+    }
+
+    TEST_METHOD(CachedRowsArePaintedLikeUncachedOnes)
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+        TextBuffer& textBuffer = si.GetTextBuffer();
+        const auto origin = si.GetViewport().Origin();
+
+        CountingEngine engine;
+        auto restore = _AttachCountingEngine(engine);
+        _FillViewportWithRuns();
+        engine.logCalls = true;
+
+        const auto repaint = [&](const bool cached) {
+            m_renderer->_rowCacheEnabled = cached;
+            engine.calls.clear();
+            m_renderer->TriggerRedrawAll();
+            VERIFY_SUCCEEDED(m_renderer->PaintFrame());
+            return engine.calls;
+        };
+
+        const auto& rowCache = til::at(m_renderer->_engineStates, m_renderer->_GetEngineIndex(&engine)).rowCache;
+
+        auto expected = repaint(false);
+        VERIFY_IS_FALSE(expected.empty());
+
+        Log::Comment(L"Painting the rows for the first time fills the cache.");
+        VERIFY_IS_TRUE(expected == repaint(true));
+        VERIFY_IS_FALSE(rowCache.empty());
+        VERIFY_IS_TRUE(std::all_of(rowCache.begin(), rowCache.end(), [](const auto& row) { return row.valid; }));
+
+        Log::Comment(L"Painting them again from the cache should result in the same calls.");
+        VERIFY_IS_TRUE(expected == repaint(true));
+
+        Log::Comment(L"A row that changed is split into runs again.");
+        textBuffer.Write(OutputCellIterator{ L"Howdy", TextAttribute{ FOREGROUND_GREEN } }, origin);
+        expected = repaint(false);
+        VERIFY_IS_TRUE(expected == repaint(true));
+        VERIFY_IS_TRUE(expected == repaint(true));
+
+        Log::Comment(L"Redrawing a row, like when its pattern IDs change, drops it from the cache.");
+        m_renderer->TriggerRedraw(Viewport::FromDimensions(origin, { 1, 1 }));
+        VERIFY_IS_FALSE(til::at(rowCache, 0).valid);
+        VERIFY_IS_TRUE(til::at(rowCache, 1).valid);
+        VERIFY_IS_TRUE(expected == repaint(true));
+        VERIFY_IS_TRUE(til::at(rowCache, 0).valid);
+    }
+
+    TEST_METHOD(RowCacheFullRepaintBenchmark)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        Log::Comment(L"Repaints a viewport full of short runs of text 500 times, with and without caching the runs of each row.");
+
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+
+        constexpr size_t iterations = 500;
+
+        CountingEngine engine;
+        auto restore = _AttachCountingEngine(engine);
+        _FillViewportWithRuns();
+
+        for (const auto cached : { false, true })
+        {
+            m_renderer->_rowCacheEnabled = cached;
+            // Split the rows into runs once, like a frame which actually changed them would.
+            m_renderer->TriggerRedrawAll();
+            VERIFY_SUCCEEDED(m_renderer->PaintFrame());
+            engine.ResetCounters();
+
+            const auto now = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                m_renderer->TriggerRedrawAll();
+                VERIFY_SUCCEEDED(m_renderer->PaintFrame());
+            }
+            const auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+            Log::Comment(NoThrowString().Format(L"%s: %zu frames of %d rows painted in %.2f ms, %.1f us per frame",
+                                                cached ? L"cached" : L"uncached",
+                                                engine.frames,
+                                                si.GetViewport().Height(),
+                                                delta * 1000.0,
+                                                delta * 1000000.0 / iterations));
+        }
+
+        m_renderer->_rowCacheEnabled = true;
+    }
 };
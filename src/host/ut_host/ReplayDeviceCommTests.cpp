@@ -0,0 +1,374 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "CommonState.hpp"
+
+#include "../server/ReplayDeviceComm.h"
+
+#include "../interactivity/inc/ServiceLocator.hpp"
+
+#include <filesystem>
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+using Microsoft::Console::Interactivity::ServiceLocator;
+
+class ReplayDeviceCommTests
+{
+    TEST_CLASS(ReplayDeviceCommTests);
+
+    std::unique_ptr<CommonState> m_state;
+    ConsoleProcessHandle* _process = nullptr;
+
+    // ReplayDeviceComm numbers handles in the order they're handed out: first the
+    // process, which we put ourselves, then the objects created by the recording.
+    static constexpr ULONG_PTR s_process = 1;
+    static constexpr ULONG_PTR s_input = 2;
+    static constexpr ULONG_PTR s_output = 3;
+
+    TEST_METHOD_SETUP(MethodSetup)
+    {
+        m_state = std::make_unique<CommonState>();
+
+        m_state->PrepareGlobalFont();
+        m_state->PrepareGlobalScreenBuffer();
+        m_state->PrepareGlobalInputBuffer();
+
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        gci.LockConsole();
+        auto unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+        VERIFY_SUCCEEDED(gci.ProcessHandleList.AllocProcessData(GetCurrentProcessId(), GetCurrentThreadId(), 0, nullptr, &_process));
+
+        return true;
+    }
+
+    TEST_METHOD_CLEANUP(MethodCleanup)
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        if (_process)
+        {
+            gci.LockConsole();
+            gci.ProcessHandleList.FreeProcessData(_process);
+            gci.UnlockConsole();
+            _process = nullptr;
+        }
+
+        m_state->CleanupGlobalInputBuffer();
+        m_state->CleanupGlobalScreenBuffer();
+        m_state->CleanupGlobalFont();
+
+        m_state.reset(nullptr);
+
+        return true;
+    }
+
+    template<typename T>
+    static gsl::span<const std::byte> _AsBytes(const T& value)
+    {
+        return gsl::as_bytes(gsl::make_span(&value, 1));
+    }
+
+    static ReplayDeviceComm::Message _WriteConsoleMessage(const std::wstring_view text)
+    {
+        CONSOLE_WRITECONSOLE_MSG body{};
+        body.NumBytes = gsl::narrow<ULONG>(text.size() * sizeof(wchar_t));
+        body.Unicode = TRUE;
+        return ReplayDeviceComm::s_CreateApiMessage(s_process, s_output, ConsolepWriteConsole, _AsBytes(body), gsl::as_bytes(gsl::make_span(text.data(), text.size())));
+    }
+
+    static ReplayDeviceComm::Message _ReadConsoleInputMessage(const ULONG records)
+    {
+        CONSOLE_GETCONSOLEINPUT_MSG body{};
+        body.Flags = CONSOLE_READ_NOWAIT;
+        body.Unicode = TRUE;
+        return ReplayDeviceComm::s_CreateApiMessage(s_process, s_input, ConsolepGetConsoleInput, _AsBytes(body), {}, gsl::narrow<ULONG>(records * sizeof(INPUT_RECORD)));
+    }
+
+    static ReplayDeviceComm::Message _WriteConsoleInputMessage(const gsl::span<const INPUT_RECORD> records)
+    {
+        CONSOLE_WRITECONSOLEINPUT_MSG body{};
+        body.NumRecords = gsl::narrow<ULONG>(records.size());
+        body.Unicode = TRUE;
+        body.Append = TRUE;
+        return ReplayDeviceComm::s_CreateApiMessage(s_process, s_input, ConsolepWriteConsoleInput, _AsBytes(body), gsl::as_bytes(records));
+    }
+
+    static ReplayDeviceComm::Message _GetScreenBufferInfoMessage()
+    {
+        const CONSOLE_SCREENBUFFERINFO_MSG body{};
+        return ReplayDeviceComm::s_CreateApiMessage(s_process, s_output, ConsolepGetScreenBufferInfo, _AsBytes(body));
+    }
+
+    static ReplayDeviceComm::Message _SetCursorPositionMessage(const COORD position)
+    {
+        CONSOLE_SETCURSORPOSITION_MSG body{};
+        body.CursorPosition = position;
+        return ReplayDeviceComm::s_CreateApiMessage(s_process, s_output, ConsolepSetCursorPosition, _AsBytes(body));
+    }
+
+    // Wraps API messages into a recording that opens the input and output buffer first and closes them at the end.
+    static std::vector<ReplayDeviceComm::Message> _CreateRecording(std::vector<ReplayDeviceComm::Message> apiMessages)
+    {
+        std::vector<ReplayDeviceComm::Message> messages;
+        messages.reserve(apiMessages.size() + 4);
+        messages.emplace_back(ReplayDeviceComm::s_CreateObjectMessage(s_process, CD_IO_OBJECT_TYPE_CURRENT_INPUT));
+        messages.emplace_back(ReplayDeviceComm::s_CreateObjectMessage(s_process, CD_IO_OBJECT_TYPE_CURRENT_OUTPUT));
+        std::move(apiMessages.begin(), apiMessages.end(), std::back_inserter(messages));
+        messages.emplace_back(ReplayDeviceComm::s_CloseObjectMessage(s_process, s_output));
+        messages.emplace_back(ReplayDeviceComm::s_CloseObjectMessage(s_process, s_input));
+        return messages;
+    }
+
+    static std::array<INPUT_RECORD, 2> _KeyPress(const wchar_t wch)
+    {
+        std::array<INPUT_RECORD, 2> records{};
+        for (auto& record : records)
+        {
+            record.EventType = KEY_EVENT;
+            record.Event.KeyEvent.wRepeatCount = 1;
+            record.Event.KeyEvent.uChar.UnicodeChar = wch;
+        }
+        records[0].Event.KeyEvent.bKeyDown = TRUE;
+        return records;
+    }
+
+    std::unique_ptr<ReplayDeviceComm> _Replay(std::vector<ReplayDeviceComm::Message> messages)
+    {
+        auto comm = std::make_unique<ReplayDeviceComm>(std::move(messages));
+        VERIFY_ARE_EQUAL(s_process, comm->PutHandle(_process));
+        VERIFY_SUCCEEDED(comm->Replay());
+        return comm;
+    }
+
+    static std::wstring _GetApiName(const ULONG apiNumber)
+    {
+        switch (apiNumber)
+        {
+        case CONSOLE_IO_CREATE_OBJECT:
+            return L"CreateObject";
+        case CONSOLE_IO_CLOSE_OBJECT:
+            return L"CloseObject";
+        case ConsolepWriteConsole:
+            return L"WriteConsole";
+        case ConsolepGetConsoleInput:
+            return L"ReadConsoleInput";
+        case ConsolepWriteConsoleInput:
+            return L"WriteConsoleInput";
+        case ConsolepGetScreenBufferInfo:
+            return L"GetConsoleScreenBufferInfo";
+        case ConsolepSetCursorPosition:
+            return L"SetConsoleCursorPosition";
+        default:
+            return static_cast<const wchar_t*>(NoThrowString().Format(L"API 0x%08x", apiNumber));
+        }
+    }
+
+    static void _LogStatistics(const std::wstring_view name, const ReplayDeviceComm& comm, const std::chrono::steady_clock::duration elapsed)
+    {
+        using microseconds = std::chrono::duration<double, std::micro>;
+
+        size_t messages = 0;
+        for (const auto& [apiNumber, statistics] : comm.GetStatistics())
+        {
+            messages += statistics.count;
+            Log::Comment(NoThrowString().Format(L"    %-28s %8zu calls, %8.2f us average, %8.2f us max, %zu failed",
+                                                _GetApiName(apiNumber).c_str(),
+                                                statistics.count,
+                                                microseconds(statistics.total).count() / statistics.count,
+                                                microseconds(statistics.max).count(),
+                                                statistics.failures));
+        }
+
+        const auto seconds = std::chrono::duration<double>(elapsed).count();
+        Log::Comment(NoThrowString().Format(L"%.*s: %zu messages in %.2f ms, %.0f messages/s",
+                                            gsl::narrow_cast<int>(name.size()),
+                                            name.data(),
+                                            messages,
+                                            seconds * 1000.0,
+                                            messages / seconds));
+    }
+
+    TEST_METHOD(RecordingRoundTrip)
+    {
+        Log::Comment(L"A recording saved to a file is loaded back unchanged.");
+
+        const auto keys = _KeyPress(L'a');
+        const auto recording = _CreateRecording({
+            _WriteConsoleMessage(L"Hello, World!"),
+            _WriteConsoleInputMessage(keys),
+            _ReadConsoleInputMessage(2),
+            _GetScreenBufferInfoMessage(),
+            _SetCursorPositionMessage({ 1, 2 }),
+        });
+
+        const auto path = (std::filesystem::temp_directory_path() / L"ReplayDeviceCommTests.bin").wstring();
+        auto deleteFile = wil::scope_exit([&] { DeleteFileW(path.c_str()); });
+
+        ReplayDeviceComm::s_SaveRecording(path, recording);
+        const auto loaded = ReplayDeviceComm::s_LoadRecording(path);
+
+        VERIFY_ARE_EQUAL(recording.size(), loaded.size());
+        for (size_t i = 0; i < recording.size(); ++i)
+        {
+            VERIFY_IS_TRUE(recording[i].packet == loaded[i].packet, NoThrowString().Format(L"packet of message %zu", i));
+            VERIFY_IS_TRUE(recording[i].input == loaded[i].input, NoThrowString().Format(L"input of message %zu", i));
+        }
+    }
+
+    TEST_METHOD(ReplayServicesMessages)
+    {
+        Log::Comment(L"Replayed messages are serviced by the server just like the ones from the driver.");
+
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        const auto& cursor = gci.GetActiveOutputBuffer().GetTextBuffer().GetCursor();
+
+        const std::wstring_view text{ L"Hello" };
+        const auto keys = _KeyPress(L'a');
+        const auto comm = _Replay(_CreateRecording({
+            _SetCursorPositionMessage({ 5, 3 }),
+            _WriteConsoleMessage(text),
+            _GetScreenBufferInfoMessage(),
+            _WriteConsoleInputMessage(keys),
+            _ReadConsoleInputMessage(2),
+        }));
+
+        const auto& messages = comm->GetMessages();
+        for (size_t i = 0; i < messages.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(STATUS_SUCCESS, messages[i].status, NoThrowString().Format(L"status of message %zu", i));
+        }
+
+        Log::Comment(L"The input and output buffers were opened with the handles the recording uses.");
+        VERIFY_ARE_EQUAL(s_input, messages[0].information);
+        VERIFY_ARE_EQUAL(s_output, messages[1].information);
+
+        Log::Comment(L"The text was written where the cursor was moved to.");
+        const COORD expectedCursor{ gsl::narrow<SHORT>(5 + text.size()), 3 };
+        VERIFY_ARE_EQUAL(expectedCursor, cursor.GetPosition());
+
+        CONSOLE_WRITECONSOLE_MSG writeConsole{};
+        VERIFY_ARE_EQUAL(sizeof(writeConsole), messages[3].reply.size());
+        memcpy(&writeConsole, messages[3].reply.data(), sizeof(writeConsole));
+        VERIFY_ARE_EQUAL(text.size() * sizeof(wchar_t), writeConsole.NumBytes);
+
+        Log::Comment(L"The screen buffer info returned to the client has the new cursor position.");
+        CONSOLE_SCREENBUFFERINFO_MSG screenBufferInfo{};
+        VERIFY_ARE_EQUAL(sizeof(screenBufferInfo), messages[4].reply.size());
+        memcpy(&screenBufferInfo, messages[4].reply.data(), sizeof(screenBufferInfo));
+        VERIFY_ARE_EQUAL(expectedCursor, screenBufferInfo.CursorPosition);
+
+        Log::Comment(L"The input records that were written are read back.");
+        CONSOLE_GETCONSOLEINPUT_MSG getConsoleInput{};
+        memcpy(&getConsoleInput, messages[6].reply.data(), sizeof(getConsoleInput));
+        VERIFY_ARE_EQUAL(keys.size(), getConsoleInput.NumRecords);
+        VERIFY_ARE_EQUAL(sizeof(keys), messages[6].output.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            INPUT_RECORD record;
+            memcpy(&record, messages[6].output.data() + i * sizeof(record), sizeof(record));
+            VERIFY_ARE_EQUAL(keys[i], record);
+        }
+
+        Log::Comment(L"Every message was counted once.");
+        const auto& statistics = comm->GetStatistics();
+        VERIFY_ARE_EQUAL(2u, statistics.at(CONSOLE_IO_CREATE_OBJECT).count);
+        VERIFY_ARE_EQUAL(2u, statistics.at(CONSOLE_IO_CLOSE_OBJECT).count);
+        for (const ULONG apiNumber : std::initializer_list<ULONG>{ ConsolepSetCursorPosition, ConsolepWriteConsole, ConsolepGetScreenBufferInfo, ConsolepWriteConsoleInput, ConsolepGetConsoleInput })
+        {
+            VERIFY_ARE_EQUAL(1u, statistics.at(apiNumber).count);
+            VERIFY_ARE_EQUAL(0u, statistics.at(apiNumber).failures);
+        }
+    }
+
+    TEST_METHOD(ApiReplayBenchmark)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        Log::Comment(L"Replays mixes of 10K API calls through the server and reports the latency of each API.");
+        Log::Comment(L"Pass /p:ReplayRecording=<path> to replay a recording from a file as well.");
+
+        constexpr size_t iterations = 10000;
+
+        const auto keys = _KeyPress(L'a');
+        const std::wstring_view line{ L"The quick brown fox jumps over the lazy dog.\r\n" };
+
+        std::vector<std::pair<std::wstring, std::vector<ReplayDeviceComm::Message>>> mixes;
+        mixes.emplace_back(L"WriteConsole", std::vector<ReplayDeviceComm::Message>{});
+        mixes.emplace_back(L"ReadConsoleInput", std::vector<ReplayDeviceComm::Message>{});
+        mixes.emplace_back(L"GetConsoleScreenBufferInfo/SetConsoleCursorPosition", std::vector<ReplayDeviceComm::Message>{});
+        mixes.emplace_back(L"Mixed", std::vector<ReplayDeviceComm::Message>{});
+
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            const COORD position{ gsl::narrow_cast<SHORT>(i % 40), gsl::narrow_cast<SHORT>(i % 20) };
+
+            mixes[0].second.emplace_back(_WriteConsoleMessage(line));
+
+            // Every read is preceded by a write, so that it never has to wait.
+            auto& read = mixes[1].second;
+            read.emplace_back(i % 2 ? _ReadConsoleInputMessage(2) : _WriteConsoleInputMessage(keys));
+
+            auto& cursor = mixes[2].second;
+            cursor.emplace_back(i % 2 ? _GetScreenBufferInfoMessage() : _SetCursorPositionMessage(position));
+
+            auto& mixed = mixes[3].second;
+            switch (i % 5)
+            {
+            case 0:
+                mixed.emplace_back(_SetCursorPositionMessage(position));
+                break;
+            case 1:
+                mixed.emplace_back(_WriteConsoleMessage(line));
+                break;
+            case 2:
+                mixed.emplace_back(_GetScreenBufferInfoMessage());
+                break;
+            case 3:
+                mixed.emplace_back(_WriteConsoleInputMessage(keys));
+                break;
+            default:
+                mixed.emplace_back(_ReadConsoleInputMessage(2));
+                break;
+            }
+        }
+
+        // The mixes go through the recording format, just like recordings from elsewhere do.
+        const auto path = (std::filesystem::temp_directory_path() / L"ApiReplayBenchmark.bin").wstring();
+        auto deleteFile = wil::scope_exit([&] { DeleteFileW(path.c_str()); });
+
+        for (auto& [name, messages] : mixes)
+        {
+            ReplayDeviceComm::s_SaveRecording(path, _CreateRecording(std::move(messages)));
+            auto recording = ReplayDeviceComm::s_LoadRecording(path);
+
+            const auto now = std::chrono::steady_clock::now();
+            const auto comm = _Replay(std::move(recording));
+            const auto elapsed = std::chrono::steady_clock::now() - now;
+
+            for (const auto& [apiNumber, statistics] : comm->GetStatistics())
+            {
+                VERIFY_ARE_EQUAL(0u, statistics.failures, _GetApiName(apiNumber).c_str());
+            }
+            _LogStatistics(name, *comm, elapsed);
+        }
+
+        String recordingPath;
+        if (SUCCEEDED(RuntimeParameters::TryGetValue(L"ReplayRecording", recordingPath)) && !recordingPath.IsEmpty())
+        {
+            auto recording = ReplayDeviceComm::s_LoadRecording(static_cast<const wchar_t*>(recordingPath));
+
+            const auto now = std::chrono::steady_clock::now();
+            const auto comm = _Replay(std::move(recording));
+            const auto elapsed = std::chrono::steady_clock::now() - now;
+
+            _LogStatistics(static_cast<const wchar_t*>(recordingPath), *comm, elapsed);
+        }
+    }
+};
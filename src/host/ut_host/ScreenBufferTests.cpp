@@ -179,6 +179,7 @@ class ScreenBufferTests
     TEST_METHOD(InsertLinesInMargins);
     TEST_METHOD(DeleteLinesInMargins);
     TEST_METHOD(ReverseLineFeedInMargins);
+    TEST_METHOD(ScrollMarginsBenchmark);
 
     TEST_METHOD(LineFeedEscapeSequences);
 
@@ -4418,6 +4419,76 @@ void ScreenBufferTests::ReverseLineFeedInMargins()
     }
 }
 
+void ScreenBufferTests::ScrollMarginsBenchmark()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    Log::Comment(L"Emulates `seq 1 1000000` inside a scrolling region, like in a split tmux or vim window, "
+                 L"and then repeatedly clears the screen.");
+
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    auto& si = gci.GetActiveOutputBuffer();
+    auto& tbi = si.GetTextBuffer();
+    auto& stateMachine = si.GetStateMachine();
+    const auto view = si.GetViewport();
+
+    // Keep the first and the last line of the viewport out of the margins.
+    stateMachine.ProcessString(L"\x1b[HA");
+    stateMachine.ProcessString(NoThrowString().Format(L"\x1b[%d;1HB", view.Height()).GetBuffer());
+    stateMachine.ProcessString(NoThrowString().Format(L"\x1b[2;%dr", view.Height() - 1).GetBuffer());
+    // Make sure we clear the margins on exit so they can't break other tests.
+    auto clearMargins = wil::scope_exit([&] { stateMachine.ProcessString(L"\x1b[r"); });
+    stateMachine.ProcessString(NoThrowString().Format(L"\x1b[%d;1H", view.Height() - 1).GetBuffer());
+
+    constexpr size_t lines = 1000000;
+    constexpr size_t linesPerChunk = 1000;
+
+    // Prepare the output up front, so that only processing it is measured.
+    std::vector<std::wstring> chunks;
+    chunks.reserve(lines / linesPerChunk);
+    for (size_t i = 1; i <= lines; i += linesPerChunk)
+    {
+        std::wstring chunk;
+        for (auto j = i; j < i + linesPerChunk; ++j)
+        {
+            chunk += std::to_wstring(j);
+            chunk += L"\r\n";
+        }
+        chunks.emplace_back(std::move(chunk));
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (const auto& chunk : chunks)
+    {
+        stateMachine.ProcessString(chunk);
+    }
+    auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+    Log::Comment(NoThrowString().Format(L"%zu lines scrolled within the margins in %.2f ms", lines, delta * 1000.0));
+
+    // The last number ended up right above the cursor, while the lines outside the margins stayed untouched.
+    const auto lastLine = gsl::narrow<SHORT>(view.Top() + view.Height() - 3);
+    const auto lastText = tbi.GetRowByOffset(lastLine).GetText();
+    VERIFY_ARE_EQUAL(L"1000000", std::wstring_view{ lastText }.substr(0, 7));
+    VERIFY_ARE_EQUAL(L"A", tbi.GetCellDataAt({ 0, view.Top() })->Chars());
+    VERIFY_ARE_EQUAL(L"B", tbi.GetCellDataAt({ 0, view.BottomInclusive() })->Chars());
+
+    constexpr size_t clears = 10000;
+
+    now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < clears; ++i)
+    {
+        stateMachine.ProcessString(L"\x1b[H\x1b[J");
+    }
+    delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+    Log::Comment(NoThrowString().Format(L"%zu screens cleared in %.2f ms", clears, delta * 1000.0));
+
+    VERIFY_ARE_EQUAL(L"\x20", tbi.GetCellDataAt({ 0, view.BottomInclusive() })->Chars());
+}
+
 void ScreenBufferTests::LineFeedEscapeSequences()
 {
     BEGIN_TEST_METHOD_PROPERTIES()
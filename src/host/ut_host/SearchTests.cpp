@@ -156,4 +156,78 @@ class SearchTests
         Search s(gci.renderData, L"\x304b", Search::Direction::Backward, Search::Sensitivity::CaseInsensitive);
         DoFoundChecks(s, coordStartExpected, -1);
     }
+
+    TEST_METHOD(FindNextSeesTextWrittenInBetween)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+
+        Search s(gci.renderData, L"ab", Search::Direction::Forward, Search::Sensitivity::CaseInsensitive);
+
+        VERIFY_IS_TRUE(s.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 0, 0 }), s._coordSelStart);
+        VERIFY_ARE_EQUAL((COORD{ 1, 0 }), s._coordSelEnd);
+
+        Log::Comment(L"Overwriting the text of the next row should make the search skip it.");
+        textBuffer.GetRowByOffset(1).GetCharRow().ClearGlyph(0);
+
+        VERIFY_IS_TRUE(s.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 0, 2 }), s._coordSelStart);
+        VERIFY_ARE_EQUAL((COORD{ 1, 2 }), s._coordSelEnd);
+    }
+
+    TEST_METHOD(FindAllIncremental)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+
+        Search s(gci.renderData, L"ab", Search::Direction::Forward, Search::Sensitivity::CaseInsensitive);
+
+        const auto matches = s.FindAll();
+        VERIFY_ARE_EQUAL(4u, matches.size());
+        for (SHORT y = 0; y < 4; ++y)
+        {
+            VERIFY_ARE_EQUAL((COORD{ 0, y }), matches.at(y).first);
+            VERIFY_ARE_EQUAL((COORD{ 1, y }), matches.at(y).second);
+        }
+
+        Log::Comment(L"Overwriting the text of one row should only drop the matches in that row.");
+        textBuffer.GetRowByOffset(1).GetCharRow().ClearGlyph(0);
+
+        const auto updated = s.FindAll();
+        VERIFY_ARE_EQUAL(3u, updated.size());
+        VERIFY_ARE_EQUAL((COORD{ 0, 0 }), updated.at(0).first);
+        VERIFY_ARE_EQUAL((COORD{ 0, 2 }), updated.at(1).first);
+        VERIFY_ARE_EQUAL((COORD{ 0, 3 }), updated.at(2).first);
+    }
+
+    TEST_METHOD(ConsecutiveSearchesShareTheCache)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+        auto& cache = textBuffer.GetSearchCache();
+
+        {
+            Search s(gci.renderData, L"ab", Search::Direction::Forward, Search::Sensitivity::CaseInsensitive);
+            VERIFY_ARE_EQUAL(4u, s.FindAll().size());
+        }
+
+        Log::Comment(L"Tamper with the cached matches of the first row to tell whether it's scanned again.");
+        auto& line = cache.lines.at(textBuffer.GetRowByOffset(0).GetCharRow().GetRevision());
+        line.columns = { 2 };
+
+        {
+            Search s(gci.renderData, L"ab", Search::Direction::Forward, Search::Sensitivity::CaseInsensitive);
+            VERIFY_IS_TRUE(s.FindNext());
+            VERIFY_ARE_EQUAL((COORD{ 2, 0 }), s._coordSelStart);
+        }
+
+        Log::Comment(L"A different needle must not use the matches of the previous one.");
+        {
+            Search s(gci.renderData, L"AB", Search::Direction::Forward, Search::Sensitivity::CaseSensitive);
+            const auto matches = s.FindAll();
+            VERIFY_ARE_EQUAL(4u, matches.size());
+            VERIFY_ARE_EQUAL((COORD{ 0, 0 }), matches.front().first);
+        }
+    }
 };
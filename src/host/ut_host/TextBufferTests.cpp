@@ -140,6 +140,10 @@ class TextBufferTests
 
     TEST_METHOD(ResizeTraditionalRotationPreservesHighUnicode);
     TEST_METHOD(ScrollBufferRotationPreservesHighUnicode);
+    TEST_METHOD(ScrollRowsInCircularBuffer);
+    TEST_METHOD(ResetRows);
+    TEST_METHOD(WriteCharInfoRectMatchesCellIterator);
+    TEST_METHOD(ReadCharInfoRectMatchesCellIterator);
 
     TEST_METHOD(ResizeTraditionalHighUnicodeRowRemoval);
     TEST_METHOD(ResizeTraditionalHighUnicodeColumnRemoval);
@@ -153,9 +157,13 @@ class TextBufferTests
 
     TEST_METHOD(GetTextRects);
     TEST_METHOD(GetText);
+    TEST_METHOD(ExportTextMatchesGetText);
+    TEST_METHOD(ExportTextBenchmark);
 
     TEST_METHOD(HyperlinkTrim);
     TEST_METHOD(NoHyperlinkTrim);
+
+    TEST_METHOD(GetPatternsOnlyRescansChangedLines);
 };
 
 void TextBufferTests::TestBufferCreate()
@@ -1903,8 +1911,197 @@ void TextBufferTests::ScrollBufferRotationPreservesHighUnicode()
     VERIFY_ARE_EQUAL(String(fire), String(shouldBeFireText.data(), gsl::narrow<int>(shouldBeFireText.size())));
 }
 
+void TextBufferTests::ScrollRowsInCircularBuffer()
+{
+    const COORD bufferSize{ 80, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    // Circle the buffer, so that the first row isn't stored at the front anymore.
+    for (auto i = 0; i < 3; ++i)
+    {
+        VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+    }
+    VERIFY_ARE_EQUAL(3, _buffer->GetFirstRowIndex());
+
+    // Label each row with its index.
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        _buffer->Write(OutputCellIterator{ std::to_wstring(y) }, { 0, y });
+    }
+
+    const auto verifyRows = [&](const std::wstring_view expected) {
+        for (SHORT y = 0; y < bufferSize.Y; ++y)
+        {
+            const auto text = *_buffer->GetTextDataAt({ 0, y });
+            VERIFY_ARE_EQUAL(String(expected.substr(y, 1).data(), 1), String(text.data(), gsl::narrow<int>(text.size())));
+        }
+
+        // The IDs of the rows have to match where they're stored.
+        for (size_t i = 0; i < _buffer->_storage.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(gsl::narrow<SHORT>(i), _buffer->_storage.at(i).GetId());
+        }
+    };
+
+    Log::Comment(L"Rows that are stored contiguously are rotated in place.");
+    _buffer->ScrollRows(1, 3, -1);
+    verifyRows(L"1230456789");
+    VERIFY_ARE_EQUAL(3, _buffer->GetFirstRowIndex());
+
+    Log::Comment(L"Rows that wrap around the end of the storage are rotated after straightening the buffer.");
+    _buffer->ScrollRows(5, 3, 2);
+    verifyRows(L"1230489567");
+    VERIFY_ARE_EQUAL(0, _buffer->GetFirstRowIndex());
+}
+
+void TextBufferTests::ResetRows()
+{
+    const COORD bufferSize{ 80, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        _buffer->Write(OutputCellIterator{ L"Hello", attr }, { 0, y });
+    }
+    _buffer->GetRowByOffset(2).SetLineRendition(LineRendition::DoubleWidth);
+    _buffer->GetRowByOffset(2).SetWrapForced(true);
+
+    const TextAttribute fillAttr{ 0x1e };
+    _buffer->ResetRows(1, 3, fillAttr);
+
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        const auto erased = y == 1 || y == 2;
+        const auto& row = _buffer->GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(erased ? L' ' : L'H', _buffer->GetCellDataAt({ 0, y })->Chars().front());
+        VERIFY_ARE_EQUAL(erased ? fillAttr : attr, _buffer->GetCellDataAt({ 0, y })->TextAttr());
+        VERIFY_ARE_EQUAL(erased ? fillAttr : attr, _buffer->GetCellDataAt({ bufferSize.X - 1, y })->TextAttr());
+        VERIFY_IS_TRUE(row.GetLineRendition() == LineRendition::SingleWidth);
+        VERIFY_IS_FALSE(row.WasWrapForced());
+    }
+}
+
+static CHAR_INFO MakeCharInfo(const wchar_t wch, const WORD attributes) noexcept
+{
+    CHAR_INFO charInfo;
+    charInfo.Char.UnicodeChar = wch;
+    charInfo.Attributes = attributes;
+    return charInfo;
+}
+
+void TextBufferTests::WriteCharInfoRectMatchesCellIterator()
+{
+    const COORD bufferSize{ 10, 6 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto expectedBuffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    auto actualBuffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        expectedBuffer->Write(OutputCellIterator{ L"\xD83C\xDF46 wide text", attr }, { 0, y });
+        actualBuffer->Write(OutputCellIterator{ L"\xD83C\xDF46 wide text", attr }, { 0, y });
+    }
+
+    // Every row is written across the whole width of the buffer, except for the first,
+    // which covers the columns 2 to 7. The rows exercise runs of attributes, double byte
+    // pairs, as well as the padding of a trailing byte at the start and a leading byte
+    // at the end of a row.
+    constexpr WORD lead = COMMON_LVB_LEADING_BYTE;
+    constexpr WORD trail = COMMON_LVB_TRAILING_BYTE;
+    const std::vector<std::vector<CHAR_INFO>> rows{
+        { MakeCharInfo(L'a', 0x1f), MakeCharInfo(L'b', 0x1f), MakeCharInfo(L'c', 0x2e), MakeCharInfo(L'd', 0x2e), MakeCharInfo(L'e', 0x1f), MakeCharInfo(L'f', 0x1f) },
+        { MakeCharInfo(L'A', 0x07), MakeCharInfo(L'\x3042', 0x4f | lead), MakeCharInfo(L'\x3042', 0x4f | trail), MakeCharInfo(L'B', 0x4f), MakeCharInfo(L'C', 0x07), MakeCharInfo(L'D', 0x07), MakeCharInfo(L'E', 0x07), MakeCharInfo(L'F', 0x07), MakeCharInfo(L'\x3044', 0x07 | lead), MakeCharInfo(L'\x3044', 0x07 | trail) },
+        { MakeCharInfo(L'\x3042', 0x5a | trail), MakeCharInfo(L'x', 0x5a), MakeCharInfo(L'y', 0x5a), MakeCharInfo(L'z', 0x5a), MakeCharInfo(L'x', 0x5a), MakeCharInfo(L'y', 0x5a), MakeCharInfo(L'z', 0x5a), MakeCharInfo(L'x', 0x5a), MakeCharInfo(L'y', 0x5a), MakeCharInfo(L'z', 0x5a) },
+        { MakeCharInfo(L'x', 0x3c), MakeCharInfo(L'y', 0x3c), MakeCharInfo(L'z', 0x3c), MakeCharInfo(L'x', 0x3c), MakeCharInfo(L'y', 0x3c), MakeCharInfo(L'z', 0x3c), MakeCharInfo(L'x', 0x3c), MakeCharInfo(L'y', 0x3c), MakeCharInfo(L'z', 0x3c), MakeCharInfo(L'\x3042', 0x3c | lead) },
+        { MakeCharInfo(L' ', 0x07), MakeCharInfo(L' ', 0x07), MakeCharInfo(L' ', 0x07), MakeCharInfo(L' ', 0x07), MakeCharInfo(L' ', 0x07), MakeCharInfo(L' ', 0x07), MakeCharInfo(L' ', 0x07), MakeCharInfo(L' ', 0x07), MakeCharInfo(L' ', 0x07), MakeCharInfo(L' ', 0x07) },
+    };
+
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        const auto& row = rows[i];
+        const COORD target{ gsl::narrow_cast<SHORT>(i == 0 ? 2 : 0), gsl::narrow_cast<SHORT>(i) };
+        expectedBuffer->Write(OutputCellIterator{ gsl::span<const CHAR_INFO>{ row } }, target);
+        actualBuffer->WriteCharInfoRect(row, row.size(), Viewport::FromDimensions(target, { gsl::narrow_cast<SHORT>(row.size()), 1 }));
+    }
+
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        const auto& expectedRow = expectedBuffer->GetRowByOffset(y);
+        const auto& actualRow = actualBuffer->GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(expectedRow.WasWrapForced(), actualRow.WasWrapForced(), NoThrowString().Format(L"row %d", y));
+        VERIFY_ARE_EQUAL(expectedRow.WasDoubleBytePadded(), actualRow.WasDoubleBytePadded(), NoThrowString().Format(L"row %d", y));
+
+        for (SHORT x = 0; x < bufferSize.X; ++x)
+        {
+            const auto expected = expectedBuffer->GetCellDataAt({ x, y });
+            const auto actual = actualBuffer->GetCellDataAt({ x, y });
+            const auto message = NoThrowString().Format(L"column %d, row %d", x, y);
+            VERIFY_ARE_EQUAL(expected->Chars(), actual->Chars(), message);
+            VERIFY_ARE_EQUAL(expected->TextAttr(), actual->TextAttr(), message);
+            VERIFY_IS_TRUE(expected->DbcsAttr() == actual->DbcsAttr(), message);
+        }
+    }
+
+    Log::Comment(L"Writing the same cells again mustn't change the row's revision.");
+    const auto revision = actualBuffer->GetRowByOffset(1).GetRevision();
+    actualBuffer->WriteCharInfoRect(rows[1], rows[1].size(), Viewport::FromDimensions({ 0, 1 }, { bufferSize.X, 1 }));
+    VERIFY_IS_TRUE(revision == actualBuffer->GetRowByOffset(1).GetRevision());
+
+    Log::Comment(L"A rectangle is written row by row with the given stride.");
+    std::vector<CHAR_INFO> block(4 * 3, MakeCharInfo(L'Q', 0x6e));
+    actualBuffer->WriteCharInfoRect(block, 4, Viewport::FromDimensions({ 1, 2 }, { 3, 3 }));
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        for (SHORT x = 0; x < bufferSize.X; ++x)
+        {
+            const auto inside = x >= 1 && x <= 3 && y >= 2 && y <= 4;
+            const auto cell = actualBuffer->GetCellDataAt({ x, y });
+            VERIFY_ARE_EQUAL(inside, cell->Chars() == L"Q", NoThrowString().Format(L"column %d, row %d", x, y));
+        }
+    }
+}
+
+void TextBufferTests::ReadCharInfoRectMatchesCellIterator()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, TextAttribute{ 0x07 }, cursorSize, _renderTarget);
+
+    _buffer->Write(OutputCellIterator{ L"ab\x3042\xD83C\xDF46", TextAttribute{ 0x1f } }, { 0, 0 });
+    _buffer->Write(OutputCellIterator{ L"cd", TextAttribute{ RGB(0x12, 0x34, 0x56), RGB(0x00, 0x00, 0x80) } }, { 3, 1 });
+    _buffer->Write(OutputCellIterator{ L"efgh", TextAttribute{ 0x2e } }, { 6, 2 });
+
+    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const auto rect = Viewport::FromDimensions({ 1, 0 }, { 8, 3 });
+    constexpr size_t stride = 9;
+
+    std::vector<CHAR_INFO> expected(stride * 3, MakeCharInfo(L'?', 0));
+    for (SHORT y = 0; y < rect.Height(); ++y)
+    {
+        for (SHORT x = 0; x < rect.Width(); ++x)
+        {
+            expected[y * stride + x] = gci.AsCharInfo(*_buffer->GetCellDataAt({ rect.Left() + x, rect.Top() + y }));
+        }
+    }
+
+    std::vector<CHAR_INFO> actual(stride * 3, MakeCharInfo(L'?', 0));
+    _buffer->ReadCharInfoRect(actual, stride, rect);
+
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        const auto message = NoThrowString().Format(L"cell %zu", i);
+        VERIFY_ARE_EQUAL(expected[i].Char.UnicodeChar, actual[i].Char.UnicodeChar, message);
+        VERIFY_ARE_EQUAL(expected[i].Attributes, actual[i].Attributes, message);
+    }
+}
+
 // This tests that rows removed from the buffer while resizing traditionally will also drop the high unicode
-// characters from the Unicode Storage buffer
+// characters stored in them
 void TextBufferTests::ResizeTraditionalHighUnicodeRowRemoval()
 {
     // Set up a text buffer for us
@@ -1928,18 +2125,23 @@ void TextBufferTests::ResizeTraditionalHighUnicodeRowRemoval()
     const auto readBackText = *readBack;
     VERIFY_ARE_EQUAL(String(emoji), String(readBackText.data(), gsl::narrow<int>(readBackText.size())));
 
-    VERIFY_ARE_EQUAL(1u, _buffer->GetUnicodeStorage()._map.size(), L"There should be one item in the map.");
+    VERIFY_ARE_EQUAL(String(emoji), String(_buffer->GetRowByOffset(pos.Y).GetText().substr(pos.X, 2).c_str()), L"The row's text should contain the emoji.");
 
     // Perform resize to trim off the row of the buffer that included the emoji
     COORD trimmedBufferSize{ bufferSize.X, bufferSize.Y - 1 };
 
     VERIFY_NT_SUCCESS(_buffer->ResizeTraditional(trimmedBufferSize));
 
-    VERIFY_IS_TRUE(_buffer->GetUnicodeStorage()._map.empty(), L"The map should now be empty.");
+    for (UINT i = 0; i < _buffer->TotalRowCount(); ++i)
+    {
+        const auto text = _buffer->GetRowByOffset(i).GetText();
+        VERIFY_ARE_EQUAL(gsl::narrow_cast<size_t>(trimmedBufferSize.X), text.size(), L"The row should only contain single code unit glyphs now.");
+        VERIFY_ARE_EQUAL(std::wstring::npos, text.find(emoji), L"The emoji should now be gone.");
+    }
 }
 
 // This tests that columns removed from the buffer while resizing traditionally will also drop the high unicode
-// characters from the Unicode Storage buffer
+// characters stored in them
 void TextBufferTests::ResizeTraditionalHighUnicodeColumnRemoval()
 {
     // Set up a text buffer for us
@@ -1963,14 +2165,19 @@ void TextBufferTests::ResizeTraditionalHighUnicodeColumnRemoval()
     const auto readBackText = *readBack;
     VERIFY_ARE_EQUAL(String(emoji), String(readBackText.data(), gsl::narrow<int>(readBackText.size())));
 
-    VERIFY_ARE_EQUAL(1u, _buffer->GetUnicodeStorage()._map.size(), L"There should be one item in the map.");
+    VERIFY_ARE_EQUAL(String(emoji), String(_buffer->GetRowByOffset(pos.Y).GetText().substr(pos.X, 2).c_str()), L"The row's text should contain the emoji.");
 
     // Perform resize to trim off the column of the buffer that included the emoji
     COORD trimmedBufferSize{ bufferSize.X - 1, bufferSize.Y };
 
     VERIFY_NT_SUCCESS(_buffer->ResizeTraditional(trimmedBufferSize));
 
-    VERIFY_IS_TRUE(_buffer->GetUnicodeStorage()._map.empty(), L"The map should now be empty.");
+    for (UINT i = 0; i < _buffer->TotalRowCount(); ++i)
+    {
+        const auto text = _buffer->GetRowByOffset(i).GetText();
+        VERIFY_ARE_EQUAL(gsl::narrow_cast<size_t>(trimmedBufferSize.X), text.size(), L"The row should only contain single code unit glyphs now.");
+        VERIFY_ARE_EQUAL(std::wstring::npos, text.find(emoji), L"The emoji should now be gone.");
+    }
 }
 
 void TextBufferTests::TestBurrito()
@@ -2573,6 +2780,143 @@ void TextBufferTests::GetText()
     }
 }
 
+void TextBufferTests::ExportTextMatchesGetText()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"Data:blockSelection", L"{false, true}")
+        TEST_METHOD_PROPERTY(L"Data:includeCRLF", L"{false, true}")
+        TEST_METHOD_PROPERTY(L"Data:trimTrailingWhitespace", L"{false, true}")
+    END_TEST_METHOD_PROPERTIES();
+
+    bool blockSelection;
+    bool includeCRLF;
+    bool trimTrailingWhitespace;
+    VERIFY_SUCCEEDED(TestData::TryGetValue(L"blockSelection", blockSelection), L"Get 'blockSelection' variant");
+    VERIFY_SUCCEEDED(TestData::TryGetValue(L"includeCRLF", includeCRLF), L"Get 'includeCRLF' variant");
+    VERIFY_SUCCEEDED(TestData::TryGetValue(L"trimTrailingWhitespace", trimTrailingWhitespace), L"Get 'trimTrailingWhitespace' variant");
+
+    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const auto GetAttributeColors = std::bind(&CONSOLE_INFORMATION::LookupAttributeColors, &gci, std::placeholders::_1);
+
+    COORD bufferSize{ 10, 20 };
+    UINT cursorSize = 12;
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, TextAttribute{ 0x7f }, cursorSize, _renderTarget);
+
+    // Setup: Write runs of differently colored text to the buffer, including
+    // wide glyphs, characters that need escaping and a wrapped row.
+    const TextAttribute red{ RGB(0xff, 0x00, 0x00), RGB(0x00, 0x00, 0x00) };
+    const TextAttribute green{ RGB(0x00, 0xff, 0x00), RGB(0x10, 0x20, 0x30) };
+    const TextAttribute legacy{ 0x1e };
+    _buffer->Write(OutputCellIterator{ L"<a&b>", red }, { 0, 0 });
+    _buffer->Write(OutputCellIterator{ L"{\\}", green }, { 5, 0 });
+    _buffer->Write(OutputCellIterator{ L"\x304b\x304d", legacy }, { 1, 1 });
+    _buffer->Write(OutputCellIterator{ L"  x ", red }, { 5, 1 });
+    _buffer->Write(OutputCellIterator{ L"0123456789abc", green }, { 0, 2 });
+    _buffer->Write(OutputCellIterator{ L"\xD83D\xDE00", legacy }, { 3, 4 });
+
+    const auto textRects = _buffer->GetTextRects({ 2, 0 }, { 6, 5 }, blockSelection, false);
+    const auto formatWrappedRows = blockSelection;
+
+    const auto textData = _buffer->GetText(includeCRLF, trimTrailingWhitespace, textRects, GetAttributeColors, formatWrappedRows);
+    std::wstring expectedText;
+    for (const auto& text : textData.text)
+    {
+        expectedText += text;
+    }
+    const auto expectedHtml = TextBuffer::GenHTML(textData, 12, L"Consolas", RGB(0x0c, 0x0c, 0x0c));
+    const auto expectedRtf = TextBuffer::GenRTF(textData, 12, L"Consolas", RGB(0x0c, 0x0c, 0x0c));
+
+    PlainTextExportSink textSink;
+    HtmlExportSink htmlSink{ 12, L"Consolas", RGB(0x0c, 0x0c, 0x0c) };
+    RtfExportSink rtfSink{ 12, L"Consolas", RGB(0x0c, 0x0c, 0x0c) };
+    const std::array<ITextExportSink*, 3> sinks{ &textSink, &htmlSink, &rtfSink };
+    _buffer->ExportText(includeCRLF, trimTrailingWhitespace, textRects, GetAttributeColors, formatWrappedRows, sinks);
+
+    const auto html = htmlSink.Finish();
+    const auto rtf = rtfSink.Finish();
+    VERIFY_ARE_EQUAL(expectedText, textSink.Text());
+    VERIFY_ARE_EQUAL(std::string_view{ expectedHtml }, std::string_view{ html });
+    VERIFY_ARE_EQUAL(std::string_view{ expectedRtf }, std::string_view{ rtf });
+}
+
+void TextBufferTests::ExportTextBenchmark()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES();
+
+    Log::Comment(L"Copies an entire buffer of colored text as plain text, HTML and RTF");
+
+    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const auto GetAttributeColors = std::bind(&CONSOLE_INFORMATION::LookupAttributeColors, &gci, std::placeholders::_1);
+
+    // A TextBuffer can't hold more than SHRT_MAX rows.
+    COORD bufferSize{ 120, 32000 };
+    UINT cursorSize = 12;
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, TextAttribute{ 0x07 }, cursorSize, _renderTarget);
+
+    // Every row consists of 8 runs of 15 characters, each in a different color.
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        for (SHORT x = 0; x < bufferSize.X; x += 15)
+        {
+            const auto color = gsl::narrow_cast<BYTE>(y + x);
+            const TextAttribute attr{ RGB(color, 0x80, 0xff - color), RGB(0x00, color, 0x00) };
+            _buffer->Write(OutputCellIterator{ L"Lorem <ipsum>. ", attr }, { x, y });
+        }
+    }
+
+    const COORD end{ gsl::narrow_cast<SHORT>(bufferSize.X - 1), gsl::narrow_cast<SHORT>(bufferSize.Y - 1) };
+    const auto textRects = _buffer->GetTextRects({ 0, 0 }, end, false, false);
+
+    // The peak memory usage is approximated by the capacity of all containers alive at the same time.
+    auto now = std::chrono::steady_clock::now();
+    size_t materializedBytes = 0;
+    size_t materializedSize = 0;
+    {
+        const auto textData = _buffer->GetText(true, true, textRects, GetAttributeColors);
+        std::wstring text;
+        for (const auto& row : textData.text)
+        {
+            text += row;
+        }
+        const auto html = TextBuffer::GenHTML(textData, 12, L"Consolas", RGB(0x0c, 0x0c, 0x0c));
+        const auto rtf = TextBuffer::GenRTF(textData, 12, L"Consolas", RGB(0x0c, 0x0c, 0x0c));
+
+        for (size_t i = 0; i < textData.text.size(); ++i)
+        {
+            materializedBytes += sizeof(std::wstring) + textData.text[i].capacity() * sizeof(wchar_t);
+            materializedBytes += 2 * sizeof(std::vector<COLORREF>) + (textData.FgAttr[i].capacity() + textData.BkAttr[i].capacity()) * sizeof(COLORREF);
+        }
+        materializedBytes += text.capacity() * sizeof(wchar_t) + html.capacity() + rtf.capacity();
+        materializedSize = text.size() + html.size() + rtf.size();
+    }
+    const auto materializedDelta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+    now = std::chrono::steady_clock::now();
+    size_t streamedBytes = 0;
+    size_t streamedSize = 0;
+    {
+        PlainTextExportSink textSink;
+        HtmlExportSink htmlSink{ 12, L"Consolas", RGB(0x0c, 0x0c, 0x0c) };
+        RtfExportSink rtfSink{ 12, L"Consolas", RGB(0x0c, 0x0c, 0x0c) };
+        const std::array<ITextExportSink*, 3> sinks{ &textSink, &htmlSink, &rtfSink };
+        _buffer->ExportText(true, true, textRects, GetAttributeColors, false, sinks);
+
+        const auto& text = textSink.Text();
+        const auto html = htmlSink.Finish();
+        const auto rtf = rtfSink.Finish();
+
+        streamedBytes = text.capacity() * sizeof(wchar_t) + html.capacity() + rtf.capacity();
+        streamedSize = text.size() + html.size() + rtf.size();
+    }
+    const auto streamedDelta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+    VERIFY_ARE_EQUAL(materializedSize, streamedSize);
+    Log::Comment(String().Format(L"GetText+GenHTML+GenRTF: %.2f ms, ~%zu KiB peak", materializedDelta * 1000.0, materializedBytes / 1024));
+    Log::Comment(String().Format(L"ExportText:             %.2f ms, ~%zu KiB peak", streamedDelta * 1000.0, streamedBytes / 1024));
+}
+
 // This tests that when we increment the circular buffer, obsolete hyperlink references
 // are removed from the hyperlink map
 void TextBufferTests::HyperlinkTrim()
@@ -2653,3 +2997,63 @@ void TextBufferTests::NoHyperlinkTrim()
     VERIFY_ARE_EQUAL(_buffer->GetHyperlinkUriFromId(id), url);
     VERIFY_ARE_EQUAL(_buffer->_hyperlinkCustomIdMap[finalCustomId], id);
 }
+
+// This tests that pattern matches span wrapped rows and that GetPatterns()
+// reuses the matches of lines that didn't change since the previous call.
+void TextBufferTests::GetPatternsOnlyRescansChangedLines()
+{
+    // Set up a text buffer for us
+    const COORD bufferSize{ 10, 5 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    const auto id = _buffer->AddPatternRecognizer(L"ab+");
+
+    // Row 1 wraps into row 2, so the match continues on row 2.
+    _buffer->WriteLine(OutputCellIterator{ L"xxab" }, { 0, 0 });
+    _buffer->WriteLine(OutputCellIterator{ L"abbbbbbbbb" }, { 0, 1 });
+    _buffer->WriteLine(OutputCellIterator{ L"bbx" }, { 0, 2 });
+    _buffer->GetRowByOffset(1).SetWrapForced(true);
+
+    const auto getMatches = [&]() {
+        std::vector<std::pair<til::point, til::point>> matches;
+        _buffer->GetPatterns(0, bufferSize.Y - 1).visit_all([&](const auto& interval) {
+            VERIFY_ARE_EQUAL(id, interval.value);
+            matches.emplace_back(interval.start, interval.stop);
+        });
+        std::sort(matches.begin(), matches.end(), [](const auto& lhs, const auto& rhs) { return lhs.first.y() < rhs.first.y(); });
+        return matches;
+    };
+
+    Log::Comment(L"Find the matches in all lines.");
+    auto matches = getMatches();
+    VERIFY_ARE_EQUAL(2u, matches.size());
+    VERIFY_ARE_EQUAL(til::point(2, 0), matches[0].first);
+    VERIFY_ARE_EQUAL(til::point(4, 0), matches[0].second);
+    VERIFY_ARE_EQUAL(til::point(0, 1), matches[1].first);
+    VERIFY_ARE_EQUAL(til::point(2, 2), matches[1].second);
+
+    // Rows 0, 1-2, 3 and 4.
+    VERIFY_ARE_EQUAL(4u, _buffer->_patternCache.size());
+    const auto wrappedRevision = _buffer->GetRowByOffset(1).GetCharRow().GetRevision();
+    const auto wrappedMatches = _buffer->_patternCache.at(wrappedRevision).matches.data();
+
+    Log::Comment(L"Only the modified line must be searched again.");
+    _buffer->WriteLine(OutputCellIterator{ L"ab" }, { 0, 3 });
+    matches = getMatches();
+    VERIFY_ARE_EQUAL(3u, matches.size());
+    VERIFY_ARE_EQUAL(til::point(0, 3), matches[2].first);
+    VERIFY_ARE_EQUAL(til::point(2, 3), matches[2].second);
+    VERIFY_ARE_EQUAL(wrappedMatches, _buffer->_patternCache.at(wrappedRevision).matches.data());
+
+    Log::Comment(L"Scrolling moves the matches without searching the lines again.");
+    _buffer->IncrementCircularBuffer();
+    matches = getMatches();
+    VERIFY_ARE_EQUAL(2u, matches.size());
+    VERIFY_ARE_EQUAL(til::point(0, 0), matches[0].first);
+    VERIFY_ARE_EQUAL(til::point(2, 1), matches[0].second);
+    VERIFY_ARE_EQUAL(til::point(0, 2), matches[1].first);
+    VERIFY_ARE_EQUAL(til::point(2, 2), matches[1].second);
+    VERIFY_ARE_EQUAL(wrappedMatches, _buffer->_patternCache.at(wrappedRevision).matches.data());
+}
@@ -76,6 +76,8 @@ class Microsoft::Console::Render::VtRendererTest
     TEST_METHOD(XtermTestAttributesAcrossReset);
 
     TEST_METHOD(FormattedString);
+    TEST_METHOD(CoalescedRenditions);
+    TEST_METHOD(RenditionCoalescingBenchmark);
 
     TEST_METHOD(TestWrapping);
 
@@ -1611,3 +1613,132 @@ void VtRendererTest::FormattedString()
     qExpectedInput.push_back("\x1b[28;3;500;500;500m");
     VERIFY_SUCCEEDED(engine->_WriteFormatted(bigFormat, bigValue, bigValue, bigValue));
 }
+
+void VtRendererTest::CoalescedRenditions()
+{
+    // Without a test callback, everything ends up in the engine's _buffer,
+    // which is where consecutive SGR sequences are merged.
+    wil::unique_hfile hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    auto engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
+    RenderData renderData;
+
+    Log::Comment(L"Changing the colors and the boldness at once should emit a single sequence.");
+    TextAttribute attributes{ 0x00030201, 0x00070605 };
+    attributes.SetBold(true);
+    VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(attributes, &renderData, false, false));
+    std::string expected = "\x1b[38;2;1;2;3;48;2;5;6;7;1m";
+    VERIFY_ARE_EQUAL(expected, engine->_buffer);
+
+    Log::Comment(L"A reset should discard the parameters immediately preceding it.");
+    VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes({}, &renderData, false, false));
+    expected = "\x1b[m";
+    VERIFY_ARE_EQUAL(expected, engine->_buffer);
+
+    Log::Comment(L"Parameters following a reset should be merged into it.");
+    VERIFY_SUCCEEDED(engine->_SetBold(true));
+    expected = "\x1b[0;1m";
+    VERIFY_ARE_EQUAL(expected, engine->_buffer);
+
+    Log::Comment(L"Anything else in between should prevent sequences from being merged.");
+    VERIFY_SUCCEEDED(engine->_Write("A"));
+    VERIFY_SUCCEEDED(engine->_SetItalic(true));
+    VERIFY_SUCCEEDED(engine->_CursorForward(2));
+    VERIFY_SUCCEEDED(engine->_SetItalic(false));
+    VERIFY_SUCCEEDED(engine->_EndHyperlink());
+    VERIFY_SUCCEEDED(engine->_SetUnderlined(true));
+    expected += "A\x1b[3m\x1b[2C\x1b[23m\x1b]8;;\x1b\\\x1b[4m";
+    VERIFY_ARE_EQUAL(expected, engine->_buffer);
+
+    Log::Comment(L"The ASCII-only engine for telnet should never merge sequences.");
+    hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    auto asciiEngine = std::make_unique<XtermEngine>(std::move(hFile), SetUpViewport(), true);
+    VERIFY_SUCCEEDED(asciiEngine->_SetBold(true));
+    VERIFY_SUCCEEDED(asciiEngine->_SetGraphicsRendition16Color(FOREGROUND_RED, true));
+    expected = "\x1b[1m\x1b[31m";
+    VERIFY_ARE_EQUAL(expected, asciiEngine->_buffer);
+}
+
+void VtRendererTest::RenditionCoalescingBenchmark()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    const auto view = SetUpViewport();
+    const auto width = gsl::narrow_cast<size_t>(view.Width());
+    const auto height = view.Height();
+    RenderData renderData;
+
+    TextAttribute plain;
+    TextAttribute keyword{ RGB(86, 156, 214), RGB(30, 30, 30) };
+    keyword.SetBold(true);
+    TextAttribute comment{ RGB(106, 153, 85), RGB(30, 30, 30) };
+    comment.SetItalic(true);
+    TextAttribute directory;
+    directory.SetIndexedForeground(FOREGROUND_BLUE | FOREGROUND_INTENSITY);
+    directory.SetBold(true);
+
+    // Each workload is a list of runs, which is repeated until the row is full.
+    const std::pair<std::wstring_view, std::vector<std::pair<std::wstring_view, TextAttribute>>> workloads[]{
+        { L"plain text", { { L"the quick brown fox jumps over the lazy dog ", plain } } },
+        { L"ls --color", { { L"src", directory }, { L"  README.md  ", plain }, { L"build", directory }, { L"  ", plain } } },
+        { L"syntax highlighting", { { L"const", keyword }, { L" auto x = 42; ", plain }, { L"// the answer", comment }, { L" ", plain } } },
+    };
+
+    std::vector<Cluster> clusters;
+    clusters.reserve(width);
+
+    for (const auto& [name, runs] : workloads)
+    {
+        for (const auto coalesce : { false, true })
+        {
+            wil::unique_hfile hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+            auto engine = std::make_unique<Xterm256Engine>(std::move(hFile), view);
+            engine->_coalesceRenditions = coalesce;
+
+            constexpr size_t frames = 200;
+            size_t bytes = 0;
+
+            const auto now = std::chrono::steady_clock::now();
+            for (size_t frame = 0; frame < frames; ++frame)
+            {
+                VERIFY_SUCCEEDED(engine->InvalidateAll());
+                VERIFY_SUCCEEDED(engine->StartPaint());
+
+                for (SHORT row = 0; row < height; ++row)
+                {
+                    size_t column = 0;
+                    for (size_t i = 0; column < width; ++i)
+                    {
+                        const auto& [text, attributes] = runs[i % runs.size()];
+                        const auto length = std::min(text.size(), width - column);
+
+                        clusters.clear();
+                        for (size_t j = 0; j < length; ++j)
+                        {
+                            clusters.emplace_back(text.substr(j, 1), 1);
+                        }
+
+                        VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(attributes, &renderData, false, false));
+                        VERIFY_SUCCEEDED(engine->PaintBufferLine({ clusters.data(), clusters.size() }, { gsl::narrow_cast<SHORT>(column), row }, false, false));
+                        column += length;
+                    }
+                }
+
+                VERIFY_SUCCEEDED(engine->EndPaint());
+
+                // The unit test engine never flushes its buffer.
+                bytes += engine->_buffer.size();
+                engine->_buffer.clear();
+                engine->_renditionEnd = std::string::npos;
+            }
+            const auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+            Log::Comment(String().Format(L"%s (%s): %zu bytes and %.1f us per frame",
+                                         name.data(),
+                                         coalesce ? L"coalesced" : L"separate",
+                                         bytes / frames,
+                                         delta * 1e6 / frames));
+        }
+    }
+}
@@ -261,7 +261,11 @@ private:
         attrs[6].SetTrailing();
 
         CharRow& charRow = pRow->GetCharRow();
-        OverwriteColumns(pwszText, pwszText + length, attrs.cbegin(), charRow.begin());
+        for (size_t i = 0; i < length; ++i)
+        {
+            charRow.GlyphAt(i) = { &pwszText[i], 1 };
+            charRow.DbcsAttrAt(i) = attrs[i];
+        }
 
         // set some colors
         TextAttribute Attr = TextAttribute(0);
@@ -326,7 +330,11 @@ private:
         attrs[79].SetLeading();
 
         CharRow& charRow = pRow->GetCharRow();
-        OverwriteColumns(pwszText, pwszText + length, attrs.cbegin(), charRow.begin());
+        for (size_t i = 0; i < length; ++i)
+        {
+            charRow.GlyphAt(i) = { &pwszText[i], 1 };
+            charRow.DbcsAttrAt(i) = attrs[i];
+        }
 
         // everything gets default attributes
         pRow->GetAttrRow().Reset(gci.GetActiveOutputBuffer().GetAttributes());
@@ -305,6 +305,14 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
         using rle_type = rle_pair<value_type, size_type>;
         using container = Container;
 
+        // The replacement of the range [start_index, end_index) with value, for apply().
+        struct edit
+        {
+            size_type start_index;
+            size_type end_index;
+            value_type value;
+        };
+
         // We don't check anywhere whether a size_type value is negative.
         // Having signed integers would break that.
         static_assert(std::is_unsigned<size_type>::value, "the run length S must be unsigned");
@@ -477,6 +485,87 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             _replace_unchecked(start_index, end_index, replacements);
         }
 
+        // Applies several replacements at once. It has the same result as calling
+        // replace(start_index, end_index, value) for each of the edits in turn,
+        // but builds the new runs in a single pass instead of moving the runs
+        // after each edit around, which makes a difference for many short edits.
+        // The edits must be sorted by start_index and must not overlap.
+        // If an end_index is larger than size() it's set to size().
+        // Returns whether any value changed.
+        bool apply(const gsl::span<const edit> edits)
+        {
+            size_type previous_end = 0;
+            for (const auto& e : edits)
+            {
+                const auto end_index = std::min(e.end_index, _total_length);
+                if (e.start_index < previous_end || e.start_index > end_index)
+                {
+                    throw std::out_of_range("edits must be sorted and must not overlap");
+                }
+                previous_end = end_index;
+            }
+
+            container runs;
+            runs.reserve(_runs.size() + 2 * edits.size());
+
+            // Adjacent runs with the same value are joined right away,
+            // so that the result doesn't need to be compacted afterwards.
+            const auto append = [&](const value_type& value, const size_type length) {
+                if (!length)
+                {
+                    return;
+                }
+                if (!runs.empty() && runs.back().value == value)
+                {
+                    runs.back().length += length;
+                }
+                else
+                {
+                    runs.emplace_back(value, length);
+                }
+            };
+
+            auto it = _runs.begin();
+            size_type position = 0;
+            size_type run_position = 0;
+
+            // Copies the existing values up to until, or just skips them.
+            const auto advance = [&](const size_type until, const bool copy) {
+                while (position < until)
+                {
+                    const auto length = std::min(static_cast<size_type>(it->length - run_position), static_cast<size_type>(until - position));
+                    if (copy)
+                    {
+                        append(it->value, length);
+                    }
+                    position += length;
+                    run_position += length;
+                    if (run_position == it->length)
+                    {
+                        ++it;
+                        run_position = 0;
+                    }
+                }
+            };
+
+            for (const auto& e : edits)
+            {
+                const auto end_index = std::min(e.end_index, _total_length);
+                advance(e.start_index, true);
+                append(e.value, static_cast<size_type>(end_index - e.start_index));
+                advance(end_index, false);
+            }
+            advance(_total_length, true);
+
+            if (runs == _runs)
+            {
+                return false;
+            }
+
+            _runs = std::move(runs);
+            return true;
+        }
+
         // Replaces every instance of old_value in this vector with new_value.
         void replace_values(const value_type& old_value, const value_type& new_value)
         {
@@ -689,6 +778,50 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             }
         }
 
+        // Appends a run, joining it with the last one if their values are the same.
+        void _append(const value_type& value, const size_type length)
+        {
+            if (!length)
+            {
+                return;
+            }
+
+            if (!_runs.empty() && _runs.back().value == value)
+            {
+                _runs.back().length += length;
+            }
+            else
+            {
+                _runs.emplace_back(value, length);
+            }
+
+            _total_length += length;
+        }
+
+        // Replace the range [start_index, _total_length) with replacements.
+        // Filling everything up to the end is common enough (think of rows being
+        // written up to their last column) to warrant a shortcut: It only needs to
+        // cut off the tail and append the replacements, without moving any runs.
+        void _replace_tail_unchecked(size_type start_index, const gsl::span<const rle_type> replacements)
+        {
+            rle_scanner scanner{ _runs.begin(), _runs.end() };
+            auto [it, pos] = scanner.scan(start_index);
+
+            if (pos)
+            {
+                it->length = pos;
+                ++it;
+            }
+
+            _runs.erase(it, _runs.end());
+            _total_length = start_index;
+
+            for (const auto& run : replacements)
+            {
+                _append(run.value, run.length);
+            }
+        }
+
         // Replace the range [start_index, end_index) with replacements.
         void _replace_unchecked(size_type start_index, size_type end_index, const gsl::span<const rle_type> replacements)
         {
@@ -852,6 +985,12 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
             // TODO GH#10135: Ensure replacements contains no runs with .length == 0.
 
+            if (end_index == _total_length)
+            {
+                _replace_tail_unchecked(start_index, replacements);
+                return;
+            }
+
             rle_scanner scanner{ _runs.begin(), _runs.end() };
             auto [begin, begin_pos] = scanner.scan(start_index);
             auto [end, end_pos] = scanner.scan(end_index);
@@ -13,7 +13,10 @@ Tests have been made in order to investigate whether or not own algorithms
 could overcome disadvantages of syscalls. Test results can be read up
 in PR #4093 and the test algorithms are available in src\tools\U8U16Test.
 Based on the results the decision was made to keep using the platform
-functions MultiByteToWideChar and WideCharToMultiByte.
+function WideCharToMultiByte for UTF-16 to UTF-8 conversions.
+UTF-8 to UTF-16 conversions are on the hot path of every VT output and are
+performed by a portable decoder with a vectorized ASCII fast path instead.
+It produces the same replacement characters as MultiByteToWideChar.
 
 Author(s):
 - Steffen Illhardt (german-one), Leonard Hecker (lhecker) 2020-2021
@@ -21,6 +24,12 @@ Author(s):
 
 #pragma once
 
+#include <cstring>
+
+#if defined(__AVX2__) || defined(_M_AMD64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace til // Terminal Implementation Library. Also: "Today I Learned"
 {
     // state structure for maintenance of UTF-8 partials
@@ -47,6 +56,190 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
         }
     };
 
+    namespace details
+    {
+        inline constexpr wchar_t u8u16_replacement = 0xFFFD;
+
+#if defined(__AVX2__) || defined(_M_AMD64) || defined(_M_IX86) || defined(__SSE2__)
+        inline unsigned long u8u16_trailing_zeros(const unsigned long mask) noexcept
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return index;
+#else
+            return static_cast<unsigned long>(__builtin_ctzl(mask));
+#endif
+        }
+#endif
+
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+        // Routine Description:
+        // - Converts the longest run of ASCII characters at the start of [it, end) to UTF-16.
+        // Arguments:
+        // - it - pointer to the first UTF-8 code unit. Advanced past the ASCII run on return.
+        // - end - pointer past the last UTF-8 code unit
+        // - out - pointer to the first UTF-16 code unit. Advanced past the ASCII run on return.
+        //   The vectorized loops write up to a whole block beyond the ASCII run, which is
+        //   why out must have as much room left as [it, end) is long.
+        inline void u8u16_ascii(const uint8_t*& it, const uint8_t* const end, wchar_t*& out) noexcept
+        {
+#if defined(__AVX2__)
+            for (; end - it >= 32; it += 32, out += 32)
+            {
+                const auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+                const auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 16));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu8_epi16(lo));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_cvtepu8_epi16(hi));
+
+                // The MSB of every non-ASCII byte is set.
+                const auto mask = static_cast<unsigned long>(_mm256_movemask_epi8(_mm256_set_m128i(hi, lo)));
+                if (mask)
+                {
+                    const auto ascii = u8u16_trailing_zeros(mask);
+                    it += ascii;
+                    out += ascii;
+                    return;
+                }
+            }
+#elif defined(_M_AMD64) || defined(_M_IX86) || defined(__SSE2__)
+            const auto zero = _mm_setzero_si128();
+            for (; end - it >= 16; it += 16, out += 16)
+            {
+                const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(bytes, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(bytes, zero));
+
+                // The MSB of every non-ASCII byte is set.
+                const auto mask = static_cast<unsigned long>(_mm_movemask_epi8(bytes));
+                if (mask)
+                {
+                    const auto ascii = u8u16_trailing_zeros(mask);
+                    it += ascii;
+                    out += ascii;
+                    return;
+                }
+            }
+#else
+            // Check 8 bytes at a time on other platforms.
+            for (; end - it >= 8; it += 8, out += 8)
+            {
+                uint64_t bytes;
+                memcpy(&bytes, it, sizeof(bytes));
+                if (bytes & 0x8080808080808080)
+                {
+                    break;
+                }
+                for (size_t i = 0; i < 8; ++i)
+                {
+                    out[i] = it[i];
+                }
+            }
+#endif
+
+            for (; it != end && *it < 0x80; ++it, ++out)
+            {
+                *out = *it;
+            }
+        }
+
+        // Routine Description:
+        // - Converts UTF-8 to UTF-16. Every maximal subpart of an ill-formed sequence
+        //   is replaced with a single U+FFFD ("U+FFFD Substitution of Maximal Subparts"
+        //   in chapter 3.9 of the Unicode Standard), just like MultiByteToWideChar does.
+        // Arguments:
+        // - in - UTF-8 string to be converted
+        // - out - pointer to the resulting UTF-16 string. Must have room for at least
+        //   in.size() code units, since no UTF-8 sequence results in more UTF-16 code units.
+        // Return Value:
+        // - the number of UTF-16 code units written to out
+        inline size_t u8u16(const std::string_view& in, wchar_t* const out) noexcept
+        {
+            auto it = reinterpret_cast<const uint8_t*>(in.data());
+            const auto end = it + in.size();
+            auto cursor16 = out;
+
+            while (it != end)
+            {
+                u8u16_ascii(it, end, cursor16);
+
+                while (it != end && *it >= 0x80)
+                {
+                    // The lead byte determines the length of the sequence and the valid range
+                    // of the first continuation byte. The ranges exclude overlong encodings,
+                    // surrogates (U+D800..U+DFFF) and anything beyond U+10FFFF.
+                    const auto lead = *it;
+                    uint8_t lo = 0x80;
+                    uint8_t hi = 0xBF;
+                    size_t length;
+                    uint32_t codepoint;
+
+                    if (lead >= 0xC2 && lead <= 0xDF)
+                    {
+                        length = 2;
+                        codepoint = lead & 0x1F;
+                    }
+                    else if (lead >= 0xE0 && lead <= 0xEF)
+                    {
+                        length = 3;
+                        codepoint = lead & 0x0F;
+                        lo = lead == 0xE0 ? 0xA0 : lo;
+                        hi = lead == 0xED ? 0x9F : hi;
+                    }
+                    else if (lead >= 0xF0 && lead <= 0xF4)
+                    {
+                        length = 4;
+                        codepoint = lead & 0x07;
+                        lo = lead == 0xF0 ? 0x90 : lo;
+                        hi = lead == 0xF4 ? 0x8F : hi;
+                    }
+                    else
+                    {
+                        // stray continuation byte or a lead byte that can't start a valid sequence
+                        *cursor16++ = u8u16_replacement;
+                        ++it;
+                        continue;
+                    }
+
+                    size_t have = 1;
+                    for (; have < length && it + have != end; ++have)
+                    {
+                        const auto trail = it[have];
+                        if (trail < lo || trail > hi)
+                        {
+                            break;
+                        }
+                        codepoint = (codepoint << 6) | (trail & 0x3F);
+                        lo = 0x80;
+                        hi = 0xBF;
+                    }
+
+                    it += have;
+
+                    if (have != length)
+                    {
+                        *cursor16++ = u8u16_replacement;
+                    }
+                    else if (codepoint < 0x10000)
+                    {
+                        *cursor16++ = gsl::narrow_cast<wchar_t>(codepoint);
+                    }
+                    else
+                    {
+                        codepoint -= 0x10000;
+                        *cursor16++ = gsl::narrow_cast<wchar_t>(0xD800 | (codepoint >> 10));
+                        *cursor16++ = gsl::narrow_cast<wchar_t>(0xDC00 | (codepoint & 0x3FF));
+                    }
+                }
+            }
+
+            return gsl::narrow_cast<size_t>(cursor16 - out);
+        }
+#pragma warning(pop)
+    }
+
     // Routine Description:
     // - Takes a UTF-8 string and performs the conversion to UTF-16. NOTE: The function relies on getting complete UTF-8 characters at the string boundaries.
     // Arguments:
@@ -55,8 +248,6 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
     // Return Value:
     // - S_OK          - the conversion succeeded
     // - E_OUTOFMEMORY - the function failed to allocate memory for the resulting string
-    // - E_ABORT       - the resulting string length would exceed the upper boundary of an int and thus, the conversion was aborted before the conversion has been completed
-    // - E_UNEXPECTED  - the underlying conversion function failed
     // - HRESULT value converted from a caught exception
     template<class outT>
     [[nodiscard]] HRESULT u8u16(const std::string_view& in, outT& out) noexcept
@@ -66,14 +257,10 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             out.clear();
             RETURN_HR_IF(S_OK, in.empty());
 
-            int lengthRequired{};
             // The worst ratio of UTF-8 code units to UTF-16 code units is 1 to 1 if UTF-8 consists of ASCII only.
-            RETURN_HR_IF(E_ABORT, !base::MakeCheckedNum(in.length()).AssignIfValid(&lengthRequired));
-            out.resize(in.length()); // avoid to call MultiByteToWideChar twice only to get the required size
-            const int lengthOut = MultiByteToWideChar(CP_UTF8, 0ul, in.data(), lengthRequired, out.data(), lengthRequired);
-            out.resize(gsl::narrow_cast<size_t>(lengthOut));
-
-            return lengthOut == 0 ? E_UNEXPECTED : S_OK;
+            out.resize(in.length());
+            out.resize(details::u8u16(in, out.data()));
+            return S_OK;
         }
         CATCH_RETURN();
     }
@@ -89,8 +276,6 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
     // Return Value:
     // - S_OK          - the conversion succeeded
     // - E_OUTOFMEMORY - the function failed to allocate memory for the resulting string
-    // - E_ABORT       - the resulting string length would exceed the upper boundary of an int and thus, the conversion was aborted before the conversion has been completed
-    // - E_UNEXPECTED  - the underlying conversion function failed
     // - HRESULT value converted from a caught exception
     template<class outT>
     [[nodiscard]] HRESULT u8u16(const std::string_view& in, outT& out, u8state& state) noexcept
@@ -100,17 +285,14 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             out.clear();
             RETURN_HR_IF(S_OK, in.empty());
 
-            int capa16{};
             // The worst ratio of UTF-8 code units to UTF-16 code units is 1 to 1 if UTF-8 consists of ASCII only.
-            RETURN_HR_IF(E_ABORT, !base::CheckAdd(in.length(), state.have).AssignIfValid(&capa16));
-
-            out.resize(gsl::narrow_cast<size_t>(capa16));
-            auto len8{ gsl::narrow_cast<int>(in.length()) };
-            int len16{};
+            out.resize(in.length() + state.have);
+            auto len8{ in.length() };
+            size_t len16{};
             auto cursor8{ in.data() };
             if (state.have)
             {
-                const auto copyable{ std::min<int>(state.want, len8) };
+                const auto copyable{ std::min<size_t>(state.want, len8) };
                 std::move(cursor8, cursor8 + copyable, &state.partials[state.have]);
                 state.have += gsl::narrow_cast<uint8_t>(copyable);
                 state.want -= gsl::narrow_cast<uint8_t>(copyable);
@@ -120,10 +302,8 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
                     return S_OK;
                 }
 
-                len16 = MultiByteToWideChar(CP_UTF8, 0UL, &state.partials[0], gsl::narrow_cast<int>(state.have), out.data(), capa16);
-                RETURN_HR_IF(E_UNEXPECTED, !len16);
+                len16 = details::u8u16({ &state.partials[0], state.have }, out.data());
 
-                capa16 -= len16;
                 len8 -= copyable;
                 cursor8 += copyable;
                 // state.want is already zero at this point
@@ -133,7 +313,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             if (len8)
             {
                 auto backIter{ cursor8 + len8 - 1 };
-                int sequenceLen{ 1 };
+                size_t sequenceLen{ 1 };
 
                 // skip UTF8 continuation bytes
                 while (backIter != cursor8 && (*backIter & 0b11'000000) == 0b10'000000)
@@ -158,13 +338,10 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
             if (len8)
             {
-                const auto convLen{ MultiByteToWideChar(CP_UTF8, 0UL, cursor8, len8, out.data() + len16, capa16) };
-                RETURN_HR_IF(E_UNEXPECTED, !convLen);
-
-                len16 += convLen;
+                len16 += details::u8u16({ cursor8, len8 }, out.data() + len16);
             }
 
-            out.resize(gsl::narrow_cast<size_t>(len16));
+            out.resize(len16);
             return S_OK;
         }
         CATCH_RETURN();
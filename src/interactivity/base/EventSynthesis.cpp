@@ -44,11 +44,17 @@ static CodepointWidth GetQuickCharWidthLegacyForNumpadEventSynthesis(const wchar
     return CodepointWidth::Invalid;
 }
 
-std::deque<std::unique_ptr<KeyEvent>> Microsoft::Console::Interactivity::CharToKeyEvents(const wchar_t wch,
-                                                                                         const unsigned int codepage)
+// Routine Description:
+// - determines how a wchar_t is typed for CharToKeyEvents()
+// Arguments:
+// - wch - the wchar_t to type
+// - keyState - on exit, the VkKeyScanW() result to type it with using the keyboard
+// Return Value:
+// - true if it needs to be typed using Alt + numpad instead
+static bool _NeedsNumpadEvents(const wchar_t wch, short& keyState)
 {
     const short invalidKey = -1;
-    short keyState = VkKeyScanW(wch);
+    keyState = VkKeyScanW(wch);
 
     if (keyState == invalidKey)
     {
@@ -65,15 +71,60 @@ std::deque<std::unique_ptr<KeyEvent>> Microsoft::Console::Interactivity::CharToK
                 // It wasn't alphanumeric or determined to be wide by the old algorithm
                 // if VkKeyScanW fails (char is not in kbd layout), we must
                 // emulate the key being input through the numpad
-                return SynthesizeNumpadEvents(wch, codepage);
+                return true;
             }
         }
         keyState = 0; // SynthesizeKeyboardEvents would rather get 0 than -1
     }
 
+    return false;
+}
+
+std::deque<std::unique_ptr<KeyEvent>> Microsoft::Console::Interactivity::CharToKeyEvents(const wchar_t wch,
+                                                                                         const unsigned int codepage)
+{
+    short keyState = 0;
+    if (_NeedsNumpadEvents(wch, keyState))
+    {
+        return SynthesizeNumpadEvents(wch, codepage);
+    }
+
     return SynthesizeKeyboardEvents(wch, keyState);
 }
 
+// Routine Description:
+// - determines the number of KeyEvents CharToKeyEvents() returns for a
+// wchar_t, without synthesizing them
+// Arguments:
+// - wch - the wchar_t to convert
+// - codepage - the codepage to convert it with, if it's typed using Alt + numpad
+// Return Value:
+// - the number of KeyEvents
+// Note:
+// - will throw exception on error
+size_t Microsoft::Console::Interactivity::CharToKeyEventCount(const wchar_t wch,
+                                                               const unsigned int codepage)
+{
+    short keyState = 0;
+    if (_NeedsNumpadEvents(wch, keyState))
+    {
+        // Alt down and up, plus a key down and up per decimal digit of the char.
+        const auto convertedChars = ConvertToA(codepage, std::wstring{ wch });
+        if (convertedChars.size() != 1)
+        {
+            return 2;
+        }
+        const auto uch = static_cast<unsigned char>(convertedChars.at(0));
+        return 2 + 2 * (uch >= 100 ? 3 : uch >= 10 ? 2 : 1);
+    }
+
+    // The key down and up, plus a modifier key down and up if necessary.
+    const byte modifierState = HIBYTE(keyState);
+    const bool needsModifier = WI_AreAllFlagsSet(modifierState, VkKeyScanModState::CtrlAndAltPressed) ||
+                               WI_IsFlagSet(modifierState, VkKeyScanModState::ShiftPressed);
+    return needsModifier ? 4 : 2;
+}
+
 // Routine Description:
 // - converts a wchar_t into a series of KeyEvents as if it was typed
 // using the keyboard
@@ -21,6 +21,7 @@ Author:
 namespace Microsoft::Console::Interactivity
 {
     std::deque<std::unique_ptr<KeyEvent>> CharToKeyEvents(const wchar_t wch, const unsigned int codepage);
+    size_t CharToKeyEventCount(const wchar_t wch, const unsigned int codepage);
 
     std::deque<std::unique_ptr<KeyEvent>> SynthesizeKeyboardEvents(const wchar_t wch,
                                                                    const short keyState);
@@ -208,8 +208,6 @@ void Clipboard::StoreSelectionToClipboard(bool const copyFormatting)
     const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
     const auto& buffer = gci.GetActiveOutputBuffer().GetTextBuffer();
 
-    const auto GetAttributeColors = std::bind(&CONSOLE_INFORMATION::LookupAttributeColors, &gci, std::placeholders::_1);
-
     bool includeCRLF, trimTrailingWhitespace;
     if (WI_IsFlagSet(GetKeyState(VK_SHIFT), KEY_PRESSED))
     {
@@ -221,31 +219,48 @@ void Clipboard::StoreSelectionToClipboard(bool const copyFormatting)
         includeCRLF = trimTrailingWhitespace = true;
     }
 
-    const auto text = buffer.GetText(includeCRLF,
-                                     trimTrailingWhitespace,
-                                     selectionRects,
-                                     GetAttributeColors);
+    // The plain text, HTML and RTF are all generated in a single pass over the buffer.
+    PlainTextExportSink textSink;
+    std::optional<HtmlExportSink> htmlSink;
+    std::optional<RtfExportSink> rtfSink;
+    std::vector<ITextExportSink*> sinks{ &textSink };
+    std::function<std::pair<COLORREF, COLORREF>(const TextAttribute&)> GetAttributeColors;
+
+    if (copyFormatting)
+    {
+        const auto& fontData = gci.GetActiveOutputBuffer().GetCurrentFont();
+        int const iFontHeightPoints = fontData.GetUnscaledSize().Y * 72 / ServiceLocator::LocateGlobals().dpi;
+        const COLORREF bgColor = gci.GetDefaultBackground();
+
+        sinks.emplace_back(&htmlSink.emplace(iFontHeightPoints, fontData.GetFaceName(), bgColor));
+        sinks.emplace_back(&rtfSink.emplace(iFontHeightPoints, fontData.GetFaceName(), bgColor));
+        GetAttributeColors = std::bind(&CONSOLE_INFORMATION::LookupAttributeColors, &gci, std::placeholders::_1);
+    }
 
-    CopyTextToSystemClipboard(text, copyFormatting);
+    buffer.ExportText(includeCRLF,
+                      trimTrailingWhitespace,
+                      selectionRects,
+                      GetAttributeColors,
+                      false,
+                      sinks);
+
+    CopyTextToSystemClipboard(textSink.Text(),
+                              htmlSink ? htmlSink->Finish() : "",
+                              rtfSink ? rtfSink->Finish() : "",
+                              copyFormatting);
 }
 
 // Routine Description:
 // - Copies the text given onto the global system clipboard.
 // Arguments:
-// - rows - Rows of text data to copy
+// - text - The text to copy
+// - html - The CF_HTML formatted text, only used if fAlsoCopyFormatting is set
+// - rtf - The RTF formatted text, only used if fAlsoCopyFormatting is set
 // - fAlsoCopyFormatting - true if the color and formatting should also be copied, false otherwise
-void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows, bool const fAlsoCopyFormatting)
+void Clipboard::CopyTextToSystemClipboard(const std::wstring& text, const std::string& html, const std::string& rtf, bool const fAlsoCopyFormatting)
 {
-    std::wstring finalString;
-
-    // Concatenate strings into one giant string to put onto the clipboard.
-    for (const auto& str : rows.text)
-    {
-        finalString += str;
-    }
-
     // allocate the final clipboard data
-    const size_t cchNeeded = finalString.size() + 1;
+    const size_t cchNeeded = text.size() + 1;
     const size_t cbNeeded = sizeof(wchar_t) * cchNeeded;
     wil::unique_hglobal globalHandle(GlobalAlloc(GMEM_MOVEABLE | GMEM_DDESHARE, cbNeeded));
     THROW_LAST_ERROR_IF_NULL(globalHandle.get());
@@ -255,7 +270,7 @@ void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows,
 
     // The pattern gets a bit strange here because there's no good wil built-in for global lock of this type.
     // Try to copy then immediately unlock. Don't throw until after (so the hglobal won't be freed until we unlock).
-    const HRESULT hr = StringCchCopyW(pwszClipboard, cchNeeded, finalString.data());
+    const HRESULT hr = StringCchCopyW(pwszClipboard, cchNeeded, text.data());
     GlobalUnlock(globalHandle.get());
     THROW_IF_FAILED(hr);
 
@@ -272,15 +287,8 @@ void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows,
 
         if (fAlsoCopyFormatting)
         {
-            const auto& fontData = ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetCurrentFont();
-            int const iFontHeightPoints = fontData.GetUnscaledSize().Y * 72 / ServiceLocator::LocateGlobals().dpi;
-            const COLORREF bgColor = ServiceLocator::LocateGlobals().getConsoleInformation().GetDefaultBackground();
-
-            std::string HTMLToPlaceOnClip = TextBuffer::GenHTML(rows, iFontHeightPoints, fontData.GetFaceName(), bgColor);
-            CopyToSystemClipboard(HTMLToPlaceOnClip, L"HTML Format");
-
-            std::string RTFToPlaceOnClip = TextBuffer::GenRTF(rows, iFontHeightPoints, fontData.GetFaceName(), bgColor);
-            CopyToSystemClipboard(RTFToPlaceOnClip, L"Rich Text Format");
+            CopyToSystemClipboard(html, L"HTML Format");
+            CopyToSystemClipboard(rtf, L"Rich Text Format");
         }
     }
 
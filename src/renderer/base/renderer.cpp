@@ -234,8 +234,10 @@ void Renderer::TriggerRedraw(const Viewport& region)
     if (view.TrimToViewport(&srUpdateRegion))
     {
         view.ConvertToOrigin(&srUpdateRegion);
+        const til::rectangle dirty{ Viewport::FromExclusive(srUpdateRegion).ToInclusive() };
         FOREACH_ENGINE(pEngine)
         {
+            _DropCachedRows(pEngine, dirty);
             LOG_IF_FAILED(pEngine->Invalidate(&srUpdateRegion));
         }
 
@@ -674,6 +676,11 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
         LOG_IF_FAILED(pEngine->ResetLineTransform());
     });
 
+    // How the rows were split into runs the last time they were painted.
+    auto& rowCache = til::at(_engineStates, _GetEngineIndex(pEngine)).rowCache;
+    rowCache.resize(gsl::narrow_cast<size_t>(view.Height()));
+    const auto screenReversed = _pData->IsScreenReversed();
+
     for (const auto& dirtyRect : dirtyAreas)
     {
         // Shortcut: don't bother redrawing if the width is 0.
@@ -699,13 +706,16 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
         // Now walk through each row of text that we need to redraw.
         for (auto row = redraw.Top(); row < redraw.BottomExclusive(); row++)
         {
+            // Retrieve the row so we can read information out of it.
+            const auto& textRow = buffer.GetRowByOffset(row);
+
             // Calculate the boundaries of a single line. This is from the left to right edge of the dirty
             // area in width and exactly 1 tall.
             const auto screenLine = SMALL_RECT{ redraw.Left(), row, redraw.RightInclusive(), row };
 
             // Convert the screen coordinates of the line to an equivalent
             // range of buffer cells, taking line rendition into account.
-            const auto lineRendition = buffer.GetLineRendition(row);
+            const auto lineRendition = textRow.GetLineRendition();
             const auto bufferLine = Viewport::FromInclusive(ScreenToBufferLine(screenLine, lineRendition));
 
             // Find where on the screen we should place this line information. This requires us to re-map
@@ -722,14 +732,40 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
             // 1. this row wrapped
             // 2. We're painting the last col of the row.
             // In that case, set lineWrapped=true for the _PaintBufferOutputHelper call.
-            const auto lineWrapped = (buffer.GetRowByOffset(bufferLine.Origin().Y).WasWrapForced()) &&
-                                     (bufferLine.RightExclusive() == buffer.GetSize().Width());
+            const auto lineWrapped = (textRow.WasWrapForced()) &&
+                                     (gsl::narrow_cast<size_t>(bufferLine.RightExclusive()) == textRow.size());
 
             // Prepare the appropriate line transform for the current row and viewport offset.
             LOG_IF_FAILED(pEngine->PrepareLineTransform(lineRendition, screenPosition.Y, view.Left()));
 
-            // Ask the helper to paint through this specific line.
-            _PaintBufferOutputHelper(pEngine, it, screenPosition, lineWrapped);
+            // Rows which didn't change since they were painted last are painted
+            // from the runs they were split into back then.
+            if (!_rowCacheEnabled)
+            {
+                // Ask the helper to paint through this specific line.
+                _PaintBufferOutputHelper(pEngine, it, screenPosition, lineWrapped);
+                continue;
+            }
+
+            auto& cache = til::at(rowCache, gsl::narrow_cast<size_t>(screenPosition.Y));
+            const auto revision = textRow.GetRevision();
+            if (cache.valid &&
+                cache.revision == revision &&
+                cache.left == bufferLine.Left() &&
+                cache.right == bufferLine.RightInclusive() &&
+                cache.screenReversed == screenReversed &&
+                cache.lastSoftFontChar == _lastSoftFontChar)
+            {
+                _PaintCachedRow(pEngine, cache, screenPosition, lineWrapped);
+                continue;
+            }
+
+            cache.revision = revision;
+            cache.left = bufferLine.Left();
+            cache.right = bufferLine.RightInclusive();
+            cache.screenReversed = screenReversed;
+            cache.lastSoftFontChar = _lastSoftFontChar;
+            _PaintBufferOutputHelper(pEngine, it, screenPosition, lineWrapped, &cache);
         }
     }
 }
@@ -740,13 +776,37 @@ static bool _IsAllSpaces(const std::wstring_view v)
     return v.find_first_not_of(L' ') == decltype(v)::npos;
 }
 
+// Routine Description:
+// - Paints a part of a single row, split into runs of clusters with the same attributes.
+// Arguments:
+// - pEngine - The render engine that we're targeting.
+// - it - The cells of the row to paint.
+// - target - Where on the screen the first cell is painted.
+// - lineWrapped - Whether the row wrapped and the part ends with its last column.
+// - cache - If given, the runs are recorded in it, so that they can be
+//           painted again with _PaintCachedRow() as long as the row doesn't change.
+//           Rows with pattern IDs aren't cached, since they can change on their own.
+// Return Value:
+// - <none>
 void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
                                         TextBufferCellIterator it,
                                         const COORD target,
-                                        const bool lineWrapped)
+                                        const bool lineWrapped,
+                                        CachedRow* const cache)
 {
     auto globalInvert{ _pData->IsScreenReversed() };
 
+    // Whether any of the runs has pattern IDs.
+    bool anyPatternIds = false;
+
+    if (cache)
+    {
+        cache->valid = false;
+        cache->text.clear();
+        cache->clusters.clear();
+        cache->runs.clear();
+    }
+
     // If we have valid data, let's figure out how to draw it.
     if (it)
     {
@@ -775,8 +835,9 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
             // when we go to draw gridlines for the length of the run.
             const auto currentRunColor = color;
 
-            // Hold onto the current pattern id as well
+            // Hold onto the current pattern id and font usage as well
             const auto currentPatternId = patternIds;
+            const auto currentUsingSoftFont = usingSoftFont;
 
             // Update the drawing brushes with our color and font usage.
             THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, currentRunColor, usingSoftFont, false));
@@ -852,6 +913,34 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
 
             } while (it);
 
+            anyPatternIds |= !currentPatternId.empty();
+
+            if (cache)
+            {
+                auto& run = cache->runs.emplace_back();
+                run.attributes = currentRunColor;
+                run.usingSoftFont = currentUsingSoftFont;
+                run.trimLeft = trimLeft;
+                run.x = gsl::narrow_cast<SHORT>(screenPoint.X - target.X);
+                run.columns = cols;
+                run.firstCluster = cache->clusters.size();
+                run.clusterCount = _clusterBuffer.size();
+                for (const auto& cluster : _clusterBuffer)
+                {
+                    const auto text = cluster.GetText();
+                    cache->clusters.push_back({ cache->text.size(), text.size(), cluster.GetColumns() });
+                    cache->text.append(text);
+                }
+                if (containsWideCharacter)
+                {
+                    auto lineIt = currentRunItStart;
+                    for (auto colsPainted = 0u; colsPainted < cols; ++colsPainted, ++lineIt)
+                    {
+                        run.columnAttributes.emplace_back(lineIt->TextAttr());
+                    }
+                }
+            }
+
             // Do the painting.
             THROW_IF_FAILED(pEngine->PaintBufferLine({ _clusterBuffer.data(), _clusterBuffer.size() }, screenPoint, trimLeft, lineWrapped));
 
@@ -890,6 +979,63 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
             }
         }
     }
+
+    if (cache)
+    {
+        cache->valid = !anyPatternIds;
+    }
+}
+
+// Routine Description:
+// - Paints a part of a single row from the runs _PaintBufferOutputHelper split it into
+//   before, exactly like the helper would paint it again, but without walking its cells.
+// Arguments:
+// - pEngine - The render engine that we're targeting.
+// - cache - The runs of the row. It must not have changed since they were recorded.
+// - target - Where on the screen the first cell is painted.
+// - lineWrapped - Whether the row wrapped and the part ends with its last column.
+// Return Value:
+// - <none>
+void Renderer::_PaintCachedRow(_In_ IRenderEngine* const pEngine,
+                               const CachedRow& cache,
+                               const COORD target,
+                               const bool lineWrapped)
+{
+    const std::wstring_view text{ cache.text };
+
+    for (const auto& run : cache.runs)
+    {
+        THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, run.attributes, run.usingSoftFont, false));
+
+        _clusterBuffer.clear();
+        for (auto i = run.firstCluster; i < run.firstCluster + run.clusterCount; ++i)
+        {
+            const auto& cluster = til::at(cache.clusters, i);
+            _clusterBuffer.emplace_back(text.substr(cluster.offset, cluster.length), cluster.columns);
+        }
+
+        const COORD screenPoint{ gsl::narrow_cast<SHORT>(target.X + run.x), target.Y };
+        THROW_IF_FAILED(pEngine->PaintBufferLine({ _clusterBuffer.data(), _clusterBuffer.size() }, screenPoint, run.trimLeft, lineWrapped));
+
+        if (_pData->IsGridLineDrawingAllowed())
+        {
+            if (!run.columnAttributes.empty())
+            {
+                // The helper paints the lines of runs with wide characters column by column,
+                // starting where the run started before it was moved left to trim it.
+                COORD lineTarget{ gsl::narrow_cast<SHORT>(screenPoint.X + (run.trimLeft ? 1 : 0)), screenPoint.Y };
+                for (const auto& lines : run.columnAttributes)
+                {
+                    _PaintBufferOutputGridLineHelper(pEngine, lines, 1, lineTarget);
+                    ++lineTarget.X;
+                }
+            }
+            else
+            {
+                _PaintBufferOutputGridLineHelper(pEngine, run.attributes, run.columns, screenPoint);
+            }
+        }
+    }
 }
 
 // Method Description:
@@ -1292,6 +1438,40 @@ void Renderer::_ScrollPreviousSelection(const til::point delta)
     }
 }
 
+// Routine Description:
+// - Drops the runs of the given rows from the row cache of an engine.
+// - Pattern IDs can change without the rows changing, but the rows are
+//   always redrawn when they do. Rows are only cached if they have no
+//   pattern IDs, so a cached row is known to still have none.
+// Arguments:
+// - pEngine - One of the engines of this renderer.
+// - rect - The area on the screen that's redrawn.
+// Return Value:
+// - <none>
+void Renderer::_DropCachedRows(const IRenderEngine* const pEngine, const til::rectangle& rect)
+{
+    auto& rowCache = til::at(_engineStates, _GetEngineIndex(pEngine)).rowCache;
+    const auto top = std::clamp<ptrdiff_t>(rect.top(), 0, gsl::narrow_cast<ptrdiff_t>(rowCache.size()));
+    const auto bottom = std::clamp<ptrdiff_t>(rect.bottom(), top, gsl::narrow_cast<ptrdiff_t>(rowCache.size()));
+    for (auto y = top; y < bottom; ++y)
+    {
+        til::at(rowCache, gsl::narrow_cast<size_t>(y)).valid = false;
+    }
+}
+
+// Routine Description:
+// - Looks up the index of an engine in _engines, which is also its index in _engineStates.
+// Arguments:
+// - pEngine - One of the engines of this renderer.
+// Return Value:
+// - The index of the engine.
+size_t Renderer::_GetEngineIndex(const IRenderEngine* const pEngine) const
+{
+    const auto it = std::find(_engines.begin(), _engines.end(), pEngine);
+    FAIL_FAST_IF(it == _engines.end()); // This is a programming error. Fail fast.
+    return gsl::narrow_cast<size_t>(it - _engines.begin());
+}
+
 // Method Description:
 // - Adds another Render engine to this renderer. Future rendering calls will
 //      also be sent to the new renderer.
@@ -25,6 +25,10 @@ Author(s):
 #include "../../buffer/out/textBuffer.hpp"
 #include "../../buffer/out/CharRow.hpp"
 
+#ifdef UNIT_TESTING
+class RendererTests;
+#endif
+
 namespace Microsoft::Console::Render
 {
     class Renderer sealed : public IRenderer
@@ -87,6 +91,53 @@ namespace Microsoft::Console::Render
         void UpdateLastHoveredInterval(const std::optional<interval_tree::IntervalTree<til::point, size_t>::interval>& newInterval);
 
     private:
+        // A run of clusters with the same attributes, as _PaintBufferOutputHelper
+        // split it off a row. Its clusters are kept in the CachedRow.
+        struct CachedRun
+        {
+            TextAttribute attributes;
+            bool usingSoftFont = false;
+            bool trimLeft = false;
+            // Where the run is painted, relative to the start of the row's part.
+            SHORT x = 0;
+            size_t columns = 0;
+            size_t firstCluster = 0;
+            size_t clusterCount = 0;
+            // The attributes of each column of runs with wide characters, for their grid lines.
+            std::vector<TextAttribute> columnAttributes;
+        };
+
+        struct CachedCluster
+        {
+            size_t offset = 0;
+            size_t length = 0;
+            size_t columns = 0;
+        };
+
+        // How a part of a row was split into runs the last time it was painted.
+        // It's used instead of splitting the row again, as long as it didn't
+        // change, for instance when it's repainted for a blinking cursor.
+        struct CachedRow
+        {
+            bool valid = false;
+            RowRevision revision;
+            SHORT left = 0;
+            SHORT right = 0;
+            bool screenReversed = false;
+            size_t lastSoftFontChar = 0;
+            // The text of all clusters. They refer to it by offset, since it may move.
+            std::wstring text;
+            std::vector<CachedCluster> clusters;
+            std::vector<CachedRun> runs;
+        };
+
+        // Everything the renderer keeps for each of its engines.
+        struct EngineState
+        {
+            // The rows painted last, by their position on the screen.
+            std::vector<CachedRow> rowCache;
+        };
+
         static IRenderEngine::GridLineSet s_GetGridlines(const TextAttribute& textAttribute) noexcept;
         static bool s_IsSoftFontChar(const std::wstring_view& v, const size_t firstSoftFontChar, const size_t lastSoftFontChar);
 
@@ -95,7 +146,8 @@ namespace Microsoft::Console::Render
         bool _CheckViewportAndScroll();
         [[nodiscard]] HRESULT _PaintBackground(_In_ IRenderEngine* const pEngine);
         void _PaintBufferOutput(_In_ IRenderEngine* const pEngine);
-        void _PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine, TextBufferCellIterator it, const COORD target, const bool lineWrapped);
+        void _PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine, TextBufferCellIterator it, const COORD target, const bool lineWrapped, CachedRow* const cache = nullptr);
+        void _PaintCachedRow(_In_ IRenderEngine* const pEngine, const CachedRow& cache, const COORD target, const bool lineWrapped);
         void _PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngine, const TextAttribute textAttribute, const size_t cchLine, const COORD coordTarget);
         void _PaintSelection(_In_ IRenderEngine* const pEngine);
         void _PaintCursor(_In_ IRenderEngine* const pEngine);
@@ -108,8 +160,11 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT _PaintTitle(IRenderEngine* const pEngine);
         [[nodiscard]] std::optional<CursorOptions> _GetCursorInfo();
         [[nodiscard]] HRESULT _PrepareRenderInfo(_In_ IRenderEngine* const pEngine);
+        size_t _GetEngineIndex(const IRenderEngine* const pEngine) const;
+        void _DropCachedRows(const IRenderEngine* const pEngine, const til::rectangle& rect);
 
         std::array<IRenderEngine*, 2> _engines{};
+        std::array<EngineState, 2> _engineStates;
         IRenderData* _pData = nullptr; // Non-ownership pointer
         std::unique_ptr<IRenderThread> _pThread;
         static constexpr size_t _firstSoftFontChar = 0xEF20;
@@ -117,12 +172,14 @@ namespace Microsoft::Console::Render
         std::optional<interval_tree::IntervalTree<til::point, size_t>::interval> _hoveredInterval;
         Microsoft::Console::Types::Viewport _viewport;
         std::vector<Cluster> _clusterBuffer;
+        bool _rowCacheEnabled = true;
         std::vector<SMALL_RECT> _previousSelection;
         std::function<void()> _pfnRendererEnteredErrorState;
         bool _destructing = false;
 
 #ifdef UNIT_TESTING
         friend class ConptyOutputTests;
+        friend class ::RendererTests;
 #endif
     };
 }
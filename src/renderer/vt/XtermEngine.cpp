@@ -21,6 +21,10 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
     // Set out initial cursor position to -1, -1. This will force our initial
     //      paint to manually move the cursor to 0, 0, not just ignore it.
     _lastText = VtEngine::INVALID_COORDS;
+
+    // The telnet client (which is what the ASCII mode is for) might not
+    //      support more than one parameter per SGR sequence.
+    _coalesceRenditions = !fUseAsciiOnly;
 }
 
 // Method Description:
@@ -101,6 +105,7 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
         if (_lastCursorIsVisible)
         {
             _buffer.insert(0, "\x1b[?25l");
+            _renditionEnd = std::string::npos;
             _lastCursorIsVisible = false;
         }
         // If the cursor was NOT previously visible, then that's fine! we don't
@@ -96,13 +96,71 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
 
     try
     {
-        _buffer.append(str);
+        if (!_coalesceRenditions || !_AppendRendition(str))
+        {
+            _buffer.append(str);
+        }
 
         return S_OK;
     }
     CATCH_RETURN();
 }
 
+// Method Description:
+// - Appends a SGR sequence to the buffer. If the buffer already ends with
+//   another SGR sequence, the parameters are merged into it instead, turning
+//   for instance "\x1b[1m\x1b[38;2;1;2;3m" into "\x1b[1;38;2;1;2;3m".
+//   A SGR reset discards all parameters that immediately precede it.
+// Arguments:
+// - str: The sequence to write.
+// Return Value:
+// - true if str was a SGR sequence and has been appended, false otherwise.
+bool VtEngine::_AppendRendition(const std::string_view str)
+{
+    // Only "CSI <parameters> m" with plain numeric parameters is coalesced.
+    if (str.size() < 3 || str[0] != '\x1b' || str[1] != '[' || str.back() != 'm')
+    {
+        return false;
+    }
+
+    const auto parameters = str.substr(2, str.size() - 3);
+    if (parameters.find_first_not_of("0123456789;") != std::string_view::npos)
+    {
+        return false;
+    }
+
+    if (_renditionEnd == _buffer.size())
+    {
+        if (parameters.empty() || parameters == "0")
+        {
+            // Nothing preceding a reset has any effect.
+            _buffer.resize(_renditionStart);
+        }
+        else
+        {
+            if (_renditionEnd - _renditionStart == 3)
+            {
+                // The preceding sequence is a "\x1b[m".
+                _buffer.back() = '0';
+                _buffer.push_back(';');
+            }
+            else
+            {
+                _buffer.back() = ';';
+            }
+            _buffer.append(parameters);
+            _buffer.push_back('m');
+            _renditionEnd = _buffer.size();
+            return true;
+        }
+    }
+
+    _renditionStart = _buffer.size();
+    _buffer.append(str);
+    _renditionEnd = _buffer.size();
+    return true;
+}
+
 [[nodiscard]] HRESULT VtEngine::_Flush() noexcept
 {
 #ifdef UNIT_TESTING
@@ -117,6 +175,7 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
     {
         bool fSuccess = !!WriteFile(_hFile.get(), _buffer.data(), gsl::narrow_cast<DWORD>(_buffer.size()), nullptr, nullptr);
         _buffer.clear();
+        _renditionEnd = std::string::npos;
         if (!fSuccess)
         {
             _exitResult = HRESULT_FROM_WIN32(GetLastError());
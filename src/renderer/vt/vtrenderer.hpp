@@ -154,8 +154,15 @@ namespace Microsoft::Console::Render
         bool _resizeQuirk{ false };
         std::optional<TextColor> _newBottomLineBG{ std::nullopt };
 
+        // If enabled, consecutive SGR sequences are merged into one. _renditionStart
+        // and _renditionEnd span the last one, if it's still at the end of _buffer.
+        bool _coalesceRenditions{ false };
+        size_t _renditionStart{ std::string::npos };
+        size_t _renditionEnd{ std::string::npos };
+
         [[nodiscard]] HRESULT _Write(std::string_view const str) noexcept;
         [[nodiscard]] HRESULT _Flush() noexcept;
+        bool _AppendRendition(const std::string_view str);
 
         template<typename S, typename... Args>
         [[nodiscard]] HRESULT _WriteFormatted(S&& format, Args&&... args)
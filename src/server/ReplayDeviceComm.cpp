@@ -0,0 +1,435 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "ReplayDeviceComm.h"
+#include "IoSorter.h"
+
+#include "../host/globals.h"
+#include "../interactivity/inc/ServiceLocator.hpp"
+
+using Microsoft::Console::Interactivity::ServiceLocator;
+
+// A recording consists of a RecordingHeader followed by the messages back to back.
+// Each message is stored as its packet (RecordingHeader::PacketSize bytes),
+// the size of its input as a ULONG and the input itself.
+struct RecordingHeader
+{
+    ULONG Magic;
+    ULONG Version;
+    ULONG PacketSize;
+    ULONG MessageCount;
+};
+
+static constexpr ULONG s_recordingMagic = 0x4c504552; // "REPL"
+static constexpr ULONG s_recordingVersion = 1;
+
+// The packet data following the descriptor is a union of the create object information and the message header.
+static constexpr size_t s_payloadOffset = FIELD_OFFSET(CONSOLE_API_MSG, msgHeader) - FIELD_OFFSET(CONSOLE_API_MSG, Descriptor);
+
+ReplayDeviceComm::ReplayDeviceComm(std::vector<Message> messages) :
+    _messages{ std::move(messages) },
+    _started(_messages.size())
+{
+    for (const auto& message : _messages)
+    {
+        THROW_HR_IF(E_INVALIDARG, message.packet.size() != PacketSize);
+    }
+}
+
+// Routine Description:
+// - Reads a recording of messages from a file.
+// Arguments:
+// - path - The file to read.
+// Return Value:
+// - The messages of the recording.
+// Note:
+// - Will throw if the file can't be read or if it was recorded by a server with a different packet layout.
+std::vector<ReplayDeviceComm::Message> ReplayDeviceComm::s_LoadRecording(const std::wstring& path)
+{
+    wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    THROW_LAST_ERROR_IF(!file);
+
+    const auto read = [&](void* const buffer, const size_t size) {
+        DWORD bytesRead = 0;
+        THROW_IF_WIN32_BOOL_FALSE(ReadFile(file.get(), buffer, gsl::narrow<DWORD>(size), &bytesRead, nullptr));
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_HANDLE_EOF), bytesRead != size);
+    };
+
+    RecordingHeader header{};
+    read(&header, sizeof(header));
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_BAD_FORMAT), header.Magic != s_recordingMagic || header.Version != s_recordingVersion);
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_BAD_FORMAT), header.PacketSize != PacketSize);
+
+    std::vector<Message> messages(header.MessageCount);
+    for (auto& message : messages)
+    {
+        message.packet.resize(PacketSize);
+        read(message.packet.data(), message.packet.size());
+
+        ULONG inputSize = 0;
+        read(&inputSize, sizeof(inputSize));
+        const auto& descriptor = s_GetDescriptor(message);
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_BAD_FORMAT), descriptor.Function == CONSOLE_IO_USER_DEFINED && inputSize != descriptor.InputSize);
+
+        message.input.resize(inputSize);
+        read(message.input.data(), message.input.size());
+    }
+
+    return messages;
+}
+
+// Routine Description:
+// - Writes a recording of messages to a file, so that it can be replayed with s_LoadRecording later.
+// - Only the messages themselves are stored, not the results of replaying them.
+// Arguments:
+// - path - The file to write. It's replaced if it exists.
+// - messages - The messages to store.
+// Return Value:
+// - <none>
+void ReplayDeviceComm::s_SaveRecording(const std::wstring& path, const std::vector<Message>& messages)
+{
+    wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    THROW_LAST_ERROR_IF(!file);
+
+    const auto write = [&](const void* const buffer, const size_t size) {
+        DWORD bytesWritten = 0;
+        THROW_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), buffer, gsl::narrow<DWORD>(size), &bytesWritten, nullptr));
+    };
+
+    const RecordingHeader header{ s_recordingMagic, s_recordingVersion, gsl::narrow<ULONG>(PacketSize), gsl::narrow<ULONG>(messages.size()) };
+    write(&header, sizeof(header));
+
+    for (const auto& message : messages)
+    {
+        THROW_HR_IF(E_INVALIDARG, message.packet.size() != PacketSize);
+        write(message.packet.data(), message.packet.size());
+
+        const auto inputSize = gsl::narrow<ULONG>(message.input.size());
+        write(&inputSize, sizeof(inputSize));
+        write(message.input.data(), message.input.size());
+    }
+}
+
+// Routine Description:
+// - Creates a message which opens a handle to the current input or output buffer, like CreateFile("CONIN$") does.
+// - The handle the server returns for it is handed out by PutHandle.
+// Arguments:
+// - process - The handle of the client process
+// - objectType - CD_IO_OBJECT_TYPE_CURRENT_INPUT or CD_IO_OBJECT_TYPE_CURRENT_OUTPUT
+// Return Value:
+// - The message.
+ReplayDeviceComm::Message ReplayDeviceComm::s_CreateObjectMessage(const ULONG_PTR process, const ULONG objectType)
+{
+    Message message;
+    message.packet.resize(PacketSize);
+
+    CD_IO_DESCRIPTOR descriptor{};
+    descriptor.Process = process;
+    descriptor.Function = CONSOLE_IO_CREATE_OBJECT;
+    memcpy(message.packet.data(), &descriptor, sizeof(descriptor));
+
+    CD_CREATE_OBJECT_INFORMATION createObject{};
+    createObject.ObjectType = objectType;
+    createObject.ShareMode = FILE_SHARE_READ | FILE_SHARE_WRITE;
+    createObject.DesiredAccess = GENERIC_READ | GENERIC_WRITE;
+    memcpy(message.packet.data() + s_payloadOffset, &createObject, sizeof(createObject));
+
+    return message;
+}
+
+// Routine Description:
+// - Creates a message which closes a handle created by a CONSOLE_IO_CREATE_OBJECT message.
+// Arguments:
+// - process - The handle of the client process
+// - object - The handle to close
+// Return Value:
+// - The message.
+ReplayDeviceComm::Message ReplayDeviceComm::s_CloseObjectMessage(const ULONG_PTR process, const ULONG_PTR object)
+{
+    Message message;
+    message.packet.resize(PacketSize);
+
+    CD_IO_DESCRIPTOR descriptor{};
+    descriptor.Process = process;
+    descriptor.Object = object;
+    descriptor.Function = CONSOLE_IO_CLOSE_OBJECT;
+    memcpy(message.packet.data(), &descriptor, sizeof(descriptor));
+
+    return message;
+}
+
+// Routine Description:
+// - Creates a message calling a console API, the way the console driver passes it on from a client.
+// Arguments:
+// - process - The handle of the client process
+// - object - The handle of the input or output buffer the API is called on
+// - apiNumber - The API to call, for instance ConsolepWriteConsole
+// - body - The API specific message, for instance a CONSOLE_WRITECONSOLE_MSG
+// - payload - The data the client sends along with the message, for instance the text to write
+// - outputSize - The size of the buffer the client provides for data returned by the API, in bytes
+// Return Value:
+// - The message.
+ReplayDeviceComm::Message ReplayDeviceComm::s_CreateApiMessage(const ULONG_PTR process,
+                                                               const ULONG_PTR object,
+                                                               const ULONG apiNumber,
+                                                               const gsl::span<const std::byte> body,
+                                                               const gsl::span<const std::byte> payload,
+                                                               const ULONG outputSize)
+{
+    Message message;
+
+    CONSOLE_MSG_HEADER header{};
+    header.ApiNumber = apiNumber;
+    header.ApiDescriptorSize = gsl::narrow<ULONG>(body.size());
+
+    // The input of a message is its header, followed by the API specific message and the payload.
+    message.input.resize(sizeof(header) + body.size() + payload.size());
+    memcpy(message.input.data(), &header, sizeof(header));
+    std::copy(body.begin(), body.end(), reinterpret_cast<std::byte*>(message.input.data() + sizeof(header)));
+    std::copy(payload.begin(), payload.end(), reinterpret_cast<std::byte*>(message.input.data() + sizeof(header) + body.size()));
+
+    CD_IO_DESCRIPTOR descriptor{};
+    descriptor.Process = process;
+    descriptor.Object = object;
+    descriptor.Function = CONSOLE_IO_USER_DEFINED;
+    descriptor.InputSize = gsl::narrow<ULONG>(message.input.size());
+    descriptor.OutputSize = header.ApiDescriptorSize + outputSize;
+
+    // Just like the driver, we copy as much of the input into the packet as fits.
+    message.packet.resize(PacketSize);
+    memcpy(message.packet.data(), &descriptor, sizeof(descriptor));
+    memcpy(message.packet.data() + s_payloadOffset, message.input.data(), std::min(message.input.size(), PacketSize - s_payloadOffset));
+
+    return message;
+}
+
+// Routine Description:
+// - Services all messages of the recording, just like the IO thread does with those from the driver.
+// - This device comm is used as the global one while replaying,
+//   since the connection and object messages are completed through it.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK once all messages were serviced, otherwise a suitable error.
+[[nodiscard]] HRESULT ReplayDeviceComm::Replay()
+{
+    auto& globals = ServiceLocator::LocateGlobals();
+    const auto previousDeviceComm = std::exchange(globals.pDeviceComm, this);
+    auto restoreDeviceComm = wil::scope_exit([&] { globals.pDeviceComm = previousDeviceComm; });
+
+    CONSOLE_API_MSG ReceiveMsg;
+    ReceiveMsg._pApiRoutines = &globals.api;
+    ReceiveMsg._pDeviceComm = this;
+    PCONSOLE_API_MSG ReplyMsg = nullptr;
+
+    for (;;)
+    {
+        if (ReplyMsg != nullptr)
+        {
+            LOG_IF_FAILED(ReplyMsg->ReleaseMessageBuffers());
+        }
+
+        const auto hr = ReadIo(ReplyMsg, &ReceiveMsg);
+        if (hr == HRESULT_FROM_WIN32(ERROR_PIPE_NOT_CONNECTED))
+        {
+            return S_OK;
+        }
+        RETURN_IF_FAILED(hr);
+
+        IoSorter::ServiceIoOperation(&ReceiveMsg, &ReplyMsg);
+    }
+}
+
+// Routine Description:
+// - Gets the messages of the recording, which include the results of the ones that were completed.
+const std::vector<ReplayDeviceComm::Message>& ReplayDeviceComm::GetMessages() const noexcept
+{
+    return _messages;
+}
+
+// Routine Description:
+// - Gets the time it took to complete the messages, keyed by their API number.
+//   Messages other than CONSOLE_IO_USER_DEFINED are keyed by their CONSOLE_IO_* function instead.
+// - The time spans from handing out the message in ReadIo until the server completes it.
+const std::map<ULONG, ReplayDeviceComm::ApiStatistics>& ReplayDeviceComm::GetStatistics() const noexcept
+{
+    return _statistics;
+}
+
+// Routine Description:
+// - There's no driver that needs to know about the input available event.
+[[nodiscard]] HRESULT ReplayDeviceComm::SetServerInformation(_In_ CD_IO_SERVER_INFORMATION* const /*pServerInfo*/) const
+{
+    return S_OK;
+}
+
+// Routine Description:
+// - Hands out the next message of the recording.
+// Arguments:
+// - pReplyMsg - Optional message to complete before retrieving the next one
+// - pMessage - A structure to hold the message data.
+// Return Value:
+// - HRESULT S_OK, or ERROR_PIPE_NOT_CONNECTED once all messages were handed out,
+//   just like the driver returns once all clients are gone.
+[[nodiscard]] HRESULT ReplayDeviceComm::ReadIo(_In_opt_ PCONSOLE_API_MSG const pReplyMsg,
+                                               _Out_ CONSOLE_API_MSG* const pMessage) const
+{
+    // pReplyMsg and pMessage are usually the same message. Complete it before it's overwritten.
+    if (pReplyMsg != nullptr)
+    {
+        RETURN_IF_FAILED(CompleteIo(&pReplyMsg->Complete));
+    }
+
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_PIPE_NOT_CONNECTED), _next >= _messages.size());
+
+    const auto& message = _messages[_next];
+    memcpy(&pMessage->Descriptor, message.packet.data(), PacketSize);
+
+    // Identifiers only need to be unique, so we use the index of the message, offset by one.
+    pMessage->Descriptor.Identifier.LowPart = gsl::narrow<DWORD>(_next + 1);
+    pMessage->Descriptor.Identifier.HighPart = 0;
+
+    _started[_next] = std::chrono::steady_clock::now();
+    ++_next;
+    return S_OK;
+}
+
+// Routine Description:
+// - Records the result of a message and the time it took to complete it.
+// Arguments:
+// - pCompletion - Completion structure of the message
+// Return Value:
+// - HRESULT S_OK or suitable error.
+[[nodiscard]] HRESULT ReplayDeviceComm::CompleteIo(_In_ CD_IO_COMPLETE* const pCompletion) const
+try
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    Message* message;
+    RETURN_IF_FAILED(_GetMessage(pCompletion->Identifier, &message));
+
+    message->status = pCompletion->IoStatus.Status;
+    message->information = pCompletion->IoStatus.Information;
+    if (pCompletion->Write.Data != nullptr)
+    {
+        const auto data = static_cast<const BYTE*>(pCompletion->Write.Data);
+        message->reply.assign(data, data + pCompletion->Write.Size);
+    }
+
+    const auto elapsed = now - til::at(_started, pCompletion->Identifier.LowPart - 1);
+    auto& statistics = _statistics[s_GetApiNumber(*message)];
+    ++statistics.count;
+    statistics.failures += NT_SUCCESS(message->status) ? 0 : 1;
+    statistics.total += elapsed;
+    statistics.max = std::max(statistics.max, elapsed);
+
+    return S_OK;
+}
+CATCH_RETURN();
+
+// Routine Description:
+// - Retrieves the input the client sent along with a message.
+// Arguments:
+// - pIoOperation - Identifies the message and the part of its input to retrieve.
+// Return Value:
+// - HRESULT S_OK or suitable error.
+[[nodiscard]] HRESULT ReplayDeviceComm::ReadInput(_In_ CD_IO_OPERATION* const pIoOperation) const
+{
+    Message* message;
+    RETURN_IF_FAILED(_GetMessage(pIoOperation->Identifier, &message));
+
+    const auto offset = pIoOperation->Buffer.Offset;
+    const auto size = pIoOperation->Buffer.Size;
+    RETURN_HR_IF(E_INVALIDARG, offset > message->input.size() || size > message->input.size() - offset);
+
+    memcpy(pIoOperation->Buffer.Data, message->input.data() + offset, size);
+    return S_OK;
+}
+
+// Routine Description:
+// - Stores the data returned to the client for a message.
+// Arguments:
+// - pIoOperation - Identifies the message and contains the data returned to the client.
+// Return Value:
+// - HRESULT S_OK or suitable error.
+[[nodiscard]] HRESULT ReplayDeviceComm::WriteOutput(_In_ CD_IO_OPERATION* const pIoOperation) const
+try
+{
+    Message* message;
+    RETURN_IF_FAILED(_GetMessage(pIoOperation->Identifier, &message));
+
+    const auto offset = pIoOperation->Buffer.Offset;
+    const auto size = pIoOperation->Buffer.Size;
+    const auto outputSize = s_GetDescriptor(*message).OutputSize;
+    RETURN_HR_IF(E_INVALIDARG, offset > outputSize || size > outputSize - offset);
+
+    const auto data = static_cast<const BYTE*>(pIoOperation->Buffer.Data);
+    message->output.resize(std::max<size_t>(message->output.size(), offset + size));
+    std::copy_n(data, size, message->output.begin() + offset);
+    return S_OK;
+}
+CATCH_RETURN();
+
+// Routine Description:
+// - There's no driver that needs to grant UI access.
+[[nodiscard]] HRESULT ReplayDeviceComm::AllowUIAccess() const
+{
+    return S_OK;
+}
+
+// Routine Description:
+// - Implements IDeviceComm handle exchange for replays.
+// - Handles are numbered in the order they're handed out, starting at 1,
+//   so that they're the same every time the recording is replayed.
+//   The handles in a recording need to be numbered the same way.
+// - The opposite of GetHandle
+[[nodiscard]] ULONG_PTR ReplayDeviceComm::PutHandle(const void* handle)
+{
+    _handles.emplace_back(handle);
+    return _handles.size();
+}
+
+// Routine Description:
+// - Implements IDeviceComm handle exchange for replays.
+// - The opposite of PutHandle
+[[nodiscard]] void* ReplayDeviceComm::GetHandle(ULONG_PTR handleId) const
+{
+    if (handleId == 0 || handleId > _handles.size())
+    {
+        return nullptr;
+    }
+    return const_cast<void*>(til::at(_handles, handleId - 1));
+}
+
+// Routine Description:
+// - There's no server handle that could be handed off to another console server.
+[[nodiscard]] HRESULT ReplayDeviceComm::GetServerHandle(_Out_ HANDLE* pHandle) const
+{
+    *pHandle = INVALID_HANDLE_VALUE;
+    return E_NOTIMPL;
+}
+
+const CD_IO_DESCRIPTOR& ReplayDeviceComm::s_GetDescriptor(const Message& message) noexcept
+{
+    return *reinterpret_cast<const CD_IO_DESCRIPTOR*>(message.packet.data());
+}
+
+ULONG ReplayDeviceComm::s_GetApiNumber(const Message& message) noexcept
+{
+    const auto& descriptor = s_GetDescriptor(message);
+    if (descriptor.Function != CONSOLE_IO_USER_DEFINED)
+    {
+        return descriptor.Function;
+    }
+    return reinterpret_cast<const CONSOLE_MSG_HEADER*>(message.packet.data() + s_payloadOffset)->ApiNumber;
+}
+
+[[nodiscard]] HRESULT ReplayDeviceComm::_GetMessage(const LUID& identifier, _Outptr_ Message** ppMessage) const noexcept
+{
+    *ppMessage = nullptr;
+    RETURN_HR_IF(E_INVALIDARG, identifier.HighPart != 0 || identifier.LowPart == 0 || identifier.LowPart > _next);
+    *ppMessage = &til::at(_messages, identifier.LowPart - 1);
+    return S_OK;
+}
@@ -0,0 +1,96 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ReplayDeviceComm.h
+
+Abstract:
+- This module replays a recorded stream of console API messages to the console
+  server entirely in process, in lieu of the console driver.
+- It allows exercising and benchmarking the server (IoSorter, ApiSorter and the
+  message buffers) without a live console driver.
+--*/
+
+#pragma once
+
+#include "DeviceComm.h"
+#include "ApiMessage.h"
+
+class ReplayDeviceComm : public IDeviceComm
+{
+public:
+    // A message as the driver hands it to us: the packet that's copied over the
+    // tail of a CONSOLE_API_MSG starting at its Descriptor, and the input the
+    // client sent along with it, which is retrieved with ReadInput.
+    struct Message
+    {
+        std::vector<BYTE> packet;
+        std::vector<BYTE> input;
+
+        // These are filled in once the server completes the message.
+        NTSTATUS status{ STATUS_PENDING };
+        ULONG_PTR information{ 0 };
+        std::vector<BYTE> reply;
+        std::vector<BYTE> output;
+    };
+
+    struct ApiStatistics
+    {
+        size_t count{ 0 };
+        size_t failures{ 0 };
+        std::chrono::steady_clock::duration total{};
+        std::chrono::steady_clock::duration max{};
+    };
+
+    static constexpr size_t PacketSize = sizeof(CONSOLE_API_MSG) - FIELD_OFFSET(CONSOLE_API_MSG, Descriptor);
+
+    ReplayDeviceComm(std::vector<Message> messages);
+
+    static std::vector<Message> s_LoadRecording(const std::wstring& path);
+    static void s_SaveRecording(const std::wstring& path, const std::vector<Message>& messages);
+
+    static Message s_CreateObjectMessage(const ULONG_PTR process, const ULONG objectType);
+    static Message s_CloseObjectMessage(const ULONG_PTR process, const ULONG_PTR object);
+    static Message s_CreateApiMessage(const ULONG_PTR process,
+                                      const ULONG_PTR object,
+                                      const ULONG apiNumber,
+                                      const gsl::span<const std::byte> body,
+                                      const gsl::span<const std::byte> payload = {},
+                                      const ULONG outputSize = 0);
+
+    [[nodiscard]] HRESULT Replay();
+
+    const std::vector<Message>& GetMessages() const noexcept;
+    const std::map<ULONG, ApiStatistics>& GetStatistics() const noexcept;
+
+    [[nodiscard]] HRESULT SetServerInformation(_In_ CD_IO_SERVER_INFORMATION* const pServerInfo) const override;
+    [[nodiscard]] HRESULT ReadIo(_In_opt_ PCONSOLE_API_MSG const pReplyMsg,
+                                 _Out_ CONSOLE_API_MSG* const pMessage) const override;
+    [[nodiscard]] HRESULT CompleteIo(_In_ CD_IO_COMPLETE* const pCompletion) const override;
+
+    [[nodiscard]] HRESULT ReadInput(_In_ CD_IO_OPERATION* const pIoOperation) const override;
+    [[nodiscard]] HRESULT WriteOutput(_In_ CD_IO_OPERATION* const pIoOperation) const override;
+
+    [[nodiscard]] HRESULT AllowUIAccess() const override;
+
+    [[nodiscard]] ULONG_PTR PutHandle(const void*) override;
+    [[nodiscard]] void* GetHandle(ULONG_PTR) const override;
+
+    [[nodiscard]] HRESULT GetServerHandle(_Out_ HANDLE* pHandle) const override;
+
+private:
+    static const CD_IO_DESCRIPTOR& s_GetDescriptor(const Message& message) noexcept;
+    static ULONG s_GetApiNumber(const Message& message) noexcept;
+
+    [[nodiscard]] HRESULT _GetMessage(const LUID& identifier, _Outptr_ Message** ppMessage) const noexcept;
+
+    // The IDeviceComm methods are const, since the driver keeps the state of
+    // the session for ConDrvDeviceComm. Here, we're the driver.
+    // Just like the console driver's IO thread, this isn't safe to be used from multiple threads.
+    mutable std::vector<Message> _messages;
+    mutable std::vector<std::chrono::steady_clock::time_point> _started;
+    mutable std::map<ULONG, ApiStatistics> _statistics;
+    mutable size_t _next{ 0 };
+    std::vector<const void*> _handles;
+};
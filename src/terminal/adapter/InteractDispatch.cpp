@@ -6,7 +6,6 @@
 #include "InteractDispatch.hpp"
 #include "DispatchCommon.hpp"
 #include "conGetSet.hpp"
-#include "../../interactivity/inc/EventSynthesis.hpp"
 #include "../../types/inc/Viewport.hpp"
 #include "../../inc/unicode.hpp"
 
@@ -51,8 +50,9 @@ bool InteractDispatch::WriteCtrlKey(const KeyEvent& event)
 }
 
 // Method Description:
-// - Writes a string of input to the host. The string is converted to keystrokes
-//      that will faithfully represent the input by CharToKeyEvents.
+// - Writes a string of input to the host. The host stores the text as is and
+//      only converts it to keystrokes by CharToKeyEvents once a client reads
+//      input records, since stream reads can consume the text directly.
 // Arguments:
 // - string : a string to write to the console.
 // Return Value:
@@ -64,24 +64,7 @@ bool InteractDispatch::WriteString(const std::wstring_view string)
         return true;
     }
 
-    unsigned int codepage = 0;
-    bool success = _pConApi->GetConsoleOutputCP(codepage);
-    if (success)
-    {
-        std::deque<std::unique_ptr<IInputEvent>> keyEvents;
-
-        for (const auto& wch : string)
-        {
-            std::deque<std::unique_ptr<KeyEvent>> convertedEvents = Microsoft::Console::Interactivity::CharToKeyEvents(wch, codepage);
-
-            std::move(convertedEvents.begin(),
-                      convertedEvents.end(),
-                      std::back_inserter(keyEvents));
-        }
-
-        success = WriteInput(keyEvents);
-    }
-    return success;
+    return _pConApi->PrivateWriteConsoleTextInput(string);
 }
 
 //Method Description:
@@ -166,13 +149,12 @@ bool InteractDispatch::MoveCursor(const size_t row, const size_t col)
     if (success)
     {
         // First retrieve some information about the buffer
-        CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-        csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-        success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+        ScreenBufferState state{};
+        success = _pConApi->PrivateGetScreenBufferState(state);
 
         if (success)
         {
-            COORD coordCursor = csbiex.dwCursorPosition;
+            COORD coordCursor = state.cursorPosition;
 
             // Safely convert the size_t positions we were given into shorts (which is the size the console deals with)
             success = SUCCEEDED(SizeTToShort(rowFixed, &coordCursor.Y)) &&
@@ -181,14 +163,14 @@ bool InteractDispatch::MoveCursor(const size_t row, const size_t col)
             if (success)
             {
                 // Set the line and column values as offsets from the viewport edge. Use safe math to prevent overflow.
-                success = SUCCEEDED(ShortAdd(coordCursor.Y, csbiex.srWindow.Top, &coordCursor.Y)) &&
-                          SUCCEEDED(ShortAdd(coordCursor.X, csbiex.srWindow.Left, &coordCursor.X));
+                success = SUCCEEDED(ShortAdd(coordCursor.Y, state.viewport.Top, &coordCursor.Y)) &&
+                          SUCCEEDED(ShortAdd(coordCursor.X, state.viewport.Left, &coordCursor.X));
 
                 if (success)
                 {
                     // Apply boundary tests to ensure the cursor isn't outside the viewport rectangle.
-                    coordCursor.Y = std::clamp(coordCursor.Y, csbiex.srWindow.Top, gsl::narrow<SHORT>(csbiex.srWindow.Bottom - 1));
-                    coordCursor.X = std::clamp(coordCursor.X, csbiex.srWindow.Left, gsl::narrow<SHORT>(csbiex.srWindow.Right - 1));
+                    coordCursor.Y = std::clamp(coordCursor.Y, state.viewport.Top, gsl::narrow<SHORT>(state.viewport.Bottom - 1));
+                    coordCursor.X = std::clamp(coordCursor.X, state.viewport.Left, gsl::narrow<SHORT>(state.viewport.Right - 1));
 
                     // Finally, attempt to set the adjusted cursor position back into the console.
                     success = _pConApi->SetConsoleCursorPosition(coordCursor);
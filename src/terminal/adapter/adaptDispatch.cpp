@@ -178,18 +178,17 @@ bool AdaptDispatch::_CursorMovePosition(const Offset rowOffset, const Offset col
     bool success = true;
 
     // First retrieve some information about the buffer
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    ScreenBufferState state{};
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    success = (_pConApi->MoveToBottom() && _pConApi->PrivateGetScreenBufferState(state));
 
     if (success)
     {
         // Calculate the viewport boundaries as inclusive values.
-        // srWindow is exclusive so we need to subtract 1 from the bottom.
-        const int viewportTop = csbiex.srWindow.Top;
-        const int viewportBottom = csbiex.srWindow.Bottom - 1;
+        // The viewport is exclusive so we need to subtract 1 from the bottom.
+        const int viewportTop = state.viewport.Top;
+        const int viewportBottom = state.viewport.Bottom - 1;
 
         // Calculate the absolute margins of the scrolling area.
         const int topMargin = viewportTop + _scrollMargins.Top;
@@ -198,8 +197,8 @@ bool AdaptDispatch::_CursorMovePosition(const Offset rowOffset, const Offset col
 
         // For relative movement, the given offsets will be relative to
         // the current cursor position.
-        int row = csbiex.dwCursorPosition.Y;
-        int col = csbiex.dwCursorPosition.X;
+        int row = state.cursorPosition.Y;
+        int col = state.cursorPosition.X;
 
         // But if the row is absolute, it will be relative to the top of the
         // viewport, or the top margin, depending on the origin mode.
@@ -219,7 +218,7 @@ bool AdaptDispatch::_CursorMovePosition(const Offset rowOffset, const Offset col
         // The row is constrained within the viewport's vertical boundaries,
         // while the column is constrained by the buffer width.
         row = std::clamp(row + rowOffset.Value, viewportTop, viewportBottom);
-        col = std::clamp(col + colOffset.Value, 0, csbiex.dwSize.X - 1);
+        col = std::clamp(col + colOffset.Value, 0, state.bufferSize.X - 1);
 
         // If the operation needs to be clamped inside the margins, or the origin
         // mode is relative (which always requires margin clamping), then the row
@@ -234,11 +233,11 @@ bool AdaptDispatch::_CursorMovePosition(const Offset rowOffset, const Offset col
             // to the bottom margin. See
             // ScreenBufferTests::CursorUpDownOutsideMargins for a test of that
             // behavior.
-            if (csbiex.dwCursorPosition.Y >= topMargin)
+            if (state.cursorPosition.Y >= topMargin)
             {
                 row = std::max(row, topMargin);
             }
-            if (csbiex.dwCursorPosition.Y <= bottomMargin)
+            if (state.cursorPosition.Y <= bottomMargin)
             {
                 row = std::min(row, bottomMargin);
             }
@@ -321,11 +320,10 @@ bool AdaptDispatch::CursorPosition(const size_t line, const size_t column)
 bool AdaptDispatch::CursorSaveState()
 {
     // First retrieve some information about the buffer
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    ScreenBufferState state{};
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    bool success = (_pConApi->MoveToBottom() && _pConApi->PrivateGetScreenBufferState(state));
 
     TextAttribute attributes;
     success = success && (_pConApi->PrivateGetTextAttributes(attributes));
@@ -334,8 +332,8 @@ bool AdaptDispatch::CursorSaveState()
     {
         // The cursor is given to us by the API as relative to the whole buffer.
         // But in VT speak, the cursor row should be relative to the current viewport top.
-        COORD coordCursor = csbiex.dwCursorPosition;
-        coordCursor.Y -= csbiex.srWindow.Top;
+        COORD coordCursor = state.cursorPosition;
+        coordCursor.Y -= state.viewport.Top;
 
         // VT is also 1 based, not 0 based, so correct by 1.
         auto& savedCursorState = _savedCursorState.at(_usingAltBuffer);
@@ -423,14 +421,13 @@ bool AdaptDispatch::_InsertDeleteHelper(const size_t count, const bool isInsert)
     RETURN_BOOL_IF_FALSE(SUCCEEDED(SizeTToShort(count, &distance)));
 
     // get current cursor, attributes
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    ScreenBufferState state{};
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
     RETURN_BOOL_IF_FALSE(_pConApi->MoveToBottom());
-    RETURN_BOOL_IF_FALSE(_pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    RETURN_BOOL_IF_FALSE(_pConApi->PrivateGetScreenBufferState(state));
 
-    const auto cursor = csbiex.dwCursorPosition;
+    const auto cursor = state.cursorPosition;
     // Rectangle to cut out of the existing buffer. This is inclusive.
     SMALL_RECT srScroll;
     srScroll.Left = cursor.X;
@@ -492,13 +489,13 @@ bool AdaptDispatch::DeleteCharacter(const size_t count)
 // - Internal helper to erase one particular line of the buffer. Either from beginning to the cursor, from the cursor to the end, or the entire line.
 // - Used by both erase line (used just once) and by erase screen (used in a loop) to erase a portion of the buffer.
 // Arguments:
-// - csbiex - Pointer to the console screen buffer that we will be erasing (and getting cursor data from within)
+// - state - The state of the screen buffer that we will be erasing (and getting cursor data from within)
 // - eraseType - Enumeration mode of which kind of erase to perform: beginning to cursor, cursor to end, or entire line.
 // - lineId - The line number (array index value, starts at 0) of the line to operate on within the buffer.
 //           - This is not aware of circular buffer. Line 0 is always the top visible line if you scrolled the whole way up the window.
 // Return Value:
 // - True if handled successfully. False otherwise.
-bool AdaptDispatch::_EraseSingleLineHelper(const CONSOLE_SCREEN_BUFFER_INFOEX& csbiex,
+bool AdaptDispatch::_EraseSingleLineHelper(const ScreenBufferState& state,
                                            const DispatchTypes::EraseType eraseType,
                                            const size_t lineId) const
 {
@@ -517,7 +514,7 @@ bool AdaptDispatch::_EraseSingleLineHelper(const CONSOLE_SCREEN_BUFFER_INFOEX& c
         coordStartPosition.X = 0; // from beginning and the whole line start from the left most edge of the buffer.
         break;
     case DispatchTypes::EraseType::ToEnd:
-        coordStartPosition.X = csbiex.dwCursorPosition.X; // from the current cursor position (including it)
+        coordStartPosition.X = state.cursorPosition.X; // from the current cursor position (including it)
         break;
     }
 
@@ -528,7 +525,7 @@ bool AdaptDispatch::_EraseSingleLineHelper(const CONSOLE_SCREEN_BUFFER_INFOEX& c
     {
     case DispatchTypes::EraseType::FromBeginning:
         // +1 because if cursor were at the left edge, the length would be 0 and we want to paint at least the 1 character the cursor is on.
-        nLength = csbiex.dwCursorPosition.X + 1;
+        nLength = state.cursorPosition.X + 1;
         break;
     case DispatchTypes::EraseType::ToEnd:
     case DispatchTypes::EraseType::All:
@@ -541,6 +538,37 @@ bool AdaptDispatch::_EraseSingleLineHelper(const CONSOLE_SCREEN_BUFFER_INFOEX& c
     return _pConApi->PrivateFillRegion(coordStartPosition, nLength, L' ', true);
 }
 
+// Routine Description:
+// - Internal helper to erase a range of entire lines of the buffer at once.
+// - The lines must have been reset to single width beforehand, so that they
+//   span the full width of the buffer and form one contiguous region.
+// Arguments:
+// - state - The state of the screen buffer that we will be erasing
+// - startLine - The first line to erase
+// - endLine - The line after the last one to erase
+// Return Value:
+// - True if handled successfully. False otherwise.
+bool AdaptDispatch::_EraseLinesHelper(const ScreenBufferState& state,
+                                      const size_t startLine,
+                                      const size_t endLine) const
+{
+    if (startLine >= endLine)
+    {
+        return true;
+    }
+
+    COORD coordStartPosition = { 0 };
+    if (FAILED(SizeTToShort(startLine, &coordStartPosition.Y)))
+    {
+        return false;
+    }
+
+    const auto nLength = (endLine - startLine) * gsl::narrow_cast<size_t>(state.bufferSize.X);
+
+    // Note that the region is filled with the standard erase attributes.
+    return _pConApi->PrivateFillRegion(coordStartPosition, nLength, L' ', true);
+}
+
 // Routine Description:
 // - ECH - Erase Characters from the current cursor position, by replacing
 //     them with a space. This will only erase characters in the current line,
@@ -552,15 +580,14 @@ bool AdaptDispatch::_EraseSingleLineHelper(const CONSOLE_SCREEN_BUFFER_INFOEX& c
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::EraseCharacters(const size_t numChars)
 {
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    ScreenBufferState state{};
+    bool success = _pConApi->PrivateGetScreenBufferState(state);
 
     if (success)
     {
-        const COORD startPosition = csbiex.dwCursorPosition;
+        const COORD startPosition = state.cursorPosition;
 
-        const SHORT remainingSpaces = csbiex.dwSize.X - startPosition.X;
+        const SHORT remainingSpaces = state.bufferSize.X - startPosition.X;
         const size_t actualRemaining = gsl::narrow_cast<size_t>((remainingSpaces < 0) ? 0 : remainingSpaces);
         // erase at max the number of characters remaining in the line from the current position.
         const auto eraseLength = (numChars <= actualRemaining) ? numChars : actualRemaining;
@@ -613,11 +640,10 @@ bool AdaptDispatch::EraseInDisplay(const DispatchTypes::EraseType eraseType)
         return eraseAllResult && (!isPty);
     }
 
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    ScreenBufferState state{};
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    bool success = (_pConApi->MoveToBottom() && _pConApi->PrivateGetScreenBufferState(state));
 
     if (success)
     {
@@ -629,13 +655,13 @@ bool AdaptDispatch::EraseInDisplay(const DispatchTypes::EraseType eraseType)
         // the line is double width).
         if (eraseType == DispatchTypes::EraseType::FromBeginning)
         {
-            const auto endRow = csbiex.dwCursorPosition.Y;
-            _pConApi->PrivateResetLineRenditionRange(csbiex.srWindow.Top, endRow);
+            const auto endRow = state.cursorPosition.Y;
+            _pConApi->PrivateResetLineRenditionRange(state.viewport.Top, endRow);
         }
         if (eraseType == DispatchTypes::EraseType::ToEnd)
         {
-            const auto startRow = csbiex.dwCursorPosition.Y + (csbiex.dwCursorPosition.X > 0 ? 1 : 0);
-            _pConApi->PrivateResetLineRenditionRange(startRow, csbiex.srWindow.Bottom);
+            const auto startRow = state.cursorPosition.Y + (state.cursorPosition.X > 0 ? 1 : 0);
+            _pConApi->PrivateResetLineRenditionRange(startRow, state.viewport.Bottom);
         }
 
         // What we need to erase is grouped into 3 types:
@@ -651,21 +677,14 @@ bool AdaptDispatch::EraseInDisplay(const DispatchTypes::EraseType eraseType)
         if (eraseType == DispatchTypes::EraseType::FromBeginning)
         {
             // For beginning and all, erase all complete lines before (above vertically) from the cursor position.
-            for (SHORT startLine = csbiex.srWindow.Top; startLine < csbiex.dwCursorPosition.Y; startLine++)
-            {
-                success = _EraseSingleLineHelper(csbiex, DispatchTypes::EraseType::All, startLine);
-
-                if (!success)
-                {
-                    break;
-                }
-            }
+            // They were reset to single width above and can be erased all at once.
+            success = _EraseLinesHelper(state, state.viewport.Top, state.cursorPosition.Y);
         }
 
         if (success)
         {
             // 2. Cursor Line
-            success = _EraseSingleLineHelper(csbiex, eraseType, csbiex.dwCursorPosition.Y);
+            success = _EraseSingleLineHelper(state, eraseType, state.cursorPosition.Y);
         }
 
         if (success)
@@ -675,15 +694,8 @@ bool AdaptDispatch::EraseInDisplay(const DispatchTypes::EraseType eraseType)
             {
                 // For beginning and all, erase all complete lines after (below vertically) the cursor position.
                 // Remember that the viewport bottom value is 1 beyond the viewable area of the viewport.
-                for (SHORT startLine = csbiex.dwCursorPosition.Y + 1; startLine < csbiex.srWindow.Bottom; startLine++)
-                {
-                    success = _EraseSingleLineHelper(csbiex, DispatchTypes::EraseType::All, startLine);
-
-                    if (!success)
-                    {
-                        break;
-                    }
-                }
+                // They were reset to single width above and can be erased all at once.
+                success = _EraseLinesHelper(state, state.cursorPosition.Y + 1, state.viewport.Bottom);
             }
         }
     }
@@ -701,13 +713,12 @@ bool AdaptDispatch::EraseInLine(const DispatchTypes::EraseType eraseType)
 {
     RETURN_BOOL_IF_FALSE(eraseType <= DispatchTypes::EraseType::All);
 
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    ScreenBufferState state{};
+    bool success = _pConApi->PrivateGetScreenBufferState(state);
 
     if (success)
     {
-        success = _EraseSingleLineHelper(csbiex, eraseType, csbiex.dwCursorPosition.Y);
+        success = _EraseSingleLineHelper(state, eraseType, state.cursorPosition.Y);
     }
 
     return success;
@@ -855,19 +866,18 @@ bool AdaptDispatch::_OperatingStatus() const
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::_CursorPositionReport() const
 {
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    ScreenBufferState state{};
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    bool success = (_pConApi->MoveToBottom() && _pConApi->PrivateGetScreenBufferState(state));
 
     if (success)
     {
         // First pull the cursor position relative to the entire buffer out of the console.
-        COORD coordCursorPos = csbiex.dwCursorPosition;
+        COORD coordCursorPos = state.cursorPosition;
 
         // Now adjust it for its position in respect to the current viewport top.
-        coordCursorPos.Y -= csbiex.srWindow.Top;
+        coordCursorPos.Y -= state.viewport.Top;
 
         // NOTE: 1,1 is the top-left corner of the viewport in VT-speak, so add 1.
         coordCursorPos.X++;
@@ -946,11 +956,10 @@ bool AdaptDispatch::_ScrollMovement(const ScrollDirection scrollDirection, const
     if (success)
     {
         // get current cursor
-        CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-        csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+        ScreenBufferState state{};
         // Make sure to reset the viewport (with MoveToBottom )to where it was
         //      before the user scrolled the console output
-        success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+        success = (_pConApi->MoveToBottom() && _pConApi->PrivateGetScreenBufferState(state));
 
         if (success)
         {
@@ -959,13 +968,13 @@ bool AdaptDispatch::_ScrollMovement(const ScrollDirection scrollDirection, const
             SMALL_RECT srScreen;
             srScreen.Left = 0;
             srScreen.Right = SHORT_MAX;
-            srScreen.Top = csbiex.srWindow.Top;
-            srScreen.Bottom = csbiex.srWindow.Bottom - 1; // srWindow is exclusive, hence the - 1
+            srScreen.Top = state.viewport.Top;
+            srScreen.Bottom = state.viewport.Bottom - 1; // the viewport is exclusive, hence the - 1
             // Clip to the DECSTBM margin boundaries
             if (_scrollMargins.Top < _scrollMargins.Bottom)
             {
-                srScreen.Top = csbiex.srWindow.Top + _scrollMargins.Top;
-                srScreen.Bottom = csbiex.srWindow.Top + _scrollMargins.Bottom;
+                srScreen.Top = state.viewport.Top + _scrollMargins.Top;
+                srScreen.Bottom = state.viewport.Top + _scrollMargins.Bottom;
             }
 
             // Paste coordinate for cut text above
@@ -1328,11 +1337,10 @@ bool AdaptDispatch::SetAutoWrapMode(const bool wrapAtEOL)
 bool AdaptDispatch::_DoSetTopBottomScrollingMargins(const size_t topMargin,
                                                     const size_t bottomMargin)
 {
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    ScreenBufferState state{};
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    bool success = (_pConApi->MoveToBottom() && _pConApi->PrivateGetScreenBufferState(state));
 
     // so notes time: (input -> state machine out -> adapter out -> conhost internal)
     // having only a top param is legal         ([3;r   -> 3,0   -> 3,h  -> 3,h,true)
@@ -1346,7 +1354,7 @@ bool AdaptDispatch::_DoSetTopBottomScrollingMargins(const size_t topMargin,
         success = SUCCEEDED(SizeTToShort(topMargin, &actualTop)) && SUCCEEDED(SizeTToShort(bottomMargin, &actualBottom));
         if (success)
         {
-            const SHORT screenHeight = csbiex.srWindow.Bottom - csbiex.srWindow.Top;
+            const SHORT screenHeight = state.viewport.Bottom - state.viewport.Top;
             // The default top margin is line 1
             if (actualTop == 0)
             {
@@ -1523,13 +1531,12 @@ bool AdaptDispatch::UseMainScreenBuffer()
 // True if handled successfully. False otherwise.
 bool AdaptDispatch::HorizontalTabSet()
 {
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    const bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    ScreenBufferState state{};
+    const bool success = _pConApi->PrivateGetScreenBufferState(state);
     if (success)
     {
-        const auto width = csbiex.dwSize.X;
-        const auto column = csbiex.dwCursorPosition.X;
+        const auto width = state.bufferSize.X;
+        const auto column = state.cursorPosition.X;
 
         _InitTabStopsForWidth(width);
         _tabStopColumns.at(column) = true;
@@ -1548,14 +1555,13 @@ bool AdaptDispatch::HorizontalTabSet()
 // True if handled successfully. False otherwise.
 bool AdaptDispatch::ForwardTab(const size_t numTabs)
 {
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    ScreenBufferState state{};
+    bool success = _pConApi->PrivateGetScreenBufferState(state);
     if (success)
     {
-        const auto width = csbiex.dwSize.X;
-        const auto row = csbiex.dwCursorPosition.Y;
-        auto column = csbiex.dwCursorPosition.X;
+        const auto width = state.bufferSize.X;
+        const auto row = state.cursorPosition.Y;
+        auto column = state.cursorPosition.X;
         auto tabsPerformed = 0u;
 
         _InitTabStopsForWidth(width);
@@ -1582,14 +1588,13 @@ bool AdaptDispatch::ForwardTab(const size_t numTabs)
 // True if handled successfully. False otherwise.
 bool AdaptDispatch::BackwardsTab(const size_t numTabs)
 {
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    ScreenBufferState state{};
+    bool success = _pConApi->PrivateGetScreenBufferState(state);
     if (success)
     {
-        const auto width = csbiex.dwSize.X;
-        const auto row = csbiex.dwCursorPosition.Y;
-        auto column = csbiex.dwCursorPosition.X;
+        const auto width = state.bufferSize.X;
+        const auto row = state.cursorPosition.Y;
+        auto column = state.cursorPosition.X;
         auto tabsPerformed = 0u;
 
         _InitTabStopsForWidth(width);
@@ -1641,13 +1646,12 @@ bool AdaptDispatch::TabClear(const DispatchTypes::TabClearType clearType)
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::_ClearSingleTabStop()
 {
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    const bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    ScreenBufferState state{};
+    const bool success = _pConApi->PrivateGetScreenBufferState(state);
     if (success)
     {
-        const auto width = csbiex.dwSize.X;
-        const auto column = csbiex.dwCursorPosition.X;
+        const auto width = state.bufferSize.X;
+        const auto column = state.cursorPosition.X;
 
         _InitTabStopsForWidth(width);
         _tabStopColumns.at(column) = false;
@@ -1956,20 +1960,19 @@ bool AdaptDispatch::HardReset()
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::ScreenAlignmentPattern()
 {
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    ScreenBufferState state{};
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = _pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    bool success = _pConApi->MoveToBottom() && _pConApi->PrivateGetScreenBufferState(state);
 
     if (success)
     {
         // Fill the screen with the letter E using the default attributes.
-        auto fillPosition = COORD{ 0, csbiex.srWindow.Top };
-        const auto fillLength = (csbiex.srWindow.Bottom - csbiex.srWindow.Top) * csbiex.dwSize.X;
+        auto fillPosition = COORD{ 0, state.viewport.Top };
+        const auto fillLength = (state.viewport.Bottom - state.viewport.Top) * state.bufferSize.X;
         success = _pConApi->PrivateFillRegion(fillPosition, fillLength, L'E', false);
         // Reset the line rendition for all of these rows.
-        success = success && _pConApi->PrivateResetLineRenditionRange(csbiex.srWindow.Top, csbiex.srWindow.Bottom);
+        success = success && _pConApi->PrivateResetLineRenditionRange(state.viewport.Top, state.viewport.Bottom);
         // Reset the meta/extended attributes (but leave the colors unchanged).
         TextAttribute attr;
         if (_pConApi->PrivateGetTextAttributes(attr))
@@ -2002,17 +2005,16 @@ bool AdaptDispatch::ScreenAlignmentPattern()
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::_EraseScrollback()
 {
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(csbiex);
+    ScreenBufferState state{};
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = (_pConApi->GetConsoleScreenBufferInfoEx(csbiex) && _pConApi->MoveToBottom());
+    bool success = (_pConApi->PrivateGetScreenBufferState(state) && _pConApi->MoveToBottom());
     if (success)
     {
-        const SMALL_RECT screen = csbiex.srWindow;
+        const SMALL_RECT screen = state.viewport;
         const SHORT height = screen.Bottom - screen.Top;
         FAIL_FAST_IF(!(height > 0));
-        const COORD cursor = csbiex.dwCursorPosition;
+        const COORD cursor = state.cursorPosition;
 
         // Rectangle to cut out of the existing buffer
         // It will be clipped to the buffer boundaries so SHORT_MAX gives us the full buffer width.
@@ -2030,12 +2032,12 @@ bool AdaptDispatch::_EraseScrollback()
         if (success)
         {
             // Clear everything after the viewport.
-            const DWORD totalAreaBelow = csbiex.dwSize.X * (csbiex.dwSize.Y - height);
+            const DWORD totalAreaBelow = state.bufferSize.X * (state.bufferSize.Y - height);
             const COORD coordBelowStartPosition = { 0, height };
             // Again we need to use the default attributes, hence standardFillAttrs is false.
             success = _pConApi->PrivateFillRegion(coordBelowStartPosition, totalAreaBelow, L' ', false);
             // Also reset the line rendition for all of the cleared rows.
-            success = success && _pConApi->PrivateResetLineRenditionRange(height, csbiex.dwSize.Y);
+            success = success && _pConApi->PrivateResetLineRenditionRange(height, state.bufferSize.Y);
 
             if (success)
             {
@@ -2650,9 +2652,8 @@ void AdaptDispatch::_ReportDECSTBMSetting() const
     // A valid response always starts with DCS 1 $ r.
     std::wstring response = L"\033P1$r";
 
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    if (_pConApi->GetConsoleScreenBufferInfoEx(csbiex))
+    ScreenBufferState state{};
+    if (_pConApi->PrivateGetScreenBufferState(state))
     {
         auto marginTop = _scrollMargins.Top + 1;
         auto marginBottom = _scrollMargins.Bottom + 1;
@@ -2662,7 +2663,7 @@ void AdaptDispatch::_ReportDECSTBMSetting() const
         if (marginTop >= marginBottom)
         {
             marginTop = 1;
-            marginBottom = csbiex.srWindow.Bottom - csbiex.srWindow.Top;
+            marginBottom = state.viewport.Bottom - state.viewport.Top;
         }
         const auto iterator = std::back_insert_iterator(response);
         fmt::format_to(iterator, FMT_STRING(L"{};{}"), marginTop, marginBottom);
@@ -169,9 +169,12 @@ namespace Microsoft::Console::VirtualTerminal
         };
 
         bool _CursorMovePosition(const Offset rowOffset, const Offset colOffset, const bool clampInMargins) const;
-        bool _EraseSingleLineHelper(const CONSOLE_SCREEN_BUFFER_INFOEX& csbiex,
+        bool _EraseSingleLineHelper(const ScreenBufferState& state,
                                     const DispatchTypes::EraseType eraseType,
                                     const size_t lineId) const;
+        bool _EraseLinesHelper(const ScreenBufferState& state,
+                               const size_t startLine,
+                               const size_t endLine) const;
         bool _EraseScrollback();
         bool _EraseAll();
         bool _InsertDeleteHelper(const size_t count, const bool isInsert) const;
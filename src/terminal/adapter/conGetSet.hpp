@@ -25,12 +25,22 @@ Author(s):
 
 namespace Microsoft::Console::VirtualTerminal
 {
+    // The parts of CONSOLE_SCREEN_BUFFER_INFOEX that cursor movement and
+    // erase operations need, without the color table and window metrics.
+    struct ScreenBufferState
+    {
+        COORD bufferSize;
+        COORD cursorPosition;
+        SMALL_RECT viewport; // Right and Bottom are exclusive, just like in srWindow
+    };
+
     class ConGetSet
     {
     public:
         virtual ~ConGetSet() = default;
         virtual bool GetConsoleScreenBufferInfoEx(CONSOLE_SCREEN_BUFFER_INFOEX& screenBufferInfo) const = 0;
         virtual bool SetConsoleScreenBufferInfoEx(const CONSOLE_SCREEN_BUFFER_INFOEX& screenBufferInfo) = 0;
+        virtual bool PrivateGetScreenBufferState(ScreenBufferState& state) const = 0;
         virtual bool SetConsoleCursorPosition(const COORD position) = 0;
 
         virtual bool PrivateIsVtInputEnabled() const = 0;
@@ -44,6 +54,7 @@ namespace Microsoft::Console::VirtualTerminal
 
         virtual bool PrivateWriteConsoleInputW(std::deque<std::unique_ptr<IInputEvent>>& events,
                                                size_t& eventsWritten) = 0;
+        virtual bool PrivateWriteConsoleTextInput(const std::wstring_view text) = 0;
         virtual bool SetConsoleWindowInfo(const bool absolute,
                                           const SMALL_RECT& window) = 0;
         virtual bool PrivateSetCursorKeysMode(const bool applicationMode) = 0;
@@ -85,6 +85,19 @@ public:
         }
         return _setConsoleScreenBufferInfoExResult;
     }
+    bool PrivateGetScreenBufferState(ScreenBufferState& state) const override
+    {
+        Log::Comment(L"PrivateGetScreenBufferState MOCK returning data...");
+
+        if (_getConsoleScreenBufferInfoExResult)
+        {
+            state.bufferSize = _bufferSize;
+            state.viewport = _viewport;
+            state.cursorPosition = _cursorPos;
+        }
+
+        return _getConsoleScreenBufferInfoExResult;
+    }
     bool SetConsoleCursorPosition(const COORD position) override
     {
         Log::Comment(L"SetConsoleCursorPosition MOCK called...");
@@ -269,6 +282,18 @@ public:
         return _privateWriteConsoleInputWResult;
     }
 
+    bool PrivateWriteConsoleTextInput(const std::wstring_view text) override
+    {
+        Log::Comment(L"PrivateWriteConsoleTextInput MOCK called...");
+
+        if (_privateWriteConsoleTextInputResult)
+        {
+            _textInput.append(text);
+        }
+
+        return _privateWriteConsoleTextInputResult;
+    }
+
     bool PrivateWriteConsoleControlInput(_In_ KeyEvent key) override
     {
         Log::Comment(L"PrivateWriteConsoleControlInput MOCK called...");
@@ -620,6 +645,7 @@ public:
         _privateGetTextAttributesResult = TRUE;
         _privateSetTextAttributesResult = TRUE;
         _privateWriteConsoleInputWResult = TRUE;
+        _privateWriteConsoleTextInputResult = TRUE;
         _privateWriteConsoleControlInputResult = TRUE;
         _setConsoleWindowInfoResult = TRUE;
         _moveToBottomResult = true;
@@ -643,6 +669,7 @@ public:
         _expectedAttribute = _attribute;
 
         _events.clear();
+        _textInput.clear();
         _retainInput = false;
     }
 
@@ -745,6 +772,7 @@ public:
     static const WORD s_defaultFill = FOREGROUND_BLUE | FOREGROUND_GREEN | FOREGROUND_RED; // dark gray on black.
 
     std::deque<std::unique_ptr<IInputEvent>> _events;
+    std::wstring _textInput;
     bool _retainInput{ false };
 
     auto EnableInputRetentionInScope()
@@ -779,6 +807,7 @@ public:
     bool _privateGetTextAttributesResult = false;
     bool _privateSetTextAttributesResult = false;
     bool _privateWriteConsoleInputWResult = false;
+    bool _privateWriteConsoleTextInputResult = false;
     bool _privateWriteConsoleControlInputResult = false;
 
     bool _setConsoleWindowInfoResult = false;
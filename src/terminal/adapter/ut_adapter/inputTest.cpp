@@ -46,6 +46,8 @@ public:
     TEST_METHOD(TerminalInputNullKeyTests);
     TEST_METHOD(DifferentModifiersTest);
     TEST_METHOD(CtrlNumTest);
+    TEST_METHOD(KeySequenceTablesMatchMappings);
+    TEST_METHOD(KeyEncodingBenchmark);
 
     wchar_t GetModifierChar(const bool fShift, const bool fAlt, const bool fCtrl)
     {
@@ -739,3 +741,217 @@ void InputTest::CtrlNumTest()
     s_expectedInput = L"9";
     TestKey(pInput, uiKeystate, vkey);
 }
+
+// The key mappings as they were before they got turned into lookup tables,
+// searched linearly just like TerminalInput used to do it.
+using ReferenceKeyMap = std::tuple<WORD, DWORD, std::wstring_view>;
+
+// These are prefixed with CSI or SS3 in ANSI mode, and just ESC in VT52 mode.
+static const std::vector<ReferenceKeyMap> s_referenceCursorKeys{
+    { VK_UP, 0, L"A" },
+    { VK_DOWN, 0, L"B" },
+    { VK_RIGHT, 0, L"C" },
+    { VK_LEFT, 0, L"D" },
+    { VK_HOME, 0, L"H" },
+    { VK_END, 0, L"F" },
+};
+
+static const std::vector<ReferenceKeyMap> s_referenceKeypadKeys{
+    { VK_TAB, 0, L"\x09" },
+    { VK_BACK, 0, L"\x7f" },
+    { VK_PAUSE, 0, L"\x1a" },
+    { VK_ESCAPE, 0, L"\x1b" },
+    { VK_INSERT, 0, L"\x1b[2~" },
+    { VK_DELETE, 0, L"\x1b[3~" },
+    { VK_PRIOR, 0, L"\x1b[5~" },
+    { VK_NEXT, 0, L"\x1b[6~" },
+    { VK_F5, 0, L"\x1b[15~" },
+    { VK_F6, 0, L"\x1b[17~" },
+    { VK_F7, 0, L"\x1b[18~" },
+    { VK_F8, 0, L"\x1b[19~" },
+    { VK_F9, 0, L"\x1b[20~" },
+    { VK_F10, 0, L"\x1b[21~" },
+    { VK_F11, 0, L"\x1b[23~" },
+    { VK_F12, 0, L"\x1b[24~" },
+};
+
+// These are prefixed with SS3 in ANSI mode, and just ESC in VT52 mode.
+static const std::vector<ReferenceKeyMap> s_referenceFunctionKeys{
+    { VK_F1, 0, L"P" },
+    { VK_F2, 0, L"Q" },
+    { VK_F3, 0, L"R" },
+    { VK_F4, 0, L"S" },
+};
+
+static const std::vector<ReferenceKeyMap> s_referenceModifierKeys{
+    { VK_UP, 0, L"\x1b[1;mA" },
+    { VK_DOWN, 0, L"\x1b[1;mB" },
+    { VK_RIGHT, 0, L"\x1b[1;mC" },
+    { VK_LEFT, 0, L"\x1b[1;mD" },
+    { VK_HOME, 0, L"\x1b[1;mH" },
+    { VK_END, 0, L"\x1b[1;mF" },
+    { VK_F1, 0, L"\x1b[1;mP" },
+    { VK_F2, 0, L"\x1b[1;mQ" },
+    { VK_F3, 0, L"\x1b[1;mR" },
+    { VK_F4, 0, L"\x1b[1;mS" },
+    { VK_INSERT, 0, L"\x1b[2;m~" },
+    { VK_DELETE, 0, L"\x1b[3;m~" },
+    { VK_PRIOR, 0, L"\x1b[5;m~" },
+    { VK_NEXT, 0, L"\x1b[6;m~" },
+    { VK_F5, 0, L"\x1b[15;m~" },
+    { VK_F6, 0, L"\x1b[17;m~" },
+    { VK_F7, 0, L"\x1b[18;m~" },
+    { VK_F8, 0, L"\x1b[19;m~" },
+    { VK_F9, 0, L"\x1b[20;m~" },
+    { VK_F10, 0, L"\x1b[21;m~" },
+    { VK_F11, 0, L"\x1b[23;m~" },
+    { VK_F12, 0, L"\x1b[24;m~" },
+};
+
+static const std::vector<ReferenceKeyMap> s_referenceSimpleModifiedKeys{
+    { VK_BACK, CTRL_PRESSED, L"\x8" },
+    { VK_BACK, ALT_PRESSED, L"\x1b\x7f" },
+    { VK_BACK, CTRL_PRESSED | ALT_PRESSED, L"\x1b\x8" },
+    { VK_TAB, CTRL_PRESSED, L"\t" },
+    { VK_TAB, SHIFT_PRESSED, L"\x1b[Z" },
+    { VK_DIVIDE, CTRL_PRESSED, L"\x1F" },
+    { static_cast<WORD>('1'), CTRL_PRESSED, L"1" },
+    { static_cast<WORD>('3'), CTRL_PRESSED, L"\x1B" },
+    { static_cast<WORD>('4'), CTRL_PRESSED, L"\x1C" },
+    { static_cast<WORD>('5'), CTRL_PRESSED, L"\x1D" },
+    { static_cast<WORD>('6'), CTRL_PRESSED, L"\x1E" },
+    { static_cast<WORD>('7'), CTRL_PRESSED, L"\x1F" },
+    { static_cast<WORD>('8'), CTRL_PRESSED, L"\x7F" },
+    { static_cast<WORD>('9'), CTRL_PRESSED, L"9" },
+};
+
+static std::optional<std::wstring_view> s_SearchReferenceKeys(const std::vector<ReferenceKeyMap>& keys, const WORD vkey, const DWORD modifiers)
+{
+    for (const auto& [mapVkey, mapModifiers, sequence] : keys)
+    {
+        if (mapVkey == vkey &&
+            (WI_AreAllFlagsClear(mapModifiers, MOD_PRESSED) ||
+             ((WI_IsFlagSet(mapModifiers, SHIFT_PRESSED) == WI_IsFlagSet(modifiers, SHIFT_PRESSED)) &&
+              (WI_IsAnyFlagSet(mapModifiers, ALT_PRESSED) == WI_IsAnyFlagSet(modifiers, ALT_PRESSED)) &&
+              (WI_IsAnyFlagSet(mapModifiers, CTRL_PRESSED) == WI_IsAnyFlagSet(modifiers, CTRL_PRESSED)))))
+        {
+            return sequence;
+        }
+    }
+    return std::nullopt;
+}
+
+void InputTest::KeySequenceTablesMatchMappings()
+{
+    Log::Comment(L"Comparing the default sequences of every key in every mode.");
+    for (const auto ansiMode : { false, true })
+    {
+        for (const auto cursorApplicationMode : { false, true })
+        {
+            for (const auto keypadApplicationMode : { false, true })
+            {
+                for (WORD vkey = 0; vkey <= 0x1ff; ++vkey)
+                {
+                    std::wstring expected;
+                    if (const auto cursorKey = s_SearchReferenceKeys(s_referenceCursorKeys, vkey, 0))
+                    {
+                        expected = !ansiMode ? L"\x1b" : cursorApplicationMode ? L"\x1bO" : L"\x1b[";
+                        expected += *cursorKey;
+                    }
+                    else if (const auto functionKey = s_SearchReferenceKeys(s_referenceFunctionKeys, vkey, 0))
+                    {
+                        expected = ansiMode ? L"\x1bO" : L"\x1b";
+                        expected += *functionKey;
+                    }
+                    else if (const auto keypadKey = s_SearchReferenceKeys(s_referenceKeypadKeys, vkey, 0))
+                    {
+                        expected = *keypadKey;
+                    }
+
+                    const auto actual = TerminalInput::_LookupDefaultSequence(vkey, ansiMode, cursorApplicationMode, keypadApplicationMode);
+                    VERIFY_ARE_EQUAL(std::wstring_view{ expected }, actual, NoThrowString().Format(L"vkey 0x%x, ANSI %d, cursor keys %d, keypad %d", vkey, ansiMode, cursorApplicationMode, keypadApplicationMode));
+                }
+            }
+        }
+    }
+
+    Log::Comment(L"Comparing the modified sequences of every key with every combination of modifiers.");
+    for (DWORD modifiers = 0; modifiers <= (SHIFT_PRESSED | ALT_PRESSED | CTRL_PRESSED); ++modifiers)
+    {
+        for (WORD vkey = 0; vkey <= 0x1ff; ++vkey)
+        {
+            std::wstring expected;
+            if (WI_IsAnyFlagSet(modifiers, MOD_PRESSED))
+            {
+                if (const auto modifierKey = s_SearchReferenceKeys(s_referenceModifierKeys, vkey, modifiers))
+                {
+                    expected = *modifierKey;
+                    expected.at(expected.size() - 2) = GetModifierChar(ShiftPressed(modifiers), AltPressed(modifiers), ControlPressed(modifiers));
+                }
+                else if (const auto simpleKey = s_SearchReferenceKeys(s_referenceSimpleModifiedKeys, vkey, modifiers))
+                {
+                    expected = *simpleKey;
+                }
+            }
+
+            const auto actual = TerminalInput::_LookupModifiedSequence(vkey, modifiers);
+            VERIFY_ARE_EQUAL(std::wstring_view{ expected }, actual, NoThrowString().Format(L"vkey 0x%x, modifiers 0x%x", vkey, modifiers));
+        }
+    }
+}
+
+void InputTest::KeyEncodingBenchmark()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    Log::Comment(L"Encodes 100K key presses of cursor, function and modified keys, like auto-repeat does.");
+
+    constexpr size_t iterations = 100000;
+    constexpr std::array<std::pair<WORD, DWORD>, 6> keys{ {
+        { VK_UP, 0 },
+        { VK_F5, 0 },
+        { VK_DELETE, 0 },
+        { VK_LEFT, LEFT_CTRL_PRESSED },
+        { VK_F12, SHIFT_PRESSED | LEFT_ALT_PRESSED },
+        { VK_BACK, LEFT_CTRL_PRESSED },
+    } };
+
+    std::vector<std::unique_ptr<IInputEvent>> events;
+    for (const auto& [vkey, modifiers] : keys)
+    {
+        INPUT_RECORD irTest = { 0 };
+        irTest.EventType = KEY_EVENT;
+        irTest.Event.KeyEvent.wRepeatCount = 1;
+        irTest.Event.KeyEvent.wVirtualKeyCode = vkey;
+        irTest.Event.KeyEvent.bKeyDown = TRUE;
+        irTest.Event.KeyEvent.dwControlKeyState = modifiers;
+        events.emplace_back(IInputEvent::Create(irTest));
+    }
+
+    size_t handled = 0;
+    size_t written = 0;
+    TerminalInput input{ [&](std::deque<std::unique_ptr<IInputEvent>>& inEvents) { written += inEvents.size(); } };
+
+    for (const auto win32InputMode : { false, true })
+    {
+        input.ChangeWin32InputMode(win32InputMode);
+        handled = 0;
+        written = 0;
+
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            handled += input.HandleKey(events[i % events.size()].get());
+        }
+        const auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+        VERIFY_ARE_EQUAL(iterations, handled);
+        Log::Comment(NoThrowString().Format(L"%s: %zu keys encoded as %zu characters in %.2f ms",
+                                            win32InputMode ? L"win32-input-mode" : L"VT",
+                                            iterations,
+                                            written,
+                                            delta * 1000.0));
+    }
+}
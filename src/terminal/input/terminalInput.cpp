@@ -274,231 +274,266 @@ void TerminalInput::ForceDisableWin32InputMode(const bool win32InputMode) noexce
     _forceDisableWin32InputMode = win32InputMode;
 }
 
-static const gsl::span<const TermKeyMap> _getKeyMapping(const KeyEvent& keyEvent,
-                                                        const bool ansiMode,
-                                                        const bool cursorApplicationMode,
-                                                        const bool keypadApplicationMode) noexcept
+// Virtual key codes are all less than 256, which makes them perfect indices into the tables below.
+static constexpr size_t s_vkeyCount = 256;
+
+// A VT sequence stored by value, so that the key tables can be generated at compile time.
+struct KeySequence
 {
-    if (ansiMode)
+    std::array<wchar_t, 8> chars{};
+    size_t length{ 0 };
+
+    constexpr KeySequence() = default;
+
+    constexpr KeySequence(const std::wstring_view sequence) :
+        length{ sequence.size() }
     {
-        if (keyEvent.IsCursorKey())
+        for (size_t i = 0; i < sequence.size(); ++i)
         {
-            if (cursorApplicationMode)
-            {
-                return { s_cursorKeysApplicationMapping.data(), s_cursorKeysApplicationMapping.size() };
-            }
-            else
-            {
-                return { s_cursorKeysNormalMapping.data(), s_cursorKeysNormalMapping.size() };
-            }
+            // at() fails the compilation if a sequence doesn't fit.
+            chars.at(i) = sequence[i];
         }
-        else
+    }
+
+    constexpr std::wstring_view view() const noexcept
+    {
+        return { chars.data(), length };
+    }
+};
+
+// Maps every virtual key of every mode to the sequence it produces.
+// The indices are 1 higher than the index of the sequence, with 0 meaning that there's none.
+template<size_t Modes, size_t Sequences>
+struct KeySequenceTable
+{
+    static_assert(Sequences < UINT8_MAX);
+
+    std::array<std::array<uint8_t, s_vkeyCount>, Modes> indices{};
+    std::array<KeySequence, Sequences> sequences{};
+    size_t count{ 0 };
+
+    constexpr void Add(const size_t mode, const WORD vkey, const KeySequence& sequence)
+    {
+        // Just like the linear searches these tables replaced, the first mapping of a key wins.
+        auto& index = indices.at(mode).at(vkey);
+        if (index == 0)
         {
-            if (keypadApplicationMode)
-            {
-                return { s_keypadApplicationMapping.data(), s_keypadApplicationMapping.size() };
-            }
-            else
-            {
-                return { s_keypadNumericMapping.data(), s_keypadNumericMapping.size() };
-            }
+            sequences.at(count) = sequence;
+            index = gsl::narrow_cast<uint8_t>(++count);
         }
     }
-    else
+
+    std::wstring_view Get(const size_t mode, const WORD vkey) const noexcept
     {
-        if (keyEvent.IsCursorKey())
+        if (vkey >= s_vkeyCount)
         {
-            return { s_cursorKeysVt52Mapping.data(), s_cursorKeysVt52Mapping.size() };
+            return {};
         }
-        else
+
+        const auto index = til::at(til::at(indices, mode), vkey);
+        return index ? til::at(sequences, index - 1u).view() : std::wstring_view{};
+    }
+};
+
+// The modes the default sequences depend on: VT52, or ANSI with every
+// combination of the cursor key and keypad application modes.
+static constexpr size_t s_defaultSequenceModes = 5;
+
+static constexpr size_t _getDefaultSequenceMode(const bool ansiMode,
+                                                const bool cursorApplicationMode,
+                                                const bool keypadApplicationMode) noexcept
+{
+    return ansiMode ? 1 + (cursorApplicationMode ? 2 : 0) + (keypadApplicationMode ? 1 : 0) : 0;
+}
+
+// Cursor keys and keypad keys don't overlap, so both tables of a mode can share its row.
+static constexpr auto s_defaultSequences = []() {
+    KeySequenceTable<s_defaultSequenceModes, s_defaultSequenceModes * (s_cursorKeysNormalMapping.size() + s_keypadNumericMapping.size())> table;
+
+    for (size_t mode = 0; mode < s_defaultSequenceModes; ++mode)
+    {
+        const auto ansiMode = mode != 0;
+        const auto cursorApplicationMode = ansiMode && ((mode - 1) & 2) != 0;
+        const auto keypadApplicationMode = ansiMode && ((mode - 1) & 1) != 0;
+
+        const auto& cursorKeys = !ansiMode ? s_cursorKeysVt52Mapping : cursorApplicationMode ? s_cursorKeysApplicationMapping : s_cursorKeysNormalMapping;
+        const auto& keypadKeys = !ansiMode ? s_keypadVt52Mapping : keypadApplicationMode ? s_keypadApplicationMapping : s_keypadNumericMapping;
+
+        for (const auto& map : cursorKeys)
+        {
+            table.Add(mode, map.vkey, map.sequence);
+        }
+        for (const auto& map : keypadKeys)
         {
-            return { s_keypadVt52Mapping.data(), s_keypadVt52Mapping.size() };
+            table.Add(mode, map.vkey, map.sequence);
         }
     }
+
+    return table;
+}();
+
+// The modified sequences are indexed by the combination of Shift (1), Alt (2) and Ctrl (4).
+// Coincidentally, this combination + 1 is also the modifier parameter of a modified sequence.
+static constexpr size_t s_modifiedSequenceModes = 8;
+
+static constexpr size_t _getModifiedSequenceMode(const DWORD modifiers) noexcept
+{
+    return (WI_IsFlagSet(modifiers, SHIFT_PRESSED) ? 1 : 0) +
+           (WI_IsAnyFlagSet(modifiers, ALT_PRESSED) ? 2 : 0) +
+           (WI_IsAnyFlagSet(modifiers, CTRL_PRESSED) ? 4 : 0);
 }
 
+static constexpr auto s_modifiedSequences = []() {
+    KeySequenceTable<s_modifiedSequenceModes, (s_modifiedSequenceModes - 1) * s_modifierKeyMapping.size() + s_simpleModifiedKeyMapping.size()> table;
+
+    // s_modifierKeyMapping applies to any modifiers and takes precedence
+    // over s_simpleModifiedKeyMapping. The 'm' in its sequences is replaced
+    // with a character indicating which modifier keys are pressed.
+    for (size_t mode = 1; mode < s_modifiedSequenceModes; ++mode)
+    {
+        for (const auto& map : s_modifierKeyMapping)
+        {
+            KeySequence sequence{ map.sequence };
+            sequence.chars.at(sequence.length - 2) = gsl::narrow_cast<wchar_t>(L'1' + mode);
+            table.Add(mode, map.vkey, sequence);
+        }
+    }
+
+    // These only apply to the exact modifiers they list.
+    for (const auto& map : s_simpleModifiedKeyMapping)
+    {
+        table.Add(_getModifiedSequenceMode(map.modifiers), map.vkey, map.sequence);
+    }
+
+    return table;
+}();
+
 // Routine Description:
-// - Searches the keyMapping for a entry corresponding to this key event, and returns it.
+// - Looks up the sequence for a key, which is sent no matter which modifiers are pressed.
 // Arguments:
-// - keyEvent - Key event to translate
-// - keyMapping - Array of key mappings to search
+// - vkey - The virtual key code of the key
+// - ansiMode - false if the terminal is in VT52 mode
+// - cursorApplicationMode - true if the cursor keys are in application mode
+// - keypadApplicationMode - true if the keypad is in application mode
 // Return Value:
-// - Has value if there was a match to a key translation.
-static std::optional<const TermKeyMap> _searchKeyMapping(const KeyEvent& keyEvent,
-                                                         gsl::span<const TermKeyMap> keyMapping) noexcept
+// - The sequence for the key, or an empty one if there's no mapping for it.
+std::wstring_view TerminalInput::_LookupDefaultSequence(const WORD vkey,
+                                                        const bool ansiMode,
+                                                        const bool cursorApplicationMode,
+                                                        const bool keypadApplicationMode) noexcept
 {
-    for (auto& map : keyMapping)
-    {
-        if (map.vkey == keyEvent.GetVirtualKeyCode())
-        {
-            // If the mapping has no modifiers set, then it doesn't really care
-            //      what the modifiers are on the key. The caller will likely do
-            //      something with them.
-            // However, if there are modifiers set, then we only want to match
-            //      if the key's modifiers are the same as the modifiers in the
-            //      mapping.
-            bool modifiersMatch = WI_AreAllFlagsClear(map.modifiers, MOD_PRESSED);
-            if (!modifiersMatch)
-            {
-                // The modifier mapping expects certain modifier keys to be
-                //      pressed. Check those as well.
-                modifiersMatch =
-                    (WI_IsFlagSet(map.modifiers, SHIFT_PRESSED) == keyEvent.IsShiftPressed()) &&
-                    (WI_IsAnyFlagSet(map.modifiers, ALT_PRESSED) == keyEvent.IsAltPressed()) &&
-                    (WI_IsAnyFlagSet(map.modifiers, CTRL_PRESSED) == keyEvent.IsCtrlPressed());
-            }
+    return s_defaultSequences.Get(_getDefaultSequenceMode(ansiMode, cursorApplicationMode, keypadApplicationMode), vkey);
+}
 
-            if (modifiersMatch)
-            {
-                return map;
-            }
-        }
-    }
-    return std::nullopt;
+// Routine Description:
+// - Looks up the sequence for a key that's pressed together with modifier keys.
+// Arguments:
+// - vkey - The virtual key code of the key
+// - modifiers - The control key state of the key event
+// Return Value:
+// - The sequence for the key, or an empty one if there's no mapping for it.
+std::wstring_view TerminalInput::_LookupModifiedSequence(const WORD vkey, const DWORD modifiers) noexcept
+{
+    return s_modifiedSequences.Get(_getModifiedSequenceMode(modifiers), vkey);
 }
 
 typedef std::function<void(const std::wstring_view)> InputSender;
 
 // Routine Description:
-// - Searches the s_modifierKeyMapping for a entry corresponding to this key event.
-//      Changes the second to last byte to correspond to the currently pressed modifier keys
-//      before sending to the input.
+// - Looks up the sequence for a key event with modifier keys pressed and
+//      sends it to the input.
 // Arguments:
 // - keyEvent - Key event to translate
 // - sender - Function to use to dispatch translated event
 // Return Value:
-// - True if there was a match to a key translation, and we successfully modified and sent it to the input
+// - True if there was a match to a key translation, and we successfully sent it to the input
 static bool _searchWithModifier(const KeyEvent& keyEvent, InputSender sender)
 {
     bool success = false;
 
-    const auto match = _searchKeyMapping(keyEvent,
-                                         { s_modifierKeyMapping.data(), s_modifierKeyMapping.size() });
-    if (match)
+    const auto sequence = s_modifiedSequences.Get(_getModifiedSequenceMode(keyEvent.GetActiveModifierKeys()), keyEvent.GetVirtualKeyCode());
+    if (!sequence.empty())
     {
-        const auto& v = match.value();
-        if (!v.sequence.empty())
-        {
-            std::wstring modified{ v.sequence }; // Make a copy so we can modify it.
-            const bool shift = keyEvent.IsShiftPressed();
-            const bool alt = keyEvent.IsAltPressed();
-            const bool ctrl = keyEvent.IsCtrlPressed();
-            modified.at(modified.size() - 2) = L'1' + (shift ? 1 : 0) + (alt ? 2 : 0) + (ctrl ? 4 : 0);
-            sender(modified);
-            success = true;
-        }
+        sender(sequence);
+        success = true;
     }
     else
     {
-        // We didn't find the key in the map of modified keys that need editing,
-        //      maybe it's in the other map of modified keys with sequences that
-        //      don't need editing before sending.
-        const auto match2 = _searchKeyMapping(keyEvent,
-                                              { s_simpleModifiedKeyMapping.data(), s_simpleModifiedKeyMapping.size() });
-        if (match2)
+        // One last check:
+        // * C-/ is supposed to be ^_ (the C0 character US)
+        // * C-? is supposed to be DEL
+        // * C-M-/ is supposed to be ^[^_
+        // * C-M-? is supposed to be ^[^?
+        //
+        // But this whole scenario is tricky. '/' is not the same VKEY on
+        // all keyboards. On USASCII keyboards, '/' and '?' share the _same_
+        // key. So we have to figure out the vkey at runtime, and we have to
+        // determine if the key that was pressed was '?' with some
+        // modifiers, or '/' with some modifiers.
+        //
+        // These translations are not in s_simpleModifiedKeyMapping, because
+        // the aforementioned fact that they aren't the same VKEY on all
+        // keyboards.
+        //
+        // See GH#3079 for details.
+        // Also see https://github.com/microsoft/terminal/pull/4947#issuecomment-600382856
+
+        // VkKeyScan will give us both the Vkey of the key needed for this
+        // character, and the modifiers the user might need to press to get
+        // this character.
+        const auto slashKeyScan = VkKeyScan(L'/'); // On USASCII: 0x00bf
+        const auto questionMarkKeyScan = VkKeyScan(L'?'); //On USASCII: 0x01bf
+
+        const auto slashVkey = LOBYTE(slashKeyScan);
+        const auto questionMarkVkey = LOBYTE(questionMarkKeyScan);
+
+        const auto ctrl = keyEvent.IsCtrlPressed();
+        const auto alt = keyEvent.IsAltPressed();
+        const bool shift = keyEvent.IsShiftPressed();
+
+        // From the KeyEvent we're translating, synthesize the equivalent VkKeyScan result
+        const auto vkey = keyEvent.GetVirtualKeyCode();
+        const short keyScanFromEvent = vkey |
+                                       (shift ? 0x100 : 0) |
+                                       (ctrl ? 0x200 : 0) |
+                                       (alt ? 0x400 : 0);
+
+        // Make sure the VKEY is an _exact_ match, and that the modifier
+        // bits also match. This handles the hypothetical case we get a
+        // keyscan back that's ctrl+alt+some_random_VK, and some_random_VK
+        // has bits that are a superset of the bits set for question mark.
+        const bool wasQuestionMark = vkey == questionMarkVkey && WI_AreAllFlagsSet(keyScanFromEvent, questionMarkKeyScan);
+        const bool wasSlash = vkey == slashVkey && WI_AreAllFlagsSet(keyScanFromEvent, slashKeyScan);
+
+        // If the key pressed was exactly the ? key, then try to send the
+        // appropriate sequence for a modified '?'. Otherwise, check if this
+        // was a modified '/' keypress. These mappings don't need to be
+        // changed at all.
+        if ((ctrl && alt) && wasQuestionMark)
         {
-            // This mapping doesn't need to be changed at all.
-            sender(match2.value().sequence);
+            sender(CTRL_ALT_QUESTIONMARK_SEQUENCE);
             success = true;
         }
-        else
+        else if (ctrl && wasQuestionMark)
         {
-            // One last check:
-            // * C-/ is supposed to be ^_ (the C0 character US)
-            // * C-? is supposed to be DEL
-            // * C-M-/ is supposed to be ^[^_
-            // * C-M-? is supposed to be ^[^?
-            //
-            // But this whole scenario is tricky. '/' is not the same VKEY on
-            // all keyboards. On USASCII keyboards, '/' and '?' share the _same_
-            // key. So we have to figure out the vkey at runtime, and we have to
-            // determine if the key that was pressed was '?' with some
-            // modifiers, or '/' with some modifiers.
-            //
-            // These translations are not in s_simpleModifiedKeyMapping, because
-            // the aforementioned fact that they aren't the same VKEY on all
-            // keyboards.
-            //
-            // See GH#3079 for details.
-            // Also see https://github.com/microsoft/terminal/pull/4947#issuecomment-600382856
-
-            // VkKeyScan will give us both the Vkey of the key needed for this
-            // character, and the modifiers the user might need to press to get
-            // this character.
-            const auto slashKeyScan = VkKeyScan(L'/'); // On USASCII: 0x00bf
-            const auto questionMarkKeyScan = VkKeyScan(L'?'); //On USASCII: 0x01bf
-
-            const auto slashVkey = LOBYTE(slashKeyScan);
-            const auto questionMarkVkey = LOBYTE(questionMarkKeyScan);
-
-            const auto ctrl = keyEvent.IsCtrlPressed();
-            const auto alt = keyEvent.IsAltPressed();
-            const bool shift = keyEvent.IsShiftPressed();
-
-            // From the KeyEvent we're translating, synthesize the equivalent VkKeyScan result
-            const auto vkey = keyEvent.GetVirtualKeyCode();
-            const short keyScanFromEvent = vkey |
-                                           (shift ? 0x100 : 0) |
-                                           (ctrl ? 0x200 : 0) |
-                                           (alt ? 0x400 : 0);
-
-            // Make sure the VKEY is an _exact_ match, and that the modifier
-            // bits also match. This handles the hypothetical case we get a
-            // keyscan back that's ctrl+alt+some_random_VK, and some_random_VK
-            // has bits that are a superset of the bits set for question mark.
-            const bool wasQuestionMark = vkey == questionMarkVkey && WI_AreAllFlagsSet(keyScanFromEvent, questionMarkKeyScan);
-            const bool wasSlash = vkey == slashVkey && WI_AreAllFlagsSet(keyScanFromEvent, slashKeyScan);
-
-            // If the key pressed was exactly the ? key, then try to send the
-            // appropriate sequence for a modified '?'. Otherwise, check if this
-            // was a modified '/' keypress. These mappings don't need to be
-            // changed at all.
-            if ((ctrl && alt) && wasQuestionMark)
-            {
-                sender(CTRL_ALT_QUESTIONMARK_SEQUENCE);
-                success = true;
-            }
-            else if (ctrl && wasQuestionMark)
-            {
-                sender(CTRL_QUESTIONMARK_SEQUENCE);
-                success = true;
-            }
-            else if ((ctrl && alt) && wasSlash)
-            {
-                sender(CTRL_ALT_SLASH_SEQUENCE);
-                success = true;
-            }
-            else if (ctrl && wasSlash)
-            {
-                sender(CTRL_SLASH_SEQUENCE);
-                success = true;
-            }
+            sender(CTRL_QUESTIONMARK_SEQUENCE);
+            success = true;
+        }
+        else if ((ctrl && alt) && wasSlash)
+        {
+            sender(CTRL_ALT_SLASH_SEQUENCE);
+            success = true;
+        }
+        else if (ctrl && wasSlash)
+        {
+            sender(CTRL_SLASH_SEQUENCE);
+            success = true;
         }
     }
 
     return success;
 }
 
-// Routine Description:
-// - Searches the input array of mappings, and sends it to the input if a match was found.
-// Arguments:
-// - keyEvent - Key event to translate
-// - keyMapping - Array of key mappings to search
-// - sender - Function to use to dispatch translated event
-// Return Value:
-// - True if there was a match to a key translation, and we successfully sent it to the input
-static bool _translateDefaultMapping(const KeyEvent& keyEvent,
-                                     const gsl::span<const TermKeyMap> keyMapping,
-                                     InputSender sender)
-{
-    const auto match = _searchKeyMapping(keyEvent, keyMapping);
-    if (match)
-    {
-        sender(match->sequence);
-    }
-    return match.has_value();
-}
-
 // Routine Description:
 // - Sends the given input event to the shell.
 // - The caller should attempt to fill the char data in pInEvent if possible.
@@ -532,8 +567,8 @@ bool TerminalInput::HandleKey(const IInputEvent* const pInEvent)
     // Only do this if win32-input-mode support isn't manually disabled.
     if (_win32InputMode && !_forceDisableWin32InputMode)
     {
-        const auto seq = _GenerateWin32KeySequence(keyEvent);
-        _SendInputSequence(seq);
+        Win32KeySequenceBuffer buffer;
+        _SendInputSequence(_GenerateWin32KeySequence(keyEvent, buffer));
         return true;
     }
 
@@ -655,9 +690,10 @@ bool TerminalInput::HandleKey(const IInputEvent* const pInEvent)
     // Check any other key mappings (like those for the F1-F12 keys).
     // These mappings will kick in no matter which modifiers are pressed and as such
     // must be checked last, or otherwise we'd override more complex key combinations.
-    const auto mapping = _getKeyMapping(keyEvent, _ansiMode, _cursorApplicationMode, _keypadApplicationMode);
-    if (_translateDefaultMapping(keyEvent, mapping, senderFunc))
+    const auto sequence = _LookupDefaultSequence(keyEvent.GetVirtualKeyCode(), _ansiMode, _cursorApplicationMode, _keypadApplicationMode);
+    if (!sequence.empty())
     {
+        _SendInputSequence(sequence);
         return true;
     }
 
@@ -767,9 +803,10 @@ void TerminalInput::_SendInputSequence(const std::wstring_view sequence) const n
 // - Synthesize a win32-input-mode sequence for the given keyevent.
 // Arguments:
 // - key: the KeyEvent to serialize.
+// - buffer: the storage for the sequence, so that none needs to be allocated.
 // Return Value:
-// - the formatted string representation of this key
-std::wstring TerminalInput::_GenerateWin32KeySequence(const KeyEvent& key)
+// - the formatted string representation of this key, stored in buffer
+std::wstring_view TerminalInput::_GenerateWin32KeySequence(const KeyEvent& key, Win32KeySequenceBuffer& buffer)
 {
     // Sequences are formatted as follows:
     //
@@ -782,11 +819,14 @@ std::wstring TerminalInput::_GenerateWin32KeySequence(const KeyEvent& key)
     //      Kd: the value of bKeyDown - either a '0' or '1'. If omitted, defaults to '0'.
     //      Cs: the value of dwControlKeyState - any number. If omitted, defaults to '0'.
     //      Rc: the value of wRepeatCount - any number. If omitted, defaults to '1'.
-    return fmt::format(FMT_COMPILE(L"\x1b[{};{};{};{};{};{}_"),
-                       key.GetVirtualKeyCode(),
-                       key.GetVirtualScanCode(),
-                       static_cast<int>(key.GetCharData()),
-                       key.IsKeyDown() ? 1 : 0,
-                       key.GetActiveModifierKeys(),
-                       key.GetRepeatCount());
+    const auto result = fmt::format_to_n(buffer.data(),
+                                         buffer.size(),
+                                         FMT_COMPILE(L"\x1b[{};{};{};{};{};{}_"),
+                                         key.GetVirtualKeyCode(),
+                                         key.GetVirtualScanCode(),
+                                         static_cast<int>(key.GetCharData()),
+                                         key.IsKeyDown() ? 1 : 0,
+                                         key.GetActiveModifierKeys(),
+                                         key.GetRepeatCount());
+    return { buffer.data(), std::min(result.size, buffer.size()) };
 }
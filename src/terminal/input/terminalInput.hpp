@@ -90,7 +90,16 @@ namespace Microsoft::Console::VirtualTerminal
         void _SendNullInputSequence(const DWORD dwControlKeyState) const;
         void _SendInputSequence(const std::wstring_view sequence) const noexcept;
         void _SendEscapedInputSequence(const wchar_t wch) const;
-        static std::wstring _GenerateWin32KeySequence(const KeyEvent& key);
+
+        // Large enough for "\x1b[65535;65535;65535;1;4294967295;65535_".
+        using Win32KeySequenceBuffer = std::array<wchar_t, 48>;
+        static std::wstring_view _GenerateWin32KeySequence(const KeyEvent& key, Win32KeySequenceBuffer& buffer);
+
+        static std::wstring_view _LookupDefaultSequence(const WORD vkey,
+                                                        const bool ansiMode,
+                                                        const bool cursorApplicationMode,
+                                                        const bool keypadApplicationMode) noexcept;
+        static std::wstring_view _LookupModifiedSequence(const WORD vkey, const DWORD modifiers) noexcept;
 
 #pragma region MouseInputState Management
         // These methods are defined in mouseInputState.cpp
@@ -147,5 +156,9 @@ namespace Microsoft::Console::VirtualTerminal
 
         static constexpr unsigned int s_GetPressedButton(const MouseButtonState state) noexcept;
 #pragma endregion
+
+#ifdef UNIT_TESTING
+        friend class InputTest;
+#endif
     };
 }
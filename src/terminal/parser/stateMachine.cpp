@@ -374,6 +374,83 @@ static constexpr bool _isActionableFromGround(const wchar_t wch) noexcept
 
 #pragma warning(pop)
 
+// Routine Description:
+// - Finds the first character at or after the given offset which is actionable
+//     from the ground state (see _isActionableFromGround). Everything before it
+//     is a printable run which can be handed to the engine as a whole.
+// - This is the hottest loop of the parser when processing plain text output,
+//     which is why it checks 16 (AVX2) or 8 (SSE2) characters at a time.
+// Arguments:
+// - string - Characters to scan.
+// - offset - Index of the first character to scan.
+// Return Value:
+// - The index of the first actionable character, or string.size() if there's none.
+static size_t _findActionableFromGround(const std::wstring_view string, const size_t offset) noexcept
+{
+    static_assert(sizeof(wchar_t) == 2, "The vectorized code broke. If you can't fix wchar_t, just remove the vectorized code.");
+
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+    const auto beg = string.data();
+    const auto end = beg + string.size();
+    auto it = beg + offset;
+
+    // A character is actionable if it's a C0 control character (<= 0x1F),
+    // DEL (0x7F) or a C1 control character (0x80-0x9F). Neither SSE2 nor AVX2
+    // have an unsigned 16-bit comparison, but saturating subtraction does the trick:
+    // * wch <= 0x1F         <=> subs_epu16(wch, 0x1F) == 0
+    // * 0x7F <= wch <= 0x9F <=> subs_epu16(wch - 0x7F, 0x20) == 0
+    //   (wch - 0x7F wraps around for wch < 0x7F and thus never saturates to 0)
+    // The comparison results in 0xffff per matching character. movemask then
+    // yields 2 bits per character, so the bit index has to be divided by 2.
+#ifdef __AVX2__
+    const auto zero = _mm256_setzero_si256();
+    const auto c0Max = _mm256_set1_epi16(0x1F);
+    const auto delMin = _mm256_set1_epi16(0x7F);
+    const auto delRange = _mm256_set1_epi16(0x20);
+
+    for (; end - it >= 16; it += 16)
+    {
+        const auto wch = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+        const auto isC0 = _mm256_cmpeq_epi16(_mm256_subs_epu16(wch, c0Max), zero);
+        const auto isC1 = _mm256_cmpeq_epi16(_mm256_subs_epu16(_mm256_sub_epi16(wch, delMin), delRange), zero);
+        const auto mask = static_cast<unsigned long>(_mm256_movemask_epi8(_mm256_or_si256(isC0, isC1)));
+        unsigned long index;
+        if (_BitScanForward(&index, mask))
+        {
+            return gsl::narrow_cast<size_t>(it - beg) + index / 2;
+        }
+    }
+#elif defined(_M_AMD64) || defined(_M_IX86)
+    const auto zero = _mm_setzero_si128();
+    const auto c0Max = _mm_set1_epi16(0x1F);
+    const auto delMin = _mm_set1_epi16(0x7F);
+    const auto delRange = _mm_set1_epi16(0x20);
+
+    for (; end - it >= 8; it += 8)
+    {
+        const auto wch = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+        const auto isC0 = _mm_cmpeq_epi16(_mm_subs_epu16(wch, c0Max), zero);
+        const auto isC1 = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(wch, delMin), delRange), zero);
+        const auto mask = static_cast<unsigned long>(_mm_movemask_epi8(_mm_or_si128(isC0, isC1)));
+        unsigned long index;
+        if (_BitScanForward(&index, mask))
+        {
+            return gsl::narrow_cast<size_t>(it - beg) + index / 2;
+        }
+    }
+#endif
+
+    // Scalar fallback for the remaining tail (or everything on ARM64).
+    for (; it != end && !_isActionableFromGround(*it); ++it)
+    {
+    }
+
+    return gsl::narrow_cast<size_t>(it - beg);
+#pragma warning(pop)
+}
+
 // Routine Description:
 // - Triggers the Execute action to indicate that the listener should immediately respond to a C0 control character.
 // Arguments:
@@ -1863,14 +1940,17 @@ void StateMachine::ProcessString(const std::wstring_view string)
         }
         else
         {
-            if (_isActionableFromGround(til::at(string, current))) // If the current char is the start of an escape sequence, or should be executed in ground state...
+            // Add all printable chars up to the next one that's the start of an
+            // escape sequence, or should be executed in ground state, to the run.
+            current = _findActionableFromGround(string, current);
+            if (current < string.size())
             {
+                // The run above was composed INCLUDING the char we started
+                // scanning from, so recompute it to end right before the
+                // actionable char and only pass through everything before it.
+                _runSize = current - start;
                 if (_runSize > 0)
                 {
-                    // Because the run above is composed INCLUDING current, we must
-                    // trim it off here since we just determined it's actionable
-                    // and only pass through everything before it.
-                    _runSize -= 1;
                     const auto allLeadingUpTo = _CurrentRun();
 
                     _engine->ActionPrintString(allLeadingUpTo); // ... print all the chars leading up to it as part of the run...
@@ -1879,11 +1959,6 @@ void StateMachine::ProcessString(const std::wstring_view string)
 
                 _processingIndividually = true; // begin processing future characters individually...
                 start = current;
-                continue;
-            }
-            else
-            {
-                ++current; // Otherwise, add this char to the current run to be printed.
             }
         }
     }
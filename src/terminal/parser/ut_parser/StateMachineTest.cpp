@@ -159,9 +159,12 @@ class Microsoft::Console::VirtualTerminal::StateMachineTest
     TEST_METHOD(PassThroughUnhandled);
     TEST_METHOD(RunStorageBeforeEscape);
     TEST_METHOD(BulkTextPrint);
+    TEST_METHOD(BulkTextPrintStopsAtActionableChars);
     TEST_METHOD(PassThroughUnhandledSplitAcrossWrites);
 
     TEST_METHOD(DcsDataStringsReceivedByHandler);
+
+    TEST_METHOD(ParserThroughputBenchmark);
 };
 
 void StateMachineTest::TwoStateMachinesDoNotInterfereWithEachother()
@@ -234,6 +237,91 @@ void StateMachineTest::BulkTextPrint()
     VERIFY_ARE_EQUAL(String(L"12345 Hello World"), String(engine.printed.c_str()));
 }
 
+void StateMachineTest::BulkTextPrintStopsAtActionableChars()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // The ground state scanner checks up to 16 chars at a time. Place the
+    // char under test at every offset of a string that's long enough to
+    // cover the vectorized blocks as well as the scalar tail.
+    constexpr size_t length = 41;
+    const std::wstring_view actionable{ L"\x07\x0a\x1f\x7f" };
+    const std::wstring_view printable{ L"\x20\x7e\xa0\xffff" };
+
+    for (size_t offset = 0; offset < length; ++offset)
+    {
+        for (const auto wch : actionable)
+        {
+            std::wstring text(length, L'a');
+            text[offset] = wch;
+
+            engine.ResetTestState();
+            machine.ProcessString(text);
+
+            VERIFY_ARE_EQUAL(std::wstring(length - 1, L'a'), engine.printed);
+            VERIFY_ARE_EQUAL(std::wstring(1, wch), engine.executed);
+        }
+
+        for (const auto wch : printable)
+        {
+            std::wstring text(length, L'a');
+            text[offset] = wch;
+
+            engine.ResetTestState();
+            machine.ProcessString(text);
+
+            VERIFY_ARE_EQUAL(text, engine.printed);
+            VERIFY_ARE_EQUAL(L"", engine.executed);
+        }
+    }
+
+    // C1 controls are the range where the vectorized classifier's wrap-around
+    // trick can disagree with the scalar check, so they get the same treatment,
+    // with runs of non-ASCII printable chars leading up to them as well.
+    // They're turned into ESC + their 7-bit equivalent, which these are
+    // simple escape sequences for and which thus don't print or execute.
+    const std::wstring_view c1Controls{ L"\x80\x85\x8d\x9c" };
+    const std::wstring_view fillers{ L"a\xe9\x3042" };
+
+    for (const auto filler : fillers)
+    {
+        for (size_t offset = 0; offset < length; ++offset)
+        {
+            for (const auto wch : c1Controls)
+            {
+                std::wstring text(length, filler);
+                text[offset] = wch;
+
+                engine.ResetTestState();
+                machine.ProcessString(text);
+
+                VERIFY_ARE_EQUAL(std::wstring(length - 1, filler), engine.printed);
+                VERIFY_ARE_EQUAL(L"", engine.executed);
+            }
+        }
+    }
+
+    Log::Comment(L"A CSI introduced by a C1 control right after a vector boundary is dispatched.");
+    for (const auto offset : { 7u, 8u, 15u, 16u, 31u, 32u })
+    {
+        std::wstring text(length, L'a');
+        text[offset] = L'\x9b';
+        text[offset + 1] = L'3';
+        text[offset + 2] = L'm';
+
+        engine.ResetTestState();
+        machine.ProcessString(text);
+
+        VERIFY_ARE_EQUAL(std::wstring(length - 3, L'a'), engine.printed);
+        VERIFY_ARE_EQUAL(VTID("m"), engine.csiId);
+        VERIFY_ARE_EQUAL(1u, engine.csiParams.size());
+        VERIFY_ARE_EQUAL(3u, engine.csiParams.at(0));
+    }
+}
+
 void StateMachineTest::PassThroughUnhandledSplitAcrossWrites()
 {
     auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
@@ -342,3 +430,48 @@ void StateMachineTest::DcsDataStringsReceivedByHandler()
     // Verify the control characters were executed (if expected).
     VERIFY_ARE_EQUAL(expectedExecuted, engine.executed);
 }
+
+void StateMachineTest::ParserThroughputBenchmark()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // Every workload is repeated until it's roughly 16 MB large.
+    constexpr size_t targetSize = 16 * 1024 * 1024;
+    const auto repeat = [](const std::wstring_view line) {
+        std::wstring text;
+        text.reserve(targetSize / sizeof(wchar_t) + line.size());
+        while (text.size() * sizeof(wchar_t) < targetSize)
+        {
+            text.append(line);
+        }
+        return text;
+    };
+
+    const std::pair<std::wstring_view, std::wstring> workloads[]{
+        { L"plain text", repeat(L"[ 42%] Building CXX object src/buffer/out/CMakeFiles/textBuffer.cpp.obj -- the quick brown fox jumps over the lazy dog\r\n") },
+        { L"SGR heavy", repeat(L"\x1b[1;31merror\x1b[m: \x1b[38;5;208mC4996\x1b[39m in \x1b[4m\x1b[38;2;97;214;214mfile.cpp\x1b[24;39m(\x1b[33m42\x1b[m)\r\n") },
+        { L"cursor movement heavy", repeat(L"\x1b[12;34H#\x1b[K\x1b[2A\x1b[5C%\x1b[1B\x1b[3D@\x1b[?25l\x1b[H\x1b[2J\x1b[24;1H$\x1b[?25h") },
+    };
+
+    for (const auto& [name, text] : workloads)
+    {
+        // Warm up the caches (and the engine's string buffers) before measuring.
+        machine.ProcessString(text);
+        engine.ResetTestState();
+
+        const auto now = std::chrono::steady_clock::now();
+        machine.ProcessString(text);
+        const auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+        engine.ResetTestState();
+
+        const auto megabytes = static_cast<double>(text.size() * sizeof(wchar_t)) / (1024.0 * 1024.0);
+        Log::Comment(String().Format(L"%s: %.1f MB in %.1f ms -> %.1f MB/s", name.data(), megabytes, delta * 1000.0, megabytes / delta));
+    }
+}
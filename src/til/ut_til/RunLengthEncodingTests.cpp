@@ -6,6 +6,9 @@
 #include "til/rle.h"
 #include "consoletaeftemplates.hpp"
 
+#include <chrono>
+#include <random>
+
 using namespace std::literals;
 using namespace WEX::Common;
 using namespace WEX::Logging;
@@ -429,6 +432,176 @@ class RunLengthEncodingTests
         }
     }
 
+    TEST_METHOD(Apply)
+    {
+        using edit = rle_vector::edit;
+
+        struct TestCase
+        {
+            std::string_view source;
+            std::vector<edit> edits;
+            std::string_view expected;
+        };
+
+        const std::array<TestCase, 8> test_cases{
+            {
+                // empty source
+                { "", {}, "" },
+                // no edits
+                { "1|3 3|2|1 1 1|5 5", {}, "1|3 3|2|1 1 1|5 5" },
+                // beginning, middle and end
+                { "1|3 3|2|1 1 1|5 5", { { 0, 1, 6 }, { 3, 4, 7 }, { 7, 9, 8 } }, "6|3 3|7|1 1 1|8 8" },
+                // join with predecessor/successor runs
+                { "1|3 3|2|1 1 1|5 5", { { 1, 3, 1 }, { 3, 4, 1 } }, "1 1 1 1 1 1 1|5 5" },
+                // several edits within a single run
+                { "1 1 1 1 1", { { 1, 2, 2 }, { 3, 4, 3 } }, "1|2|1|3|1" },
+                // adjacent edits with the same value
+                { "1 1|2 2", { { 0, 2, 3 }, { 2, 4, 3 } }, "3 3 3 3" },
+                // empty edit
+                { "1 1|2 2", { { 1, 1, 3 }, { 2, 3, 4 } }, "1 1|4|2" },
+                // end_index past the end
+                { "1 1 1", { { 1, 2, 2 }, { 2, 10, 3 } }, "1|2|3" },
+            }
+        };
+
+        int idx = 0;
+
+        for (const auto& test_case : test_cases)
+        {
+            rle_vector rle{ rle_encode(test_case.source) };
+            rle.apply(test_case.edits);
+
+            VERIFY_ARE_EQUAL(
+                test_case.expected,
+                rle,
+                NoThrowString().Format(
+                    L"test case: %d\nsource:    %hs\nexpected:  %hs\nactual:    %s",
+                    idx,
+                    test_case.source.data(),
+                    test_case.expected.data(),
+                    rle.to_string().c_str()));
+
+            ++idx;
+        }
+
+        Log::Comment(L"apply() returns whether any value changed.");
+        {
+            rle_vector rle{ rle_encode("1 1|2 2"sv) };
+            VERIFY_IS_FALSE(rle.apply(std::vector<edit>{ { 0, 1, 1 }, { 2, 4, 2 } }));
+            VERIFY_IS_TRUE(rle.apply(std::vector<edit>{ { 0, 1, 1 }, { 2, 3, 1 } }));
+            VERIFY_ARE_EQUAL("1 1 1|2"sv, rle);
+        }
+
+        Log::Comment(L"Edits which aren't sorted or which overlap are rejected.");
+        {
+            rle_vector rle{ rle_encode("1 1|2 2"sv) };
+            VERIFY_THROWS(rle.apply(std::vector<edit>{ { 2, 3, 1 }, { 0, 1, 1 } }), std::out_of_range);
+            VERIFY_THROWS(rle.apply(std::vector<edit>{ { 0, 2, 1 }, { 1, 3, 1 } }), std::out_of_range);
+            VERIFY_THROWS(rle.apply(std::vector<edit>{ { 3, 2, 1 } }), std::out_of_range);
+            VERIFY_ARE_EQUAL("1 1|2 2"sv, rle);
+        }
+
+        Log::Comment(L"Random edits have the same result as calling replace() for each of them.");
+        {
+            std::minstd_rand rng{ 42 };
+            for (int i = 0; i < 100; ++i)
+            {
+                const auto [source, edits] = _MakeRowAndEdits(rng, 40, 10);
+
+                rle_vector expected{ rle_container{ source } };
+                for (const auto& e : edits)
+                {
+                    expected.replace(e.start_index, e.end_index, e.value);
+                }
+
+                rle_vector actual{ rle_container{ source } };
+                actual.apply(edits);
+                VERIFY_ARE_EQUAL(expected, actual);
+            }
+        }
+    }
+
+    // Creates a row of width columns with many short runs, and count short sorted
+    // edits to it with random values, like the ones of a line of colored output.
+    static std::pair<rle_container, std::vector<rle_vector::edit>> _MakeRowAndEdits(std::minstd_rand& rng, const size_type width, const size_type count)
+    {
+        rle_container row;
+        for (size_type column = 0; column < width;)
+        {
+            const auto length = static_cast<size_type>(std::min<size_t>(1 + rng() % 4, width - column));
+            row.emplace_back(static_cast<value_type>(rng() % 8), length);
+            column += length;
+        }
+
+        std::vector<rle_vector::edit> edits;
+        const auto stride = static_cast<size_type>(width / count);
+        for (size_type i = 0; i < count; ++i)
+        {
+            const auto start = static_cast<size_type>(i * stride + rng() % (stride / 2));
+            const auto end = static_cast<size_type>(start + 1 + rng() % (stride / 2));
+            edits.push_back({ start, end, static_cast<value_type>(rng() % 8) });
+        }
+
+        return { std::move(row), std::move(edits) };
+    }
+
+    TEST_METHOD(ApplyBenchmark)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        Log::Comment(L"Edits 10K rows of 200 columns with many short runs, one edit at a time and all edits at once.");
+
+        constexpr size_t rows = 10000;
+        constexpr size_type width = 200;
+
+        std::minstd_rand rng{ 42 };
+        std::vector<std::pair<rle_container, std::vector<rle_vector::edit>>> inputs;
+        for (const auto count : std::initializer_list<size_type>{ 5, 20, 50 })
+        {
+            inputs.clear();
+            for (size_t i = 0; i < rows; ++i)
+            {
+                inputs.emplace_back(_MakeRowAndEdits(rng, width, count));
+            }
+
+            for (const auto batched : { false, true })
+            {
+                std::vector<rle_vector> targets;
+                targets.reserve(rows);
+                for (const auto& input : inputs)
+                {
+                    targets.emplace_back(rle_container{ input.first });
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < rows; ++i)
+                {
+                    auto& target = targets[i];
+                    const auto& edits = inputs[i].second;
+                    if (batched)
+                    {
+                        target.apply(edits);
+                    }
+                    else
+                    {
+                        for (const auto& e : edits)
+                        {
+                            target.replace(e.start_index, e.end_index, e.value);
+                        }
+                    }
+                }
+                const auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+
+                Log::Comment(NoThrowString().Format(L"%zu edits per row, %s: %.2f ms",
+                                                    static_cast<size_t>(count),
+                                                    batched ? L"apply()" : L"replace()",
+                                                    delta * 1000.0));
+            }
+        }
+    }
+
     TEST_METHOD(ResizeTrailingExtent)
     {
         constexpr std::string_view data{ "133211155" };
@@ -17,6 +17,8 @@ class Utf8Utf16ConvertTests
     TEST_METHOD(TestU8ToU16Partials);
     TEST_METHOD(TestU16ToU8Partials);
     TEST_METHOD(TestU8ToU16OneByOne);
+    TEST_METHOD(TestU8ToU16Replacement);
+    TEST_METHOD(TestU8ToU16AsciiBlocks);
 };
 
 void Utf8Utf16ConvertTests::TestU8ToU16()
@@ -191,3 +193,85 @@ void Utf8Utf16ConvertTests::TestU8ToU16OneByOne()
     VERIFY_SUCCEEDED(til::u8u16(u8String1_4, u16Out1, state));
     VERIFY_ARE_EQUAL(u16StringComp1, u16Out1);
 }
+
+void Utf8Utf16ConvertTests::TestU8ToU16Replacement()
+{
+    // Each maximal subpart of an ill-formed sequence is replaced with a single U+FFFD,
+    // just like MultiByteToWideChar does it.
+    const std::string u8String{
+        '\x41', // A
+        '\xC0', // invalid lead byte
+        '\xAF',
+        '\xE0', // overlong encoding of U+002F
+        '\x80',
+        '\xAF',
+        '\xED', // encoded high surrogate U+D800
+        '\xA0',
+        '\x80',
+        '\xF4', // U+110000 (exceeds the Unicode range)
+        '\x90',
+        '\x80',
+        '\x80',
+        '\xE2', // truncated EURO SIGN
+        '\x82',
+        '\x42', // B
+        '\xF5', // invalid lead byte
+        '\x43', // C
+        '\xF0', // truncated U+1F4F7 CAMERA
+        '\x9F',
+        '\x93'
+    };
+
+    const std::wstring u16StringComp{
+        L'A',
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        L'B',
+        gsl::narrow_cast<wchar_t>(0xFFFDU),
+        L'C',
+        gsl::narrow_cast<wchar_t>(0xFFFDU)
+    };
+
+    std::wstring u16Out{};
+    VERIFY_SUCCEEDED(til::u8u16(u8String, u16Out));
+    VERIFY_ARE_EQUAL(u16StringComp, u16Out);
+}
+
+void Utf8Utf16ConvertTests::TestU8ToU16AsciiBlocks()
+{
+    // The ASCII fast path converts whole blocks at once. Place a non-ASCII
+    // character at every offset of a string that spans several blocks to
+    // make sure that the fast path hands over to the regular decoder correctly.
+    for (size_t offset = 0; offset < 80; ++offset)
+    {
+        std::string u8String(offset, 'a');
+        u8String.append("\xC3\xB6"); // LATIN SMALL LETTER O WITH DIAERESIS
+        u8String.append(80 - offset, 'b');
+
+        std::wstring u16StringComp(offset, L'a');
+        u16StringComp.push_back(gsl::narrow_cast<wchar_t>(0x00f6U));
+        u16StringComp.append(80 - offset, L'b');
+
+        std::wstring u16Out{};
+        VERIFY_SUCCEEDED(til::u8u16(u8String, u16Out));
+        VERIFY_ARE_EQUAL(u16StringComp, u16Out);
+
+        til::u8state state{};
+        std::wstring u16Out1{};
+        std::wstring u16Out2{};
+        VERIFY_SUCCEEDED(til::u8u16(std::string_view{ u8String }.substr(0, offset + 1), u16Out1, state));
+        VERIFY_SUCCEEDED(til::u8u16(std::string_view{ u8String }.substr(offset + 1), u16Out2, state));
+        VERIFY_ARE_EQUAL(u16StringComp, u16Out1 + u16Out2);
+    }
+}
@@ -3,6 +3,7 @@
 // NOTE The functions u8u16 and u16u8 contain own algorithms. Tests have shown that they perform
 // worse than the platform API functions.
 // Thus, these functions are *unrelated* to the til::u8u16 and til::u16u8 implementation.
+// The til::u8u16 decoder itself is measured alongside the platform functions in the natural language tests.
 
 #include <iostream>
 #include <memory>
@@ -13,6 +14,11 @@
 
 #include "U8U16Test.hpp"
 
+#include <wil/result_macros.h>
+#include <gsl/gsl>
+#include <base/numerics/safe_math.h>
+#include <til/u8u16convert.h>
+
 typedef NTSTATUS(WINAPI* t_RtlUTF8ToUnicodeN)(PWSTR, ULONG, PULONG, PCCH, ULONG);
 typedef NTSTATUS(WINAPI* t_RtlUnicodeToUTF8N)(PCHAR, ULONG, PULONG, PCWSTR, ULONG);
 NTSTATUS(WINAPI* p_RtlUTF8ToUnicodeN)
@@ -354,6 +360,12 @@ void CompNaturalLang_WholeString(const std::string& fileName)
     duration = GetDuration();
     std::cout << " u8u16_ptr           length " << u16Str.length() << " elapsed " << duration << std::endl;
 
+    GetDuration();
+    std::wstring u16StrTil{};
+    hRes = til::u8u16(u8Str, u16StrTil);
+    duration = GetDuration();
+    std::cout << " til::u8u16          length " << u16StrTil.length() << " elapsed " << duration << std::endl;
+
     GetDuration();
     std::unique_ptr<char[]> u8Buffer{ std::make_unique<char[]>(u16Str.length() * 3) };
     length = WideCharToMultiByte(65001, 0, u16Str.data(), static_cast<int>(u16Str.length()), u8Buffer.get(), static_cast<int>(u16Str.length()) * 3, nullptr, nullptr);
@@ -390,10 +402,12 @@ void CompNaturalLang_Chunks(const std::string& fileName)
     int lenTotalMB2WC{};
     int lenTotalWC2MB{};
     size_t lenTotalU8U16{};
+    size_t lenTotalTilU8U16{};
     size_t lenTotalU16U8{};
     double durTotalMB2WC{};
     double durTotalWC2MB{};
     double durTotalU8U16{};
+    double durTotalTilU8U16{};
     double durTotalU16U8{};
 
     GetDuration();
@@ -404,6 +418,11 @@ void CompNaturalLang_Chunks(const std::string& fileName)
     std::wstring u16StrOut{};
     durTotalU8U16 += GetDuration();
 
+    GetDuration();
+    std::wstring u16StrTilOut{};
+    til::u8state tilState{};
+    durTotalTilU8U16 += GetDuration();
+
     GetDuration();
     std::unique_ptr<char[]> u8Buffer{ std::make_unique<char[]>(chunkSize * 3) };
     durTotalWC2MB += GetDuration();
@@ -426,6 +445,11 @@ void CompNaturalLang_Chunks(const std::string& fileName)
         durTotalU8U16 += GetDuration();
         lenTotalU8U16 += u16StrOut.length();
 
+        GetDuration();
+        hRes = til::u8u16(u8Chunk, u16StrTilOut, tilState);
+        durTotalTilU8U16 += GetDuration();
+        lenTotalTilU8U16 += u16StrTilOut.length();
+
         GetDuration();
         lenTotalWC2MB += WideCharToMultiByte(65001, 0, u16Chunk.data(), static_cast<int>(u16Chunk.length()), u8Buffer.get(), static_cast<int>(u16Chunk.length()) * 3, nullptr, nullptr);
         durTotalWC2MB += GetDuration();
@@ -438,6 +462,7 @@ void CompNaturalLang_Chunks(const std::string& fileName)
 
     std::cout << " MultiByteToWideChar length " << lenTotalMB2WC << " elapsed " << durTotalMB2WC << std::endl;
     std::cout << " u8u16_ptr           length " << lenTotalU8U16 << " elapsed " << durTotalU8U16 << std::endl;
+    std::cout << " til::u8u16          length " << lenTotalTilU8U16 << " elapsed " << durTotalTilU8U16 << std::endl;
     std::cout << " WideCharToMultiByte length " << lenTotalWC2MB << " elapsed " << durTotalWC2MB << std::endl;
     std::cout << " u16u8_ptr           length " << lenTotalU16U8 << " elapsed " << durTotalU16U8 << std::endl;
 }
@@ -3,6 +3,7 @@
 
 #include "precomp.h"
 #include "inc/CodepointWidthDetector.hpp"
+#include "inc/Utf16Parser.hpp"
 
 namespace
 {
@@ -14,11 +15,6 @@ namespace
         CodepointWidth width;
     };
 
-    static bool operator<(const UnicodeRange& range, const unsigned int searchTerm) noexcept
-    {
-        return range.upperBound < searchTerm;
-    }
-
     // Generated by Generate-CodepointWidthsFromUCD.ps1 -Pack:True -Full:False -NoOverrides:False
     // on 10/25/2020 7:32:04 AM (UTC) from Unicode 13.0.0.
     // 321205 (0x4E6B5) codepoints covered.
@@ -321,6 +317,122 @@ namespace
         UnicodeRange{ 0xf0000, 0xffffd, CodepointWidth::Ambiguous },
         UnicodeRange{ 0x100000, 0x10fffd, CodepointWidth::Ambiguous },
     };
+
+    // The table above is turned into a two-level lookup table at compile time, so that
+    // looking up the width of a codepoint doesn't require a binary search.
+    // The first level is indexed by the codepoint divided by the block size. Its entries are
+    // either a CodepointWidth, if all codepoints of the block are equally wide, or the index
+    // of a block of the second level plus s_firstMixedBlock. The second level stores the width
+    // of each codepoint of such a block in 2 bits.
+    static constexpr unsigned int s_blockShift = 8;
+    static constexpr unsigned int s_blockSize = 1u << s_blockShift;
+    static constexpr unsigned int s_blockCount = 0x110000 >> s_blockShift;
+    static constexpr uint8_t s_firstMixedBlock = static_cast<uint8_t>(CodepointWidth::Invalid);
+    static constexpr uint8_t s_unassignedMixedBlock = UINT8_MAX;
+
+    using CodepointWidthBlock = std::array<uint8_t, s_blockSize / 4>;
+
+    static constexpr std::array<uint8_t, s_blockCount> s_classifyBlocks() noexcept
+    {
+        // Blocks which don't intersect with any of the ranges are narrow (0).
+        std::array<uint8_t, s_blockCount> blocks{};
+        for (const auto& range : s_wideAndAmbiguousTable)
+        {
+            for (auto block = range.lowerBound >> s_blockShift; block <= range.upperBound >> s_blockShift; ++block)
+            {
+                const auto first = block << s_blockShift;
+                const auto last = first + s_blockSize - 1;
+                // The ranges don't overlap. A block that's completely covered by one isn't touched by any other.
+                const auto uniform = range.lowerBound <= first && last <= range.upperBound;
+                til::at(blocks, block) = uniform ? static_cast<uint8_t>(range.width) : s_unassignedMixedBlock;
+            }
+        }
+        return blocks;
+    }
+
+    static constexpr size_t s_countMixedBlocks(const std::array<uint8_t, s_blockCount>& blocks) noexcept
+    {
+        size_t count = 0;
+        for (const auto block : blocks)
+        {
+            count += block == s_unassignedMixedBlock;
+        }
+        return count;
+    }
+
+    static constexpr auto s_blockClasses = s_classifyBlocks();
+    static constexpr auto s_mixedBlockCount = s_countMixedBlocks(s_blockClasses);
+    static_assert(s_firstMixedBlock + s_mixedBlockCount < s_unassignedMixedBlock, "too many mixed blocks for 8 bit indices");
+
+    struct CodepointWidthTable
+    {
+        std::array<uint8_t, s_blockCount> stage1;
+        std::array<CodepointWidthBlock, s_mixedBlockCount> stage2;
+    };
+
+    static constexpr CodepointWidthTable s_buildCodepointWidthTable() noexcept
+    {
+        CodepointWidthTable table{};
+
+        auto next = s_firstMixedBlock;
+        for (size_t block = 0; block < s_blockCount; ++block)
+        {
+            const auto entry = til::at(s_blockClasses, block);
+            if (entry == s_unassignedMixedBlock)
+            {
+                til::at(table.stage1, block) = next;
+                ++next;
+            }
+            else
+            {
+                til::at(table.stage1, block) = entry;
+            }
+        }
+
+        for (const auto& range : s_wideAndAmbiguousTable)
+        {
+            for (auto block = range.lowerBound >> s_blockShift; block <= range.upperBound >> s_blockShift; ++block)
+            {
+                const auto entry = til::at(table.stage1, block);
+                if (entry < s_firstMixedBlock)
+                {
+                    continue;
+                }
+
+                auto& widths = til::at(table.stage2, entry - s_firstMixedBlock);
+                const auto first = std::max(range.lowerBound, block << s_blockShift);
+                const auto last = std::min(range.upperBound, (block << s_blockShift) + s_blockSize - 1);
+                for (auto codepoint = first; codepoint <= last; ++codepoint)
+                {
+                    const auto index = codepoint % s_blockSize;
+                    auto& packed = til::at(widths, index / 4);
+                    packed = static_cast<uint8_t>(packed | static_cast<uint8_t>(range.width) << (index % 4 * 2));
+                }
+            }
+        }
+
+        return table;
+    }
+
+    static constexpr auto s_codepointWidths = s_buildCodepointWidthTable();
+
+    static CodepointWidth s_lookupCodepointWidth(const unsigned int codepoint) noexcept
+    {
+        if (codepoint >= s_blockCount << s_blockShift)
+        {
+            return CodepointWidth::Narrow;
+        }
+
+        const auto entry = til::at(s_codepointWidths.stage1, codepoint >> s_blockShift);
+        if (entry < s_firstMixedBlock)
+        {
+            return static_cast<CodepointWidth>(entry);
+        }
+
+        const auto& widths = til::at(s_codepointWidths.stage2, entry - s_firstMixedBlock);
+        const auto index = codepoint % s_blockSize;
+        return static_cast<CodepointWidth>((til::at(widths, index / 4) >> (index % 4 * 2)) & 0b11);
+    }
 }
 
 // Routine Description:
@@ -404,7 +516,63 @@ bool CodepointWidthDetector::IsWide(const std::wstring_view glyph) const
 }
 
 // Routine Description:
-// - returns the width type of codepoint by searching the map generated from the unicode spec
+// - Measures the widths of all codepoints of a string at once, which saves
+//   the overhead of looking them up one glyph at a time.
+// - Just like IsWide(), ambiguous codepoints are only wide if the fallback method says so.
+// Arguments:
+// - text - the utf16 encoded string to measure
+// - widths - receives one entry per code unit of text: the number of columns (1 or 2)
+//   for the first code unit of each codepoint and 0 for trailing surrogates.
+//   Must be at least as long as text.
+// Return Value:
+// - the total number of columns
+size_t CodepointWidthDetector::MeasureWidths(const std::wstring_view text, const gsl::span<uint8_t> widths) const
+{
+    THROW_HR_IF(E_INVALIDARG, widths.size() < text.size());
+
+    size_t columns = 0;
+    for (size_t i = 0; i < text.size();)
+    {
+        const auto wch = til::at(text, i);
+
+        // Printable ASCII makes up most of all text.
+        if (GetQuickCharWidth(wch) == CodepointWidth::Narrow)
+        {
+            til::at(widths, i) = 1;
+            ++columns;
+            ++i;
+            continue;
+        }
+
+        size_t length = 1;
+        if (Utf16Parser::IsLeadingSurrogate(wch) && i + 1 < text.size() && Utf16Parser::IsTrailingSurrogate(til::at(text, i + 1)))
+        {
+            length = 2;
+        }
+
+        const auto glyph = text.substr(i, length);
+        auto width = s_lookupCodepointWidth(_extractCodepoint(glyph));
+        if (width == CodepointWidth::Ambiguous && _pfnFallbackMethod)
+        {
+            width = _checkFallbackViaCache(glyph) ? CodepointWidth::Wide : CodepointWidth::Ambiguous;
+        }
+
+        const uint8_t cells = width == CodepointWidth::Wide ? 2 : 1;
+        til::at(widths, i) = cells;
+        if (length == 2)
+        {
+            til::at(widths, i + 1) = 0;
+        }
+
+        columns += cells;
+        i += length;
+    }
+
+    return columns;
+}
+
+// Routine Description:
+// - returns the width type of codepoint by looking it up in the table generated from the unicode spec
 // Arguments:
 // - glyph - the utf16 encoded codepoint to search for
 // Return Value:
@@ -416,17 +584,7 @@ CodepointWidth CodepointWidthDetector::_lookupGlyphWidth(const std::wstring_view
         return CodepointWidth::Invalid;
     }
 
-    const auto codepoint = _extractCodepoint(glyph);
-    const auto it = std::lower_bound(s_wideAndAmbiguousTable.begin(), s_wideAndAmbiguousTable.end(), codepoint);
-
-    // For characters that are not _in_ the table, lower_bound will return the nearest item that is.
-    // We must check its bounds to make sure that our hit was a true hit.
-    if (it != s_wideAndAmbiguousTable.end() && codepoint >= it->lowerBound && codepoint <= it->upperBound)
-    {
-        return it->width;
-    }
-
-    return CodepointWidth::Narrow;
+    return s_lookupCodepointWidth(_extractCodepoint(glyph));
 }
 
 // Routine Description: